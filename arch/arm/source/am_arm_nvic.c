@@ -16,6 +16,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.02 26-10-18  lgg, add trace points for interrupt service routines.
  * - 1.01 17-04-10  sdy, modified.
  * - 1.00 14-12-04  hbt, first implementation.
  * \endinternal
@@ -24,6 +25,7 @@
 #include "ametal.h"
 #include "am_arm_nvic.h"
 #include "hw/amhw_arm_nvic.h"
+#include "am_trace.h"
 
 /*******************************************************************************
 * ˽ж
@@ -145,7 +147,9 @@ void am_exc_eint_handler (void)
     p_arg   = p_nvic_devinfo->p_isrinfo[slot].p_arg;
 
     if (pfn_isr != NULL) {
+        AM_TRACE_ENTER(AM_TRACE_ISR, inum);
         pfn_isr(p_arg);
+        AM_TRACE_EXIT(AM_TRACE_ISR, inum);
     }
 }
 
@@ -16,6 +16,7 @@
  * \sa am_prj_config.h
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add stack usage monitor configuration.
  * - 1.00 17-04-11  nwt, first implementation.
  * \endinternal
  */
@@ -69,6 +70,12 @@
 /** \brief Ƿʹ isr defer  */
 #define AM_CFG_ISR_DEFER_ENABLE          0
 
+/** \brief Ƿͳջʹ am_stack.hʱջδʹõĲ */
+#define AM_CFG_STACK_ENABLE              0
+
+/** \brief ջڣmsΪ 0 ʱ飬Ҫʹʱ */
+#define AM_CFG_STACK_GUARD_MS            0
+
 /** @} */
 
 /**
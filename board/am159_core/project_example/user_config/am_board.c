@@ -16,6 +16,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add stack usage monitor
  * - 1.00 14-12-01  tee, first implementation
  * \endinternal
  */
@@ -27,6 +28,7 @@
 #include "am_event_input_key.h"
 #include "am_event_category_input.h"
 #include "am_bsp_isr_defer_pendsv.h"
+#include "am_bsp_stack.h"
 #include "am_bsp_system_heap.h"
 #include "am_bsp_delay_timer.h"
 #include "am_service_inst_init.h"
@@ -155,6 +157,10 @@ void am_board_init (void)
     am_bsp_isr_defer_pendsv_init();
 #endif /* (AM_CFG_ISR_DEFER_ENABLE == 1) */
 
+#if (AM_CFG_STACK_ENABLE == 1)
+    am_bsp_stack_init(AM_CFG_STACK_GUARD_MS);     /* ջͳջʹ */
+#endif /* (AM_CFG_STACK_ENABLE == 1) */
+
     /* ݴ */
 }
 
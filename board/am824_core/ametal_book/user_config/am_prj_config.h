@@ -17,6 +17,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add stack usage monitor configuration
  * - 1.00 14-12-23  tee, first implementation
  * \endinternal
  */
@@ -75,6 +76,12 @@ extern "C" {
 /** \brief Ƿʹ isr defer  */
 #define AM_CFG_ISR_DEFER_ENABLE          1
 
+/** \brief Ƿͳջʹ am_stack.hʱջδʹõĲ */
+#define AM_CFG_STACK_ENABLE              0
+
+/** \brief ջڣmsΪ 0 ʱ飬Ҫʹʱ */
+#define AM_CFG_STACK_GUARD_MS            0
+
 
 
 /** \brief Ƿʹ RAW_FS (ļϵͳ) */
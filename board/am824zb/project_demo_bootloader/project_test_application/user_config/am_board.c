@@ -17,6 +17,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add stack usage monitor.
  * - 1.00 14-12-01  tee, first implementation.
  * \endinternal
  */
@@ -40,6 +41,7 @@
 
 #include "am_bsp_system_heap.h"
 #include "am_bsp_isr_defer_pendsv.h"
+#include "am_bsp_stack.h"
 #include "am_bsp_delay_timer.h"
 #include "am_service_inst_init.h"
 
@@ -272,6 +274,10 @@ void am_board_init (void)
     am_key_gpio_inst_init();
 #endif /* (AM_CFG_KEY_GPIO_ENABLE == 1) */
 
+#if (AM_CFG_STACK_ENABLE == 1)
+    am_bsp_stack_init(AM_CFG_STACK_GUARD_MS);     /* ջͳջʹ */
+#endif /* (AM_CFG_STACK_ENABLE == 1) */
+
     /* ݴ */
 
 }
@@ -17,6 +17,7 @@
  * \sa am_prj_config.h
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add stack usage monitor configuration.
  * - 1.00 14-12-23  tee, first implementation.
  * \endinternal
  */
@@ -67,6 +68,12 @@
 /** \brief Ƿʹðϵͳ */
 #define AM_CFG_KEY_ENABLE                0
 
+/** \brief Ƿͳջʹ am_stack.hʱջδʹõĲ */
+#define AM_CFG_STACK_ENABLE              0
+
+/** \brief ջڣmsΪ 0 ʱ飬Ҫʹʱ */
+#define AM_CFG_STACK_GUARD_MS            0
+
 /** @} */
 
 
@@ -0,0 +1,63 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ջʹͳư弶֧
+ *
+ * ŵõջMSPķΧעᵽ am_stack У am_stack.h
+ * - GCC   : __heap_end__ ~ _estackӽűУջλϵͳ֮
+ * - ARMCC : STACK$$Base ~ STACK$$Limitļе STACK Σ
+ *           AM_BSP_STACK_ARM_LIB_STACK ʱΪ Image$$ARM_LIB_STACK$$ZI$$Base ~
+ *           Image$$ARM_LIB_STACK$$ZI$$Limitɢļе ARM_LIB_STACK
+ *           KL26 ϵеĹʹַʽڹ̵ C 궨жú꣩
+ *
+ * \internal
+ * \par modification history
+ * - 1.01 26-10-18  lgg, support ARM_LIB_STACK regions in scatter files
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_BSP_STACK_H
+#define __AM_BSP_STACK_H
+
+#include "ametal.h"
+#include "am_stack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief עᲢջ
+ *
+ * \param[in] guard_ms : ջڣmsΪ 0 ʱ顣ʹʱ
+ *                       Ӧʱʼ
+ *
+ * \return 
+ */
+void am_bsp_stack_init (unsigned int guard_ms);
+
+/**
+ * \brief ȡջϢ
+ * \return ջϢδעʱΪ NULL
+ */
+am_stack_t *am_bsp_stack_main_get (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AM_BSP_STACK_H */
+
+/* end of file */
@@ -16,8 +16,13 @@
  *
  * ʼ󣬼ʹ am_mem.h ļеؽӿ
  *
+ * ͨ AM_BSP_SYSTEM_HEAP_POOL16_NUM Ⱥ꣨ͨڹ̵Ԥѡж壩
+ * ϵͳԤɶڴأam_mem_alloc() Сڴ潫ȴӶӦ
+ * СڴлȡͷžΪ O(1)ûжѿͷĿ
+ *
  * \internal
  * \par Modification History
+ * - 1.01 26-10-18  lgg, serve small size classes from am_mempool
  * - 1.00 17-08-17  tee, first implementation.
  * \endinternal
  */
@@ -29,6 +34,28 @@
 extern "C" {
 #endif
 
+/**
+ * \name ϵͳСڴãֵΪߴڴصĿΪ 0 ʱʹøڴ
+ * @{
+ */
+
+/** \brief 16 ֽڴؿ */
+#ifndef AM_BSP_SYSTEM_HEAP_POOL16_NUM
+#define AM_BSP_SYSTEM_HEAP_POOL16_NUM    0
+#endif
+
+/** \brief 32 ֽڴؿ */
+#ifndef AM_BSP_SYSTEM_HEAP_POOL32_NUM
+#define AM_BSP_SYSTEM_HEAP_POOL32_NUM    0
+#endif
+
+/** \brief 64 ֽڴؿ */
+#ifndef AM_BSP_SYSTEM_HEAP_POOL64_NUM
+#define AM_BSP_SYSTEM_HEAP_POOL64_NUM    0
+#endif
+
+/** @} */
+
 /**
  * \brief ʼ
  */
@@ -0,0 +1,80 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ջʹͳư弶֧
+ *
+ * \internal
+ * \par modification history
+ * - 1.01 26-10-18  lgg, support ARM_LIB_STACK regions in scatter files
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "ametal.h"
+#include "am_stack.h"
+#include "am_bsp_stack.h"
+
+/*******************************************************************************
+  ֲ
+*******************************************************************************/
+
+static am_stack_t  __g_main_stack;
+static am_bool_t   __g_main_stack_valid = AM_FALSE;
+
+/*******************************************************************************
+  
+*******************************************************************************/
+void am_bsp_stack_init (unsigned int guard_ms)
+{
+#ifdef  __GNUC__
+    extern char __heap_end__;              /* Defined by the linker */
+    extern char _estack;                   /* Defined by the linker */
+
+    char *stack_bottom = &__heap_end__;
+    char *stack_top    = &_estack;
+
+#elif defined(__CC_ARM) && defined(AM_BSP_STACK_ARM_LIB_STACK)
+    extern char Image$$ARM_LIB_STACK$$ZI$$Base;    /* Defined by the linker */
+    extern char Image$$ARM_LIB_STACK$$ZI$$Limit;   /* Defined by the linker */
+
+    char *stack_bottom = &Image$$ARM_LIB_STACK$$ZI$$Base;
+    char *stack_top    = &Image$$ARM_LIB_STACK$$ZI$$Limit;
+
+#elif defined(__CC_ARM)
+    extern char STACK$$Base;               /* Defined by the linker */
+    extern char STACK$$Limit;              /* Defined by the linker */
+
+    char *stack_bottom = &STACK$$Base;
+    char *stack_top    = &STACK$$Limit;
+#endif
+
+    if (am_stack_register(&__g_main_stack,
+                          "main",
+                          (void *)stack_bottom,
+                          (void *)stack_top) == AM_OK) {
+        __g_main_stack_valid = AM_TRUE;
+    }
+
+    if (guard_ms != 0) {
+        am_stack_guard_start(guard_ms);
+    }
+}
+
+/******************************************************************************/
+am_stack_t *am_bsp_stack_main_get (void)
+{
+    return __g_main_stack_valid ? &__g_main_stack : NULL;
+}
+
+/* end of file */
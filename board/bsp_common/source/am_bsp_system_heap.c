@@ -16,6 +16,7 @@
  *
  * \internal
  * \par modification history:
+ * - 1.01 26-10-18  lgg, serve small size classes from am_mempool
  * - 1.00 14-06-13  zen, first implementation
  * \endinternal
  */
@@ -23,7 +24,9 @@
 #include "ametal.h"
 #include "am_mem.h"
 #include "am_memheap.h"
+#include "am_mempool.h"
 #include "am_board.h"
+#include "am_bsp_system_heap.h"
 
 #include <string.h>
 
@@ -32,6 +35,91 @@
 *******************************************************************************/
 static struct am_memheap __g_system_heap;       /* system heap object */
 
+#define __SYSTEM_HEAP_POOL_ENABLE  ((AM_BSP_SYSTEM_HEAP_POOL16_NUM + \
+                                     AM_BSP_SYSTEM_HEAP_POOL32_NUM + \
+                                     AM_BSP_SYSTEM_HEAP_POOL64_NUM) > 0)
+
+#if __SYSTEM_HEAP_POOL_ENABLE
+
+/* small size classes, in ascending order of block size */
+static const struct {
+    uint16_t blk_size;
+    uint16_t nblks;
+} __g_system_pool_cfg[] = {
+    {16, AM_BSP_SYSTEM_HEAP_POOL16_NUM},
+    {32, AM_BSP_SYSTEM_HEAP_POOL32_NUM},
+    {64, AM_BSP_SYSTEM_HEAP_POOL64_NUM},
+};
+
+#define __SYSTEM_POOL_NUM   AM_NELEMENTS(__g_system_pool_cfg)
+
+static am_mempool_t        __g_system_pool[__SYSTEM_POOL_NUM];
+static am_mempool_handle_t __g_system_pool_handle[__SYSTEM_POOL_NUM];
+
+/* reserve the pools at the start of system heap */
+static void __system_pool_init (void)
+{
+    void     *p_buf;
+    size_t    buf_size;
+    unsigned  i;
+
+    for (i = 0; i < __SYSTEM_POOL_NUM; i++) {
+
+        __g_system_pool_handle[i] = NULL;
+
+        if (__g_system_pool_cfg[i].nblks == 0) {
+            continue;
+        }
+
+        buf_size = __g_system_pool_cfg[i].blk_size *
+                   __g_system_pool_cfg[i].nblks;
+        p_buf    = am_memheap_alloc(&__g_system_heap, buf_size);
+        if (p_buf != NULL) {
+            __g_system_pool_handle[i] = am_mempool_init(
+                                            &__g_system_pool[i],
+                                             p_buf,
+                                             buf_size,
+                                            __g_system_pool_cfg[i].blk_size);
+        }
+    }
+}
+
+/* allocate from the smallest pool that fits, fall back to larger pools */
+static void *__system_pool_alloc (size_t size)
+{
+    void     *ptr;
+    unsigned  i;
+
+    for (i = 0; i < __SYSTEM_POOL_NUM; i++) {
+        if ((__g_system_pool_handle[i] != NULL) &&
+            (size <= __g_system_pool_cfg[i].blk_size)) {
+            ptr = am_mempool_alloc(__g_system_pool_handle[i]);
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* get the pool which the pointer is allocated from */
+static am_mempool_handle_t __system_pool_find (void *ptr)
+{
+    unsigned i;
+
+    for (i = 0; i < __SYSTEM_POOL_NUM; i++) {
+        if ((__g_system_pool_handle[i] != NULL) &&
+            am_mempool_is_owner(__g_system_pool_handle[i], ptr)) {
+            return __g_system_pool_handle[i];
+        }
+    }
+
+    return NULL;
+}
+
+#endif /* __SYSTEM_HEAP_POOL_ENABLE */
+
 /*******************************************************************************
   implementation
 *******************************************************************************/
@@ -44,6 +132,10 @@ void am_bsp_system_heap_init (void *heap_start, void *heap_end)
                     "system_heap",
                     (void *)heap_start,
                     (uint32_t)heap_end - (uint32_t)heap_start);
+
+#if __SYSTEM_HEAP_POOL_ENABLE
+    __system_pool_init();
+#endif
 }
 
 /******************************************************************************/
@@ -53,6 +145,17 @@ void *am_mem_align(size_t size, size_t align)
     void    *ptr;
     size_t   align_size;
 
+#if __SYSTEM_HEAP_POOL_ENABLE
+
+    /* pool blocks are pointer aligned, no need to save the real pointer */
+    if (align <= sizeof(void *)) {
+        ptr = __system_pool_alloc(size);
+        if (ptr != NULL) {
+            return ptr;
+        }
+    }
+#endif
+
     /* align the alignment size to 4 byte */
     align = AM_ROUND_UP(align, sizeof(void *));
 
@@ -102,6 +205,15 @@ void am_mem_free(void *ptr)
 {
     void *real_ptr = NULL;
 
+#if __SYSTEM_HEAP_POOL_ENABLE
+    am_mempool_handle_t pool = __system_pool_find(ptr);
+
+    if (pool != NULL) {
+        am_mempool_free(pool, ptr);
+        return;
+    }
+#endif
+
     if (ptr != NULL) {
         real_ptr = (void *)*(uint32_t *)((uint32_t)ptr - sizeof(void *));
     }
@@ -113,6 +225,14 @@ size_t am_mem_size(void *ptr)
 {
     void *real_ptr = NULL;
 
+#if __SYSTEM_HEAP_POOL_ENABLE
+    am_mempool_handle_t pool = __system_pool_find(ptr);
+
+    if (pool != NULL) {
+        return am_mempool_blk_size_get(pool);
+    }
+#endif
+
     if (ptr != NULL) {
         real_ptr = (void *)*(uint32_t *)((uint32_t)ptr - sizeof(void *));
     }
@@ -125,6 +245,24 @@ void *am_mem_realloc(void *ptr, size_t newsize)
     void  *real_ptr     = NULL;
     void  *new_ptr      = NULL;
 
+#if __SYSTEM_HEAP_POOL_ENABLE
+    am_mempool_handle_t pool = __system_pool_find(ptr);
+
+    /* a pool block can't be resized, move it if it's too small */
+    if (pool != NULL) {
+        if (newsize <= am_mempool_blk_size_get(pool)) {
+            return ptr;
+        }
+
+        new_ptr = am_mem_alloc(newsize);
+        if (new_ptr != NULL) {
+            memcpy(new_ptr, ptr, am_mempool_blk_size_get(pool));
+            am_mempool_free(pool, ptr);
+        }
+        return new_ptr;
+    }
+#endif
+
     if (ptr != NULL) {
         /* get real pointer */
         real_ptr = (void *)*(uint32_t *)((uint32_t)ptr - sizeof(void *));
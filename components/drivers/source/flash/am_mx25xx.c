@@ -19,6 +19,7 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add vectored read and write for MTD.
  * - 1.00 15-09-14  tee, first implementation.
  * \endinternal
  */
@@ -29,6 +30,7 @@
 #include "ametal.h"
 #include "am_vdebug.h"
 #include "am_mx25xx.h"
+#include "am_wait.h"
 #include <string.h>
 
 /*******************************************************************************
@@ -90,6 +92,9 @@
 
 /** @} */
 
+/** \brief ɢ/ۼдʱһ SPI ݶθ */
+#define __MX25XX_IOV_TRANS_MAX  4
+
 /*******************************************************************************
   غ
 *******************************************************************************/
@@ -680,12 +685,230 @@ static int __mx25xx_mtd_write (void                 *p_cookie,
     return err;
 }
 
+/******************************************************************************/
+
+/* SPI Ϣɻص */
+static void __mx25xx_msg_complete (void *p_arg)
+{
+    am_wait_done((am_wait_t *)p_arg);
+}
+
+/******************************************************************************/
+
+/*
+ * һ SPI зȻ p_iov[*p_idx]  *p_off ʼдַ
+ * ݶΣֱַ endMTD ַݶεַﵽݶθ
+ */
+static int __mx25xx_iov_xfer (am_mx25xx_dev_t      *p_dev,
+                              const uint8_t        *p_cmd,
+                              uint32_t              cmd_len,
+                              const am_mtd_iovec_t *p_iov,
+                              unsigned int          iovcnt,
+                              unsigned int         *p_idx,
+                              uint32_t             *p_off,
+                              uint32_t              end,
+                              am_bool_t             is_read)
+{
+    am_spi_transfer_t  trans[__MX25XX_IOV_TRANS_MAX + 1];
+    am_spi_message_t   msg;
+    am_wait_t          msg_wait;
+    uint8_t           *p_data;
+    uint32_t           addr = p_iov[*p_idx].addr + *p_off;
+    uint32_t           len;
+    int                i    = 1;
+    int                ret;
+
+    am_wait_init(&msg_wait);
+    am_spi_msg_init(&msg, __mx25xx_msg_complete, (void *)&msg_wait);
+
+    am_spi_mktrans(&trans[0], p_cmd, NULL, cmd_len, 0, 0, 0, 0, 0);
+    am_spi_trans_add_tail(&msg, &trans[0]);
+
+    while ((i <= __MX25XX_IOV_TRANS_MAX) && (*p_idx < iovcnt) && (addr < end)) {
+
+        /* ǰݶɣһݶεĵַ */
+        if (*p_off == p_iov[*p_idx].len) {
+            (*p_idx)++;
+            *p_off = 0;
+
+            if ((*p_idx < iovcnt) && (p_iov[*p_idx].addr != addr)) {
+                break;
+            }
+            continue;
+        }
+
+        p_data = (uint8_t *)p_iov[*p_idx].p_buf + *p_off;
+        len    = p_iov[*p_idx].len - *p_off;
+
+        if (len > end - addr) {
+            len = end - addr;
+        }
+
+        am_spi_mktrans(&trans[i],
+                       (is_read) ? NULL : p_data,
+                       (is_read) ? p_data : NULL,
+                       len,
+                       0,
+                       0,
+                       0,
+                       0,
+                       0);
+        am_spi_trans_add_tail(&msg, &trans[i]);
+
+        i++;
+        addr   += len;
+        *p_off += len;
+    }
+
+    ret = am_spi_msg_start(&(p_dev->spi_dev), &msg);
+
+    if (ret != AM_OK) {
+        return ret;
+    }
+
+    am_wait_on(&msg_wait);
+
+    return msg.status;
+}
+
+/******************************************************************************/
+
+/* ɵݶΣ AM_FALSE ʾݶ */
+static am_bool_t __mx25xx_iov_next (const am_mtd_iovec_t *p_iov,
+                                    unsigned int          iovcnt,
+                                    unsigned int         *p_idx,
+                                    uint32_t             *p_off)
+{
+    while ((*p_idx < iovcnt) && (*p_off == p_iov[*p_idx].len)) {
+        (*p_idx)++;
+        *p_off = 0;
+    }
+
+    return (*p_idx < iovcnt) ? AM_TRUE : AM_FALSE;
+}
+
+/******************************************************************************/
+
+/* ַݶʹһٶȡ */
+static int __mx25xx_mtd_readv (void                 *p_cookie,
+                               const am_mtd_iovec_t *p_iov,
+                               unsigned int          iovcnt)
+{
+    am_mx25xx_dev_t *p_dev = (am_mx25xx_dev_t *)p_cookie;
+
+    uint8_t          cmd_buf[5];
+    unsigned int     idx   = 0;
+    uint32_t         off   = 0;
+    uint32_t         from;
+    int              ret;
+
+    if (p_cookie == NULL || p_iov == NULL) {
+        return -AM_EINVAL;
+    }
+
+    /* ٶǰҪȷ״̬ڿ״̬ȡвæ */
+    ret = __mx25xx_wait_busy(p_dev);
+
+    if (ret != AM_OK) {
+        return ret;
+    }
+
+    while (__mx25xx_iov_next(p_iov, iovcnt, &idx, &off)) {
+
+        from = p_iov[idx].addr + off + p_dev->addr_offset;
+
+        cmd_buf[0] = __MX25XX_CMD_FAST_READ;
+        cmd_buf[1] = (from >> 16) & 0xFF;
+        cmd_buf[2] = (from >> 8 ) & 0xFF;
+        cmd_buf[3] = from & 0xFF;
+        cmd_buf[4] = 0xFF;             /* Dummy Byte */
+
+        ret = __mx25xx_iov_xfer(p_dev,
+                                cmd_buf,
+                                5,
+                                p_iov,
+                                iovcnt,
+                                &idx,
+                                &off,
+                                0xFFFFFFFF,
+                                AM_TRUE);
+        if (ret != AM_OK) {
+            return -AM_EIO;
+        }
+    }
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+
+/* ͬһҳеַݶʹһҳд */
+static int __mx25xx_mtd_writev (void                 *p_cookie,
+                                const am_mtd_iovec_t *p_iov,
+                                unsigned int          iovcnt)
+{
+    am_mx25xx_dev_t *p_dev = (am_mx25xx_dev_t *)p_cookie;
+
+    uint32_t         page;
+    uint8_t          cmd_buf[4];
+    unsigned int     idx   = 0;
+    uint32_t         off   = 0;
+    uint32_t         addr;
+    uint32_t         to;
+    int              ret;
+
+    if (p_cookie == NULL || p_iov == NULL) {
+        return -AM_EINVAL;
+    }
+
+    page = __MX25XX_PAGE_SIZE_GET(p_dev->p_devinfo->type);
+
+    while (__mx25xx_iov_next(p_iov, iovcnt, &idx, &off)) {
+
+        addr = p_iov[idx].addr + off;
+        to   = addr + p_dev->addr_offset;
+
+        __mx25xx_wait_busy(p_dev);
+        __mx25xx_write_en(p_dev);
+        __mx25xx_wait_busy(p_dev);
+
+        cmd_buf[0] = __MX25XX_CMD_PP;
+        cmd_buf[1] = (to >> 16) & 0xFF;
+        cmd_buf[2] = (to >> 8 ) & 0xFF;
+        cmd_buf[3] = to & 0xFF;
+
+        /* ܳǰҳ */
+        ret = __mx25xx_iov_xfer(p_dev,
+                                cmd_buf,
+                                4,
+                                p_iov,
+                                iovcnt,
+                                &idx,
+                                &off,
+                                addr + (page - (to % page)),
+                                AM_FALSE);
+        if (ret != AM_OK) {
+            return -AM_EIO;
+        }
+
+        /* ȴд */
+        ret = __mx25xx_wait_busy_and_wel(p_dev);
+
+        if (ret != AM_OK) {
+            return ret;
+        }
+    }
+
+    return AM_OK;
+}
+
 /******************************************************************************/
 static const struct am_mtd_ops __g_mtd_ops = {
     __mx25xx_mtd_erase,       /* mtd_erase */
     __mx25xx_mtd_read,        /* mtd_read */
     __mx25xx_mtd_write,       /* mtd_write */
-
+    __mx25xx_mtd_readv,       /* mtd_readv */
+    __mx25xx_mtd_writev,      /* mtd_writev */
 };
 
 am_mtd_handle_t am_mx25xx_mtd_init(am_mx25xx_handle_t  handle,
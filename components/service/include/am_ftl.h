@@ -15,6 +15,12 @@
  *
  * \internal
  * \par Modification history
+ * - 1.06 26-10-18  lgg, keep the wear leveling state across mounts.
+ * - 1.05 26-10-18  lgg, add multi-block read and write.
+ * - 1.04 26-10-18  lgg, add incremental merge in background.
+ * - 1.03 26-10-18  lgg, add static wear leveling and wear statistics.
+ * - 1.02 26-10-18  lgg, add write-back cache.
+ * - 1.01 26-10-18  lgg, add checkpoint of mapping table for fast mount.
  * - 1.00 16-08-23  tee, first implementation.
  * \endinternal
  */
@@ -29,6 +35,52 @@
 extern "C" {
 #endif
 
+/**
+ * \brief ̬ĥִڣÿִһ
+ */
+#ifndef AM_FTL_WL_PERIOD
+#define AM_FTL_WL_PERIOD       16
+#endif
+
+/**
+ * \brief ̬ĥÿһžǷ
+ *
+ * ȫɨĹҲһ飬б˼ĽȣƵλʱ̬
+ * ĥȻЧ
+ */
+#ifndef AM_FTL_WL_SCAN_STEP
+#define AM_FTL_WL_SCAN_STEP    8
+#endif
+
+/**
+ * \brief ̨ϲֵĿ־ڸֵʱ am_ftl_gc_step() ϲһ־
+ */
+#ifndef AM_FTL_GC_FREE_LOGS
+#define AM_FTL_GC_FREE_LOGS    1
+#endif
+
+/**
+ * \brief ̨ϲʱam_ftl_gc_step() ÿһิƵ߼
+ */
+#ifndef AM_FTL_GC_STEP_SECTORS
+#define AM_FTL_GC_STEP_SECTORS 4
+#endif
+
+/**
+ * \brief ̨ϲʱڵڸֵ־Ҳϲдͬ
+ *        ϲֵԽͬϲԽ٣ϲԽ࣬Ϊ 0 ʱֻϲ־
+ */
+#ifndef AM_FTL_GC_LOG_SPARE
+#define AM_FTL_GC_LOG_SPARE    4
+#endif
+
+/**
+ * \brief д߼ʱһύ MTD ݶΣ߼飩
+ */
+#ifndef AM_FTL_IOV_MAX
+#define AM_FTL_IOV_MAX         8
+#endif
+
 /**
  * \brief FTLҪʹõڴ棨RAMռС
  *
@@ -45,7 +97,65 @@ extern "C" {
      + ((nb_log_blocks) * (sizeof(struct log_buf)))                          \
      + ((nb_log_blocks) * ((erase_size) / (logic_blk_size)))                 \
      + (((((size) / (erase_size)) + 31) / 32) * sizeof(uint32_t)))
+
+/**
+ * \brief һҪ飨Ԫ
+ *
+ * бӳпλͼ־ϢĥĽȣʱ
+ * Чɨÿһ飬Ӷ̹ʱ䡣λ FTL 
+ * ĩβ
+ *
+ * \param[in] size           : 洢
+ * \param[in] erase_size     : ԪС
+ * \param[in] logic_blk_size : ߼ĴС
+ * \param[in] nb_log_blocks  : ־
+ *
+ * \return ҪΪ am_ftl_info_t  ckpt_blocks ֵ
+ *         ʹøֵʱʹøԷɢ
+ */
+#define AM_FTL_CKPT_BLOCKS_GET(size, erase_size, logic_blk_size, nb_log_blocks) \
+   ((48                                                                      \
+     + ((size) / (erase_size) * 2) + 2                                       \
+     + (((((size) / (erase_size)) + 31) / 32) * sizeof(uint32_t))            \
+     + ((nb_log_blocks) * (8 + ((erase_size) / (logic_blk_size)) + 3))       \
+     + (erase_size) - 1) / (erase_size))
  
+/**
+ * \brief дػҪʹõڴ棨RAMռС
+ *
+ * \param[in] logic_blk_size : ߼ĴС
+ * \param[in] nb_items       : ߼
+ *
+ * \return дػҪʹõڴ棨RAMռС
+ */
+#define AM_FTL_CACHE_RAM_SIZE_GET(logic_blk_size, nb_items)                 \
+   (sizeof(void *)                                                           \
+     + ((nb_items) * (sizeof(struct am_ftl_cache_item) + (logic_blk_size))))
+
+/** \brief дػеһһ߼ */
+struct am_ftl_cache_item {
+    struct am_list_head  node;      /**< \brief LRU      */
+    uint32_t             lbn;       /**< \brief ߼     */
+    am_bool_t            dirty;     /**< \brief Ƿδд   */
+    uint8_t             *p_data;    /**< \brief ߼       */
+};
+
+/** \brief Ĳͳ */
+typedef struct am_ftl_wear_stats {
+    uint32_t  min;                  /**< \brief С     */
+    uint32_t  max;                  /**< \brief      */
+    uint32_t  mean;                 /**< \brief ƽ     */
+} am_ftl_wear_stats_t;
+
+/** \brief дػͳϢ */
+typedef struct am_ftl_cache_stat {
+    uint32_t  read_hits;            /**< \brief д       */
+    uint32_t  read_misses;          /**< \brief δд     */
+    uint32_t  write_hits;           /**< \brief дд       */
+    uint32_t  write_misses;         /**< \brief дδд     */
+    uint32_t  flushes;              /**< \brief дش洢߼ */
+} am_ftl_cache_stat_t;
+
 typedef struct am_ftl_info {
 
     /** \brief RAM    */
@@ -72,6 +182,22 @@ typedef struct am_ftl_info {
     /** \brief 飨Ԫʼļ齫ᱻʹ     */
     size_t     reserved_blocks;
 
+    /**
+     * \brief ʹõ飨ԪΪ 0 ʱʹü
+     *
+     * Ϊ 0 ʱС AM_FTL_CKPT_BLOCKS_GET() õֵЩ FTL
+     * ĩβ޸ĸֵ󣬴洢ԭеݽʧЧ
+     */
+    size_t     ckpt_blocks;
+
+    /**
+     * \brief ̬ĥֵΪ 0 ʱо̬ĥ
+     *
+     * ݿĲ֮ֵʱݿеݰ
+     * 飬ʹдһΪд 1% ң 1000
+     */
+    uint32_t   wl_threshold;
+
 } am_ftl_info_t ;
 
 
@@ -119,6 +245,72 @@ typedef struct am_ftl_serv {
     }*p_log_buf;
 
     const   am_ftl_info_t  *p_info;
+
+    /** \brief The number of checkpoint slots, 0 if checkpoint is disabled */
+    uint16_t        ckpt_nslots;
+
+    /** \brief The erase units of each checkpoint slot      */
+    uint16_t        ckpt_slot_units;
+
+    /** \brief The sequence number of the last checkpoint   */
+    uint32_t        ckpt_seq;
+
+    /** \brief The offset to write the next checkpoint      */
+    uint32_t        ckpt_pos;
+
+    /** \brief The offset of the valid checkpoint, 0xFFFFFFFF if stale */
+    uint32_t        ckpt_live;
+
+    /** \brief The max erase count of all blocks          */
+    uint32_t        wear_max;
+
+    /** \brief Erase count since the last wear leveling step */
+    uint32_t        wl_erases;
+
+    /** \brief The next block to check for wear leveling   */
+    uint16_t        wl_cursor;
+
+    /** \brief The coldest data block found in this pass    */
+    uint16_t        wl_cold_pbn;
+
+    /** \brief The erase count of the coldest data block    */
+    uint32_t        wl_cold_wear;
+
+    /** \brief The log buffer being merged in background, NULL if none */
+    struct log_buf *p_gc_log;
+
+    /** \brief The log buffer written last, not merged in background */
+    struct log_buf *p_gc_hot;
+
+    /** \brief The block the log buffer is merged into     */
+    uint16_t        gc_new_eun;
+
+    /** \brief The direct block of the log buffer being merged */
+    uint16_t        gc_direct_eun;
+
+    /** \brief The next sector to copy                     */
+    uint16_t        gc_sec;
+
+    /** \brief The state of the merge in background        */
+    uint8_t         gc_state;
+
+    /** \brief The sectors have been copied, a bit for each sector */
+    uint32_t        gc_copied[8];
+
+    /** \brief The cache items, the most recently used is the first */
+    struct am_list_head  cache_lru;
+
+    /** \brief The number of cache items, 0 if no cache      */
+    size_t               cache_num;
+
+    /** \brief The statistics of the cache                   */
+    am_ftl_cache_stat_t  cache_stat;
+
+    /** \brief The nesting count of operations in progress   */
+    volatile uint8_t     busy;
+
+    /** \brief Power is failing, write back the cache at once */
+    volatile am_bool_t   pwr_fail;
  
 } am_ftl_serv_t;
 
@@ -171,6 +363,173 @@ int am_ftl_write (am_ftl_handle_t handle, unsigned int lbn, void *p_buf);
  */
 int am_ftl_read (am_ftl_handle_t handle, unsigned int lbn, void *p_buf);
 
+/**
+ * \brief д߼
+ *
+ *  am_ftl_write() ȣдͬһλõ߼飨˳д룩
+ * ݼǩϢϲΪһ MTD д
+ *
+ * \param[in] handle : FTL ʵ
+ * \param[in] lbn    : ʼ߼
+ * \param[in] p_buf  : ݴŵĻΪ nblks ߼С
+ * \param[in] nblks  : ߼
+ *
+ * \retval  AM_OK     : дݳɹ
+ * \retval -AM_EINVAL : 
+ * \retval  < 0       : дʧܣ֮ǰ߼д
+ */
+int am_ftl_writev (am_ftl_handle_t  handle,
+                   unsigned int     lbn,
+                   const void      *p_buf,
+                   unsigned int     nblks);
+
+/**
+ * \brief ȡ߼
+ *
+ * λ߼ϲΪһζȡĲͨ am_mtd_readv() һύ
+ * ֧ʱһ SPI ɡ
+ *
+ * \param[in] handle : FTL ʵ
+ * \param[in] lbn    : ʼ߼
+ * \param[in] p_buf  : ݴŵĻΪ nblks ߼С
+ * \param[in] nblks  : ߼
+ *
+ * \retval  AM_OK     : ȡݳɹ
+ * \retval -AM_EINVAL : 
+ * \retval  < 0       : ȡʧ
+ */
+int am_ftl_readv (am_ftl_handle_t  handle,
+                  unsigned int     lbn,
+                  void            *p_buf,
+                  unsigned int     nblks);
+
+/**
+ * \brief 
+ *
+ * ӳпλͼ־Ϣ浽´ιʱֱӼأɨ
+ * 洢㱣κζԴ洢޸ĶʹʧЧӦڹػǰ
+ * ʱԵصøúжеãϴα޸ģֱӷء
+ * ʹдػ棬дػеݡ
+ *
+ * \param[in] handle : FTL ʵ
+ *
+ * \retval  AM_OK       : ɹ
+ * \retval -AM_EINVAL   : 
+ * \retval -AM_ENOTSUP  : δʹü㣨ckpt_blocks Ϊ 0
+ * \retval  < 0         : ʧ
+ */
+int am_ftl_checkpoint (am_ftl_handle_t handle);
+
+/**
+ * \brief ʼдػ
+ *
+ * ʹдػд߼ȱڻУ滻δʹõĻ滻
+ *  am_ftl_sync() ʱд洢Ƶдͬһ߼ʱɴٶԴ洢
+ * д롣ȡʱֻ滻δ޸ĵĻѳʼ棬ԭеݽдء
+ *
+ * \param[in] handle   : FTL ʵ
+ * \param[in] p_buf    : ʹõ RAM 
+ * \param[in] len      : ĳȣС AM_FTL_CACHE_RAM_SIZE_GET() õ
+ *                       ֵ
+ * \param[in] nb_items : ߼Ϊ 0 ʱʹû
+ *
+ * \retval  AM_OK     : ʼɹ
+ * \retval -AM_EINVAL : 
+ * \retval  < 0       : ԭедʧ
+ *
+ * \note δдصڵʱʧػǰӦ am_ftl_sync()ܹ⵽磬
+ *       ڵже am_ftl_power_fail()
+ */
+int am_ftl_cache_init (am_ftl_handle_t  handle,
+                       uint8_t         *p_buf,
+                       size_t           len,
+                       size_t           nb_items);
+
+/**
+ * \brief дػб޸ĵд洢
+ *
+ * \param[in] handle : FTL ʵ
+ *
+ * \retval  AM_OK     : дسɹδʹûʱֱӷسɹ
+ * \retval -AM_EINVAL : 
+ * \retval  < 0       : дʧ
+ */
+int am_ftl_sync (am_ftl_handle_t handle);
+
+/**
+ * \brief ֪ͨдػеݣ˺дݲٻ
+ *
+ * ڵжеáʱڶд FTLڸôζдʱдء
+ *
+ * \param[in] handle : FTL ʵ
+ *
+ * \return 
+ */
+void am_ftl_power_fail (am_ftl_handle_t handle);
+
+/**
+ * \brief ȡдػͳϢ
+ *
+ * \param[in]  handle : FTL ʵ
+ * \param[out] p_stat : ͳϢ
+ *
+ * \retval  AM_OK     : ȡɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_ftl_cache_stat_get (am_ftl_handle_t      handle,
+                           am_ftl_cache_stat_t *p_stat);
+
+/**
+ * \brief ȡĲͳ
+ *
+ * ȡÿĿϢʱϳӦƵá
+ *
+ * \param[in]  handle  : FTL ʵ
+ * \param[out] p_stats : ͳ
+ *
+ * \retval  AM_OK     : ȡɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EIO    : ȡϢʧ
+ */
+int am_ftl_wear_stats_get (am_ftl_handle_t      handle,
+                           am_ftl_wear_stats_t *p_stats);
+
+/**
+ * \brief ִһ̨ϲ
+ *
+ * ־ʱдͬϲһ־飨Ԫʱɴ
+ * ٺ롣ڿʱѭдУøúǰ־
+ * ֲϲ AM_FTL_GC_FREE_LOGS ־飬ϲ־飨
+ * AM_FTL_GC_LOG_SPAREʹдȴϲ
+ * ÿһิ AM_FTL_GC_STEP_SECTORS ߼һ顣
+ *
+ * ϲдںϲ߼飬δĺϲѸɻ־
+ * ɺϲǰɺϲ
+ *
+ * ʹõķ
+ * \code
+ * static am_jobq_job_t __g_ftl_gc_job;
+ *
+ * static void __ftl_gc_job (void *p_arg)
+ * {
+ *     if (am_ftl_gc_step((am_ftl_handle_t)p_arg) > 0) {
+ *         am_jobq_post(jobq_handle, &__g_ftl_gc_job);   // ϲٴμ
+ *     }
+ * }
+ *
+ * am_jobq_job_init(&__g_ftl_gc_job, __ftl_gc_job, ftl_handle, 0);
+ * am_jobq_post(jobq_handle, &__g_ftl_gc_job);           // дݺ
+ * \endcode
+ *
+ * \param[in] handle : FTL ʵ
+ *
+ * \retval  > 0       : һϲ
+ * \retval  0         : ϲ
+ * \retval -AM_EINVAL : 
+ * \retval  < 0       : ϲʧ
+ */
+int am_ftl_gc_step (am_ftl_handle_t handle);
+
 /**
  * \brief ʼ NVRAM ܣԱʹNVRAMӿڷʴ洢
  *
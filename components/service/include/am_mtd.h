@@ -18,6 +18,7 @@
  *
  * \internal
  * \par modification history:
+ * - 26-10-18 lgg, add vectored read and write.
  * - 15-09-15 tee, first implementation.
  * \endinternal
  */
@@ -109,6 +110,13 @@ struct am_mtd_erase_info {
     enum am_mtd_erase_status    state;
 };
 
+/** \brief ɢ/ۼдݶ */
+typedef struct am_mtd_iovec {
+    uint32_t            addr;            /**< \brief ݶε׵ַ     */
+    void               *p_buf;           /**< \brief ݶεĻ     */
+    uint32_t            len;             /**< \brief ݶεĳ       */
+} am_mtd_iovec_t;
+
 /** \brief MTD driver operations */
 struct am_mtd_ops {
     
@@ -126,6 +134,16 @@ struct am_mtd_ops {
                           uint32_t            addr,
                           const void         *p_buf,
                           uint32_t            len);
+
+    /** \brief ɢݺΪ NULLʱεöݺ */
+    int (*pfn_mtd_readv)  (void                 *p_drv,
+                           const am_mtd_iovec_t *p_iov,
+                           unsigned int          iovcnt);
+
+    /** \brief ۼдݺΪ NULLʱεдݺ */
+    int (*pfn_mtd_writev) (void                 *p_drv,
+                           const am_mtd_iovec_t *p_iov,
+                           unsigned int          iovcnt);
 };
 
 /** 
@@ -227,6 +245,43 @@ int am_mtd_write (am_mtd_handle_t     handle,
                   const void         *p_buf,
                   uint32_t            len);
 
+/**
+ * \brief ɢȡݣζȡݶ
+ *
+ * ṩ˷ɢݶνһɣַݶһ
+ * SPI жȡַͻݶκϲΪһζȡ
+ *
+ * \param[in] handle : MTD׼豸ʵľ
+ * \param[in] p_iov  : ݶ
+ * \param[in] iovcnt : ݶεĸ
+ *
+ * \retval  AM_OK      : ȡɹ
+ * \retval -AM_EINVAL  : 
+ * \retval         : ȡʧ
+ */
+int am_mtd_readv (am_mtd_handle_t         handle,
+                  const am_mtd_iovec_t   *p_iov,
+                  unsigned int            iovcnt);
+
+/**
+ * \brief ۼдݣдݶ
+ *
+ * ṩ˾ۼд뺯ݶνһɣͬһҳеַ
+ * һαд룩ַͻݶκϲΪһд롣
+ *
+ * \param[in] handle : MTD׼豸ʵľ
+ * \param[in] p_iov  : ݶ
+ * \param[in] iovcnt : ݶεĸ
+ *
+ * \retval  AM_OK      : дɹ
+ * \retval -AM_EINVAL  : 
+ * \retval -AM_EROFS   : 豸д
+ * \retval         : дʧ
+ */
+int am_mtd_writev (am_mtd_handle_t         handle,
+                   const am_mtd_iovec_t   *p_iov,
+                   unsigned int            iovcnt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,8 @@
  *
  * \internal
  * \par modification history:
+ * - 1.03 26-10-18 lgg, keep handler list walks safe against unregistering.
+ * - 1.02 26-10-18 lgg, add queued asynchronous dispatch.
  * - 1.01 15-01-05 orz, move event configuration to aw_event_cfg.c.
  * - 1.00 14-06-05 orz, first implementation.
  * \endinternal
@@ -23,34 +25,109 @@
 #include "ametal.h"
 #include "am_event.h"
 #include "am_int.h"
+#include "am_isr_defer.h"
+#include <string.h>
+
+/*******************************************************************************
+  Local types
+*******************************************************************************/
+
+/*
+ * a walk of a handler list in progress, p_next is the next handler to call.
+ * Unlinking a handler moves p_next of every walk standing on it, so a walk
+ * never follows a handler it has already called or that has been removed.
+ */
+struct __event_walk {
+    am_event_handler_t  *p_next;
+    struct __event_walk *p_outer;        /* the walk this one interrupted */
+};
+
+/*******************************************************************************
+  Local variables
+*******************************************************************************/
+
+/* the innermost walk in progress, walks nest like interrupts */
+static struct __event_walk *__gp_event_walk;
+
+/* queue and worker of the asynchronous dispatch */
+static struct __event_async {
+    am_event_msg_t     *p_msgs;         /* message buffer */
+    size_t              nmsgs;          /* capacity */
+    size_t              in;             /* next slot to write */
+    size_t              out;            /* next slot to read */
+    size_t              count;          /* queued messages */
+    uint32_t            dropped;        /* messages dropped, queue full */
+    am_jobq_handle_t    jobq;           /* worker queue, NULL: isr defer */
+    am_jobq_job_t       job;            /* worker on jobq */
+    am_isr_defer_job_t  defer_job;      /* worker on isr defer */
+} __g_event_async;
 
 /*******************************************************************************
   Local functions
 *******************************************************************************/
 
-/* go through an event handler list and call each handler functions */
+/* unlink a handler from a list, must be called with the lock held */
+static int __event_handler_unlink (am_event_handler_t **pp_head,
+                                   am_event_handler_t  *p_handler)
+{
+    am_event_handler_t  *prev;
+    am_event_handler_t  *hdlr;
+    struct __event_walk *p_walk;
+
+    prev = container_of(pp_head, am_event_handler_t, p_next);
+
+    for (hdlr = *pp_head; NULL != hdlr; prev = hdlr, hdlr = hdlr->p_next) {
+        if (hdlr == p_handler) {
+            break;
+        }
+    }
+
+    if (NULL == hdlr) {
+        return -AM_ENODEV;
+    }
+
+    prev->p_next = p_handler->p_next;
+
+    for (p_walk = __gp_event_walk; NULL != p_walk; p_walk = p_walk->p_outer) {
+        if (p_walk->p_next == p_handler) {
+            p_walk->p_next = p_handler->p_next;
+        }
+    }
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+/*
+ * go through an event handler list and call each handler functions, must be
+ * called with the lock held. An auto-unregister handler is unlinked before it
+ * is called, so it may register itself again in its handler function.
+ */
 static void __event_handler_process (am_event_handler_t **pp_head,
                                      am_event_type_t     *p_event,
                                      void                *p_evt_data)
 {
-    am_event_handler_t *p_next, *p_handler;
+    struct __event_walk  walk;
+    am_event_handler_t  *p_handler;
 
-    for (p_handler = *pp_head; NULL != p_handler; p_handler = p_next) {
+    walk.p_next     = *pp_head;
+    walk.p_outer    = __gp_event_walk;
+    __gp_event_walk = &walk;
 
-        p_next = p_handler->p_next;   /* handlers may delete themselves */
+    while (NULL != (p_handler = walk.p_next)) {
 
-        if (NULL != p_handler->pfn_proc) {
-            p_handler->pfn_proc(p_event, p_evt_data, p_handler->p_data);
-        }
+        walk.p_next = p_handler->p_next;
 
         if (p_handler->flags & AM_EVENT_HANDLER_FLAG_AUTO_UNREG) {
-            /* the handler request to delete it's self */
-            p_handler->p_next = NULL; /* this handler point to NULL */
-            *pp_head          = p_next; /* previous handler pointer point to next */
-        } else {
-             pp_head = &p_handler->p_next; /* now this handler is 'previous' */
+            __event_handler_unlink(pp_head, p_handler);
+        }
+
+        if (NULL != p_handler->pfn_proc) {
+            p_handler->pfn_proc(p_event, p_evt_data, p_handler->p_data);
         }
     }
+
+    __gp_event_walk = walk.p_outer;
 }
 
 /******************************************************************************/
@@ -77,20 +154,10 @@ static int __event_raise (am_event_type_t *p_event, void *p_evt_data, int cat_on
 static int __event_handler_delete (am_event_handler_t **pp_head,
                                    am_event_handler_t  *p_handler)
 {
-    int                 ret  = -AM_ENODEV;
-    am_event_handler_t *prev = container_of(pp_head, am_event_handler_t, p_next);
-    am_event_handler_t *hdlr;
-
+    int ret;
     int key = am_int_cpu_lock();
 
-    for (hdlr = *pp_head; NULL != hdlr; prev = hdlr, hdlr = hdlr->p_next) {
-        if (hdlr == p_handler) {
-            prev->p_next      = p_handler->p_next;
-            p_handler->p_next = NULL;
-            ret               = AM_OK;
-            break;
-        }
-    }
+    ret = __event_handler_unlink(pp_head, p_handler);
 
     am_int_cpu_unlock(key);
 
@@ -121,6 +188,92 @@ static int __event_type_delete (am_event_type_t **pp_head,
     return ret;
 }
 
+/******************************************************************************/
+/*
+ * go through an event handler list with interrupts enabled. The lock is only
+ * held between two handler functions, the handler is not touched once its
+ * function is called, so it may be unregistered, registered again or reused
+ * meanwhile. A handler unregistered after it has been reached is still called.
+ */
+static void __event_handler_process_async (am_event_handler_t **pp_head,
+                                           am_event_type_t     *p_event,
+                                           void                *p_evt_data)
+{
+    struct __event_walk  walk;
+    am_event_handler_t  *p_handler;
+    am_event_function_t *pfn_proc;
+    void                *p_hdl_data;
+    int                  key;
+
+    key             = am_int_cpu_lock();
+    walk.p_next     = *pp_head;
+    walk.p_outer    = __gp_event_walk;
+    __gp_event_walk = &walk;
+
+    while (NULL != (p_handler = walk.p_next)) {
+
+        walk.p_next = p_handler->p_next;
+        pfn_proc    = p_handler->pfn_proc;
+        p_hdl_data  = p_handler->p_data;
+
+        if (p_handler->flags & AM_EVENT_HANDLER_FLAG_AUTO_UNREG) {
+            __event_handler_unlink(pp_head, p_handler);
+        }
+
+        am_int_cpu_unlock(key);
+
+        if (NULL != pfn_proc) {
+            pfn_proc(p_event, p_evt_data, p_hdl_data);
+        }
+
+        key = am_int_cpu_lock();
+    }
+
+    __gp_event_walk = walk.p_outer;
+    am_int_cpu_unlock(key);
+}
+
+/******************************************************************************/
+/* worker of the asynchronous dispatch, drains the queue */
+static void __event_async_work (void *p_arg)
+{
+    am_event_msg_t msg;
+    void          *p_data;
+    int            key;
+
+    (void)p_arg;
+
+    while (1) {
+
+        key = am_int_cpu_lock();
+
+        if (__g_event_async.count == 0) {
+            am_int_cpu_unlock(key);
+            break;
+        }
+
+        msg = __g_event_async.p_msgs[__g_event_async.out];
+        if (++__g_event_async.out == __g_event_async.nmsgs) {
+            __g_event_async.out = 0;
+        }
+        __g_event_async.count--;
+
+        am_int_cpu_unlock(key);
+
+        p_data = (msg.size != 0) ? (void *)msg.data : msg.p_data;
+
+        __event_handler_process_async(&msg.p_event->p_category->p_handler,
+                                      msg.p_event,
+                                      p_data);
+
+        if (!(msg.flags & AM_EVENT_PROC_FLAG_CAT_ONLY)) {
+            __event_handler_process_async(&msg.p_event->p_handler,
+                                          msg.p_event,
+                                          p_data);
+        }
+    }
+}
+
 /*******************************************************************************
   Public functions
 *******************************************************************************/
@@ -134,9 +287,131 @@ int am_event_raise (am_event_type_t *p_event, void *p_evt_data, int flags)
         return -AM_EINVAL;
     }
 
+    if (flags & AM_EVENT_PROC_FLAG_ASYNC) {
+        return am_event_raise_async(p_event, p_evt_data, 0, flags);
+    }
+
     return __event_raise(p_event, p_evt_data, cat_only);
 }
 
+/******************************************************************************/
+int am_event_async_init (am_event_msg_t   *p_msgs,
+                         size_t            nmsgs,
+                         am_jobq_handle_t  jobq,
+                         uint16_t          pri)
+{
+    int key;
+
+    if ((p_msgs == NULL) || (nmsgs == 0)) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+
+    __g_event_async.p_msgs  = p_msgs;
+    __g_event_async.nmsgs   = nmsgs;
+    __g_event_async.in      = 0;
+    __g_event_async.out     = 0;
+    __g_event_async.count   = 0;
+    __g_event_async.dropped = 0;
+    __g_event_async.jobq    = jobq;
+
+    if (jobq != NULL) {
+        am_jobq_job_init(&__g_event_async.job, __event_async_work, NULL, pri);
+    } else {
+        am_isr_defer_job_init(&__g_event_async.defer_job,
+                              __event_async_work,
+                              NULL,
+                              pri);
+    }
+
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_event_raise_async (am_event_type_t *p_event,
+                          const void      *p_evt_data,
+                          size_t           size,
+                          int              flags)
+{
+    am_event_msg_t *p_msg;
+    int             key;
+    int             ret;
+
+    if ((p_event == NULL) || (size > AM_EVENT_ASYNC_DATA_SIZE)) {
+        return -AM_EINVAL;
+    }
+
+    /* asynchronous dispatch not initialized, process immediately */
+    if (__g_event_async.p_msgs == NULL) {
+        return __event_raise(p_event,
+                             (void *)p_evt_data,
+                             flags & AM_EVENT_PROC_FLAG_CAT_ONLY);
+    }
+
+    key = am_int_cpu_lock();
+
+    if (__g_event_async.count == __g_event_async.nmsgs) {
+        __g_event_async.dropped++;
+        am_int_cpu_unlock(key);
+        return -AM_ENOSPC;
+    }
+
+    p_msg          = &__g_event_async.p_msgs[__g_event_async.in];
+    p_msg->p_event = p_event;
+    p_msg->p_data  = (void *)p_evt_data;
+    p_msg->flags   = (uint16_t)flags;
+    p_msg->size    = (uint16_t)size;
+    if (size != 0) {
+        memcpy(p_msg->data, p_evt_data, size);
+    }
+
+    if (++__g_event_async.in == __g_event_async.nmsgs) {
+        __g_event_async.in = 0;
+    }
+    __g_event_async.count++;
+
+    am_int_cpu_unlock(key);
+
+    if (__g_event_async.jobq != NULL) {
+        ret = am_jobq_post(__g_event_async.jobq, &__g_event_async.job);
+    } else {
+        ret = am_isr_defer_job_add(&__g_event_async.defer_job);
+    }
+
+    /* -AM_EBUSY: the worker is already queued and will drain this message */
+    if ((ret == AM_OK) || (ret == -AM_EBUSY)) {
+        return AM_OK;
+    }
+
+    /*
+     * the worker can not be started (e.g. isr defer not initialized), take the
+     * message back so that it does not stay in the queue. Raises interrupting
+     * this one have failed the same way and taken their messages back already.
+     */
+    key = am_int_cpu_lock();
+
+    if ((__g_event_async.count != 0) &&
+        (p_msg == &__g_event_async.p_msgs[(__g_event_async.in == 0) ?
+                                          (__g_event_async.nmsgs - 1) :
+                                          (__g_event_async.in - 1)])) {
+        __g_event_async.in = p_msg - __g_event_async.p_msgs;
+        __g_event_async.count--;
+    }
+
+    am_int_cpu_unlock(key);
+
+    return ret;
+}
+
+/******************************************************************************/
+uint32_t am_event_async_dropped_get (void)
+{
+    return __g_event_async.dropped;
+}
+
 /******************************************************************************/
 int am_event_handler_register (am_event_type_t     *p_event,
                                am_event_handler_t  *p_handler)
@@ -15,6 +15,12 @@
  *
  * \internal
  * \par Modification history
+ * - 1.06 26-10-18  lgg, keep the wear leveling state across mounts.
+ * - 1.05 26-10-18  lgg, add multi-block read and write.
+ * - 1.04 26-10-18  lgg, add incremental merge in background.
+ * - 1.03 26-10-18  lgg, add static wear leveling and wear statistics.
+ * - 1.02 26-10-18  lgg, add write-back cache.
+ * - 1.01 26-10-18  lgg, add checkpoint of mapping table for fast mount.
  * - 1.00 16-08-23  tee, first implementation.
  * \endinternal
  */
@@ -66,6 +72,32 @@ struct __ftl_sci {
     uint8_t  locgic_sec1;       /* logic sector         */
 };
 
+#define __FTL_CKPT_MAGIC_NUM   0x3c59c4b7u
+
+#define __FTL_CKPT_NONE        0xFFFFFFFFu   /* no valid checkpoint */
+
+/* Checkpoint header (32 bytes), followed by the tables and wear info */
+struct __ftl_ckpt_hdr {
+    uint32_t      magic_num;        /* magic num   */
+    uint32_t      seq;              /* sequence number, the max is the newest */
+    uint32_t      len;              /* length of the checkpoint, with header  */
+    uint16_t      nb_blocks;        /* geometry, must be same as current      */
+    uint16_t      sectors_per_blk;
+    uint16_t      nb_log_blocks;
+    uint16_t      last_free;        /* free block with minimum wear info      */
+    uint32_t      logic_blk_size;
+    uint32_t      crc;              /* crc32 of header (before crc) and data  */
+    uint32_t      valid;            /* 0xFFFFFFFF: valid, 0: stale, no crc    */
+};
+
+/* Wear leveling state in the checkpoint (12 bytes) */
+struct __ftl_ckpt_wl {
+    uint32_t      erases;           /* erase count since the last step        */
+    uint32_t      cold_wear;        /* erase count of the coldest data block  */
+    uint16_t      cursor;           /* the next block to check                */
+    uint16_t      cold_pbn;         /* the coldest data block in this pass    */
+};
+
 /*******************************************************************************
     Local defines
 *******************************************************************************/
@@ -98,6 +130,38 @@ struct __ftl_sci {
     ((pbn + p_ftl->p_info->reserved_blocks) *      \
      (AM_MTD_ERASE_UNIT_SIZE_GET(p_ftl->mtd)))
 
+/* the checkpoint area is just after the last physical block */
+#define __FTL_CKPT_ADDR_GET(p_ftl, off) \
+    (__FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, p_ftl->nb_blocks) + (off))
+
+/* the address of the data of a sector */
+#define __FTL_DATA_ADDR_GET(p_ftl, pbn, sec)                    \
+    (__FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, pbn) +               \
+     ((sec) + p_ftl->sectors_hdr) * p_ftl->p_info->logic_blk_size)
+
+/* the address of the sector control information of a sector */
+#define __FTL_SCI_ADDR_GET(p_ftl, pbn, sec)                     \
+    (__FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, pbn) +               \
+     sizeof(struct __ftl_bci) + sizeof(struct __ftl_sci) * (sec))
+
+#define __FTL_CKPT_SLOT_SIZE_GET(p_ftl) \
+    ((uint32_t)p_ftl->ckpt_slot_units * AM_MTD_ERASE_UNIT_SIZE_GET(p_ftl->mtd))
+
+/*
+ * the state of the merge in background
+ */
+#define __FTL_GC_IDLE          0  /* no merge in progress                    */
+#define __FTL_GC_COPY_LOG      1  /* copy the sectors in log buffer          */
+#define __FTL_GC_COPY_DIRECT   2  /* copy the other sectors in direct block  */
+#define __FTL_GC_COMMIT        3  /* make the new block valid                */
+#define __FTL_GC_ERASE_DIRECT  4  /* erase the direct block                  */
+#define __FTL_GC_ERASE_LOG     5  /* erase the log buffer, then it's done    */
+#define __FTL_GC_ABORT         6  /* aborted, erase the new block            */
+
+/* the logic sector has been copied in the merge */
+#define __FTL_GC_COPIED(p_ftl, sec) \
+    ((p_ftl)->gc_copied[(sec) >> 5] & (1u << ((sec) & 0x1F)))
+
 /*******************************************************************************
     Local function declare
 *******************************************************************************/
@@ -118,10 +182,61 @@ static int __ftl_memcmpb (void *a, int c, int n)
     return 0;
 }
 
+/******************************************************************************/
+
+/* CRC-32 (poly 0x04C11DB7, reflected), a nibble table to save the ROM */
+static uint32_t __ftl_crc32 (uint32_t crc, const void *p_data, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    const uint8_t *p = (const uint8_t *)p_data;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc  = (crc >> 4) ^ table[crc & 0x0F];
+        crc  = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
 /*******************************************************************************
     The MTD base handle fuctions
 *******************************************************************************/
 
+/* the flash will be changed, make the checkpoint stale before that */
+static int __ftl_ckpt_invalidate (am_ftl_serv_t *p_ftl)
+{
+    uint32_t stale = 0;
+    int      ret;
+
+    if (p_ftl->ckpt_live == __FTL_CKPT_NONE) {
+        return 0;
+    }
+
+    ret = am_mtd_write(p_ftl->mtd,
+                       __FTL_CKPT_ADDR_GET(p_ftl, p_ftl->ckpt_live) +
+                       AM_OFFSET(struct __ftl_ckpt_hdr, valid),
+                       &stale,
+                       sizeof(stale));
+
+    if (ret < 0) {
+        AM_DBG_INFO("ftl: __ftl_ckpt_invalidate error, ret is: %d\n", ret);
+        return ret;
+    }
+
+    p_ftl->ckpt_live = __FTL_CKPT_NONE;
+
+    return 0;
+}
+
+/******************************************************************************/
+
 /* already consider the reserved blocks */
 static int __ftl_bci_read (am_ftl_serv_t    *p_ftl,
                            uint16_t          pbn,
@@ -157,6 +272,11 @@ static int __ftl_bci_write (am_ftl_serv_t    *p_ftl,
 
     addr = __FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, pbn);
 
+    ret = __ftl_ckpt_invalidate(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
     ret = am_mtd_write(p_ftl->mtd, addr, p_bci, sizeof(struct __ftl_bci));
 
     if (ret < sizeof(struct __ftl_bci)) {
@@ -210,6 +330,11 @@ static int __ftl_sci_write (am_ftl_serv_t    *p_ftl,
             sizeof(struct __ftl_bci) +
            (sizeof(struct __ftl_sci) * sec);
 
+    ret = __ftl_ckpt_invalidate(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
     ret = am_mtd_write(p_ftl->mtd, addr, p_sci, sizeof(struct __ftl_sci));
 
     if (ret < sizeof(struct __ftl_sci)) {
@@ -246,9 +371,15 @@ static int __ftl_data_write (am_ftl_serv_t     *p_ftl,
                              void              *p_buf)
 {
     size_t logic_blk_size = p_ftl->p_info->logic_blk_size;
+    int    ret;
 
     sec += p_ftl->sectors_hdr;     /* skip the header sectors for information */
 
+    ret = __ftl_ckpt_invalidate(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
     return am_mtd_write(p_ftl->mtd,
                         __FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, pbn) +
                         sec * logic_blk_size,
@@ -287,6 +418,11 @@ static int __ftl_block_erase (am_ftl_serv_t     *p_ftl,
 
     AM_DBG_INFO("Erase block : %d \n", pbn);
 
+    ret = __ftl_ckpt_invalidate(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
     ret = am_mtd_erase(p_ftl->mtd,
                        __FTL_PHY_BLOCK_START_ADDR_GET(p_ftl, pbn),
                        AM_MTD_ERASE_UNIT_SIZE_GET(p_ftl->mtd));
@@ -295,6 +431,11 @@ static int __ftl_block_erase (am_ftl_serv_t     *p_ftl,
         return ret;
     }
 
+    if (p_ftl->wear_max < wear_info) {
+        p_ftl->wear_max = wear_info;
+    }
+    p_ftl->wl_erases++;
+
     return __ftl_bci_write(p_ftl, pbn, &bci);
 }
 
@@ -356,6 +497,388 @@ static int __free_block_next_get (am_ftl_serv_t *p_ftl, uint16_t pbn)
     return -1;
 }
 
+/*******************************************************************************
+    Checkpoint manage
+*******************************************************************************/
+
+/* the length of a checkpoint, include the header */
+static uint32_t __ftl_ckpt_len (am_ftl_serv_t *p_ftl)
+{
+    return sizeof(struct __ftl_ckpt_hdr)
+           + AM_ROUND_UP(sizeof(uint16_t) * p_ftl->nb_blocks, 4)
+           + sizeof(uint32_t) * p_ftl->free_size
+           + sizeof(uint32_t)
+           + sizeof(struct __ftl_ckpt_wl)
+           + p_ftl->p_info->nb_log_blocks *
+             (sizeof(uint16_t) * 4 + AM_ROUND_UP(p_ftl->sectors_per_blk, 4));
+}
+
+/******************************************************************************/
+
+static void __ftl_ckpt_hdr_fill (am_ftl_serv_t         *p_ftl,
+                                 struct __ftl_ckpt_hdr *p_hdr)
+{
+    p_hdr->magic_num       = __FTL_CKPT_MAGIC_NUM;
+    p_hdr->seq             = p_ftl->ckpt_seq;
+    p_hdr->len             = __ftl_ckpt_len(p_ftl);
+    p_hdr->nb_blocks       = p_ftl->nb_blocks;
+    p_hdr->sectors_per_blk = p_ftl->sectors_per_blk;
+    p_hdr->nb_log_blocks   = p_ftl->p_info->nb_log_blocks;
+    p_hdr->last_free       = p_ftl->last_free;
+    p_hdr->logic_blk_size  = p_ftl->p_info->logic_blk_size;
+    p_hdr->crc             = 0;
+    p_hdr->valid           = __FTL_CKPT_NONE;
+}
+
+/******************************************************************************/
+
+/* read a part of the checkpoint, and update the crc */
+static int __ftl_ckpt_part_read (am_ftl_serv_t *p_ftl,
+                                 uint32_t       addr,
+                                 void          *p_buf,
+                                 uint32_t       len,
+                                 uint32_t      *p_crc)
+{
+    int ret = am_mtd_read(p_ftl->mtd, addr, p_buf, len);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    *p_crc = __ftl_crc32(*p_crc, p_buf, len);
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/*
+ * find the newest checkpoint (may be torn), return the offset of it, and the
+ * position to write next checkpoint is just after it
+ */
+static uint32_t __ftl_ckpt_scan (am_ftl_serv_t         *p_ftl,
+                                 struct __ftl_ckpt_hdr *p_hdr)
+{
+    struct __ftl_ckpt_hdr  hdr;
+
+    uint32_t  slot_size = __FTL_CKPT_SLOT_SIZE_GET(p_ftl);
+    uint32_t  newest    = __FTL_CKPT_NONE;
+    uint32_t  off, end;
+    int       i;
+
+    p_ftl->ckpt_seq = 0;
+    p_ftl->ckpt_pos = 0;
+
+    for (i = 0; i < p_ftl->ckpt_nslots; i++) {
+
+        off = i * slot_size;
+        end = off + slot_size;
+
+        /* the checkpoints are written one by one in a slot */
+        while (off + sizeof(hdr) <= end) {
+
+            if (am_mtd_read(p_ftl->mtd,
+                            __FTL_CKPT_ADDR_GET(p_ftl, off),
+                            &hdr,
+                            sizeof(hdr)) < 0) {
+                break;
+            }
+
+            if ((hdr.magic_num != __FTL_CKPT_MAGIC_NUM) ||
+                (hdr.len        < sizeof(hdr))          ||
+                (hdr.len        > end - off)) {
+                break;
+            }
+
+            if ((newest == __FTL_CKPT_NONE) || (hdr.seq > p_ftl->ckpt_seq)) {
+                newest          = off;
+                *p_hdr          = hdr;
+                p_ftl->ckpt_seq = hdr.seq;
+                p_ftl->ckpt_pos = off + hdr.len;
+            }
+
+            off += hdr.len;
+        }
+    }
+
+    return newest;
+}
+
+/******************************************************************************/
+
+/* load the newest checkpoint, it's only used if it's not stale */
+static int __ftl_ckpt_load (am_ftl_serv_t *p_ftl)
+{
+    struct __ftl_ckpt_hdr  hdr;
+    struct __ftl_ckpt_hdr  expect;
+    struct __ftl_ckpt_wl   wl;
+    uint16_t               log_info[4];
+
+    size_t    log_blocks = p_ftl->p_info->nb_log_blocks;
+    uint32_t  off, addr;
+    uint32_t  crc;
+    size_t    i;
+
+    p_ftl->ckpt_live = __FTL_CKPT_NONE;
+
+    if (p_ftl->ckpt_nslots == 0) {
+        return -1;
+    }
+
+    off = __ftl_ckpt_scan(p_ftl, &hdr);
+
+    /* The newest is stale (the older are also stale) or not found */
+    if ((off == __FTL_CKPT_NONE) || (hdr.valid != __FTL_CKPT_NONE)) {
+        AM_DBG_INFO("No valid checkpoint!\n");
+        return -1;
+    }
+
+    /* the geometry must not be changed */
+    __ftl_ckpt_hdr_fill(p_ftl, &expect);
+    if ((hdr.len             != expect.len)             ||
+        (hdr.nb_blocks       != expect.nb_blocks)       ||
+        (hdr.sectors_per_blk != expect.sectors_per_blk) ||
+        (hdr.nb_log_blocks   != expect.nb_log_blocks)   ||
+        (hdr.logic_blk_size  != expect.logic_blk_size)  ||
+        (hdr.last_free       >= p_ftl->nb_blocks)) {
+        AM_DBG_INFO("The checkpoint is mismatched!\n");
+        return -1;
+    }
+
+    crc  = __ftl_crc32(0, &hdr, AM_OFFSET(struct __ftl_ckpt_hdr, crc));
+    addr = __FTL_CKPT_ADDR_GET(p_ftl, off) + sizeof(hdr);
+
+    if (__ftl_ckpt_part_read(p_ftl,
+                             addr,
+                             p_ftl->p_eun_table,
+                             sizeof(uint16_t) * p_ftl->nb_blocks,
+                             &crc) < 0) {
+        return -1;
+    }
+    addr += AM_ROUND_UP(sizeof(uint16_t) * p_ftl->nb_blocks, 4);
+
+    if (__ftl_ckpt_part_read(p_ftl,
+                             addr,
+                             p_ftl->p_free,
+                             sizeof(uint32_t) * p_ftl->free_size,
+                             &crc) < 0) {
+        return -1;
+    }
+    addr += sizeof(uint32_t) * p_ftl->free_size;
+
+    if (__ftl_ckpt_part_read(p_ftl,
+                             addr,
+                             &p_ftl->wear_max,
+                             sizeof(uint32_t),
+                             &crc) < 0) {
+        return -1;
+    }
+    addr += sizeof(uint32_t);
+
+    if (__ftl_ckpt_part_read(p_ftl, addr, &wl, sizeof(wl), &crc) < 0) {
+        return -1;
+    }
+    addr += sizeof(wl);
+
+    for (i = 0; i < log_blocks; i++) {
+
+        if (__ftl_ckpt_part_read(p_ftl,
+                                 addr,
+                                 log_info,
+                                 sizeof(log_info),
+                                 &crc) < 0) {
+            return -1;
+        }
+        addr += sizeof(log_info);
+
+        p_ftl->p_log_buf[i].used = log_info[0];
+        p_ftl->p_log_buf[i].lbn  = log_info[1];
+        p_ftl->p_log_buf[i].pbn  = log_info[2];
+
+        if (__ftl_ckpt_part_read(p_ftl,
+                                 addr,
+                                 p_ftl->p_log_buf[i].p_map,
+                                 p_ftl->sectors_per_blk,
+                                 &crc) < 0) {
+            return -1;
+        }
+        addr += AM_ROUND_UP(p_ftl->sectors_per_blk, 4);
+    }
+
+    if (crc != hdr.crc) {
+        AM_DBG_INFO("The checkpoint crc error!\n");
+        return -1;
+    }
+
+    if ((wl.cursor    > p_ftl->nb_blocks) ||
+        ((wl.cold_pbn >= p_ftl->nb_blocks) &&
+         (wl.cold_pbn != __FTL_BLOCK_NIL))) {
+        AM_DBG_INFO("The checkpoint is mismatched!\n");
+        return -1;
+    }
+
+    /* the wear leveling goes on with the pass it was doing */
+    p_ftl->wl_erases    = wl.erases;
+    p_ftl->wl_cold_wear = wl.cold_wear;
+    p_ftl->wl_cursor    = wl.cursor;
+    p_ftl->wl_cold_pbn  = wl.cold_pbn;
+
+    p_ftl->last_free = hdr.last_free;
+    p_ftl->ckpt_live = off;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* write a part of the checkpoint */
+static int __ftl_ckpt_part_write (am_ftl_serv_t *p_ftl,
+                                  uint32_t      *p_addr,
+                                  const void    *p_buf,
+                                  uint32_t       len,
+                                  uint32_t       size)
+{
+    int ret = am_mtd_write(p_ftl->mtd, *p_addr, p_buf, len);
+
+    *p_addr += size;
+
+    return (ret < 0) ? ret : 0;
+}
+
+/******************************************************************************/
+
+static int __ftl_ckpt_save (am_ftl_serv_t *p_ftl)
+{
+    struct __ftl_ckpt_hdr  hdr;
+    struct __ftl_ckpt_wl   wl;
+    uint16_t               log_info[4];
+
+    size_t    log_blocks = p_ftl->p_info->nb_log_blocks;
+    uint32_t  slot_size  = __FTL_CKPT_SLOT_SIZE_GET(p_ftl);
+    uint32_t  pos        = p_ftl->ckpt_pos;
+    uint32_t  addr;
+    size_t    i;
+    int       ret;
+
+    p_ftl->ckpt_seq++;
+    __ftl_ckpt_hdr_fill(p_ftl, &hdr);
+
+    wl.erases    = p_ftl->wl_erases;
+    wl.cold_wear = p_ftl->wl_cold_wear;
+    wl.cursor    = p_ftl->wl_cursor;
+    wl.cold_pbn  = p_ftl->wl_cold_pbn;
+
+    /* no enough space in this slot, use the next slot */
+    if (((pos % slot_size) != 0) && ((pos % slot_size) + hdr.len > slot_size)) {
+        pos = (pos / slot_size + 1) * slot_size;
+    }
+
+    if (pos >= slot_size * p_ftl->ckpt_nslots) {
+        pos = 0;
+    }
+
+    /* the next position, even if failed */
+    p_ftl->ckpt_pos = pos + hdr.len;
+
+    /* use a new slot, erase it first */
+    if ((pos % slot_size) == 0) {
+        ret = am_mtd_erase(p_ftl->mtd,
+                           __FTL_CKPT_ADDR_GET(p_ftl, pos),
+                           slot_size);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    hdr.crc = __ftl_crc32(0, &hdr, AM_OFFSET(struct __ftl_ckpt_hdr, crc));
+    hdr.crc = __ftl_crc32(hdr.crc,
+                          p_ftl->p_eun_table,
+                          sizeof(uint16_t) * p_ftl->nb_blocks);
+    hdr.crc = __ftl_crc32(hdr.crc,
+                          p_ftl->p_free,
+                          sizeof(uint32_t) * p_ftl->free_size);
+    hdr.crc = __ftl_crc32(hdr.crc, &p_ftl->wear_max, sizeof(uint32_t));
+    hdr.crc = __ftl_crc32(hdr.crc, &wl, sizeof(wl));
+
+    for (i = 0; i < log_blocks; i++) {
+        log_info[0] = p_ftl->p_log_buf[i].used;
+        log_info[1] = p_ftl->p_log_buf[i].lbn;
+        log_info[2] = p_ftl->p_log_buf[i].pbn;
+        log_info[3] = 0xFFFF;
+
+        hdr.crc = __ftl_crc32(hdr.crc, log_info, sizeof(log_info));
+        hdr.crc = __ftl_crc32(hdr.crc,
+                              p_ftl->p_log_buf[i].p_map,
+                              p_ftl->sectors_per_blk);
+    }
+
+    /* header first, a torn checkpoint can be skipped with the length */
+    addr = __FTL_CKPT_ADDR_GET(p_ftl, pos);
+
+    ret = __ftl_ckpt_part_write(p_ftl, &addr, &hdr, sizeof(hdr), sizeof(hdr));
+
+    if (ret == 0) {
+        ret = __ftl_ckpt_part_write(
+                  p_ftl,
+                  &addr,
+                  p_ftl->p_eun_table,
+                  sizeof(uint16_t) * p_ftl->nb_blocks,
+                  AM_ROUND_UP(sizeof(uint16_t) * p_ftl->nb_blocks, 4));
+    }
+
+    if (ret == 0) {
+        ret = __ftl_ckpt_part_write(p_ftl,
+                                    &addr,
+                                    p_ftl->p_free,
+                                    sizeof(uint32_t) * p_ftl->free_size,
+                                    sizeof(uint32_t) * p_ftl->free_size);
+    }
+
+    if (ret == 0) {
+        ret = __ftl_ckpt_part_write(p_ftl,
+                                    &addr,
+                                    &p_ftl->wear_max,
+                                    sizeof(uint32_t),
+                                    sizeof(uint32_t));
+    }
+
+    if (ret == 0) {
+        ret = __ftl_ckpt_part_write(p_ftl, &addr, &wl, sizeof(wl), sizeof(wl));
+    }
+
+    for (i = 0; (ret == 0) && (i < log_blocks); i++) {
+        log_info[0] = p_ftl->p_log_buf[i].used;
+        log_info[1] = p_ftl->p_log_buf[i].lbn;
+        log_info[2] = p_ftl->p_log_buf[i].pbn;
+        log_info[3] = 0xFFFF;
+
+        ret = __ftl_ckpt_part_write(p_ftl,
+                                    &addr,
+                                    log_info,
+                                    sizeof(log_info),
+                                    sizeof(log_info));
+        if (ret == 0) {
+            ret = __ftl_ckpt_part_write(
+                      p_ftl,
+                      &addr,
+                      p_ftl->p_log_buf[i].p_map,
+                      p_ftl->sectors_per_blk,
+                      AM_ROUND_UP(p_ftl->sectors_per_blk, 4));
+        }
+    }
+
+    if (ret < 0) {
+        AM_DBG_INFO("ftl: __ftl_ckpt_save error, ret is: %d\n", ret);
+        return ret;
+    }
+
+    p_ftl->ckpt_live = pos;
+
+    AM_DBG_INFO("checkpoint %d saved at %d\n", hdr.seq, pos);
+
+    return 0;
+}
+
 /******************************************************************************/
 static int __ftl_mem_init (am_ftl_serv_t          *p_ftl,
                            uint8_t                *p_buf,
@@ -430,10 +953,12 @@ static int __ftl_init (am_ftl_serv_t *p_ftl)
     p_ftl->max_lbn         = ((p_ftl->nb_blocks
                                - 1
                                - p_info->reserved_blocks
-                               - p_info->nb_log_blocks)
+                               - p_info->nb_log_blocks
+                               - p_info->ckpt_blocks)
                               * p_ftl->sectors_per_blk) - 1;
 
-    p_ftl->nb_blocks       -= p_info->reserved_blocks;
+    /* the checkpoint blocks are at the end */
+    p_ftl->nb_blocks       -= p_info->reserved_blocks + p_info->ckpt_blocks;
 
 
     AM_DBG_INFO("The sectors hdr is %d \n", p_ftl->sectors_hdr);
@@ -447,6 +972,35 @@ static int __ftl_init (am_ftl_serv_t *p_ftl)
         return -1;
     }
 
+    p_ftl->ckpt_nslots     = 0;
+    p_ftl->ckpt_slot_units = 0;
+    p_ftl->ckpt_live       = __FTL_CKPT_NONE;
+
+    p_ftl->wear_max        = 0;
+    p_ftl->wl_erases       = 0;
+    p_ftl->wl_cursor       = 0;
+    p_ftl->wl_cold_pbn     = __FTL_BLOCK_NIL;
+    p_ftl->wl_cold_wear    = 0xFFFFFFFF;
+
+    p_ftl->p_gc_log        = NULL;
+    p_ftl->p_gc_hot        = NULL;
+    p_ftl->gc_state        = __FTL_GC_IDLE;
+
+    if (p_info->ckpt_blocks != 0) {
+
+        p_ftl->ckpt_slot_units = AM_DIV_ROUND_UP(
+                                     __ftl_ckpt_len(p_ftl),
+                                     AM_MTD_ERASE_UNIT_SIZE_GET(p_ftl->mtd));
+
+        p_ftl->ckpt_nslots     = p_info->ckpt_blocks / p_ftl->ckpt_slot_units;
+
+        if (p_ftl->ckpt_nslots == 0) {
+            AM_DBG_INFO("The ckpt_blocks (%d) is not enough\n",
+                        p_info->ckpt_blocks);
+            return -1;
+        }
+    }
+
     return 0;
 }
 
@@ -574,10 +1128,19 @@ static int __nfl_mount (am_ftl_serv_t *p_ftl)
     struct __ftl_bci  bci;
     struct __ftl_sci  sci;
 
+    /* with a valid checkpoint, no need to scan all the blocks */
+    if (__ftl_ckpt_load(p_ftl) == 0) {
+        AM_DBG_INFO("The checkpoint %d is loaded!\n", p_ftl->ckpt_seq);
+        return 0;
+    }
+
     /* after init, all block mask as free block */
     __free_block_init(p_ftl);
 
-    p_ftl->last_free = 0;
+    p_ftl->last_free    = 0;
+    p_ftl->wear_max     = 0;
+    p_ftl->wl_cold_pbn  = __FTL_BLOCK_NIL;
+    p_ftl->wl_cold_wear = 0xFFFFFFFF;
 
     for (i = 0; i < log_blocks; i++) {
         p_ftl->p_log_buf[i].lbn  = 0xFFFF;
@@ -603,6 +1166,10 @@ static int __nfl_mount (am_ftl_serv_t *p_ftl)
             continue;
         }
 
+        if (p_ftl->wear_max < bci.wear_info) {
+            p_ftl->wear_max = bci.wear_info;
+        }
+
         /* power failed, erase the block */
         if ((bci.lbn1  != bci.lbn2) ||
             ((bci.lbn1 != 0xFFFF) && (bci.lbn1 > max_lbn))) {
@@ -633,6 +1200,12 @@ static int __nfl_mount (am_ftl_serv_t *p_ftl)
                 }
                 p_ftl->p_eun_table[bci.lbn1] = i;
                 __free_block_set(p_ftl, i, 0);       /* mask it as not free */
+
+                /* the scan is also a pass of wear leveling */
+                if (bci.wear_info < p_ftl->wl_cold_wear) {
+                    p_ftl->wl_cold_pbn  = i;
+                    p_ftl->wl_cold_wear = bci.wear_info;
+                }
             }
 
         } else if (bci.type_log  == __FTL_BLOCK_TYPE_LOG) {
@@ -722,6 +1295,10 @@ static int __nfl_mount (am_ftl_serv_t *p_ftl)
 
     AM_DBG_INFO("last free is %d \n", p_ftl->last_free);
 
+    /* the pass is done, the coldest block is checked at the next write */
+    p_ftl->wl_cursor = p_ftl->nb_blocks;
+    p_ftl->wl_erases = AM_FTL_WL_PERIOD;
+
     return 0;
 }
 
@@ -937,70 +1514,381 @@ static int __ftl_log_buf_victim_normal (am_ftl_serv_t  *p_ftl,
 }
 
 /******************************************************************************/
-static int __ftl_log_buf_victim (am_ftl_serv_t *p_ftl, struct log_buf *p_log)
+
+/* the log buffer is full and in order, it can be switched to a data block */
+static am_bool_t __ftl_log_buf_switchable (am_ftl_serv_t  *p_ftl,
+                                           struct log_buf *p_log)
 {
     int i;
 
-    AM_DBG_INFO("try to victim the block, lbn(%d)->pbn(%d)\n", p_log->lbn, 
-                                                               p_log->pbn);
-
-    if (p_log->used == p_ftl->sectors_per_blk) {
+    if (p_log->used != p_ftl->sectors_per_blk) {
+        return AM_FALSE;
+    }
 
-        AM_DBG_INFO("The log buffer is full!\n");
+    AM_DBG_INFO("The log buffer is full!\n");
 
-        for (i = 0; i < p_ftl->sectors_per_blk; i++) {
-            if (p_log->p_map[i] != i) {
-                break;
-            }
+    for (i = 0; i < p_ftl->sectors_per_blk; i++) {
+        if (p_log->p_map[i] != i) {
+            return AM_FALSE;
         }
+    }
 
-        if (i == p_ftl->sectors_per_blk) {
-            return __ftl_log_buf_victim_switch(p_ftl, p_log);
-        }
+    return AM_TRUE;
+}
+
+/******************************************************************************/
+static int __ftl_log_buf_victim (am_ftl_serv_t *p_ftl, struct log_buf *p_log)
+{
+    AM_DBG_INFO("try to victim the block, lbn(%d)->pbn(%d)\n", p_log->lbn, 
+                                                               p_log->pbn);
+
+    if (__ftl_log_buf_switchable(p_ftl, p_log)) {
+        return __ftl_log_buf_victim_switch(p_ftl, p_log);
     }
 
     return __ftl_log_buf_victim_normal(p_ftl, p_log);
 }
 
-/******************************************************************************/
+/*******************************************************************************
+    Incremental merge in background
+*******************************************************************************/
+
 /*
- * Get the unit number into which we can write for this block.
- * Make it available if it isn't already
+ * The merge is the same as __ftl_log_buf_victim_normal(), but split into
+ * steps, so the flash is always in the same state as the merge interrupted by
+ * power failure. The sector map of the log buffer is kept for read, the copied
+ * sectors are marked in gc_copied instead.
  */
-static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
-                                 unsigned       lbn,
-                                 uint16_t      *p_pbn,
-                                 uint16_t      *p_sec)
-{
-    uint16_t this_vuc = lbn / p_ftl->sectors_per_blk;
-    uint16_t idx      = lbn % p_ftl->sectors_per_blk;
 
-    uint16_t write_eun;
-    int      i;
-    int      ret;
-    struct __ftl_bci  bci;
+/* copy a valid sector to the new block, if the logic sector isn't copied */
+static void __ftl_gc_sector_copy (am_ftl_serv_t *p_ftl,
+                                  uint16_t       eun,
+                                  uint16_t       sec)
+{
     struct __ftl_sci  sci;
+    uint16_t          logic_sec;
 
-    struct log_buf   *p_log_victim = NULL;
-    struct log_buf   *p_log_empty  = NULL;
-    uint8_t           log_num      = 0;
-    size_t            log_blocks   = p_ftl->p_info->nb_log_blocks;
+    if ((__ftl_sci_read(p_ftl, eun, sec, &sci) < 0)        ||
+        (sci.stat_start  != __FTL_SECTOR_STAT_START)       ||
+        (sci.stat_data   != __FTL_SECTOR_STAT_DATA)        ||
+        (sci.locgic_sec0 >= p_ftl->sectors_per_blk)        ||
+        __FTL_GC_COPIED(p_ftl, sci.locgic_sec0)) {
+        return;
+    }
 
+    logic_sec = sci.locgic_sec0;
 
-    if (p_ftl->p_eun_table[this_vuc] == 0xFFFF) {   /* no related blocks */
+    if (__ftl_data_read(p_ftl, eun, sec, p_ftl->p_wr_buf) < 0) {
+        return;
+    }
 
-        /* Try to find an already-free block */
-        write_eun  = __ftl_freeblock_find(p_ftl);
+    sci.stat_data = 0xFF;
+    __ftl_sci_write(p_ftl, p_ftl->gc_new_eun, logic_sec, &sci);
 
-        if (write_eun == 0xFFFF) {
-            return -1;
-        }
+    /* write the data */
+    __ftl_data_write(p_ftl, p_ftl->gc_new_eun, logic_sec, p_ftl->p_wr_buf);
 
-        AM_DBG_INFO("The new data block is %d .\n", write_eun);
+    /* make the data is valid */
+    sci.stat_data = __FTL_SECTOR_STAT_DATA;
+    __ftl_sci_write(p_ftl, p_ftl->gc_new_eun, logic_sec, &sci);
 
-        p_ftl->p_eun_table[this_vuc] = write_eun;
+    p_ftl->gc_copied[logic_sec >> 5] |= 1u << (logic_sec & 0x1F);
+}
 
-        /* tag the block is a data buffer */
+/******************************************************************************/
+
+/*
+ * Find the log buffer to merge: a nearly full one, it must be merged before
+ * all the following writes done, otherwise the most used one except the last
+ * written, if free log buffers are less than AM_FTL_GC_FREE_LOGS.
+ */
+static struct log_buf *__ftl_gc_victim_find (am_ftl_serv_t *p_ftl)
+{
+    struct log_buf *p_log      = NULL;
+    size_t          log_blocks = p_ftl->p_info->nb_log_blocks;
+    size_t          nb_free    = 0;
+    int             i;
+
+    for (i = 0; i < log_blocks; i++) {
+
+        if (p_ftl->p_log_buf[i].lbn == 0xFFFF) {
+            nb_free++;
+            continue;
+        }
+
+        /* nearly full, the following writes may need a merge */
+        if (p_ftl->p_log_buf[i].used + AM_FTL_GC_LOG_SPARE >=
+            p_ftl->sectors_per_blk) {
+            return &p_ftl->p_log_buf[i];
+        }
+
+        if ((&p_ftl->p_log_buf[i] != p_ftl->p_gc_hot) &&
+            ((p_log == NULL) || (p_log->used < p_ftl->p_log_buf[i].used))) {
+            p_log = &p_ftl->p_log_buf[i];
+        }
+    }
+
+    return (nb_free < AM_FTL_GC_FREE_LOGS) ? p_log : NULL;
+}
+
+/******************************************************************************/
+
+/* start to merge the log buffer, the new block is taken at once */
+static int __ftl_gc_start (am_ftl_serv_t *p_ftl, struct log_buf *p_log)
+{
+    struct __ftl_bci  bci;
+    uint16_t          new_eun;
+
+    /* Try to find an already-free block */
+    new_eun = __ftl_freeblock_find(p_ftl);
+
+    if (new_eun == 0xFFFF) {
+        return -1;
+    }
+
+    AM_DBG_INFO("merge lbn(%d) in background : %d -> %d\n", p_log->lbn,
+                                                             p_log->pbn,
+                                                             new_eun);
+
+    /* Save the lbn, it's invalid until lbn2 is set */
+    __ftl_bci_read(p_ftl, new_eun, &bci);
+    bci.lbn1 = p_log->lbn;
+    __ftl_bci_write(p_ftl, new_eun, &bci);
+
+    __free_block_set(p_ftl, new_eun, 0);      /* mask it not free */
+
+    memset(p_ftl->gc_copied, 0, sizeof(p_ftl->gc_copied));
+
+    p_ftl->p_gc_log      = p_log;
+    p_ftl->gc_new_eun    = new_eun;
+    p_ftl->gc_direct_eun = p_ftl->p_eun_table[p_log->lbn];
+    p_ftl->gc_sec        = p_log->used;
+    p_ftl->gc_state      = __FTL_GC_COPY_LOG;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* one step of merge, copy AM_FTL_GC_STEP_SECTORS sectors or erase a block */
+static void __ftl_gc_step (am_ftl_serv_t *p_ftl)
+{
+    struct log_buf   *p_log = p_ftl->p_gc_log;
+    struct __ftl_bci  bci;
+    int               i;
+
+    switch (p_ftl->gc_state) {
+
+    case __FTL_GC_COPY_LOG:         /* the newest sector first */
+        for (i = 0; (i < AM_FTL_GC_STEP_SECTORS) && (p_ftl->gc_sec > 0); i++) {
+            p_ftl->gc_sec--;
+            __ftl_gc_sector_copy(p_ftl, p_log->pbn, p_ftl->gc_sec);
+        }
+
+        if (p_ftl->gc_sec == 0) {
+            p_ftl->gc_state = (p_ftl->gc_direct_eun != 0xFFFF) ?
+                              __FTL_GC_COPY_DIRECT : __FTL_GC_COMMIT;
+        }
+        break;
+
+    case __FTL_GC_COPY_DIRECT:      /* the data havn't copy from log buffer */
+        for (i = 0; (i < AM_FTL_GC_STEP_SECTORS) &&
+                    (p_ftl->gc_sec < p_ftl->sectors_per_blk); i++) {
+            if (!__FTL_GC_COPIED(p_ftl, p_ftl->gc_sec)) {
+                __ftl_gc_sector_copy(p_ftl,
+                                     p_ftl->gc_direct_eun,
+                                     p_ftl->gc_sec);
+            }
+            p_ftl->gc_sec++;
+        }
+
+        if (p_ftl->gc_sec == p_ftl->sectors_per_blk) {
+            p_ftl->gc_state = __FTL_GC_COMMIT;
+        }
+        break;
+
+    case __FTL_GC_COMMIT:
+        __ftl_bci_read(p_ftl, p_ftl->gc_new_eun, &bci);
+
+        /* 1. copy done, set the type is copy  */
+        bci.type_copy = __FTL_BLOCK_TYPE_COPY;
+        __ftl_bci_write(p_ftl, p_ftl->gc_new_eun, &bci);
+
+        /* 2. set the lbn1 equal to lbn2, make it valid  */
+        bci.lbn1 = bci.lbn2 = p_log->lbn;
+        __ftl_bci_write(p_ftl, p_ftl->gc_new_eun, &bci);
+
+        /* the direct block will be erased, read from the new block */
+        p_ftl->p_eun_table[p_log->lbn] = p_ftl->gc_new_eun;
+
+        p_ftl->gc_state = __FTL_GC_ERASE_DIRECT;
+        break;
+
+    case __FTL_GC_ERASE_DIRECT:     /* 3.erase the directly buffer */
+        if (p_ftl->gc_direct_eun != 0xFFFF) {
+            if (__ftl_block_erase(p_ftl, p_ftl->gc_direct_eun) >= 0) {
+                __free_block_set(p_ftl, p_ftl->gc_direct_eun, 1);
+            }
+        }
+
+        p_ftl->gc_state = __FTL_GC_ERASE_LOG;
+        break;
+
+    case __FTL_GC_ERASE_LOG:        /* 4. erase the log buffer */
+        if (__ftl_block_erase(p_ftl, p_log->pbn) >= 0) {
+            __free_block_set(p_ftl, p_log->pbn, 1);
+        }
+
+        /* 5. set the new block to data block */
+        __ftl_bci_read(p_ftl, p_ftl->gc_new_eun, &bci);
+        bci.type_data = __FTL_BLOCK_TYPE_DATA;
+        __ftl_bci_write(p_ftl, p_ftl->gc_new_eun, &bci);
+
+        p_log->pbn      = 0xFFFF;
+        p_log->lbn      = 0xFFFF;
+        p_log->used     = 0;
+
+        memset(p_log->p_map, 0xFF, p_ftl->sectors_per_blk);
+
+        p_ftl->p_gc_log = NULL;
+        p_ftl->gc_state = __FTL_GC_IDLE;
+        break;
+
+    case __FTL_GC_ABORT:            /* lbn2 isn't set, it's invalid */
+        if (__ftl_block_erase(p_ftl, p_ftl->gc_new_eun) >= 0) {
+            __free_block_set(p_ftl, p_ftl->gc_new_eun, 1);
+        }
+
+        p_ftl->gc_state = __FTL_GC_IDLE;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/******************************************************************************/
+
+/* finish the merge in progress at once */
+static int __ftl_gc_finish (am_ftl_serv_t *p_ftl)
+{
+    while (p_ftl->gc_state != __FTL_GC_IDLE) {
+        __ftl_gc_step(p_ftl);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/*
+ * The logic block is to be written, if it's being merged, the copied data may
+ * be stale. Abort the merge if it's still copying, otherwise finish it, the
+ * full log buffer must be merged anyway.
+ */
+static int __ftl_gc_yield (am_ftl_serv_t *p_ftl, uint16_t lbn)
+{
+    if ((p_ftl->p_gc_log == NULL) || (p_ftl->p_gc_log->lbn != lbn)) {
+        return 0;
+    }
+
+    if ((p_ftl->gc_state >= __FTL_GC_COMMIT) ||
+        (p_ftl->p_gc_log->used == p_ftl->sectors_per_blk)) {
+        return __ftl_gc_finish(p_ftl);
+    }
+
+    AM_DBG_INFO("abort the merge of lbn(%d)\n", lbn);
+
+    p_ftl->p_gc_log = NULL;
+    p_ftl->gc_state = __FTL_GC_ABORT;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* one step of merge in background, return 1 if more steps needed */
+static int __ftl_gc_run (am_ftl_serv_t *p_ftl)
+{
+    struct log_buf *p_log;
+    int             ret;
+
+    if (p_ftl->gc_state != __FTL_GC_IDLE) {
+
+        __ftl_gc_step(p_ftl);
+
+    } else {
+
+        p_log = __ftl_gc_victim_find(p_ftl);
+
+        if (p_log == NULL) {
+            return 0;
+        }
+
+        /* only erase the direct block, no need to split */
+        if (__ftl_log_buf_switchable(p_ftl, p_log)) {
+            ret = __ftl_log_buf_victim_switch(p_ftl, p_log);
+        } else {
+            ret = __ftl_gc_start(p_ftl, p_log);
+        }
+
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    if ((p_ftl->gc_state != __FTL_GC_IDLE) ||
+        (__ftl_gc_victim_find(p_ftl) != NULL)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
+/*
+ * Get the unit number into which we can write for this block.
+ * Make it available if it isn't already
+ */
+static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
+                                 unsigned       lbn,
+                                 uint16_t      *p_pbn,
+                                 uint16_t      *p_sec)
+{
+    uint16_t this_vuc = lbn / p_ftl->sectors_per_blk;
+    uint16_t idx      = lbn % p_ftl->sectors_per_blk;
+
+    uint16_t write_eun;
+    int      i;
+    int      ret;
+    struct __ftl_bci  bci;
+    struct __ftl_sci  sci;
+
+    struct log_buf   *p_log_victim = NULL;
+    struct log_buf   *p_log_empty  = NULL;
+    uint8_t           log_num      = 0;
+    size_t            log_blocks   = p_ftl->p_info->nb_log_blocks;
+
+    /* the logic block may be being merged in background */
+    ret = __ftl_gc_yield(p_ftl, this_vuc);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (p_ftl->p_eun_table[this_vuc] == 0xFFFF) {   /* no related blocks */
+
+        /* Try to find an already-free block */
+        write_eun  = __ftl_freeblock_find(p_ftl);
+
+        if (write_eun == 0xFFFF) {
+            return -1;
+        }
+
+        AM_DBG_INFO("The new data block is %d .\n", write_eun);
+
+        p_ftl->p_eun_table[this_vuc] = write_eun;
+
+        /* tag the block is a data buffer */
         __ftl_bci_read(p_ftl, write_eun, &bci);
         bci.lbn1      = bci.lbn2 = this_vuc;
         bci.type_data = __FTL_BLOCK_TYPE_DATA;
@@ -1051,10 +1939,22 @@ static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
     if (i == log_blocks) {                   /* Can't find log buf */
 
         if (log_num == log_blocks) {         /* log buf is full    */
-            ret = __ftl_log_buf_victim(p_ftl, p_log_victim); /* victim use most */
+
+            /* the merge in background must be done, it frees one */
+            p_log_empty = p_ftl->p_gc_log;
+            ret         = __ftl_gc_finish(p_ftl);
             if (ret < 0) {
                 return ret;
             }
+
+            if (p_log_empty != NULL) {
+                p_log_victim = p_log_empty;
+            } else {
+                ret = __ftl_log_buf_victim(p_ftl, p_log_victim); /* use most */
+                if (ret < 0) {
+                    return ret;
+                }
+            }
         } else {                            /* not full */
             p_log_victim = p_log_empty;     /* such as victim the free log */
         }
@@ -1062,7 +1962,12 @@ static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
     } else {                                /* find the matched  */
 
         if (p_ftl->p_log_buf[i].used == p_ftl->sectors_per_blk) {    /* full */
-            ret = __ftl_log_buf_victim(p_ftl, &p_ftl->p_log_buf[i]); /* victim it  */
+
+            /* the new block taken by the merge in background is needed */
+            ret = __ftl_gc_finish(p_ftl);
+            if (ret >= 0) {
+                ret = __ftl_log_buf_victim(p_ftl, &p_ftl->p_log_buf[i]);
+            }
             if (ret < 0) {
                 return ret;
             }
@@ -1075,6 +1980,8 @@ static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
             *p_pbn = p_ftl->p_log_buf[i].pbn;
             *p_sec = p_ftl->p_log_buf[i].used++;
 
+            p_ftl->p_gc_hot = &p_ftl->p_log_buf[i];
+
             return 0;
         }
     }
@@ -1107,6 +2014,7 @@ static int __ftl_writeunit_find (am_ftl_serv_t *p_ftl,
     p_log_victim->p_map[0] = idx;
     p_log_victim->used     = 1;
 
+    p_ftl->p_gc_hot        = p_log_victim;
 
     *p_pbn = p_log_victim->pbn;
     *p_sec = 0;
@@ -1178,61 +2086,807 @@ static int __ftl_readunit_find (am_ftl_serv_t *p_ftl,
         }
     }
 
-    if (i < log_blocks) {   /* find it in log buffer */
-         for (j = p_ftl->p_log_buf[i].used - 1; j >= 0; j--) {
+    if (i < log_blocks) {   /* find it in log buffer */
+         for (j = p_ftl->p_log_buf[i].used - 1; j >= 0; j--) {
+
+             /* at start up, if the logic_sector error, the p_map[j] is 0xFF */
+             if (p_ftl->p_log_buf[i].p_map[j] == logic_sec) {
+
+                 /* It's valid */
+                 if (__ftl_readunit_check(p_ftl,
+                                          p_ftl->p_log_buf[i].pbn,
+                                          j) == 0) {
+
+                     *p_eun = p_ftl->p_log_buf[i].pbn;
+                     *p_sec = j;
+
+                     return 0;
+                 }
+             }
+         }
+    }
+
+    /* can't find it in log buffer, read out from directly buffer */
+    if (p_ftl->p_eun_table[logic_block] != 0xFFFF) {
+
+        /* It's valid */
+        if (__ftl_readunit_check(p_ftl,
+                                 p_ftl->p_eun_table[logic_block],
+                                 logic_sec) == 0) {        /* directly map */
+
+            *p_eun = p_ftl->p_eun_table[logic_block];
+            *p_sec = logic_sec;
+
+            return 0;
+        }
+    }
+
+    /* can't find it */
+    return -1;
+}
+
+/******************************************************************************/
+
+int __ftl_format_all (am_ftl_serv_t *p_ftl)
+{
+    unsigned int i;
+
+    for (i = 0; i < p_ftl->nb_blocks; i++) {
+        if (__ftl_block_erase(p_ftl, i) < 0) {
+            __free_block_set(p_ftl, i, 0);    /* mask it as not free */
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+    Static wear leveling
+*******************************************************************************/
+
+/* move a data block without log buffer to a free block, as the merge does */
+static int __ftl_data_block_move (am_ftl_serv_t *p_ftl, uint16_t lbn)
+{
+    int               i;
+    struct __ftl_bci  bci;
+    struct __ftl_sci  sci;
+    uint16_t          new_eun;
+    uint16_t          old_eun = p_ftl->p_eun_table[lbn];
+
+    /* Try to find an already-free block */
+    new_eun = __ftl_freeblock_find(p_ftl);
+
+    if (new_eun == 0xFFFF) {
+        return -1;
+    }
+
+    AM_DBG_INFO("move the cold block lbn(%d) : %d -> %d\n", lbn,
+                                                            old_eun,
+                                                            new_eun);
+
+    /* Save the lbn, it's invalid until lbn2 is set */
+    __ftl_bci_read(p_ftl, new_eun, &bci);
+    bci.lbn1 = lbn;
+    __ftl_bci_write(p_ftl, new_eun, &bci);
+
+    for (i = 0; i < p_ftl->sectors_per_blk; i++) {
+
+        /* only the valid data is copied */
+        if ((__ftl_readunit_check(p_ftl, old_eun, i) < 0) ||
+            (__ftl_data_read(p_ftl, old_eun, i, p_ftl->p_wr_buf) < 0)) {
+            continue;
+        }
+
+        memset(&sci, 0xFF, sizeof(struct __ftl_sci));
+
+        sci.stat_start  = __FTL_SECTOR_STAT_START;
+        sci.locgic_sec0 = sci.locgic_sec1 = i;
+        __ftl_sci_write(p_ftl, new_eun, i, &sci);
+
+        __ftl_data_write(p_ftl, new_eun, i, p_ftl->p_wr_buf);
+
+        sci.stat_data = __FTL_SECTOR_STAT_DATA;
+        __ftl_sci_write(p_ftl, new_eun, i, &sci);
+    }
+
+    /* 1. copy done, set the type is copy  */
+    bci.type_copy = __FTL_BLOCK_TYPE_COPY;
+    __ftl_bci_write(p_ftl, new_eun, &bci);
+
+    /* 2. set the lbn1 equal to lbn2, make it valid  */
+    bci.lbn1 = bci.lbn2 = lbn;
+    __ftl_bci_write(p_ftl, new_eun, &bci);
+
+    /* 3. erase the cold block, it will be used for hot data */
+    if (__ftl_block_erase(p_ftl, old_eun) >= 0) {
+        __free_block_set(p_ftl, old_eun, 1);    /* mask it free */
+    }
+
+    /* 4. set the new block to data block */
+    bci.type_data = __FTL_BLOCK_TYPE_DATA;
+    __ftl_bci_write(p_ftl, new_eun, &bci);
+
+    p_ftl->p_eun_table[lbn] = new_eun;          /* new relationship */
+
+    __free_block_set(p_ftl, new_eun, 0);        /* mask it not free */
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/*
+ * One step of static wear leveling, it's done every AM_FTL_WL_PERIOD erases.
+ * Check AM_FTL_WL_SCAN_STEP blocks to find the coldest data block, after all
+ * blocks checked, move the coldest one if the wear spread is too large. The
+ * full scan at mount is a pass too, and a checkpoint keeps the pass going,
+ * so the leveling is done even if the system is often reset.
+ */
+static int __ftl_wl_step (am_ftl_serv_t *p_ftl)
+{
+    struct __ftl_bci  bci;
+    uint16_t          pbn;
+    uint16_t          cold_pbn;
+    uint32_t          cold_wear;
+    size_t            log_blocks = p_ftl->p_info->nb_log_blocks;
+    int               i;
+
+    if ((p_ftl->p_info->wl_threshold == 0) ||
+        (p_ftl->wl_erases < AM_FTL_WL_PERIOD)) {
+        return 0;
+    }
+
+    p_ftl->wl_erases = 0;
+
+    for (i = 0; (i < AM_FTL_WL_SCAN_STEP) &&
+                (p_ftl->wl_cursor < p_ftl->nb_blocks); i++) {
+
+        pbn = p_ftl->wl_cursor++;
+
+        /* only the data block directly mapped, not free */
+        if (!(p_ftl->p_free[pbn >> 5] & (1 << (pbn & 0x1F)))  &&
+            (__ftl_bci_read(p_ftl, pbn, &bci) >= 0)             &&
+            (bci.magic_num            == __FTL_MAGIC_NUM)       &&
+            (bci.type_data            != 0xFF)                  &&
+            (bci.lbn1                  < p_ftl->nb_blocks)      &&
+            (p_ftl->p_eun_table[bci.lbn1] == pbn)               &&
+            (bci.wear_info             < p_ftl->wl_cold_wear)) {
+
+            p_ftl->wl_cold_pbn  = pbn;
+            p_ftl->wl_cold_wear = bci.wear_info;
+        }
+    }
+
+    if (p_ftl->wl_cursor < p_ftl->nb_blocks) {
+        return 0;
+    }
+
+    /* all blocks checked, start the next pass */
+    cold_pbn            = p_ftl->wl_cold_pbn;
+    cold_wear           = p_ftl->wl_cold_wear;
+    p_ftl->wl_cursor    = 0;
+    p_ftl->wl_cold_pbn  = __FTL_BLOCK_NIL;
+    p_ftl->wl_cold_wear = 0xFFFFFFFF;
+
+    if ((cold_pbn == __FTL_BLOCK_NIL) ||
+        (p_ftl->wear_max - cold_wear <= p_ftl->p_info->wl_threshold)) {
+        return 0;
+    }
+
+    /* the block may be changed in this pass */
+    if ((__ftl_bci_read(p_ftl, cold_pbn, &bci) < 0) ||
+        (bci.type_data                     == 0xFF) ||
+        (bci.lbn1                          >= p_ftl->nb_blocks) ||
+        (p_ftl->p_eun_table[bci.lbn1]      != cold_pbn)) {
+        return 0;
+    }
+
+    /* it's not cold if there is a log buffer */
+    for (i = 0; i < log_blocks; i++) {
+        if (p_ftl->p_log_buf[i].lbn == bci.lbn1) {
+            return 0;
+        }
+    }
+
+    return __ftl_data_block_move(p_ftl, bci.lbn1);
+}
+
+/******************************************************************************/
+
+/* read a logic block from the flash */
+static int __ftl_read (am_ftl_serv_t *p_ftl, unsigned int lbn, void *p_buf)
+{
+    uint16_t read_eun = 0xFFFF;
+    uint16_t read_sec = 0xFFFF;
+
+    /* find a space to read */
+    if (__ftl_readunit_find(p_ftl, lbn, &read_eun, &read_sec) >= 0) {
+
+        return __ftl_data_read(p_ftl, read_eun, read_sec, p_buf);
+
+    } else {
+        AM_DBG_INFO("Can't find the lbn %d to read!\n", lbn);
+    }
+
+    /* the requested block is not on the media, return all 0x00 */
+    memset(p_buf, 0, p_ftl->p_info->logic_blk_size);
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* write a logic block into the flash */
+static int __ftl_write (am_ftl_serv_t *p_ftl, unsigned int lbn, void *p_buf)
+{
+    uint16_t         write_eun;
+    uint16_t         write_sec;
+    struct __ftl_sci sci;
+
+    /* find a space to write */
+    if (__ftl_writeunit_find(p_ftl, lbn, &write_eun, &write_sec) < 0) {
+
+        AM_DBG_INFO("am_ftl_write(): Cannot find block to write to\n");
+
+        /* If we _still_ haven't got a block to use, we're screwed */
+        return -1;
+    }
+
+    AM_DBG_INFO("Write lbn %d to (%d, %d)!\n", lbn, write_eun, write_sec);
+
+    /* Set the TAG to __FTL_SECTOR_USED */
+    memset(&sci, 0xFF, sizeof(struct __ftl_sci));
+
+    sci.stat_start = __FTL_SECTOR_STAT_START;
+
+    /* the logic sector */
+    sci.locgic_sec0 = sci.locgic_sec1 = lbn % p_ftl->sectors_per_blk;
+
+    __ftl_sci_write(p_ftl, write_eun, write_sec, &sci);
+
+#if 0
+    /* check the data is 0xFF */
+    __ftl_data_read(p_ftl, write_eun, write_sec, p_ftl->p_wr_buf);
+
+    if (__ftl_memcmpb(p_ftl->p_wr_buf,
+                      0xFF,
+                      p_ftl->p_info->logic_blk_size) != 0) {
+        AM_DBG_INFO("The block is error ! write failed! \n");
+        while(1);
+    }
+#endif
+
+    __ftl_data_write(p_ftl, write_eun, write_sec, p_buf);
+
+    /* otherwise the data is invalid */
+    sci.stat_data = __FTL_SECTOR_STAT_DATA;
+    __ftl_sci_write(p_ftl, write_eun, write_sec, &sci);
+
+    __ftl_wl_step(p_ftl);
+
+    return 0;
+}
+
+/*******************************************************************************
+    Multi-block read and write
+*******************************************************************************/
+
+/* get the log buffer of the logic block, NULL if none */
+static struct log_buf *__ftl_log_buf_get (am_ftl_serv_t *p_ftl, uint16_t lbn)
+{
+    size_t log_blocks = p_ftl->p_info->nb_log_blocks;
+    int    i;
+
+    for (i = 0; i < log_blocks; i++) {
+        if (p_ftl->p_log_buf[i].lbn == lbn) {
+            return &p_ftl->p_log_buf[i];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************/
+
+/*
+ * Find the sector to read. If the logic block has no log buffer, the sector
+ * control information of the following sectors in the direct block are read at
+ * once, and used by the following calls, *p_nsci is the number of them left.
+ */
+static int __ftl_readunit_next (am_ftl_serv_t    *p_ftl,
+                                unsigned int      lbn,
+                                unsigned int      nblks,
+                                struct __ftl_sci *p_sci,
+                                unsigned int     *p_nsci,
+                                uint16_t         *p_eun,
+                                uint16_t         *p_sec)
+{
+    uint16_t logic_block = lbn / p_ftl->sectors_per_blk;
+    uint16_t logic_sec   = lbn % p_ftl->sectors_per_blk;
+    uint16_t eun         = p_ftl->p_eun_table[logic_block];
+
+    if ((*p_nsci == 0) &&
+        (eun != 0xFFFF) &&
+        (__ftl_log_buf_get(p_ftl, logic_block) == NULL)) {
+
+        *p_nsci = p_ftl->sectors_per_blk - logic_sec;
+
+        if (*p_nsci > nblks) {
+            *p_nsci = nblks;
+        }
+
+        if (*p_nsci > AM_FTL_IOV_MAX) {
+            *p_nsci = AM_FTL_IOV_MAX;
+        }
+
+        if (am_mtd_read(p_ftl->mtd,
+                        __FTL_SCI_ADDR_GET(p_ftl, eun, logic_sec),
+                        p_sci,
+                        sizeof(struct __ftl_sci) * (*p_nsci)) < 0) {
+            *p_nsci = 0;
+        } else {
+            memmove(&p_sci[AM_FTL_IOV_MAX - *p_nsci],
+                    p_sci,
+                    sizeof(struct __ftl_sci) * (*p_nsci));
+        }
+    }
+
+    if (*p_nsci == 0) {
+        return __ftl_readunit_find(p_ftl, lbn, p_eun, p_sec);
+    }
+
+    p_sci = &p_sci[AM_FTL_IOV_MAX - (*p_nsci)--];
+
+    if ((p_sci->stat_start != __FTL_SECTOR_STAT_START) ||
+        (p_sci->stat_data  != __FTL_SECTOR_STAT_DATA)) {
+        return -1;
+    }
+
+    *p_eun = eun;
+    *p_sec = logic_sec;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* read nblks logic blocks, the contiguous sectors are read at once */
+static int __ftl_readv (am_ftl_serv_t *p_ftl,
+                        unsigned int   lbn,
+                        uint8_t       *p_buf,
+                        unsigned int   nblks)
+{
+    am_mtd_iovec_t   iov[AM_FTL_IOV_MAX];
+    struct __ftl_sci sci[AM_FTL_IOV_MAX];
+    unsigned int     nsci     = 0;
+    unsigned int     iovcnt   = 0;
+    size_t           blk_size = p_ftl->p_info->logic_blk_size;
+    uint16_t         read_eun;
+    uint16_t         read_sec;
+    uint32_t         addr;
+    int              ret;
+
+    for (; nblks > 0; nblks--, lbn++, p_buf += blk_size) {
+
+        if (__ftl_readunit_next(p_ftl,
+                                lbn,
+                                nblks,
+                                sci,
+                                &nsci,
+                                &read_eun,
+                                &read_sec) < 0) {
+
+            /* the requested block is not on the media, return all 0x00 */
+            memset(p_buf, 0, blk_size);
+            continue;
+        }
+
+        addr = __FTL_DATA_ADDR_GET(p_ftl, read_eun, read_sec);
+
+        /* follow the last segment both in flash and in the buffer */
+        if ((iovcnt != 0) &&
+            (iov[iovcnt - 1].addr + iov[iovcnt - 1].len == addr) &&
+            ((uint8_t *)iov[iovcnt - 1].p_buf + iov[iovcnt - 1].len == p_buf)) {
+            iov[iovcnt - 1].len += blk_size;
+            continue;
+        }
+
+        if (iovcnt == AM_FTL_IOV_MAX) {
+            ret = am_mtd_readv(p_ftl->mtd, iov, iovcnt);
+            if (ret < 0) {
+                return ret;
+            }
+            iovcnt = 0;
+        }
+
+        iov[iovcnt].addr  = addr;
+        iov[iovcnt].p_buf = p_buf;
+        iov[iovcnt].len   = blk_size;
+        iovcnt++;
+    }
+
+    return (iovcnt != 0) ? am_mtd_readv(p_ftl->mtd, iov, iovcnt) : 0;
+}
+
+/******************************************************************************/
+
+/*
+ * write the data into the contiguous sectors found, the same steps as
+ * __ftl_write(), but each step is done for all sectors at once
+ */
+static int __ftl_run_write (am_ftl_serv_t    *p_ftl,
+                            uint16_t          pbn,
+                            uint16_t          sec,
+                            struct __ftl_sci *p_sci,
+                            unsigned int      nsecs,
+                            const uint8_t    *p_buf)
+{
+    uint32_t     sci_addr = __FTL_SCI_ADDR_GET(p_ftl, pbn, sec);
+    uint32_t     sci_len  = sizeof(struct __ftl_sci) * nsecs;
+    uint32_t     data_len = p_ftl->p_info->logic_blk_size * nsecs;
+    unsigned int i;
+    int          ret;
+
+    ret = __ftl_ckpt_invalidate(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* 1. the sectors are being written */
+    ret = am_mtd_write(p_ftl->mtd, sci_addr, p_sci, sci_len);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* 2. write the data */
+    ret = am_mtd_write(p_ftl->mtd,
+                       __FTL_DATA_ADDR_GET(p_ftl, pbn, sec),
+                       p_buf,
+                       data_len);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* 3. make the data valid */
+    for (i = 0; i < nsecs; i++) {
+        p_sci[i].stat_data = __FTL_SECTOR_STAT_DATA;
+    }
+
+    ret = am_mtd_write(p_ftl->mtd, sci_addr, p_sci, sci_len);
+
+    return (ret < 0) ? ret : 0;
+}
+
+
+/******************************************************************************/
+
+/* write nblks logic blocks, the contiguous sectors are written at once */
+static int __ftl_writev (am_ftl_serv_t *p_ftl,
+                         unsigned int   lbn,
+                         const uint8_t *p_buf,
+                         unsigned int   nblks)
+{
+    struct __ftl_sci  sci[AM_FTL_IOV_MAX];
+    struct log_buf   *p_log;
+    size_t            blk_size  = p_ftl->p_info->logic_blk_size;
+    const uint8_t    *p_run     = p_buf;
+    unsigned int      run_secs  = 0;
+    uint16_t          run_eun   = 0xFFFF;
+    uint16_t          run_sec   = 0xFFFF;
+    uint16_t          write_eun;
+    uint16_t          write_sec;
+    int               ret       = 0;
+
+    for (; nblks > 0; nblks--, lbn++, p_buf += blk_size) {
+
+        /*
+         * The sectors found but not written may be moved by a merge. Write them
+         * before finding the next, if it's in another logic block, whose log
+         * buffer may victim the one of this, or the log buffer of this is full.
+         */
+        p_log = __ftl_log_buf_get(p_ftl, lbn / p_ftl->sectors_per_blk);
+
+        if ((run_secs != 0) &&
+            ((run_secs == AM_FTL_IOV_MAX)                               ||
+             (lbn % p_ftl->sectors_per_blk == 0)                        ||
+             ((p_log != NULL) && (p_log->used == p_ftl->sectors_per_blk)))) {
+
+            ret = __ftl_run_write(p_ftl,
+                                  run_eun,
+                                  run_sec,
+                                  sci,
+                                  run_secs,
+                                  p_run);
+            if (ret < 0) {
+                return ret;
+            }
+            run_secs = 0;
+        }
+
+        /* find a space to write */
+        if (__ftl_writeunit_find(p_ftl, lbn, &write_eun, &write_sec) < 0) {
+
+            AM_DBG_INFO("am_ftl_writev(): Cannot find block to write to\n");
+
+            ret = -1;
+            break;
+        }
+
+        /* not follow the last sector */
+        if ((run_secs != 0) &&
+            ((write_eun != run_eun) || (write_sec != run_sec + run_secs))) {
+
+            ret = __ftl_run_write(p_ftl,
+                                  run_eun,
+                                  run_sec,
+                                  sci,
+                                  run_secs,
+                                  p_run);
+            if (ret < 0) {
+                return ret;
+            }
+            run_secs = 0;
+        }
+
+        if (run_secs == 0) {
+            run_eun = write_eun;
+            run_sec = write_sec;
+            p_run   = p_buf;
+        }
+
+        memset(&sci[run_secs], 0xFF, sizeof(struct __ftl_sci));
+
+        sci[run_secs].stat_start  = __FTL_SECTOR_STAT_START;
+        sci[run_secs].locgic_sec0 = lbn % p_ftl->sectors_per_blk;
+        sci[run_secs].locgic_sec1 = sci[run_secs].locgic_sec0;
+        run_secs++;
+    }
+
+    /* the sectors found are written even if failed */
+    if (run_secs != 0) {
+        if (__ftl_run_write(p_ftl,
+                            run_eun,
+                            run_sec,
+                            sci,
+                            run_secs,
+                            p_run) < 0) {
+            ret = -1;
+        }
+    }
+
+    __ftl_wl_step(p_ftl);
+
+    return ret;
+}
+
+/*******************************************************************************
+    Write-back cache
+*******************************************************************************/
+
+/* find the cached logic block, and make it as the most recently used */
+static struct am_ftl_cache_item *__ftl_cache_find (am_ftl_serv_t *p_ftl,
+                                                   unsigned int   lbn)
+{
+    struct am_ftl_cache_item *p_item;
+
+    am_list_for_each_entry(p_item,
+                           &p_ftl->cache_lru,
+                           struct am_ftl_cache_item,
+                           node) {
+        if (p_item->lbn == lbn) {
+            am_list_move(&p_item->node, &p_ftl->cache_lru);
+            return p_item;
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************/
+
+static int __ftl_cache_item_flush (am_ftl_serv_t            *p_ftl,
+                                   struct am_ftl_cache_item *p_item)
+{
+    int ret;
+
+    if (!p_item->dirty) {
+        return 0;
+    }
+
+    ret = __ftl_write(p_ftl, p_item->lbn, p_item->p_data);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    p_item->dirty = AM_FALSE;
+    p_ftl->cache_stat.flushes++;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/*
+ * replace the least recently used item with the logic block, if clean_only is
+ * true, only the item haven't be modified can be replaced, *pp_item is NULL if
+ * there is no such item.
+ */
+static int __ftl_cache_alloc (am_ftl_serv_t             *p_ftl,
+                              unsigned int               lbn,
+                              am_bool_t                  clean_only,
+                              struct am_ftl_cache_item **pp_item)
+{
+    struct am_ftl_cache_item *p_item;
+    struct am_ftl_cache_item *p_victim = NULL;
+    int                       ret;
+
+    *pp_item = NULL;
+
+    /* the least recently used is the last one */
+    am_list_for_each_entry_reverse(p_item,
+                                   &p_ftl->cache_lru,
+                                   struct am_ftl_cache_item,
+                                   node) {
+        if (!clean_only || !p_item->dirty) {
+            p_victim = p_item;
+            break;
+        }
+    }
+
+    if (p_victim == NULL) {
+        return 0;
+    }
+
+    ret = __ftl_cache_item_flush(p_ftl, p_victim);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    p_victim->lbn = lbn;
+    am_list_move(&p_victim->node, &p_ftl->cache_lru);
+
+    *pp_item = p_victim;
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* read part of a logic block through the cache */
+static int __ftl_cache_read (am_ftl_serv_t *p_ftl,
+                             unsigned int   lbn,
+                             size_t         off,
+                             void          *p_buf,
+                             size_t         len)
+{
+    struct am_ftl_cache_item *p_item;
+    uint8_t                  *p_data;
+    int                       ret;
+
+    p_item = __ftl_cache_find(p_ftl, lbn);
+
+    if (p_item != NULL) {
+        p_ftl->cache_stat.read_hits++;
+        memcpy(p_buf, p_item->p_data + off, len);
+        return 0;
+    }
+
+    p_ftl->cache_stat.read_misses++;
+
+    /* don't write back the modified data while reading */
+    ret = __ftl_cache_alloc(p_ftl, lbn, AM_TRUE, &p_item);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    p_data = (p_item != NULL) ? p_item->p_data : p_ftl->p_wr_buf;
+
+    ret = __ftl_read(p_ftl, lbn, p_data);
+
+    if (ret < 0) {
+        if (p_item != NULL) {
+            p_item->lbn = 0xFFFFFFFF;
+        }
+        return ret;
+    }
+
+    memcpy(p_buf, p_data + off, len);
+
+    return 0;
+}
+
+/******************************************************************************/
+
+/* write part of a logic block into the cache */
+static int __ftl_cache_write (am_ftl_serv_t *p_ftl,
+                              unsigned int   lbn,
+                              size_t         off,
+                              const void    *p_buf,
+                              size_t         len)
+{
+    struct am_ftl_cache_item *p_item;
+    int                       ret;
+
+    p_item = __ftl_cache_find(p_ftl, lbn);
+
+    if (p_item != NULL) {
+        p_ftl->cache_stat.write_hits++;
+    } else {
+        p_ftl->cache_stat.write_misses++;
+
+        ret = __ftl_cache_alloc(p_ftl, lbn, AM_FALSE, &p_item);
 
-             /* at start up, if the logic_sector error, the p_map[j] is 0xFF */
-             if (p_ftl->p_log_buf[i].p_map[j] == logic_sec) {
+        if (ret < 0) {
+            return ret;
+        }
 
-                 /* It's valid */
-                 if (__ftl_readunit_check(p_ftl,
-                                          p_ftl->p_log_buf[i].pbn,
-                                          j) == 0) {
+        /* only part of the block is written, read the other part */
+        if (len != p_ftl->p_info->logic_blk_size) {
 
-                     *p_eun = p_ftl->p_log_buf[i].pbn;
-                     *p_sec = j;
+            ret = __ftl_read(p_ftl, lbn, p_item->p_data);
 
-                     return 0;
-                 }
-             }
-         }
+            if (ret < 0) {
+                p_item->lbn = 0xFFFFFFFF;
+                return ret;
+            }
+        }
     }
 
-    /* can't find it in log buffer, read out from directly buffer */
-    if (p_ftl->p_eun_table[logic_block] != 0xFFFF) {
+    memcpy(p_item->p_data + off, p_buf, len);
+    p_item->dirty = AM_TRUE;
 
-        /* It's valid */
-        if (__ftl_readunit_check(p_ftl,
-                                 p_ftl->p_eun_table[logic_block],
-                                 logic_sec) == 0) {        /* directly map */
+    return 0;
+}
 
-            *p_eun = p_ftl->p_eun_table[logic_block];
-            *p_sec = logic_sec;
+/******************************************************************************/
 
-            return 0;
+/* write back all the modified data, the older first */
+static int __ftl_cache_sync (am_ftl_serv_t *p_ftl)
+{
+    struct am_ftl_cache_item *p_item;
+    int                       ret = 0;
+    int                       err;
+
+    if (p_ftl->cache_num == 0) {
+        return 0;
+    }
+
+    am_list_for_each_entry_reverse(p_item,
+                                   &p_ftl->cache_lru,
+                                   struct am_ftl_cache_item,
+                                   node) {
+        err = __ftl_cache_item_flush(p_ftl, p_item);
+        if (err < 0) {
+            ret = err;
         }
     }
 
-    /* can't find it */
-    return -1;
+    return ret;
 }
 
 /******************************************************************************/
 
-int __ftl_format_all (am_ftl_serv_t *p_ftl)
+/* begin an operation, the cache can't be written back in power fail hook */
+static void __ftl_enter (am_ftl_serv_t *p_ftl)
 {
-    unsigned int i;
+    p_ftl->busy++;
+}
 
-    for (i = 0; i < p_ftl->nb_blocks; i++) {
-        if (__ftl_block_erase(p_ftl, i) < 0) {
-            __free_block_set(p_ftl, i, 0);    /* mask it as not free */
-        }
+/******************************************************************************/
+
+/* end an operation, write back the cache if power failed */
+static int __ftl_exit (am_ftl_serv_t *p_ftl, int ret)
+{
+    if ((--p_ftl->busy == 0) && p_ftl->pwr_fail) {
+        __ftl_cache_sync(p_ftl);
     }
 
-    return 0;
+    return ret;
 }
 
- 
 /*******************************************************************************
     Public fuctions
 *******************************************************************************/
@@ -1241,10 +2895,8 @@ int __ftl_format_all (am_ftl_serv_t *p_ftl)
 int am_ftl_read (am_ftl_handle_t handle, unsigned int lbn, void *p_buf)
 {
     am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+    int            ret;
 
-    uint16_t read_eun = 0xFFFF;
-    uint16_t read_sec = 0xFFFF;
- 
     if (handle == NULL) {
         return -1;
     }
@@ -1257,19 +2909,17 @@ int am_ftl_read (am_ftl_handle_t handle, unsigned int lbn, void *p_buf)
         return -1;
     }
 
-    /* find a space to read */
-    if (__ftl_readunit_find(p_ftl, lbn, &read_eun, &read_sec) >= 0) {
-
-        return __ftl_data_read(p_ftl, read_eun, read_sec, p_buf);
-
-    } else {
-        AM_DBG_INFO("Can't find the lbn %d to read!\n", lbn);
+    if (p_ftl->cache_num == 0) {
+        return __ftl_read(p_ftl, lbn, p_buf);
     }
 
-    /* the requested block is not on the media, return all 0x00 */
-    memset(p_buf, 0, p_ftl->p_info->logic_blk_size);
-
-    return 0;
+    __ftl_enter(p_ftl);
+    ret = __ftl_cache_read(p_ftl,
+                           lbn,
+                           0,
+                           p_buf,
+                           p_ftl->p_info->logic_blk_size);
+    return __ftl_exit(p_ftl, ret);
 }
 
 /******************************************************************************/
@@ -1277,10 +2927,7 @@ int am_ftl_read (am_ftl_handle_t handle, unsigned int lbn, void *p_buf)
 int am_ftl_write (am_ftl_handle_t handle, unsigned int lbn, void *p_buf)
 {
     am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
-
-    uint16_t         write_eun;
-    uint16_t         write_sec;
-    struct __ftl_sci sci;
+    int            ret;
 
     if (handle == NULL) {
         return -1;
@@ -1293,47 +2940,82 @@ int am_ftl_write (am_ftl_handle_t handle, unsigned int lbn, void *p_buf)
 
         return -1;
     }
- 
-    /* find a space to write */
-    if (__ftl_writeunit_find(p_ftl, lbn, &write_eun, &write_sec) < 0) {
 
-        AM_DBG_INFO("am_ftl_write(): Cannot find block to write to\n");
+    if (p_ftl->cache_num == 0) {
+        return __ftl_write(p_ftl, lbn, p_buf);
+    }
 
-        /* If we _still_ haven't got a block to use, we're screwed */
-        return -1;
+    __ftl_enter(p_ftl);
+    ret = __ftl_cache_write(p_ftl,
+                            lbn,
+                            0,
+                            p_buf,
+                            p_ftl->p_info->logic_blk_size);
+    return __ftl_exit(p_ftl, ret);
+}
+
+/******************************************************************************/
+int am_ftl_writev (am_ftl_handle_t  handle,
+                   unsigned int     lbn,
+                   const void      *p_buf,
+                   unsigned int     nblks)
+{
+    am_ftl_serv_t *p_ftl    = (am_ftl_serv_t *)handle;
+    const uint8_t *p_data   = (const uint8_t *)p_buf;
+    size_t         blk_size;
+    int            ret      = 0;
+
+    if ((handle == NULL) || (p_buf == NULL)) {
+        return -AM_EINVAL;
     }
 
-    AM_DBG_INFO("Write lbn %d to (%d, %d)!\n", lbn, write_eun, write_sec);
+    if ((lbn > p_ftl->max_lbn) || (nblks > p_ftl->max_lbn + 1 - lbn)) {
+        return -AM_EINVAL;
+    }
 
-    /* Set the TAG to __FTL_SECTOR_USED */
-    memset(&sci, 0xFF, sizeof(struct __ftl_sci));
+    if (p_ftl->cache_num == 0) {
+        return (nblks != 0) ? __ftl_writev(p_ftl, lbn, p_data, nblks) : 0;
+    }
 
-    sci.stat_start = __FTL_SECTOR_STAT_START;
+    blk_size = p_ftl->p_info->logic_blk_size;
 
-    /* the logic sector */
-    sci.locgic_sec0 = sci.locgic_sec1 = lbn % p_ftl->sectors_per_blk;
+    __ftl_enter(p_ftl);
+    for (; (ret == 0) && (nblks > 0); nblks--, lbn++, p_data += blk_size) {
+        ret = __ftl_cache_write(p_ftl, lbn, 0, p_data, blk_size);
+    }
+    return __ftl_exit(p_ftl, ret);
+}
 
-    __ftl_sci_write(p_ftl, write_eun, write_sec, &sci);
+/******************************************************************************/
+int am_ftl_readv (am_ftl_handle_t  handle,
+                  unsigned int     lbn,
+                  void            *p_buf,
+                  unsigned int     nblks)
+{
+    am_ftl_serv_t *p_ftl    = (am_ftl_serv_t *)handle;
+    uint8_t       *p_data   = (uint8_t *)p_buf;
+    size_t         blk_size;
+    int            ret      = 0;
 
-#if 0
-    /* check the data is 0xFF */
-    __ftl_data_read(p_ftl, write_eun, write_sec, p_ftl->p_wr_buf);
+    if ((handle == NULL) || (p_buf == NULL)) {
+        return -AM_EINVAL;
+    }
 
-    if (__ftl_memcmpb(p_ftl->p_wr_buf,
-                      0xFF,
-                      p_ftl->p_info->logic_blk_size) != 0) {
-        AM_DBG_INFO("The block is error ! write failed! \n");
-        while(1);
+    if ((lbn > p_ftl->max_lbn) || (nblks > p_ftl->max_lbn + 1 - lbn)) {
+        return -AM_EINVAL;
     }
-#endif
 
-    __ftl_data_write(p_ftl, write_eun, write_sec, p_buf);
+    if (p_ftl->cache_num == 0) {
+        return (nblks != 0) ? __ftl_readv(p_ftl, lbn, p_data, nblks) : 0;
+    }
 
-    /* otherwise the data is invalid */
-    sci.stat_data = __FTL_SECTOR_STAT_DATA;
-    __ftl_sci_write(p_ftl, write_eun, write_sec, &sci);
+    blk_size = p_ftl->p_info->logic_blk_size;
 
-    return 0;
+    __ftl_enter(p_ftl);
+    for (; (ret == 0) && (nblks > 0); nblks--, lbn++, p_data += blk_size) {
+        ret = __ftl_cache_read(p_ftl, lbn, 0, p_data, blk_size);
+    }
+    return __ftl_exit(p_ftl, ret);
 }
  
 /******************************************************************************/
@@ -1351,8 +3033,13 @@ am_ftl_handle_t am_ftl_init (am_ftl_serv_t          *p_ftl,
         return NULL;
     }
 
-    p_ftl->p_info = p_info;
-    p_ftl->mtd    = mtd_handle;
+    p_ftl->p_info    = p_info;
+    p_ftl->mtd       = mtd_handle;
+    p_ftl->cache_num = 0;
+    p_ftl->busy      = 0;
+    p_ftl->pwr_fail  = AM_FALSE;
+    am_list_head_init(&p_ftl->cache_lru);
+    memset(&p_ftl->cache_stat, 0, sizeof(p_ftl->cache_stat));
 
     /* initial the memory allocation */
     if (__ftl_init(p_ftl) < 0) {
@@ -1378,6 +3065,200 @@ am_ftl_handle_t am_ftl_init (am_ftl_serv_t          *p_ftl,
     return p_ftl;
 }
 
+/******************************************************************************/
+int am_ftl_checkpoint (am_ftl_handle_t handle)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+    int            ret;
+
+    if (handle == NULL) {
+        return -AM_EINVAL;
+    }
+
+    if (p_ftl->ckpt_nslots == 0) {
+        return -AM_ENOTSUP;
+    }
+
+    __ftl_enter(p_ftl);
+
+    /* the cached data should be saved first, the merge in progress too */
+    ret = __ftl_cache_sync(p_ftl);
+
+    if (ret == 0) {
+        ret = __ftl_gc_finish(p_ftl);
+    }
+
+    /* nothing changed since the last checkpoint */
+    if ((ret == 0) && (p_ftl->ckpt_live == __FTL_CKPT_NONE)) {
+        ret = __ftl_ckpt_save(p_ftl);
+    }
+
+    return __ftl_exit(p_ftl, ret);
+}
+
+/******************************************************************************/
+int am_ftl_gc_step (am_ftl_handle_t handle)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+
+    if (handle == NULL) {
+        return -AM_EINVAL;
+    }
+
+    __ftl_enter(p_ftl);
+
+    return __ftl_exit(p_ftl, __ftl_gc_run(p_ftl));
+}
+
+/******************************************************************************/
+int am_ftl_wear_stats_get (am_ftl_handle_t      handle,
+                           am_ftl_wear_stats_t *p_stats)
+{
+    am_ftl_serv_t    *p_ftl = (am_ftl_serv_t *)handle;
+    struct __ftl_bci  bci;
+    uint64_t          sum   = 0;
+    unsigned int      n     = 0;
+    unsigned int      i;
+    int               ret   = AM_OK;
+
+    if ((handle == NULL) || (p_stats == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    p_stats->min = 0xFFFFFFFF;
+    p_stats->max = 0;
+
+    __ftl_enter(p_ftl);
+
+    for (i = 0; i < p_ftl->nb_blocks; i++) {
+
+        if (__ftl_bci_read(p_ftl, i, &bci) < 0) {
+            ret = -AM_EIO;
+            break;
+        }
+
+        /* never used */
+        if (bci.magic_num != __FTL_MAGIC_NUM) {
+            continue;
+        }
+
+        if (p_stats->min > bci.wear_info) {
+            p_stats->min = bci.wear_info;
+        }
+        if (p_stats->max < bci.wear_info) {
+            p_stats->max = bci.wear_info;
+        }
+
+        sum += bci.wear_info;
+        n++;
+    }
+
+    if (n == 0) {
+        p_stats->min = 0;
+    }
+
+    p_stats->mean = (n != 0) ? (uint32_t)(sum / n) : 0;
+
+    return __ftl_exit(p_ftl, ret);
+}
+
+/******************************************************************************/
+int am_ftl_cache_init (am_ftl_handle_t  handle,
+                       uint8_t         *p_buf,
+                       size_t           len,
+                       size_t           nb_items)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+    uintptr_t      addr  = (uintptr_t)p_buf;
+    size_t         i;
+    int            ret;
+
+    struct am_ftl_cache_item *p_items;
+
+    if ((handle == NULL) || ((nb_items != 0) && (p_buf == NULL))) {
+        return -AM_EINVAL;
+    }
+
+    if (len < AM_FTL_CACHE_RAM_SIZE_GET(p_ftl->p_info->logic_blk_size,
+                                        nb_items)) {
+        return -AM_EINVAL;
+    }
+
+    /* write back the data in the old cache */
+    ret = __ftl_cache_sync(p_ftl);
+    if (ret < 0) {
+        return ret;
+    }
+
+    p_ftl->cache_num = 0;
+    am_list_head_init(&p_ftl->cache_lru);
+    memset(&p_ftl->cache_stat, 0, sizeof(p_ftl->cache_stat));
+
+    /* align with pointer */
+    addr    = (addr + sizeof(void *) - 1) & ~(uintptr_t)(sizeof(void *) - 1);
+    p_items = (struct am_ftl_cache_item *)addr;
+    addr   += sizeof(struct am_ftl_cache_item) * nb_items;
+
+    for (i = 0; i < nb_items; i++) {
+        p_items[i].lbn    = 0xFFFFFFFF;
+        p_items[i].dirty  = AM_FALSE;
+        p_items[i].p_data = (uint8_t *)addr;
+        addr             += p_ftl->p_info->logic_blk_size;
+
+        am_list_add_tail(&p_items[i].node, &p_ftl->cache_lru);
+    }
+
+    p_ftl->cache_num = nb_items;
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_ftl_sync (am_ftl_handle_t handle)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+
+    if (handle == NULL) {
+        return -AM_EINVAL;
+    }
+
+    __ftl_enter(p_ftl);
+    return __ftl_exit(p_ftl, __ftl_cache_sync(p_ftl));
+}
+
+/******************************************************************************/
+void am_ftl_power_fail (am_ftl_handle_t handle)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+
+    if (handle == NULL) {
+        return;
+    }
+
+    p_ftl->pwr_fail = AM_TRUE;
+
+    /* write back at once if idle, otherwise at the end of the operation */
+    if (p_ftl->busy == 0) {
+        __ftl_enter(p_ftl);
+        __ftl_exit(p_ftl, 0);
+    }
+}
+
+/******************************************************************************/
+int am_ftl_cache_stat_get (am_ftl_handle_t      handle,
+                           am_ftl_cache_stat_t *p_stat)
+{
+    am_ftl_serv_t *p_ftl = (am_ftl_serv_t *)handle;
+
+    if ((handle == NULL) || (p_stat == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    *p_stat = p_ftl->cache_stat;
+
+    return AM_OK;
+}
+
 /******************************************************************************/
 size_t am_ftl_max_lbn_get (am_ftl_serv_t *p_ftl)
 {
@@ -1408,6 +3289,11 @@ am_local int __ftl_nvram_program_data (am_ftl_serv_t        *p_ftl,
     uint16_t write_eun = 0xFFFF;
     uint16_t write_sec = 0xFFFF;
 
+    if (p_ftl->cache_num != 0) {
+        return (is_read) ? __ftl_cache_read(p_ftl, lbn, off, p_buf, len)
+                         : __ftl_cache_write(p_ftl, lbn, off, p_buf, len);
+    }
+
     if (len == lbn_size) {
 
         /* just right a logic block */
@@ -1535,15 +3421,37 @@ am_local int __ftl_nvram_rw (am_ftl_serv_t    *p_ftl,
     }
 
     ret = AM_OK;
-    ret = __ftl_nvram_program_data(p_ftl, start, p_buf, len_tmp, is_read);
 
-    if (ret < AM_OK) {
-        return -AM_EIO;
+    if (len_tmp != page) {
+        ret = __ftl_nvram_program_data(p_ftl, start, p_buf, len_tmp, is_read);
+
+        if (ret < AM_OK) {
+            return -AM_EIO;
+        }
+
+        len   -= len_tmp;
+        start += len_tmp;
+        p_buf += len_tmp;
     }
 
-    len   -= len_tmp;
-    start += len_tmp;
-    p_buf += len_tmp;
+    /* the whole blocks are read or written at once */
+    if ((len >= page) && (p_ftl->cache_num == 0)) {
+        len_tmp = AM_ROUND_DOWN(len, page);
+
+        if (is_read) {
+            ret = __ftl_readv(p_ftl, start / page, p_buf, len_tmp / page);
+        } else {
+            ret = __ftl_writev(p_ftl, start / page, p_buf, len_tmp / page);
+        }
+
+        if (ret < AM_OK) {
+            return -AM_EIO;
+        }
+
+        len   -= len_tmp;
+        start += len_tmp;
+        p_buf += len_tmp;
+    }
 
     /* write the rest data */
 
@@ -1571,7 +3479,11 @@ am_local int __ftl_nvram_get (void            *p_drv,
                               uint8_t         *p_buf,
                               int              len)
 {
-    return __ftl_nvram_rw(p_drv, offset, (uint8_t *)p_buf, len, AM_TRUE);
+    int ret;
+
+    __ftl_enter((am_ftl_serv_t *)p_drv);
+    ret = __ftl_nvram_rw(p_drv, offset, (uint8_t *)p_buf, len, AM_TRUE);
+    return __ftl_exit((am_ftl_serv_t *)p_drv, ret);
 }
 
 /******************************************************************************/
@@ -1582,7 +3494,11 @@ am_local int __ftl_nvram_set (void            *p_drv,
                               uint8_t         *p_buf,
                               int              len)
 {
-    return __ftl_nvram_rw(p_drv, offset, (uint8_t *)p_buf, len, AM_FALSE);
+    int ret;
+
+    __ftl_enter((am_ftl_serv_t *)p_drv);
+    ret = __ftl_nvram_rw(p_drv, offset, (uint8_t *)p_buf, len, AM_FALSE);
+    return __ftl_exit((am_ftl_serv_t *)p_drv, ret);
 }
 
 /******************************************************************************/
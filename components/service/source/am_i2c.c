@@ -16,6 +16,7 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.03 26-10-18  lgg, add asynchronous read/write.
  * - 1.02 15-10-27  tee, add the concept of message.
  * - 1.01 15-08-19  tee, modified some interface.
  * - 1.00 14-11-01  jon, first implementation.
@@ -35,22 +36,21 @@ static void __i2c_callback (void *p_arg)
 
 /******************************************************************************/
 
-static int __i2c_rw_sync (am_i2c_device_t *p_dev,
-                          uint32_t         sub_addr,
-                          uint8_t         *p_buf,
-                          uint32_t         nbytes,
-                          am_bool_t        is_read)
+/* /дϢ䣬ȴ */
+static int __i2c_rw_start (am_i2c_device_t *p_dev,
+                           uint32_t         sub_addr,
+                           uint8_t         *p_buf,
+                           uint32_t         nbytes,
+                           am_bool_t        is_read,
+                           am_i2c_async_t  *p_async,
+                           am_pfnvoid_t     pfn_complete,
+                           void            *p_arg)
 {
     uint16_t subaddr_len = AM_I2C_SUBADDR_LEN_GET(p_dev->dev_flags);
-    
-    am_i2c_transfer_t trans[3];
-    am_wait_t         trans_wait;
-    am_i2c_message_t  msg;
-    uint8_t           subaddr_buf[2];  /* ڴ2bytesڼӵַ */
-    int               ret;
-    
-    am_wait_init(&trans_wait);
-    
+
+    am_i2c_transfer_t *trans       = p_async->trans;
+    uint8_t           *subaddr_buf = p_async->subaddr_buf;
+
     /* if no sub address just send the data */
     if (subaddr_len == 0) {
         
@@ -61,7 +61,7 @@ static int __i2c_rw_sync (am_i2c_device_t *p_dev,
                        p_buf, 
                        nbytes);
         
-        am_i2c_mkmsg( &msg, &trans[0], 1, __i2c_callback, &trans_wait);
+        am_i2c_mkmsg(&p_async->msg, &trans[0], 1, pfn_complete, p_arg);
                        
                        
     } else {
@@ -101,10 +101,34 @@ static int __i2c_rw_sync (am_i2c_device_t *p_dev,
                        p_buf, 
                        nbytes);
         
-        am_i2c_mkmsg( &msg, &trans[0], 2, __i2c_callback, &trans_wait);
+        am_i2c_mkmsg(&p_async->msg, &trans[0], 2, pfn_complete, p_arg);
     }
     
-    ret = am_i2c_msg_start(p_dev->handle, &msg);
+    return am_i2c_msg_start(p_dev->handle, &p_async->msg);
+}
+
+/******************************************************************************/
+
+static int __i2c_rw_sync (am_i2c_device_t *p_dev,
+                          uint32_t         sub_addr,
+                          uint8_t         *p_buf,
+                          uint32_t         nbytes,
+                          am_bool_t        is_read)
+{
+    am_i2c_async_t    async;
+    am_wait_t         trans_wait;
+    int               ret;
+    
+    am_wait_init(&trans_wait);
+    
+    ret = __i2c_rw_start(p_dev,
+                         sub_addr,
+                         p_buf,
+                         nbytes,
+                         is_read,
+                         &async,
+                         __i2c_callback,
+                         &trans_wait);
     
     if (ret != AM_OK) {
         return ret;
@@ -112,7 +136,7 @@ static int __i2c_rw_sync (am_i2c_device_t *p_dev,
     
     am_wait_on(&trans_wait);
     
-    return msg.status;
+    return async.msg.status;
 }
 
 /******************************************************************************/
@@ -149,4 +173,58 @@ int am_i2c_read (am_i2c_device_t *p_dev,
                          AM_TRUE);
 }
 
+/******************************************************************************/
+
+/**
+ * \brief I2C asynchronous write operate
+ */
+int am_i2c_write_async (am_i2c_device_t *p_dev,
+                        uint32_t         sub_addr,
+                        const uint8_t   *p_buf,
+                        uint32_t         nbytes,
+                        am_i2c_async_t  *p_async,
+                        am_pfnvoid_t     pfn_complete,
+                        void            *p_arg)
+{
+    if ((p_dev == NULL) || (p_async == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    return __i2c_rw_start(p_dev,
+                          sub_addr,
+                          (void *)p_buf,
+                          nbytes,
+                          AM_FALSE,
+                          p_async,
+                          pfn_complete,
+                          p_arg);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief I2C asynchronous read operate
+ */
+int am_i2c_read_async (am_i2c_device_t *p_dev,
+                       uint32_t         sub_addr,
+                       uint8_t         *p_buf,
+                       uint32_t         nbytes,
+                       am_i2c_async_t  *p_async,
+                       am_pfnvoid_t     pfn_complete,
+                       void            *p_arg)
+{
+    if ((p_dev == NULL) || (p_async == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    return __i2c_rw_start(p_dev,
+                          sub_addr,
+                          p_buf,
+                          nbytes,
+                          AM_TRUE,
+                          p_async,
+                          pfn_complete,
+                          p_arg);
+}
+
 /* end of file */
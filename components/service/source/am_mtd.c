@@ -16,6 +16,7 @@
  *
  * \internal
  * \par modification history:
+ * - 26-10-18 lgg, add vectored read and write.
  * - 15-09-15 tee, first implementation,copy from amorks.
  * \endinternal
  */
@@ -28,6 +29,57 @@
 #include "string.h"
 #include "am_int.h"
 
+/*******************************************************************************
+  Local functions
+*******************************************************************************/
+
+/* check all the segments are in the device */
+static int __mtd_iov_check (am_mtd_handle_t         handle,
+                            const am_mtd_iovec_t   *p_iov,
+                            unsigned int            iovcnt)
+{
+    unsigned int i;
+
+    if ((handle == NULL) || ((p_iov == NULL) && (iovcnt != 0))) {
+        return -AM_EINVAL;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        if ((p_iov[i].addr > handle->size) ||
+            (p_iov[i].len  > (handle->size - p_iov[i].addr))) {
+            return -AM_EINVAL;
+        }
+    }
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+
+/*
+ * The number of segments from p_iov[0] contiguous both in the device and in
+ * the buffer, they can be read or written at once. The total length is
+ * returned by p_len.
+ */
+static unsigned int __mtd_iov_merge (const am_mtd_iovec_t   *p_iov,
+                                     unsigned int            iovcnt,
+                                     uint32_t               *p_len)
+{
+    unsigned int n   = 1;
+    uint32_t     len = p_iov[0].len;
+
+    while ((n < iovcnt) &&
+           (p_iov[n].addr  == p_iov[0].addr + len) &&
+           (p_iov[n].p_buf == (uint8_t *)p_iov[0].p_buf + len)) {
+        len += p_iov[n].len;
+        n++;
+    }
+
+    *p_len = len;
+
+    return n;
+}
+
 /*******************************************************************************
   Public functions
 *******************************************************************************/
@@ -121,4 +173,99 @@ int am_mtd_write (am_mtd_handle_t     handle,
     return handle->p_ops->pfn_mtd_write(handle->p_drv, addr, p_buf, len);
 }
 
+/******************************************************************************/
+int am_mtd_readv (am_mtd_handle_t         handle,
+                  const am_mtd_iovec_t   *p_iov,
+                  unsigned int            iovcnt)
+{
+    unsigned int i;
+    unsigned int n;
+    uint32_t     len;
+    int          ret;
+
+    ret = __mtd_iov_check(handle, p_iov, iovcnt);
+
+    if (ret != AM_OK) {
+        return ret;
+    }
+
+    if (!iovcnt) {
+        return AM_OK;
+    }
+
+    /* the driver can do it better, e.g. in one SPI transfer */
+    if (handle->p_ops->pfn_mtd_readv) {
+        return handle->p_ops->pfn_mtd_readv(handle->p_drv, p_iov, iovcnt);
+    }
+
+    for (i = 0; i < iovcnt; i += n) {
+
+        n = __mtd_iov_merge(&p_iov[i], iovcnt - i, &len);
+
+        if (!len) {
+            continue;
+        }
+
+        ret = handle->p_ops->pfn_mtd_read(handle->p_drv,
+                                          p_iov[i].addr,
+                                          p_iov[i].p_buf,
+                                          len);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_mtd_writev (am_mtd_handle_t         handle,
+                   const am_mtd_iovec_t   *p_iov,
+                   unsigned int            iovcnt)
+{
+    unsigned int i;
+    unsigned int n;
+    uint32_t     len;
+    int          ret;
+
+    ret = __mtd_iov_check(handle, p_iov, iovcnt);
+
+    if (ret != AM_OK) {
+        return ret;
+    }
+
+    if (!(handle->p_ops->pfn_mtd_write)         ||
+        !(handle->flags & AM_MTD_FLAG_WRITEABLE)) {
+        return -AM_EROFS;
+    }
+
+    if (!iovcnt) {
+        return AM_OK;
+    }
+
+    /* the driver can do it better, e.g. program a page at once */
+    if (handle->p_ops->pfn_mtd_writev) {
+        return handle->p_ops->pfn_mtd_writev(handle->p_drv, p_iov, iovcnt);
+    }
+
+    for (i = 0; i < iovcnt; i += n) {
+
+        n = __mtd_iov_merge(&p_iov[i], iovcnt - i, &len);
+
+        if (!len) {
+            continue;
+        }
+
+        ret = handle->p_ops->pfn_mtd_write(handle->p_drv,
+                                           p_iov[i].addr,
+                                           p_iov[i].p_buf,
+                                           len);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return AM_OK;
+}
+
 /* end of file */
@@ -16,6 +16,7 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.01 26-10-18  lgg, add asynchronous write/read.
  * - 1.00 14-11-01  jon, first implementation.
  * \endinternal
  */
@@ -35,67 +36,88 @@ static void __message_complete (void *p_arg)
 }
 
 /**
- * \brief д
+ * \brief ɵϢȴ
+ *
+ * Ϊ NULL 򳤶Ϊ 0 Ĵ䲻Ϣ
  */
-int am_spi_write_then_read (am_spi_device_t *p_dev,
-                            const uint8_t   *p_txbuf,
-                            size_t           n_tx,
-                            uint8_t         *p_rxbuf,
-                            size_t           n_rx)
+static int __spi_two_trans_start (am_spi_device_t *p_dev,
+                                  const uint8_t   *p_txbuf0,
+                                  uint8_t         *p_rxbuf0,
+                                  size_t           n0,
+                                  const uint8_t   *p_txbuf1,
+                                  uint8_t         *p_rxbuf1,
+                                  size_t           n1,
+                                  am_spi_async_t  *p_async,
+                                  am_pfnvoid_t     pfn_complete,
+                                  void            *p_arg)
 {
-    am_spi_transfer_t trans[2];
-    am_wait_t         msg_wait;
-    am_spi_message_t  spi_msg;
-    
-    if (p_dev == NULL) {
-        return -AM_EINVAL;
-    }
-    
-    if(p_txbuf == NULL && p_rxbuf == NULL) {
-        return AM_OK;
-    }
+    am_spi_msg_init(&p_async->msg, pfn_complete, p_arg);
     
-    am_wait_init(&msg_wait);
-    
-    am_spi_msg_init(&spi_msg,
-                    __message_complete,
-                    (void *)&msg_wait);
-    
-    if ((p_txbuf != NULL) && (n_tx != 0)) {
+    if (((p_txbuf0 != NULL) || (p_rxbuf0 != NULL)) && (n0 != 0)) {
         
-        am_spi_mktrans(&trans[0], 
-                        p_txbuf,
-                        NULL,
-                        n_tx,
+        am_spi_mktrans(&p_async->trans[0], 
+                        p_txbuf0,
+                        p_rxbuf0,
+                        n0,
                         0,
                         0,
                         0,
                         0,
                         0);
         
-        am_spi_trans_add_tail(&spi_msg, &trans[0]);
+        am_spi_trans_add_tail(&p_async->msg, &p_async->trans[0]);
     }
     
-    if ((p_rxbuf != NULL) && (n_rx != 0)) {
+    if (((p_txbuf1 != NULL) || (p_rxbuf1 != NULL)) && (n1 != 0)) {
         
-        am_spi_mktrans(&trans[1], 
-                        NULL,
-                        p_rxbuf,
-                        n_rx,
+        am_spi_mktrans(&p_async->trans[1], 
+                        p_txbuf1,
+                        p_rxbuf1,
+                        n1,
                         0,
                         0,
                         0,
                         0,
                         0);
         
-        am_spi_trans_add_tail(&spi_msg, &trans[1]);
+        am_spi_trans_add_tail(&p_async->msg, &p_async->trans[1]);
+    }
+    
+    return am_spi_msg_start(p_dev, &p_async->msg);
+}
+
+/**
+ * \brief д
+ */
+int am_spi_write_then_read (am_spi_device_t *p_dev,
+                            const uint8_t   *p_txbuf,
+                            size_t           n_tx,
+                            uint8_t         *p_rxbuf,
+                            size_t           n_rx)
+{
+    am_spi_async_t    async;
+    am_wait_t         msg_wait;
+    
+    if (p_dev == NULL) {
+        return -AM_EINVAL;
+    }
+    
+    if(p_txbuf == NULL && p_rxbuf == NULL) {
+        return AM_OK;
     }
     
-    am_spi_msg_start(p_dev, &spi_msg);
+    am_wait_init(&msg_wait);
+    
+    __spi_two_trans_start(p_dev,
+                          p_txbuf, NULL, n_tx,
+                          NULL, p_rxbuf, n_rx,
+                          &async,
+                          __message_complete,
+                          (void *)&msg_wait);
     
     am_wait_on(&msg_wait);
 
-    return spi_msg.status;
+    return async.msg.status;
 }
 
 /**
@@ -107,9 +129,8 @@ int am_spi_write_then_write (am_spi_device_t *p_dev,
                              const uint8_t   *p_txbuf1,
                              size_t           n_tx1)
 {
-    am_spi_transfer_t trans[2];
+    am_spi_async_t    async;
     am_wait_t         msg_wait;
-    am_spi_message_t  spi_msg;
     
     if (p_dev == NULL) {
         return -AM_EINVAL;
@@ -121,45 +142,64 @@ int am_spi_write_then_write (am_spi_device_t *p_dev,
     
     am_wait_init(&msg_wait);
     
-    am_spi_msg_init(&spi_msg,
-                    __message_complete,
-                    (void *)&msg_wait);
+    __spi_two_trans_start(p_dev,
+                          p_txbuf0, NULL, n_tx0,
+                          p_txbuf1, NULL, n_tx1,
+                          &async,
+                          __message_complete,
+                          (void *)&msg_wait);
     
-    if ((p_txbuf0 != NULL) && (n_tx0 != 0)) {
-        
-        am_spi_mktrans(&trans[0], 
-                        p_txbuf0,
-                        NULL,
-                        n_tx0,
-                        0,
-                        0,
-                        0,
-                        0,
-                        0);
-        
-        am_spi_trans_add_tail(&spi_msg, &trans[0]);
+    am_wait_on(&msg_wait);
+
+    return async.msg.status;
+}
+
+/**
+ * \brief 첽д
+ */
+int am_spi_write_then_read_async (am_spi_device_t *p_dev,
+                                  const uint8_t   *p_txbuf,
+                                  size_t           n_tx,
+                                  uint8_t         *p_rxbuf,
+                                  size_t           n_rx,
+                                  am_spi_async_t  *p_async,
+                                  am_pfnvoid_t     pfn_complete,
+                                  void            *p_arg)
+{
+    if ((p_dev == NULL) || (p_async == NULL)) {
+        return -AM_EINVAL;
     }
-    
-    if ((p_txbuf1 != NULL) && (n_tx1 != 0)) {
-        
-        am_spi_mktrans(&trans[1], 
-                        p_txbuf1,
-                        NULL,
-                        n_tx1,
-                        0,
-                        0,
-                        0,
-                        0,
-                        0);
-        
-        am_spi_trans_add_tail(&spi_msg, &trans[1]);
+
+    return __spi_two_trans_start(p_dev,
+                                 p_txbuf, NULL, n_tx,
+                                 NULL, p_rxbuf, n_rx,
+                                 p_async,
+                                 pfn_complete,
+                                 p_arg);
+}
+
+/**
+ * \brief 첽ִд
+ */
+int am_spi_write_then_write_async (am_spi_device_t *p_dev,
+                                   const uint8_t   *p_txbuf0,
+                                   size_t           n_tx0,
+                                   const uint8_t   *p_txbuf1,
+                                   size_t           n_tx1,
+                                   am_spi_async_t  *p_async,
+                                   am_pfnvoid_t     pfn_complete,
+                                   void            *p_arg)
+{
+    if ((p_dev == NULL) || (p_async == NULL)) {
+        return -AM_EINVAL;
     }
-    
-    am_spi_msg_start(p_dev, &spi_msg);
-    
-    am_wait_on(&msg_wait);
 
-    return spi_msg.status;
+    return __spi_two_trans_start(p_dev,
+                                 p_txbuf0, NULL, n_tx0,
+                                 p_txbuf1, NULL, n_tx1,
+                                 p_async,
+                                 pfn_complete,
+                                 p_arg);
 }
 
 /* end of file */
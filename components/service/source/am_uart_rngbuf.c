@@ -16,6 +16,7 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.02 26-10-18  lgg, add am_uart_rngbuf_receive_async()
  * - 1.01 15-07-15  bob, add UART flowctrl mode
  * - 1.01 14-12-03  jon, add UART interrupt mode
  * - 1.00 14-11-01  tee, first implementation.
@@ -209,6 +210,42 @@ int am_uart_rngbuf_ioctl (am_uart_rngbuf_handle_t   handle,
     return ret;
 }
 
+/******************************************************************************/
+
+/**
+ * \brief ӽջжȡ nbytes ݣ
+ */
+static uint32_t __uart_rngbuf_read (am_uart_rngbuf_dev_t *p_dev,
+                                    uint8_t              *p_rxbuf,
+                                    uint32_t              nbytes)
+{
+    am_rngbuf_t rb = &(p_dev->rx_rngbuf);
+    uint32_t    rb_ct, read_ct;
+
+    rb_ct   = am_rngbuf_nbytes(rb);
+
+    read_ct = (rb_ct > nbytes) ? nbytes : rb_ct;
+
+    am_rngbuf_get(rb, (char *)p_rxbuf, read_ct);
+    
+    /* ݽչرգжǷҪ */
+    if (p_dev->flow_stat == AM_FALSE) {
+        
+        /* ֵֽ */
+        if (am_rngbuf_freebytes(rb) > p_dev->xon_threshold) {
+
+            /* Notify the other party continues to send */ 
+            am_uart_ioctl(p_dev->handle, 
+                          AM_UART_FLOWSTAT_RX_SET, 
+                          (void *)AM_UART_FLOWSTAT_ON);
+            
+            p_dev->flow_stat = AM_TRUE;
+        }
+    }
+
+    return read_ct;
+}
+
 /******************************************************************************/
 /**
  * \brief UART receive data
@@ -221,7 +258,7 @@ int am_uart_rngbuf_receive (am_uart_rngbuf_handle_t   handle,
     am_uart_rngbuf_dev_t *p_dev =  (am_uart_rngbuf_dev_t *)handle;
     am_rngbuf_t            rb    = &(p_dev->rx_rngbuf);
     
-    uint32_t rb_ct, read_ct;
+    uint32_t read_ct;
     uint32_t len = 0;                                /* ȡֽ      */
 
     while (nbytes > 0) {
@@ -245,30 +282,40 @@ int am_uart_rngbuf_receive (am_uart_rngbuf_handle_t   handle,
             }
         }
 
-        rb_ct   = am_rngbuf_nbytes(rb);
-
-        read_ct = (rb_ct > nbytes) ? nbytes : rb_ct;
-
-        am_rngbuf_get(rb, (char *)p_rxbuf, read_ct);
+        read_ct = __uart_rngbuf_read(p_dev, p_rxbuf, nbytes);
         
         p_rxbuf += read_ct;
         nbytes  -= read_ct;
         len     += read_ct;
-        
-        /* ݽչرգжǷҪ */
-        if (p_dev->flow_stat == AM_FALSE) {
-            
-            /* ֵֽ */
-            if (am_rngbuf_freebytes(rb) > p_dev->xon_threshold) {
-
-                /* Notify the other party continues to send */ 
-                am_uart_ioctl(p_dev->handle, 
-                              AM_UART_FLOWSTAT_RX_SET, 
-                              (void *)AM_UART_FLOWSTAT_ON);
-                
-                p_dev->flow_stat = AM_TRUE;
-            }
-        }
+    }
+
+    return len;
+}
+
+/******************************************************************************/
+/**
+ * \brief UART receive data without blocking
+ */
+int am_uart_rngbuf_receive_async (am_uart_rngbuf_handle_t   handle,
+                                  uint8_t                  *p_rxbuf,
+                                  uint32_t                  nbytes,
+                                  am_pfnvoid_t              pfn_notify,
+                                  void                     *p_arg)
+{
+    am_uart_rngbuf_dev_t *p_dev =  (am_uart_rngbuf_dev_t *)handle;
+    uint32_t              len;
+
+    if ((handle == NULL) || (p_rxbuf == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    /* ֪ͨٶȡȡǰݲ֪ͨ */
+    am_wait_notify_set(&p_dev->rx_wait, pfn_notify, p_arg);
+
+    len = __uart_rngbuf_read(p_dev, p_rxbuf, nbytes);
+
+    if (len != 0) {
+        am_wait_notify_set(&p_dev->rx_wait, NULL, NULL);
     }
 
     return len;
@@ -0,0 +1,296 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief Э̣ջprotothread 
+ *
+ * \internal
+ * \par modification history:
+ * - 1.01 26-10-18  lgg, resume yielded coroutines after the current jobq pass
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+#include "am_common.h"
+#include "am_co.h"
+#include "am_int.h"
+
+/******************************************************************************/
+
+/* λЭ̱־ */
+static void __co_flags_set (am_co_t *p_co, uint8_t flags)
+{
+    int key = am_int_cpu_lock();
+
+    p_co->flags |= flags;
+
+    am_int_cpu_unlock(key);
+}
+
+/* Э̱־ */
+static void __co_flags_clr (am_co_t *p_co, uint8_t flags)
+{
+    int key = am_int_cpu_lock();
+
+    p_co->flags &= ~flags;
+
+    am_int_cpu_unlock(key);
+}
+
+/* Э̱־λ */
+static am_bool_t __co_flags_take (am_co_t *p_co, uint8_t flags)
+{
+    am_bool_t ret;
+    int       key = am_int_cpu_lock();
+
+    ret = (p_co->flags & flags) ? AM_TRUE : AM_FALSE;
+    p_co->flags &= ~flags;
+
+    am_int_cpu_unlock(key);
+
+    return ret;
+}
+
+/******************************************************************************/
+
+/* ִЭ */
+static void __co_job (void *p_arg)
+{
+    am_co_t *p_co = (am_co_t *)p_arg;
+    int      ret;
+
+    if (p_co->flags & AM_CO_FLAG_ENDED) {
+        return;
+    }
+
+    ret = p_co->pfn_entry(p_co, p_co->p_arg);
+
+    if (ret == AM_CO_YIELDED) {
+
+        /* ζдټִУִⷴжʹòִ */
+        am_jobq_post_yield(p_co->jobq, &p_co->job);
+    } else if (ret >= AM_CO_EXITED) {
+        am_softimer_stop(&p_co->timer);
+        __co_flags_set(p_co, AM_CO_FLAG_ENDED);
+    }
+}
+
+/* ʱʱ䵽 */
+static void __co_timer_callback (void *p_arg)
+{
+    am_co_t *p_co = (am_co_t *)p_arg;
+
+    am_softimer_stop(&p_co->timer);
+
+    __co_flags_set(p_co, AM_CO_FLAG_TIMEOUT);
+
+    am_co_wake(p_co);
+}
+
+/* յȴ¼ */
+static void __co_event_proc (am_event_type_t *p_evt_type,
+                             void            *p_evt_data,
+                             void            *p_hdl_data)
+{
+    am_co_t *p_co = (am_co_t *)p_hdl_data;
+
+    (void)p_evt_type;
+
+    p_co->p_evt_data = p_evt_data;
+
+    __co_flags_set(p_co, AM_CO_FLAG_EVENT);
+
+    am_co_wake(p_co);
+}
+
+/******************************************************************************/
+int am_co_init (am_co_t          *p_co,
+                am_co_func_t      pfn_entry,
+                void             *p_arg,
+                am_jobq_handle_t  jobq,
+                uint16_t          pri)
+{
+    if ((p_co == NULL) || (pfn_entry == NULL) || (jobq == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    p_co->lc         = 0;
+    p_co->flags      = AM_CO_FLAG_ENDED;
+    p_co->pfn_entry  = pfn_entry;
+    p_co->p_arg      = p_arg;
+    p_co->jobq       = jobq;
+    p_co->p_evt_data = NULL;
+
+    am_jobq_job_init(&p_co->job, __co_job, p_co, pri);
+
+    return am_softimer_init(&p_co->timer, __co_timer_callback, p_co);
+}
+
+/******************************************************************************/
+int am_co_start (am_co_t *p_co)
+{
+    int key;
+
+    if (p_co == NULL) {
+        return -AM_EINVAL;
+    }
+
+    am_softimer_stop(&p_co->timer);
+
+    key = am_int_cpu_lock();
+    p_co->lc    = 0;
+    p_co->flags = 0;
+    am_int_cpu_unlock(key);
+
+    am_co_wake(p_co);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_co_kill (am_co_t *p_co)
+{
+    am_softimer_stop(&p_co->timer);
+
+    __co_flags_set(p_co, AM_CO_FLAG_ENDED);
+}
+
+/******************************************************************************/
+void am_co_wake (void *p_co)
+{
+    am_co_t *p = (am_co_t *)p_co;
+
+    /* ڶʱ -AM_EBUSYЭִʱеȴ */
+    am_jobq_post(p->jobq, &p->job);
+}
+
+/******************************************************************************/
+void am_co_signal (void *p_co)
+{
+    __co_flags_set((am_co_t *)p_co, AM_CO_FLAG_SIGNAL);
+
+    am_co_wake(p_co);
+}
+
+/******************************************************************************/
+void am_co_signal_clr (am_co_t *p_co)
+{
+    __co_flags_clr(p_co, AM_CO_FLAG_SIGNAL);
+}
+
+/******************************************************************************/
+am_bool_t am_co_signal_check (am_co_t *p_co)
+{
+    return __co_flags_take(p_co, AM_CO_FLAG_SIGNAL);
+}
+
+/******************************************************************************/
+void am_co_timer_start (am_co_t *p_co, unsigned int ms)
+{
+    if (ms == 0) {
+        am_softimer_stop(&p_co->timer);
+        __co_flags_set(p_co, AM_CO_FLAG_TIMEOUT);
+        return;
+    }
+
+    __co_flags_clr(p_co, AM_CO_FLAG_TIMEOUT);
+
+    am_softimer_start(&p_co->timer, ms);
+}
+
+/******************************************************************************/
+am_bool_t am_co_timeout_check (am_co_t *p_co)
+{
+    return __co_flags_take(p_co, AM_CO_FLAG_TIMEOUT);
+}
+
+/******************************************************************************/
+void am_co_wait_begin (am_co_t *p_co, am_wait_t *p_wait, uint32_t timeout_ms)
+{
+    __co_flags_clr(p_co, AM_CO_FLAG_TIMEOUT);
+
+    am_wait_notify_set(p_wait, am_co_wake, p_co);
+
+    if (timeout_ms != 0) {
+        am_softimer_start(&p_co->timer, timeout_ms);
+    }
+}
+
+/******************************************************************************/
+am_bool_t am_co_wait_end (am_co_t *p_co, am_wait_t *p_wait, int *p_ret)
+{
+    int ret = am_wait_try(p_wait);
+
+    if ((ret == -AM_EAGAIN) && am_co_timeout_check(p_co)) {
+        ret = -AM_ETIME;
+    }
+
+    if (ret == -AM_EAGAIN) {
+        return AM_FALSE;
+    }
+
+    am_softimer_stop(&p_co->timer);
+    am_wait_notify_set(p_wait, NULL, NULL);
+
+    *p_ret = ret;
+
+    return AM_TRUE;
+}
+
+/******************************************************************************/
+void am_co_event_begin (am_co_t         *p_co,
+                        am_event_type_t *p_event,
+                        uint32_t         timeout_ms)
+{
+    __co_flags_clr(p_co, AM_CO_FLAG_TIMEOUT | AM_CO_FLAG_EVENT);
+
+    p_co->p_evt_data = NULL;
+
+    am_event_handler_init(&p_co->evt_handler,
+                          __co_event_proc,
+                          p_co,
+                          AM_EVENT_HANDLER_FLAG_AUTO_UNREG);
+
+    am_event_handler_register(p_event, &p_co->evt_handler);
+
+    if (timeout_ms != 0) {
+        am_softimer_start(&p_co->timer, timeout_ms);
+    }
+}
+
+/******************************************************************************/
+am_bool_t am_co_event_end (am_co_t          *p_co,
+                           am_event_type_t  *p_event,
+                           void            **pp_evt_data,
+                           int              *p_ret)
+{
+    if (__co_flags_take(p_co, AM_CO_FLAG_EVENT)) {
+        *p_ret = AM_OK;
+    } else if (am_co_timeout_check(p_co)) {
+
+        /* ʱ¼δԶע */
+        am_event_handler_unregister(p_event, &p_co->evt_handler);
+        *p_ret = -AM_ETIME;
+    } else {
+        return AM_FALSE;
+    }
+
+    am_softimer_stop(&p_co->timer);
+
+    if (pp_evt_data != NULL) {
+        *pp_evt_data = p_co->p_evt_data;
+    }
+
+    return AM_TRUE;
+}
+
+/* end of file */
@@ -26,12 +26,14 @@
  *
  * \internal
  * \par modification history:
+ * - 1.01 26-10-18  lgg, add coalescing counts and statistics
  * - 1.00 15-09-23  tee, first implementation
  * \endinternal
  */
  
 #include "ametal.h"
 #include "am_isr_defer.h"
+#include "am_int.h"
  
 /*******************************************************************************
   Locals
@@ -39,6 +41,47 @@
 static am_jobq_handle_t           __g_isr_defer_handle = NULL;
 static am_isr_defer_add_cb_t      __gpfn_trigger_cb    = NULL;
 static void                      *__gp_cb_arg          = NULL;
+static am_jobq_clk_get_t          __gpfn_clk_get       = NULL;
+
+/*******************************************************************************
+  Local functions
+*******************************************************************************/
+
+/* ʵִеĺȡϲĴ¼ô */
+static void __isr_defer_job_run (void *p_arg)
+{
+    am_isr_defer_job_t *p_job = (am_isr_defer_job_t *)p_arg;
+    uint32_t            latency;
+    int                 key;
+
+    key = am_int_cpu_lock();
+
+    /*
+     * Ӻȡǰֱʱٴӣȡȫ
+     * ٴִʱô
+     */
+    if ((p_job->pending == 0) && (p_job->events == 0)) {
+        am_int_cpu_unlock(key);
+        return;
+    }
+
+    p_job->count      = p_job->pending;
+    p_job->cur_events = p_job->events;
+    p_job->pending    = 0;
+    p_job->events     = 0;
+    p_job->stat.runs++;
+
+    if (__gpfn_clk_get != NULL) {
+        latency = __gpfn_clk_get() - p_job->post_time;
+        if (latency > p_job->stat.latency_max) {
+            p_job->stat.latency_max = latency;
+        }
+    }
+
+    am_int_cpu_unlock(key);
+
+    p_job->func(p_job->p_arg);
+}
 
 /*******************************************************************************
   Public functions
@@ -62,18 +105,60 @@ void am_isr_defer_job_init (am_isr_defer_job_t  *p_job,
                             void                *p_arg,
                             uint16_t             pri)
 {
-     am_jobq_job_init(p_job, func, p_arg, pri);
+    if (p_job == NULL) {
+        return;
+    }
+
+    memset(p_job, 0, sizeof(*p_job));
+
+    p_job->func  = func;
+    p_job->p_arg = p_arg;
+
+    am_jobq_job_init(&p_job->job, __isr_defer_job_run, p_job, pri);
 }
 
 /******************************************************************************/
 int am_isr_defer_job_add (am_isr_defer_job_t *p_job)
 {
+    return am_isr_defer_job_add_events(p_job, 0);
+}
+
+/******************************************************************************/
+int am_isr_defer_job_add_events (am_isr_defer_job_t *p_job, uint32_t events)
+{
+    int key;
+    int ret;
+
     if (__g_isr_defer_handle == NULL) {
         return -AM_EPERM;
     }
-    
-    am_jobq_post(__g_isr_defer_handle, p_job);
- 
+
+    if ((p_job == NULL) || (p_job->func == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+
+    p_job->stat.posts++;
+    if ((p_job->pending == 0) && (p_job->events == 0) &&
+        (__gpfn_clk_get != NULL)) {
+        p_job->post_time = __gpfn_clk_get();
+    }
+    p_job->pending++;
+    p_job->events |= events;
+
+    /* ڶУӺϲôִУٴδ */
+    ret = am_jobq_post(__g_isr_defer_handle, &p_job->job);
+    if (ret == -AM_EBUSY) {
+        p_job->stat.coalesced++;
+    }
+
+    am_int_cpu_unlock(key);
+
+    if (ret != AM_OK) {
+        return ret;
+    }
+
     if (__gpfn_trigger_cb) {
         __gpfn_trigger_cb(__gp_cb_arg);
     }
@@ -81,6 +166,57 @@ int am_isr_defer_job_add (am_isr_defer_job_t *p_job)
     return AM_OK;
 }
 
+/******************************************************************************/
+uint32_t am_isr_defer_job_count_get (am_isr_defer_job_t *p_job)
+{
+    return (p_job != NULL) ? p_job->count : 0;
+}
+
+/******************************************************************************/
+uint32_t am_isr_defer_job_events_get (am_isr_defer_job_t *p_job)
+{
+    return (p_job != NULL) ? p_job->cur_events : 0;
+}
+
+/******************************************************************************/
+int am_isr_defer_clk_set (am_jobq_clk_get_t pfn_clk_get)
+{
+    if (__g_isr_defer_handle == NULL) {
+        return -AM_EPERM;
+    }
+
+    __gpfn_clk_get = pfn_clk_get;
+
+    return am_jobq_clk_set(__g_isr_defer_handle, pfn_clk_get);
+}
+
+/******************************************************************************/
+int am_isr_defer_stat_get (am_isr_defer_job_t  *p_job,
+                           am_isr_defer_stat_t *p_stat)
+{
+    int key;
+
+    if ((p_job == NULL) || (p_stat == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+    *p_stat = p_job->stat;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_isr_defer_stat_clr (am_isr_defer_job_t *p_job)
+{
+    int key;
+
+    key = am_int_cpu_lock();
+    memset(&p_job->stat, 0, sizeof(p_job->stat));
+    am_int_cpu_unlock(key);
+}
+
 /******************************************************************************/
 int am_isr_defer_job_process (void)
 {
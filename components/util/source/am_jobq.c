@@ -21,6 +21,11 @@
  *
  * \internal
  * \par modification history:
+ * - 1.04 26-10-18  lgg, keep statistics out of the job, do not touch the job
+ *                   after its function returns
+ * - 1.03 26-10-18  lgg, add am_jobq_post_yield()
+ * - 1.02 26-10-18  lgg, add trace points
+ * - 1.01 26-10-18  lgg, add deadline jobs, budget and statistics
  * - 1.00 15-09-18  tee, first implementation
  * \endinternal
  */
@@ -28,6 +33,7 @@
 #include "am_jobq.h"
 #include "am_int.h"
 #include "am_bitops.h"
+#include "am_trace.h"
 
 /*******************************************************************************
   ڲʹú궨
@@ -36,6 +42,9 @@
 /* ־ѱ                        */
 #define __JOBQ_JOB_ENQUEUED      0x100
 
+/* ־нֹʱ                        */
+#define __JOBQ_JOB_DEADLINE      0x200
+
 /* ־ǰڴ                   */
 #define __JOBQ_FLG_RUNNING   0x01
 
@@ -99,6 +108,52 @@ int __jobq_ffs (unsigned int x )
     return pos;
 }
 
+/******************************************************************************/
+
+/* ȡʱԴĵǰʱ䣬δʱԴʱΪ 0 */
+#define __JOBQ_CLK_GET(p_jobq_queue)                  \
+            (((p_jobq_queue)->pfn_clk_get != NULL) ?  \
+              (p_jobq_queue)->pfn_clk_get() : 0)
+
+/* жϱδǷѴﵽԤ */
+static am_bool_t __jobq_budget_exhausted (am_jobq_queue_t *p_jobq_queue,
+                                          uint32_t         njobs,
+                                          uint32_t         start)
+{
+    if ((p_jobq_queue->budget_jobs != 0) &&
+        (njobs >= p_jobq_queue->budget_jobs)) {
+        return AM_TRUE;
+    }
+
+    if ((p_jobq_queue->budget_time != 0) &&
+        (p_jobq_queue->pfn_clk_get != NULL) &&
+        (p_jobq_queue->pfn_clk_get() - start >= p_jobq_queue->budget_time)) {
+        return AM_TRUE;
+    }
+
+    return AM_FALSE;
+}
+
+#ifdef AM_JOBQ_STAT
+
+/* һʱֵ¼ֱͼ */
+static void __jobq_stat_add (uint32_t *p_hist, uint32_t *p_max, uint32_t val)
+{
+    unsigned int idx = 0;
+
+    while ((val >> idx) != 0 && idx < AM_JOBQ_STAT_BUCKETS - 1) {
+        idx++;
+    }
+
+    p_hist[idx]++;
+
+    if (val > *p_max) {
+        *p_max = val;
+    }
+}
+
+#endif /* AM_JOBQ_STAT */
+
 /******************************************************************************/
 am_jobq_handle_t am_jobq_queue_init (am_jobq_queue_t     *p_jobq_queue,
                                      unsigned int         pri_num,
@@ -131,6 +186,12 @@ am_jobq_handle_t am_jobq_queue_init (am_jobq_queue_t     *p_jobq_queue,
     p_jobq_queue->p_heads      = p_heads;
     p_jobq_queue->pri_num      = pri_num;
     p_jobq_queue->p_bitmap_job = p_bitmap_job;
+    p_jobq_queue->flags        = 0;
+    p_jobq_queue->pfn_clk_get  = NULL;
+    p_jobq_queue->budget_jobs  = 0;
+    p_jobq_queue->budget_time  = 0;
+
+    am_list_head_init(&p_jobq_queue->yielded);
  
     am_int_cpu_unlock(key);
     
@@ -150,13 +211,22 @@ void am_jobq_job_init (am_jobq_job_t  *p_job,
     p_job->flags = 0;
     
     am_list_head_init(&p_job->node);
+
+#ifdef AM_JOBQ_STAT
+    p_job->p_stat = NULL;
+#endif
 }
 
 /******************************************************************************/
-int am_jobq_post (am_jobq_queue_t *p_jobq_queue, am_jobq_job_t *p_job)
+
+/* Уp_deadline Ϊ NULL ʱֹʱ */
+static int __jobq_post (am_jobq_queue_t *p_jobq_queue,
+                        am_jobq_job_t   *p_job,
+                        uint32_t        *p_deadline)
 {
-    uint32_t pri;
-    int      key;
+    uint32_t             pri;
+    int                  key;
+    struct am_list_head *p_pos;
 
     if (p_jobq_queue == NULL || p_job == NULL || p_job->func == NULL) {
         return -AM_EINVAL;
@@ -179,9 +249,40 @@ int am_jobq_post (am_jobq_queue_t *p_jobq_queue, am_jobq_job_t *p_job)
         
         __JOBQ_BITMAP_GRP_SET(p_jobq_queue->bitmap_grp, pri);
         __JOBQ_BITMAP_JOB_SET(p_jobq_queue->p_bitmap_job, pri);
-        
-        /* ȼβ */
-        am_list_add_tail(&p_job->node, &p_jobq_queue->p_heads[pri]);
+
+        /* Ĭϼȼβ */
+        p_pos = &p_jobq_queue->p_heads[pri];
+
+#ifdef AM_JOBQ_DEADLINE
+        if (p_deadline != NULL) {
+
+            am_jobq_job_t *p_iter;
+
+            p_job->deadline  = *p_deadline;
+            p_job->flags    |= __JOBQ_JOB_DEADLINE;
+
+            /* 뵽һֹͨʱ֮ǰ */
+            am_list_for_each_entry(p_iter,
+                                  &p_jobq_queue->p_heads[pri],
+                                   am_jobq_job_t,
+                                   node) {
+                if (!(p_iter->flags & __JOBQ_JOB_DEADLINE) ||
+                    ((int32_t)(p_iter->deadline - *p_deadline) > 0)) {
+                    p_pos = &p_iter->node;
+                    break;
+                }
+            }
+        }
+#else
+        (void)p_deadline;
+#endif
+
+#ifdef AM_JOBQ_STAT
+        p_job->post_time = __JOBQ_CLK_GET(p_jobq_queue);
+#endif
+
+        /* 뵽 p_pos ֮ǰ */
+        am_list_add_tail(&p_job->node, p_pos);
 
         am_int_cpu_unlock(key);
 
@@ -192,13 +293,92 @@ int am_jobq_post (am_jobq_queue_t *p_jobq_queue, am_jobq_job_t *p_job)
 
     return -AM_EBUSY;
 }
+
+/******************************************************************************/
+int am_jobq_post (am_jobq_queue_t *p_jobq_queue, am_jobq_job_t *p_job)
+{
+    return __jobq_post(p_jobq_queue, p_job, NULL);
+}
+
+/******************************************************************************/
+int am_jobq_post_yield (am_jobq_queue_t *p_jobq_queue, am_jobq_job_t *p_job)
+{
+    int key;
+
+    if (p_jobq_queue == NULL || p_job == NULL || p_job->func == NULL) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+
+    /* δڴУֱӼ */
+    if ((p_jobq_queue->flags & __JOBQ_FLG_RUNNING) == 0) {
+        am_int_cpu_unlock(key);
+        return __jobq_post(p_jobq_queue, p_job, NULL);
+    }
+
+    if (p_job->flags & __JOBQ_JOB_ENQUEUED) {
+        am_int_cpu_unlock(key);
+        return -AM_EBUSY;
+    }
+
+    /* δʱټУڼΪڶ */
+    p_job->flags |= __JOBQ_JOB_ENQUEUED;
+    am_list_add_tail(&p_job->node, &p_jobq_queue->yielded);
+
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+#ifdef AM_JOBQ_DEADLINE
+
+/******************************************************************************/
+int am_jobq_post_deadline (am_jobq_queue_t *p_jobq_queue,
+                           am_jobq_job_t   *p_job,
+                           uint32_t         deadline)
+{
+    return __jobq_post(p_jobq_queue, p_job, &deadline);
+}
+
+#endif /* AM_JOBQ_DEADLINE */
  
+/******************************************************************************/
+
+/*
+ * һδδóУǰж
+ *  AM_TRUE ʾ
+ */
+static am_bool_t __jobq_process_end (am_jobq_queue_t *p_jobq_queue)
+{
+    am_jobq_job_t *p_job;
+    am_bool_t      posted = AM_FALSE;
+
+    p_jobq_queue->flags &= ~__JOBQ_FLG_RUNNING;
+
+    while (!am_list_empty(&p_jobq_queue->yielded)) {
+        p_job = am_list_first_entry(&p_jobq_queue->yielded,
+                                    am_jobq_job_t,
+                                    node);
+        am_list_del_init(&p_job->node);
+        p_job->flags &= ~__JOBQ_JOB_ENQUEUED;
+
+        __jobq_post(p_jobq_queue, p_job, NULL);
+        posted = AM_TRUE;
+    }
+
+    return posted;
+}
+
 /******************************************************************************/
 int am_jobq_process (am_jobq_queue_t *p_jobq_queue)
 {
     int             key;
+    int             ret;
     am_pfnvoid_t    func;
     void           *p_arg;
+    uint32_t        njobs = 0;
+    uint32_t        start;
 
     struct am_list_head *p_q;
     am_jobq_job_t       *p_job;
@@ -211,6 +391,8 @@ int am_jobq_process (am_jobq_queue_t *p_jobq_queue)
     if ((p_jobq_queue->flags & __JOBQ_FLG_RUNNING) != 0) {
         return -AM_EBUSY;
     }
+
+    start = __JOBQ_CLK_GET(p_jobq_queue);
     
     key = am_int_cpu_lock();
    
@@ -220,15 +402,26 @@ int am_jobq_process (am_jobq_queue_t *p_jobq_queue)
 
     while(1) {
 
-        unsigned int pri;
+        unsigned int    pri;
+#ifdef AM_JOBQ_STAT
+        uint32_t        now;
+        am_jobq_stat_t *p_stat;
+#endif
 
         key = am_int_cpu_lock();
         
-        /* κ */
+        /* κó񣬽Уٴδ */
         if (p_jobq_queue->bitmap_grp == 0) {
-            p_jobq_queue->flags &= ~__JOBQ_FLG_RUNNING;
+            ret = __jobq_process_end(p_jobq_queue) ? -AM_EAGAIN : AM_OK;
+            am_int_cpu_unlock(key);
+            return ret;
+        }
+
+        /* ﵽԤ㣬ʣ´δ */
+        if (__jobq_budget_exhausted(p_jobq_queue, njobs, start)) {
+            __jobq_process_end(p_jobq_queue);
             am_int_cpu_unlock(key);
-            return AM_OK;
+            return -AM_EAGAIN;
         }
         
         /* ҵȼߵ     */
@@ -256,17 +449,139 @@ int am_jobq_process (am_jobq_queue_t *p_jobq_queue)
             }
         }
 
-        p_job->flags &= ~__JOBQ_JOB_ENQUEUED;
+        p_job->flags &= ~(__JOBQ_JOB_ENQUEUED | __JOBQ_JOB_DEADLINE);
 
         func  = p_job->func;
         p_arg = p_job->p_arg;
+
+#ifdef AM_JOBQ_STAT
+
+        /*
+         * жбٴμУ¼ʱ䣩ڿжǰͳ
+         * ȴʱ䡣ͷŻ³ʼ˺ٷ
+         * ִʱ¼ԤȡõͳϢ
+         */
+        now    = __JOBQ_CLK_GET(p_jobq_queue);
+        p_stat = p_job->p_stat;
+        if (p_stat != NULL) {
+            __jobq_stat_add(p_stat->wait_hist,
+                           &p_stat->wait_max,
+                            now - p_job->post_time);
+        }
+#endif
         
         am_int_cpu_unlock(key);
 
         if (func) {
+            AM_TRACE_ENTER(AM_TRACE_JOB, func);
             func(p_arg);
+            AM_TRACE_EXIT(AM_TRACE_JOB, func);
         }
+
+#ifdef AM_JOBQ_STAT
+        if (p_stat != NULL) {
+            key = am_int_cpu_lock();
+            __jobq_stat_add(p_stat->exec_hist,
+                           &p_stat->exec_max,
+                            __JOBQ_CLK_GET(p_jobq_queue) - now);
+            am_int_cpu_unlock(key);
+        }
+#endif
+
+        njobs++;
+    }
+}
+
+/******************************************************************************/
+int am_jobq_clk_set (am_jobq_handle_t handle, am_jobq_clk_get_t pfn_clk_get)
+{
+    if (handle == NULL) {
+        return -AM_EINVAL;
+    }
+
+    handle->pfn_clk_get = pfn_clk_get;
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_jobq_budget_set (am_jobq_handle_t handle,
+                        uint32_t         max_jobs,
+                        uint32_t         max_time)
+{
+    int key;
+
+    if (handle == NULL) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+    handle->budget_jobs = max_jobs;
+    handle->budget_time = max_time;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+#ifdef AM_JOBQ_STAT
+
+/******************************************************************************/
+int am_jobq_stat_attach (am_jobq_job_t *p_job, am_jobq_stat_t *p_stat)
+{
+    int key;
+
+    if (p_job == NULL) {
+        return -AM_EINVAL;
+    }
+
+    if (p_stat != NULL) {
+        memset(p_stat, 0, sizeof(*p_stat));
+    }
+
+    key = am_int_cpu_lock();
+    p_job->p_stat = p_stat;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_jobq_stat_get (am_jobq_job_t *p_job, am_jobq_stat_t *p_stat)
+{
+    int key;
+    int ret = AM_OK;
+
+    if ((p_job == NULL) || (p_stat == NULL)) {
+        return -AM_EINVAL;
     }
+
+    key = am_int_cpu_lock();
+
+    if (p_job->p_stat != NULL) {
+        *p_stat = *p_job->p_stat;
+    } else {
+        ret = -AM_EPERM;
+    }
+
+    am_int_cpu_unlock(key);
+
+    return ret;
 }
 
+/******************************************************************************/
+void am_jobq_stat_clr (am_jobq_job_t *p_job)
+{
+    int key;
+
+    key = am_int_cpu_lock();
+
+    if (p_job->p_stat != NULL) {
+        memset(p_job->p_stat, 0, sizeof(*p_job->p_stat));
+    }
+
+    am_int_cpu_unlock(key);
+}
+
+#endif /* AM_JOBQ_STAT */
+
 /* end of file */
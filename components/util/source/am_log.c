@@ -0,0 +1,262 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ӳٸʽĶ־
+ *
+ * ÿ¼ɸɣ
+ * - ͷ0xA5 (bit24 ~ 31) (bit20 ~ 23) (bit16 ~ 19)
+ *   Ƿʱ (bit15) (bit0 ~ 14)
+ * - ʽַַ
+ * - ʱѡ
+ * - 
+ *
+ * ʱÿ¼Сֽ base64 Ϊһ "#L:xxxx\n"
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+#include "am_common.h"
+#include "am_log.h"
+#include "am_int.h"
+#include "am_koutput.h"
+
+/*******************************************************************************
+  궨
+*******************************************************************************/
+
+#define __LOG_SYNC          0xA5u           /**< \brief ¼ͷֽͬ */
+#define __LOG_TS_FLAG       (1u << 15)      /**< \brief ʱ־ */
+#define __LOG_SEQ_MASK      0x7FFFu         /**< \brief  */
+
+/** \brief һ¼ */
+#define __LOG_REC_WORDS_MAX (3 + AM_LOG_ARGS_MAX)
+
+/** \brief ͷõ¼ */
+#define __LOG_REC_WORDS(hdr) \
+    (2 + (((hdr) >> 16) & 0x0F) + (((hdr) & __LOG_TS_FLAG) ? 1 : 0))
+
+/*******************************************************************************
+  ֲ
+*******************************************************************************/
+
+/** \brief ־ */
+static struct __log_dev {
+    uint32_t           *p_buf;          /**< \brief  */
+    uint32_t            mask;           /**< \brief  - 1 */
+    volatile uint32_t   in;             /**< \brief д*/
+    volatile uint32_t   out;            /**< \brief */
+    uint32_t            seq;            /**< \brief һ¼ */
+    volatile uint32_t   dropped;        /**< \brief ļ¼ */
+    uint32_t          (*pfn_clk_get) (void); /**< \brief ʱ */
+} __g_log;
+
+/** \brief base64  */
+static const char __g_b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*******************************************************************************
+  ֲ
+*******************************************************************************/
+
+/**
+ * \brief  n ְСֽΪ base64 ַַĩβ
+ */
+static char *__log_b64_encode (char *p_str, const uint32_t *p_words, int n)
+{
+    uint8_t  bytes[__LOG_REC_WORDS_MAX * 4];
+    uint32_t v;
+    int      len = n * 4;
+    int      i;
+
+    for (i = 0; i < n; i++) {
+        bytes[i * 4]     = (uint8_t)(p_words[i]);
+        bytes[i * 4 + 1] = (uint8_t)(p_words[i] >> 8);
+        bytes[i * 4 + 2] = (uint8_t)(p_words[i] >> 16);
+        bytes[i * 4 + 3] = (uint8_t)(p_words[i] >> 24);
+    }
+
+    for (i = 0; i + 3 <= len; i += 3) {
+        v = ((uint32_t)bytes[i] << 16) |
+            ((uint32_t)bytes[i + 1] << 8) | bytes[i + 2];
+        *p_str++ = __g_b64[(v >> 18) & 0x3F];
+        *p_str++ = __g_b64[(v >> 12) & 0x3F];
+        *p_str++ = __g_b64[(v >> 6) & 0x3F];
+        *p_str++ = __g_b64[v & 0x3F];
+    }
+
+    if (len - i == 1) {
+        v = (uint32_t)bytes[i] << 16;
+        *p_str++ = __g_b64[(v >> 18) & 0x3F];
+        *p_str++ = __g_b64[(v >> 12) & 0x3F];
+        *p_str++ = '=';
+        *p_str++ = '=';
+    } else if (len - i == 2) {
+        v = ((uint32_t)bytes[i] << 16) | ((uint32_t)bytes[i + 1] << 8);
+        *p_str++ = __g_b64[(v >> 18) & 0x3F];
+        *p_str++ = __g_b64[(v >> 12) & 0x3F];
+        *p_str++ = __g_b64[(v >> 6) & 0x3F];
+        *p_str++ = '=';
+    }
+
+    return p_str;
+}
+
+/*******************************************************************************
+  ⲿ
+*******************************************************************************/
+
+int am_log_init (uint32_t *p_buf, size_t nwords)
+{
+    int key;
+
+    if ((p_buf == NULL) ||
+        (nwords < __LOG_REC_WORDS_MAX) ||
+        ((nwords & (nwords - 1)) != 0)) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+    __g_log.p_buf   = p_buf;
+    __g_log.mask    = nwords - 1;
+    __g_log.in      = 0;
+    __g_log.out     = 0;
+    __g_log.seq     = 0;
+    __g_log.dropped = 0;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_log_clk_set (uint32_t (*pfn_clk_get) (void))
+{
+    __g_log.pfn_clk_get = pfn_clk_get;
+}
+
+/******************************************************************************/
+void am_log_write (uint32_t info, const char *p_fmt, const uint32_t *p_args)
+{
+    uint32_t  nargs = info & 0x0F;
+    uint32_t  hdr   = (__LOG_SYNC << 24) | ((info & 0xF0) << 16) | (nargs << 16);
+    uint32_t *p_buf;
+    uint32_t  mask;
+    uint32_t  in;
+    uint32_t  i;
+    int       key;
+
+    if (nargs > AM_LOG_ARGS_MAX) {
+        return;
+    }
+
+    /*
+     * Ϲжд룬ٽֻʮָжϾɵ
+     */
+    key = am_int_cpu_lock();
+
+    p_buf = __g_log.p_buf;
+    mask  = __g_log.mask;
+    in    = __g_log.in;
+
+    if (__g_log.pfn_clk_get != NULL) {
+        hdr |= __LOG_TS_FLAG;
+    }
+
+    if ((p_buf == NULL) ||
+        (mask + 1 - (in - __g_log.out) < __LOG_REC_WORDS(hdr))) {
+
+        /* ͬӣʱɾݴ˷ֶʧļ¼ */
+        __g_log.seq++;
+        __g_log.dropped++;
+        am_int_cpu_unlock(key);
+        return;
+    }
+
+    p_buf[in++ & mask] = hdr | (__g_log.seq++ & __LOG_SEQ_MASK);
+    p_buf[in++ & mask] = (uint32_t)(uintptr_t)p_fmt;
+    if (hdr & __LOG_TS_FLAG) {
+        p_buf[in++ & mask] = __g_log.pfn_clk_get();
+    }
+    for (i = 0; i < nargs; i++) {
+        p_buf[in++ & mask] = p_args[i];
+    }
+    __g_log.in = in;
+
+    am_int_cpu_unlock(key);
+}
+
+/******************************************************************************/
+int am_log_drain (unsigned int max)
+{
+    uint32_t rec[__LOG_REC_WORDS_MAX];
+    char     line[3 + (__LOG_REC_WORDS_MAX * 4 + 2) / 3 * 4 + 2];
+    char    *p_end;
+    uint32_t out;
+    uint32_t n;
+    uint32_t i;
+    int      cnt = 0;
+
+    if (__g_log.p_buf == NULL) {
+        return 0;
+    }
+
+    while ((max == 0) || (cnt < (int)max)) {
+
+        out = __g_log.out;
+        if (out == __g_log.in) {
+            break;
+        }
+
+        rec[0] = __g_log.p_buf[out & __g_log.mask];
+        n      = __LOG_REC_WORDS(rec[0]);
+
+        /* ͷ𻵣³ʼڼ䱻ȡ */
+        if (((rec[0] >> 24) != __LOG_SYNC) ||
+            (n > __LOG_REC_WORDS_MAX) ||
+            (n > __g_log.in - out)) {
+            __g_log.out = __g_log.in;
+            break;
+        }
+
+        for (i = 1; i < n; i++) {
+            rec[i] = __g_log.p_buf[(out + i) & __g_log.mask];
+        }
+
+        /* ɺ󼴿ͷſռ䣬пԼд */
+        __g_log.out = out + n;
+
+        line[0] = '#';
+        line[1] = 'L';
+        line[2] = ':';
+        p_end   = __log_b64_encode(&line[3], rec, n);
+        p_end[0] = '\n';
+        p_end[1] = '\0';
+
+        if (gpfunc_kputs != NULL) {
+            gpfunc_kputs(line, gp_kout_file);
+        }
+        cnt++;
+    }
+
+    return cnt;
+}
+
+/******************************************************************************/
+uint32_t am_log_dropped_get (void)
+{
+    return __g_log.dropped;
+}
+
+/* end of file */
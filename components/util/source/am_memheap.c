@@ -16,6 +16,8 @@
  *
  * \internal
  * \par modification history:
+ * - 1.02 26-10-18  lgg, add heap walk, fragmentation info and call-site tags
+ * - 1.01 26-10-18  lgg, add TLSF free block management
  * - 1.00 16-10-27  tee, copy from amorks
  * \endinternal
  */
@@ -27,6 +29,10 @@
 #include "am_errno.h"
 #include <string.h>
 
+#ifdef AM_MEMHEAP_TRACE
+#undef am_memheap_alloc             /* the real function is defined here */
+#endif
+
 /* dynamic pool magic and mask */
 #define __MEMHEAP_MAGIC        0x1ea01ea0
 #define __MEMHEAP_MASK         0xfffffffe
@@ -44,6 +50,225 @@
 
 void am_memheap_free(void *ptr);
 
+/******************************************************************************/
+#ifdef AM_MEMHEAP_TLSF
+
+/*
+ * Two-Level Segregated Fit free block management
+ *
+ * Free blocks are kept in AM_MEMHEAP_TLSF_FL_COUNT * AM_MEMHEAP_TLSF_SL_COUNT
+ * lists. The first level splits block sizes by power of two, the second level
+ * splits each power of two range linearly. Two bitmaps record the non-empty
+ * lists, so finding a suitable block needs only two bit scans.
+ */
+
+#define __TLSF_SMALL_BLOCK_SIZE    (1U << AM_MEMHEAP_TLSF_FL_SHIFT)
+
+#if defined(__CC_ARM)
+#define __TLSF_CLZ(x)    __clz(x)
+#elif defined(__GNUC__)
+#define __TLSF_CLZ(x)    __builtin_clz(x)
+#else
+static int __TLSF_CLZ (uint32_t x)
+{
+    int n = 0;
+
+    while (!(x & 0x80000000)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+#endif
+
+/* find last set bit, word must not be 0 */
+static int __tlsf_fls (uint32_t word)
+{
+    return 31 - __TLSF_CLZ(word);
+}
+
+/* find first set bit, word must not be 0 */
+static int __tlsf_ffs (uint32_t word)
+{
+    return __tlsf_fls(word & (~word + 1));
+}
+
+/* get the list index of a block with the specified size */
+static void __tlsf_mapping_insert (uint32_t size, int *p_fl, int *p_sl)
+{
+    int fl, sl;
+
+    if (size < __TLSF_SMALL_BLOCK_SIZE) {
+        fl = 0;
+        sl = size / (__TLSF_SMALL_BLOCK_SIZE / AM_MEMHEAP_TLSF_SL_COUNT);
+    } else {
+        fl = __tlsf_fls(size);
+        sl = (size >> (fl - AM_MEMHEAP_TLSF_SL_LOG2)) ^
+             (1 << AM_MEMHEAP_TLSF_SL_LOG2);
+        fl -= (AM_MEMHEAP_TLSF_FL_SHIFT - 1);
+    }
+
+    /* too large blocks are all put into the last list */
+    if (fl >= AM_MEMHEAP_TLSF_FL_COUNT) {
+        fl = AM_MEMHEAP_TLSF_FL_COUNT - 1;
+        sl = AM_MEMHEAP_TLSF_SL_COUNT - 1;
+    }
+
+    *p_fl = fl;
+    *p_sl = sl;
+}
+
+static void __free_insert (struct am_memheap      *heap,
+                           struct am_memheap_item *item)
+{
+    struct am_memheap_item *head;
+    int                     fl, sl;
+
+    __tlsf_mapping_insert(__MEMITEM_SIZE(item), &fl, &sl);
+
+    head            = heap->free_lists[fl][sl];
+    item->prev_free = NULL;
+    item->next_free = head;
+    if (head != NULL) {
+        head->prev_free = item;
+    }
+    heap->free_lists[fl][sl] = item;
+
+    heap->fl_bitmap     |= (1UL << fl);
+    heap->sl_bitmap[fl] |= (1UL << sl);
+}
+
+static void __free_remove (struct am_memheap      *heap,
+                           struct am_memheap_item *item)
+{
+    int fl, sl;
+
+    __tlsf_mapping_insert(__MEMITEM_SIZE(item), &fl, &sl);
+
+    if (item->next_free != NULL) {
+        item->next_free->prev_free = item->prev_free;
+    }
+
+    if (item->prev_free != NULL) {
+        item->prev_free->next_free = item->next_free;
+    } else {
+        heap->free_lists[fl][sl] = item->next_free;
+        if (item->next_free == NULL) {
+            heap->sl_bitmap[fl] &= ~(1UL << sl);
+            if (heap->sl_bitmap[fl] == 0) {
+                heap->fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+
+    item->next_free = NULL;
+    item->prev_free = NULL;
+}
+
+static struct am_memheap_item *__free_find (struct am_memheap *heap,
+                                            uint32_t           size)
+{
+    struct am_memheap_item *item;
+    uint32_t                sl_map;
+    uint32_t                fl_map;
+    int                     fl, sl;
+
+    /*
+     * round up to the next list, so that any block in the list found is
+     * large enough
+     */
+    if (size >= __TLSF_SMALL_BLOCK_SIZE) {
+        size += (1UL << (__tlsf_fls(size) - AM_MEMHEAP_TLSF_SL_LOG2)) - 1;
+    }
+    __tlsf_mapping_insert(size, &fl, &sl);
+
+    if ((fl == AM_MEMHEAP_TLSF_FL_COUNT - 1) &&
+        (sl == AM_MEMHEAP_TLSF_SL_COUNT - 1)) {
+
+        /* the last list holds blocks of any size above, search it */
+        item = heap->free_lists[fl][sl];
+        while ((item != NULL) && (__MEMITEM_SIZE(item) < size)) {
+            item = item->next_free;
+        }
+        return item;
+    }
+
+    sl_map = heap->sl_bitmap[fl] & (~0UL << sl);
+    if (sl_map == 0) {
+        fl_map = heap->fl_bitmap & (~0UL << (fl + 1));
+        if (fl_map == 0) {
+            return NULL;
+        }
+        fl     = __tlsf_ffs(fl_map);
+        sl_map = heap->sl_bitmap[fl];
+    }
+    sl = __tlsf_ffs(sl_map);
+
+    return heap->free_lists[fl][sl];
+}
+
+static void __free_list_init (struct am_memheap *heap)
+{
+    memset(heap->sl_bitmap, 0, sizeof(heap->sl_bitmap));
+    memset(heap->free_lists, 0, sizeof(heap->free_lists));
+    heap->fl_bitmap = 0;
+}
+
+#else
+
+/*
+ * first-fit free block management, all free blocks are in a double linked
+ * list started from heap->free_list
+ */
+
+static void __free_insert (struct am_memheap      *heap,
+                           struct am_memheap_item *item)
+{
+    item->next_free = heap->free_list->next_free;
+    item->prev_free = heap->free_list;
+    heap->free_list->next_free->prev_free = item;
+    heap->free_list->next_free            = item;
+}
+
+static void __free_remove (struct am_memheap      *heap,
+                           struct am_memheap_item *item)
+{
+    (void)heap;
+
+    item->next_free->prev_free = item->prev_free;
+    item->prev_free->next_free = item->next_free;
+    item->next_free = NULL;
+    item->prev_free = NULL;
+}
+
+static struct am_memheap_item *__free_find (struct am_memheap *heap,
+                                            uint32_t           size)
+{
+    struct am_memheap_item *header_ptr;
+
+    /* get the first free memory block */
+    header_ptr = heap->free_list->next_free;
+    while (header_ptr != heap->free_list) {
+
+        /* get current freed memory block size */
+        if (__MEMITEM_SIZE(header_ptr) >= size) {
+            return header_ptr;
+        }
+
+        /* move to next free memory block */
+        header_ptr = header_ptr->next_free;
+    }
+
+    return NULL;
+}
+
+static void __free_list_init (struct am_memheap *heap)
+{
+    (void)heap;
+}
+
+#endif /* AM_MEMHEAP_TLSF */
+
 /*
  * The initialized memory pool will be:
  * +-----------------------------------+--------------------------+
@@ -82,6 +307,7 @@ am_err_t am_memheap_init(struct am_memheap *memheap,
 
     /* set the free list to free list header */
     memheap->free_list = item;
+    __free_list_init(memheap);
 
     /* initialize the first big memory block */
     item            = (struct am_memheap_item *)start_addr;
@@ -100,10 +326,7 @@ am_err_t am_memheap_init(struct am_memheap *memheap,
     memheap->block_list = item;
 
     /* place the big memory block to free list */
-    item->next_free = memheap->free_list->next_free;
-    item->prev_free = memheap->free_list;
-    memheap->free_list->next_free->prev_free = item;
-    memheap->free_list->next_free            = item;
+    __free_insert(memheap, item);
 
     /* move to the end of memory pool to build a small tailer block,
      * which prevents block merging
@@ -142,23 +365,15 @@ void *am_memheap_alloc(struct am_memheap *heap, uint32_t size)
     if (size < heap->available_size) {
 
         /* search on free list */
-        free_size = 0;
-
-        /* get the first free memory block */
-        header_ptr = heap->free_list->next_free;
-        while (header_ptr != heap->free_list && free_size < size) {
-
-            /* get current freed memory block size */
-            free_size = __MEMITEM_SIZE(header_ptr);
-            if (free_size < size) {
-                /* move to next free memory block */
-                header_ptr = header_ptr->next_free;
-            }
-        }
+        header_ptr = __free_find(heap, size);
 
         /* determine if the memory is available. */
-        if (free_size >= size) {
+        if (header_ptr != NULL) {
             /* a block that satisfies the request has been found. */
+            free_size = __MEMITEM_SIZE(header_ptr);
+
+            /* remove header ptr from free list */
+            __free_remove(heap, header_ptr);
 
             /* determine if the block needs to be split. */
             if (free_size >= (size + __MEMHEAP_SIZE + __MEMHEAP_MINALLOC)){
@@ -187,17 +402,8 @@ void *am_memheap_alloc(struct am_memheap *heap, uint32_t size)
                 header_ptr->next->prev = new_ptr;
                 header_ptr->next       = new_ptr;
 
-                /* remove header ptr from free list */
-                header_ptr->next_free->prev_free = header_ptr->prev_free;
-                header_ptr->prev_free->next_free = header_ptr->next_free;
-                header_ptr->next_free = NULL;
-                header_ptr->prev_free = NULL;
-
                 /* insert new_ptr to free list */
-                new_ptr->next_free = heap->free_list->next_free;
-                new_ptr->prev_free = heap->free_list;
-                heap->free_list->next_free->prev_free = new_ptr;
-                heap->free_list->next_free            = new_ptr;
+                __free_insert(heap, new_ptr);
                 AM_DBGF(("new ptr: next_free 0x%08x, prev_free 0x%08x\n",
                          new_ptr->next_free,
                          new_ptr->prev_free));
@@ -217,20 +423,15 @@ void *am_memheap_alloc(struct am_memheap *heap, uint32_t size)
                 if (heap->pool_size - heap->available_size > heap->max_used_size) {
                     heap->max_used_size = heap->pool_size - heap->available_size;
                 }
-                /* remove header_ptr from free list */
-                AM_DBGF(("one block: block[0x%08x], next_free 0x%08x, prev_free 0x%08x\n",
-                         header_ptr,
-                         header_ptr->next_free,
-                         header_ptr->prev_free));
-
-                header_ptr->next_free->prev_free = header_ptr->prev_free;
-                header_ptr->prev_free->next_free = header_ptr->next_free;
-                header_ptr->next_free = NULL;
-                header_ptr->prev_free = NULL;
+                AM_DBGF(("one block: block[0x%08x]\n", header_ptr));
             }
 
             /* Mark the allocated block as not available. */
             header_ptr->magic    |= __MEMHEAP_USED;
+#ifdef AM_MEMHEAP_TRACE
+            header_ptr->file      = NULL;
+            header_ptr->line      = 0;
+#endif
 
             /* Return a memory address to the caller.  */
             AM_DBGF(("alloc mem: memory[0x%08x], heap[0x%08x], size: %d\n",
@@ -326,8 +527,7 @@ void *am_memheap_realloc(struct am_memheap *heap, void *ptr, size_t newsize)
                          next_ptr->next_free,
                          next_ptr->prev_free));
 
-                next_ptr->next_free->prev_free = next_ptr->prev_free;
-                next_ptr->prev_free->next_free = next_ptr->next_free;
+                __free_remove(heap, next_ptr);
                 next_ptr->next->prev = next_ptr->prev;
                 next_ptr->prev->next = next_ptr->next;
 
@@ -351,10 +551,7 @@ void *am_memheap_realloc(struct am_memheap *heap, void *ptr, size_t newsize)
                 header_ptr->next       = next_ptr;
 
                 /* insert next_ptr to free list */
-                next_ptr->next_free = heap->free_list->next_free;
-                next_ptr->prev_free = heap->free_list;
-                heap->free_list->next_free->prev_free = next_ptr;
-                heap->free_list->next_free            = next_ptr;
+                __free_insert(heap, next_ptr);
                 AM_DBGF(("new ptr: next_free 0x%08x, prev_free 0x%08x",
                          next_ptr->next_free,
                          next_ptr->prev_free));
@@ -366,6 +563,13 @@ void *am_memheap_realloc(struct am_memheap *heap, void *ptr, size_t newsize)
         /* re-allocate a memory block */
         new_ptr = (void*)am_memheap_alloc(heap, newsize);
         if (new_ptr != NULL) {
+#ifdef AM_MEMHEAP_TRACE
+            /* the new block belongs to the original caller */
+            next_ptr = (struct am_memheap_item *)
+                       ((uint8_t *)new_ptr - __MEMHEAP_SIZE);
+            next_ptr->file = header_ptr->file;
+            next_ptr->line = header_ptr->line;
+#endif
             memcpy(new_ptr, ptr, oldsize < newsize ? oldsize : newsize);
             am_memheap_free(ptr);
         }
@@ -410,19 +614,15 @@ void *am_memheap_realloc(struct am_memheap *heap, void *ptr, size_t newsize)
         AM_DBGF(("merge: right node 0x%08x, next_free 0x%08x, prev_free 0x%08x\n",
                  header_ptr, header_ptr->next_free, header_ptr->prev_free));
 
+        /* remove free ptr from free list */
+        __free_remove(heap, free_ptr);
+
         free_ptr->next->prev = new_ptr;
         new_ptr->next   = free_ptr->next;
-
-        /* remove free ptr from free list */
-        free_ptr->next_free->prev_free = free_ptr->prev_free;
-        free_ptr->prev_free->next_free = free_ptr->next_free;
     }
 
     /* insert the split block to free list */
-    new_ptr->next_free = heap->free_list->next_free;
-    new_ptr->prev_free = heap->free_list;
-    heap->free_list->next_free->prev_free = new_ptr;
-    heap->free_list->next_free            = new_ptr;
+    __free_insert(heap, new_ptr);
     AM_DBGF(("new free ptr: next_free 0x%08x, prev_free 0x%08x\n",
              new_ptr->next_free,
              new_ptr->prev_free));
@@ -439,13 +639,10 @@ void am_memheap_free(void *ptr)
 {
     struct am_memheap *heap;
     struct am_memheap_item *header_ptr, *new_ptr;
-    uint32_t insert_header;
 
 	/* NULL check */
 	if (ptr == NULL) return;
 
-    /* set initial status as OK */
-    insert_header = 1;
     new_ptr       = NULL;
     header_ptr    = (struct am_memheap_item *)
                     ((uint8_t *)ptr - __MEMHEAP_SIZE);
@@ -471,14 +668,15 @@ void am_memheap_free(void *ptr)
         /* adjust the available number of bytes. */
         heap->available_size = heap->available_size + __MEMHEAP_SIZE;
 
+        /* the size of previous neighbor changes, take it out of free list */
+        __free_remove(heap, header_ptr->prev);
+
         /* yes, merge block with previous neighbor. */
         (header_ptr->prev)->next = header_ptr->next;
         (header_ptr->next)->prev = header_ptr->prev;
 
         /* move header pointer to previous. */
         header_ptr = header_ptr->prev;
-        /* don't insert header to free list */
-        insert_header = 0;
     }
 
     /* determine if the block can be merged with the next neighbor. */
@@ -492,26 +690,167 @@ void am_memheap_free(void *ptr)
         AM_DBGF(("merge: right node 0x%08x, next_free 0x%08x, prev_free 0x%08x\n",
                  new_ptr, new_ptr->next_free, new_ptr->prev_free));
 
+        /* remove new ptr from free list */
+        __free_remove(heap, new_ptr);
+
         new_ptr->next->prev = header_ptr;
         header_ptr->next    = new_ptr->next;
+    }
 
-        /* remove new ptr from free list */
-        new_ptr->next_free->prev_free = new_ptr->prev_free;
-        new_ptr->prev_free->next_free = new_ptr->next_free;
+    /* insert the merged block to free list */
+    __free_insert(heap, header_ptr);
+
+    AM_DBGF(("insert to free list: next_free 0x%08x, prev_free 0x%08x\n",
+             header_ptr->next_free, header_ptr->prev_free));
+}
+
+/******************************************************************************/
+int am_memheap_walk (struct am_memheap    *heap,
+                     am_memheap_walk_cb_t  pfn_cb,
+                     void                 *p_arg)
+{
+    struct am_memheap_item *item;
+    const char             *file;
+    int                     line;
+    int                     n = 0;
+
+    am_assert(heap != NULL);
+
+    /* the tailer block points back to the start, and ends the walk */
+    for (item = heap->block_list; item->next > item; item = item->next) {
+
+        file = NULL;
+        line = 0;
+#ifdef AM_MEMHEAP_TRACE
+        if (__MEMHEAP_IS_USED(item)) {
+            file = item->file;
+            line = item->line;
+        }
+#endif
+        if (pfn_cb != NULL) {
+            pfn_cb(p_arg,
+                   (uint8_t *)item + __MEMHEAP_SIZE,
+                   __MEMITEM_SIZE(item),
+                   (am_bool_t)(__MEMHEAP_IS_USED(item) ? AM_TRUE : AM_FALSE),
+                   file,
+                   line);
+        }
+        n++;
+    }
+
+    return n;
+}
+
+/******************************************************************************/
+static void __memheap_info_cb (void       *p_arg,
+                               void       *p_mem,
+                               uint32_t    size,
+                               am_bool_t   used,
+                               const char *file,
+                               int         line)
+{
+    am_memheap_info_t *p_info = (am_memheap_info_t *)p_arg;
+
+    (void)p_mem;
+    (void)file;
+    (void)line;
+
+    if (used) {
+        p_info->used_blocks++;
+    } else {
+        p_info->free_blocks++;
+        p_info->total_free += size;
+        if (size > p_info->largest_free) {
+            p_info->largest_free = size;
+        }
+    }
+}
+
+void am_memheap_info_get (struct am_memheap *heap, am_memheap_info_t *p_info)
+{
+    memset(p_info, 0, sizeof(*p_info));
+
+    am_memheap_walk(heap, __memheap_info_cb, p_info);
+
+    if (p_info->total_free != 0) {
+        p_info->frag = 100 - (uint32_t)((uint64_t)p_info->largest_free * 100 /
+                                        p_info->total_free);
+    }
+}
+
+/******************************************************************************/
+uint32_t am_memheap_largest_free_get (struct am_memheap *heap)
+{
+    am_memheap_info_t info;
+
+    am_memheap_info_get(heap, &info);
+
+    return info.largest_free;
+}
+
+/******************************************************************************/
+static void __memheap_dump_cb (void       *p_arg,
+                               void       *p_mem,
+                               uint32_t    size,
+                               am_bool_t   used,
+                               const char *file,
+                               int         line)
+{
+    (void)p_arg;
+
+    am_kprintf("  0x%08x %8d %s", (uint32_t)p_mem, size, used ? "used" : "free");
+    if (file != NULL) {
+        am_kprintf(" %s:%d", file, line);
     }
+    am_kprintf("\r\n");
+}
 
-    if (insert_header) {
-        /* no left merge, insert to free list */
-        header_ptr->next_free = heap->free_list->next_free;
-        header_ptr->prev_free = heap->free_list;
-        heap->free_list->next_free->prev_free = header_ptr;
-        heap->free_list->next_free            = header_ptr;
+void am_memheap_dump (struct am_memheap *heap)
+{
+    am_memheap_info_t info;
+
+    am_memheap_info_get(heap, &info);
+
+    am_kprintf("heap %s: start 0x%08x, size %d, available %d, max used %d\r\n",
+               heap->name,
+               (uint32_t)heap->start_addr,
+               heap->pool_size,
+               heap->available_size,
+               heap->max_used_size);
+    am_kprintf("free %d in %d blocks, largest %d, used blocks %d, frag %d%%\r\n",
+               info.total_free,
+               info.free_blocks,
+               info.largest_free,
+               info.used_blocks,
+               info.frag);
+
+    am_memheap_walk(heap, __memheap_dump_cb, NULL);
+}
+
+#ifdef AM_MEMHEAP_TRACE
 
-        AM_DBGF(("insert to free list: next_free 0x%08x, prev_free 0x%08x\n",
-                 header_ptr->next_free, header_ptr->prev_free));
+/******************************************************************************/
+void *am_memheap_alloc_tag (struct am_memheap *heap,
+                            uint32_t           size,
+                            const char        *file,
+                            int                line)
+{
+    struct am_memheap_item *header_ptr;
+    void                   *ptr;
+
+    ptr = am_memheap_alloc(heap, size);
+    if (ptr != NULL) {
+        header_ptr       = (struct am_memheap_item *)
+                           ((uint8_t *)ptr - __MEMHEAP_SIZE);
+        header_ptr->file = file;
+        header_ptr->line = line;
     }
+
+    return ptr;
 }
 
+#endif /* AM_MEMHEAP_TRACE */
+
 /* end of file */
 
 
@@ -0,0 +1,116 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ڴ
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+#include "am_common.h"
+#include "am_mempool.h"
+#include "am_int.h"
+
+/******************************************************************************/
+am_mempool_handle_t am_mempool_init (am_mempool_t *p_pool,
+                                     void         *p_buf,
+                                     size_t        buf_size,
+                                     size_t        blk_size)
+{
+    char     *p_blk;
+    uint32_t  i;
+
+    if ((p_pool == NULL) || (p_buf == NULL) ||
+        !AM_ALIGNED(p_buf, sizeof(void *))) {
+        return NULL;
+    }
+
+    blk_size = AM_MEMPOOL_BLK_SIZE(blk_size);
+
+    if (buf_size < blk_size) {
+        return NULL;
+    }
+
+    p_pool->blk_size = blk_size;
+    p_pool->nblks    = buf_size / blk_size;
+    p_pool->nfree    = p_pool->nblks;
+    p_pool->max_used = 0;
+    p_pool->p_start  = (char *)p_buf;
+    p_pool->p_end    = p_pool->p_start + p_pool->nblks * blk_size;
+
+    /* ÿпĵһֱһпĵַ */
+    p_blk = p_pool->p_start;
+    for (i = 0; i < p_pool->nblks - 1; i++) {
+        *(void **)p_blk = p_blk + blk_size;
+        p_blk          += blk_size;
+    }
+    *(void **)p_blk = NULL;
+
+    p_pool->p_free = p_pool->p_start;
+
+    return p_pool;
+}
+
+/******************************************************************************/
+void *am_mempool_alloc (am_mempool_handle_t handle)
+{
+    void     *p_blk;
+    uint32_t  used;
+    uint32_t  key;
+
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    key = am_int_cpu_lock();
+
+    p_blk = handle->p_free;
+    if (p_blk != NULL) {
+        handle->p_free = *(void **)p_blk;
+        handle->nfree--;
+
+        used = handle->nblks - handle->nfree;
+        if (used > handle->max_used) {
+            handle->max_used = used;
+        }
+    }
+
+    am_int_cpu_unlock(key);
+
+    return p_blk;
+}
+
+/******************************************************************************/
+int am_mempool_free (am_mempool_handle_t handle, void *p_blk)
+{
+    uint32_t key;
+
+    if ((handle == NULL) || !am_mempool_is_owner(handle, p_blk) ||
+        (((char *)p_blk - handle->p_start) % handle->blk_size != 0)) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+
+    *(void **)p_blk = handle->p_free;
+    handle->p_free  = p_blk;
+    handle->nfree++;
+
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/* end of file */
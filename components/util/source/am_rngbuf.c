@@ -16,6 +16,10 @@
  *
  * \internal
  * \par modification history
+ * - 1.04 26-10-18  lgg, record ring buffer indices have a single writer each
+ * - 1.03 26-10-18  lgg, add record-oriented ring buffer
+ * - 1.02 26-10-18  lgg, add zero-copy reserve/commit and peek/release
+ * - 1.01 26-10-18  lgg, add lock-free SPSC ring buffer
  * - 1.00 15-12-09  tee, add implementation from AWorks
  * \endinternal
  */
@@ -239,4 +243,339 @@ void am_rngbuf_move_ahead (am_rngbuf_t rb, size_t n)
     rb->in = n;
 }
 
+/******************************************************************************/
+size_t am_rngbuf_write_reserve (am_rngbuf_t   rb,
+                                char        **pp_span1,
+                                char        **pp_span2,
+                                size_t       *p_len2)
+{
+    int in    = rb->in;
+    int nfree = rb->out - in - 1;
+    int len1;
+
+    if (nfree < 0) {
+        nfree += rb->size;
+    }
+
+    /* һൽĩβʣĿпռӻʼʼ */
+    len1 = min(nfree, rb->size - in);
+
+    *pp_span1 = &rb->buf[in];
+
+    if (pp_span2 != NULL) {
+        *pp_span2 = rb->buf;
+    }
+    if (p_len2 != NULL) {
+        *p_len2 = nfree - len1;
+    }
+
+    return len1;
+}
+
+/******************************************************************************/
+void am_rngbuf_write_commit (am_rngbuf_t rb, size_t nbytes)
+{
+    am_rngbuf_move_ahead(rb, nbytes);
+}
+
+/******************************************************************************/
+size_t am_rngbuf_read_peek (am_rngbuf_t   rb,
+                            char        **pp_span1,
+                            char        **pp_span2,
+                            size_t       *p_len2)
+{
+    int out    = rb->out;
+    int nbytes = rb->in - out;
+    int len1;
+
+    if (nbytes < 0) {
+        nbytes += rb->size;
+    }
+
+    len1 = min(nbytes, rb->size - out);
+
+    *pp_span1 = &rb->buf[out];
+
+    if (pp_span2 != NULL) {
+        *pp_span2 = rb->buf;
+    }
+    if (p_len2 != NULL) {
+        *p_len2 = nbytes - len1;
+    }
+
+    return len1;
+}
+
+/******************************************************************************/
+void am_rngbuf_read_release (am_rngbuf_t rb, size_t nbytes)
+{
+    int n = rb->out + nbytes;
+
+    if (n >= rb->size) {
+        n -= rb->size;
+    }
+
+    rb->out = n;
+}
+
+/******************************************************************************/
+
+/*
+ * SPSC λڴ
+ *
+ * дݺ󷢲 inȶݺ󷢲 outϱ֤ݷ
+ * µȺ˳򲻱˴š
+ */
+#if defined(__CC_ARM)
+#define __RNGBUF_SPSC_BARRIER()    __dmb(0xF)
+#elif defined(__ICCARM__)
+#include <intrinsics.h>
+#define __RNGBUF_SPSC_BARRIER()    __DMB()
+#elif defined(__GNUC__)
+#define __RNGBUF_SPSC_BARRIER()    __sync_synchronize()
+#else
+#define __RNGBUF_SPSC_BARRIER()
+#endif
+
+/******************************************************************************/
+int am_rngbuf_spsc_init (struct am_rngbuf_spsc *p_rb, char *p_buf, size_t size)
+{
+    if ((size == 0) || ((size & (size - 1)) != 0) || (p_buf == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    p_rb->in   = 0;
+    p_rb->out  = 0;
+    p_rb->mask = size - 1;
+    p_rb->buf  = p_buf;
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+int am_rngbuf_spsc_putchar (am_rngbuf_spsc_t rb, const char data)
+{
+    uint32_t in  = rb->in;
+    uint32_t out = rb->out;     /* acquire: Ѷ out ֮ǰ */
+
+    if ((in - out) > rb->mask) {
+        return 0;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+    rb->buf[in & rb->mask] = data;
+    __RNGBUF_SPSC_BARRIER();    /* release: д in ĸ */
+    rb->in = in + 1;
+
+    return 1;
+}
+
+/******************************************************************************/
+int am_rngbuf_spsc_getchar (am_rngbuf_spsc_t rb, char *p_data)
+{
+    uint32_t out = rb->out;
+    uint32_t in  = rb->in;      /* acquire: д in ֮ǰ */
+
+    if (in == out) {
+        return 0;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+    *p_data = rb->buf[out & rb->mask];
+    __RNGBUF_SPSC_BARRIER();    /* release: ݶȡ out ĸ */
+    rb->out = out + 1;
+
+    return 1;
+}
+
+/******************************************************************************/
+size_t am_rngbuf_spsc_put (am_rngbuf_spsc_t rb, const char *p_buf, size_t nbytes)
+{
+    uint32_t in  = rb->in;
+    uint32_t out = rb->out;
+    uint32_t off = in & rb->mask;
+    size_t   bytes_put;
+    size_t   bytes_tmp;
+
+    bytes_put = min(nbytes, rb->mask + 1 - (in - out));
+    if (bytes_put == 0) {
+        return 0;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+
+    /* ĩβʣಿֻƵʼ */
+    bytes_tmp = min(bytes_put, rb->mask + 1 - off);
+    memcpy(&rb->buf[off], p_buf, bytes_tmp);
+    memcpy(rb->buf, p_buf + bytes_tmp, bytes_put - bytes_tmp);
+
+    __RNGBUF_SPSC_BARRIER();
+    rb->in = in + bytes_put;
+
+    return bytes_put;
+}
+
+/******************************************************************************/
+size_t am_rngbuf_spsc_get (am_rngbuf_spsc_t rb, char *p_buf, size_t nbytes)
+{
+    uint32_t out = rb->out;
+    uint32_t in  = rb->in;
+    uint32_t off = out & rb->mask;
+    size_t   bytes_got;
+    size_t   bytes_tmp;
+
+    bytes_got = min(nbytes, in - out);
+    if (bytes_got == 0) {
+        return 0;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+
+    bytes_tmp = min(bytes_got, rb->mask + 1 - off);
+    memcpy(p_buf, &rb->buf[off], bytes_tmp);
+    memcpy(p_buf + bytes_tmp, rb->buf, bytes_got - bytes_tmp);
+
+    __RNGBUF_SPSC_BARRIER();
+    rb->out = out + bytes_got;
+
+    return bytes_got;
+}
+
+/******************************************************************************/
+void am_rngbuf_spsc_flush (am_rngbuf_spsc_t rb)
+{
+    rb->out = rb->in;
+}
+
+/******************************************************************************/
+
+/*
+ * ¼λĶд 0 ~ 2 * nrecs - 1 ֮ѭ֮Ϊ¼
+ * 赥ļֵдֻһ޸ġ
+ */
+
+/* ǰ n ¼ */
+static size_t __rngbuf_rec_idx_add (am_rngbuf_rec_t rb, size_t idx, size_t n)
+{
+    idx += n;
+    if (idx >= 2 * rb->nrecs) {
+        idx -= 2 * rb->nrecs;
+    }
+
+    return idx;
+}
+
+/* Ӧļ¼λ */
+static size_t __rngbuf_rec_pos (am_rngbuf_rec_t rb, size_t idx)
+{
+    return (idx >= rb->nrecs) ? (idx - rb->nrecs) : idx;
+}
+
+/******************************************************************************/
+int am_rngbuf_rec_init (struct am_rngbuf_rec *p_rb,
+                        void                 *p_buf,
+                        size_t                rec_size,
+                        size_t                nrecs,
+                        am_bool_t             overwrite)
+{
+    if ((p_buf == NULL) || (rec_size == 0) || (nrecs == 0) ||
+        (nrecs > ((size_t)-1) / 2)) {
+        return -AM_EINVAL;
+    }
+
+    p_rb->in        = 0;
+    p_rb->out       = 0;
+    p_rb->nrecs     = nrecs;
+    p_rb->rec_size  = rec_size;
+    p_rb->overwrite = overwrite;
+    p_rb->buf       = (char *)p_buf;
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+size_t am_rngbuf_rec_put (am_rngbuf_rec_t rb, const void *p_recs, size_t nrecs)
+{
+    const char *p_src = (const char *)p_recs;
+    size_t      in    = rb->in;
+    size_t      n     = nrecs;
+    size_t      n_free;
+    size_t      pos;
+    size_t      n_tmp;
+
+    n_free = rb->nrecs - am_rngbuf_rec_nrecs(rb);
+
+    if (rb->overwrite) {
+
+        /* Ĳֻµļ¼ */
+        if (n > rb->nrecs) {
+            p_src += (n - rb->nrecs) * rb->rec_size;
+            n      = rb->nrecs;
+        }
+
+        /* Ϊ¼¼ڳռ䣬ɵļ¼޸Ķ軥⣩ */
+        if (n > n_free) {
+            rb->out = __rngbuf_rec_idx_add(rb, rb->out, n - n_free);
+        }
+    } else {
+        n     = min(n, n_free);
+        nrecs = n;
+    }
+
+    if (n == 0) {
+        return nrecs;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+
+    /* οдλõĩβԼƺĲ */
+    pos   = __rngbuf_rec_pos(rb, in);
+    n_tmp = min(n, rb->nrecs - pos);
+    memcpy(&rb->buf[pos * rb->rec_size], p_src, n_tmp * rb->rec_size);
+    memcpy(rb->buf,
+           p_src + n_tmp * rb->rec_size,
+           (n - n_tmp) * rb->rec_size);
+
+    /* дٸд */
+    __RNGBUF_SPSC_BARRIER();
+    rb->in = __rngbuf_rec_idx_add(rb, in, n);
+
+    return nrecs;
+}
+
+/******************************************************************************/
+size_t am_rngbuf_rec_get (am_rngbuf_rec_t rb, void *p_recs, size_t nrecs)
+{
+    char   *p_dst = (char *)p_recs;
+    size_t  out   = rb->out;
+    size_t  n     = min(nrecs, am_rngbuf_rec_nrecs(rb));
+    size_t  pos;
+    size_t  n_tmp;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    __RNGBUF_SPSC_BARRIER();
+
+    pos   = __rngbuf_rec_pos(rb, out);
+    n_tmp = min(n, rb->nrecs - pos);
+    memcpy(p_dst, &rb->buf[pos * rb->rec_size], n_tmp * rb->rec_size);
+    memcpy(p_dst + n_tmp * rb->rec_size,
+           rb->buf,
+           (n - n_tmp) * rb->rec_size);
+
+    /* ݶٸ¶ͷſռ */
+    __RNGBUF_SPSC_BARRIER();
+    rb->out = __rngbuf_rec_idx_add(rb, out, n);
+
+    return n;
+}
+
+/******************************************************************************/
+void am_rngbuf_rec_flush (am_rngbuf_rec_t rb)
+{
+    rb->out = rb->in;
+}
+
 /* end of file */
@@ -16,6 +16,11 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.05 26-10-18  lgg, reject timers too narrow for one tick in tickless mode
+ * - 1.04 26-10-18  lgg, add trace points
+ * - 1.03 26-10-18  lgg, add deferred callbacks and statistics
+ * - 1.02 26-10-18  lgg, add tickless mode
+ * - 1.01 26-10-18  lgg, use hierarchical timing wheel instead of delta list
  * - 1.00 15-08-03  tee, first implementation.
  * \endinternal
  */
@@ -23,12 +28,32 @@
 #include "am_softimer.h"
 #include "am_common.h"
 #include "am_int.h"
+#include "am_trace.h"
+#include <string.h>
+
+/** \brief ÿʱֵĲ */
+#define __WHEEL_SIZE       (1u << AM_SOFTIMER_WHEEL_BITS)
+
+/** \brief  */
+#define __WHEEL_MASK       (__WHEEL_SIZE - 1)
+
+/** \brief ʱֱֿӶλ tick  */
+#define __WHEEL_MAX_IDX    \
+    ((1ul << (AM_SOFTIMER_WHEEL_BITS * AM_SOFTIMER_WHEEL_LEVELS)) - 1)
+
+/** \brief  lvl ʱУʱ expires ӦĲ */
+#define __WHEEL_SLOT(lvl, expires) \
+    (((expires) >> ((lvl) * AM_SOFTIMER_WHEEL_BITS)) & __WHEEL_MASK)
 
 /** \brief ʱӲʱƵʣʱƵʲΪ0 */
 static unsigned int __g_hwtimer_freq = 0;
 
-/** \brief ʱͷ */
-static struct am_list_head g_softimer_head;
+/** \brief ֲʱ֣ÿΪһʱ */
+static struct am_list_head __g_softimer_wheel[AM_SOFTIMER_WHEEL_LEVELS]
+                                             [__WHEEL_SIZE];
+
+/** \brief һ tickǰʱ̼Ϊ __g_softimer_next - 1 */
+static unsigned int __g_softimer_next;
 
 /******************************************************************************/
 static unsigned int __ms_to_ticks (unsigned int ms)
@@ -40,119 +65,455 @@ static unsigned int __ms_to_ticks (unsigned int ms)
 }
 
 /******************************************************************************/
-static void __softimer_add (am_softimer_t *p_timer, unsigned int ticks)
+
+/* ʱ̣p_timer->ticksʱʱкʵĲ */
+static void __softimer_wheel_add (am_softimer_t *p_timer)
 {
-    struct am_list_head  *p;
-    am_softimer_t        *p_timer_iterator = NULL;
-    
-    am_list_for_each(p, &g_softimer_head) {
-        p_timer_iterator = am_list_entry(p, am_softimer_t, node);
-        if (ticks >= p_timer_iterator->ticks ) {  /* ͬʱӦڽڵ */
-            ticks -= p_timer_iterator->ticks;
-        } else {
+    unsigned int expires = p_timer->ticks;
+    unsigned int idx     = expires - __g_softimer_next;
+    unsigned int lvl;
+
+    if ((int)idx < 0) {                       /* ѵڣһĲ */
+        idx     = 0;
+        expires = __g_softimer_next;
+    } else if (idx > __WHEEL_MAX_IDX) {       /* Χȷһ     */
+        idx     = __WHEEL_MAX_IDX;
+        expires = __g_softimer_next + __WHEEL_MAX_IDX;
+    }
+
+    /* ൽԽԶԽߵһ */
+    for (lvl = 0; lvl < AM_SOFTIMER_WHEEL_LEVELS - 1; lvl++) {
+        if (idx < (1u << ((lvl + 1) * AM_SOFTIMER_WHEEL_BITS))) {
             break;
         }
     }
-    p_timer->ticks = ticks;
 
-    am_list_add_tail( &p_timer->node, p);         /* ȷλò붨ʱ   */
-    
-    if (p != &g_softimer_head ) {                 /* pָʱʱҪ    */
-        p_timer_iterator->ticks -= ticks;
-    }
+    am_list_add_tail(&p_timer->node,
+                     &__g_softimer_wheel[lvl][__WHEEL_SLOT(lvl, expires)]);
 }
 
 /******************************************************************************/
-static void __softimer_remove (am_softimer_t *p_timer)
+static void __softimer_add (am_softimer_t *p_timer, unsigned int ticks)
 {
-    am_softimer_t *p_next = NULL;
+    p_timer->ticks = __g_softimer_next - 1 + ticks;
 
-    if (am_list_empty(&p_timer->node) ) {         /* ڵδ         */
-        return ;
-    }
-    
-    /* ǰڵ㲻һڵ, ɾýڵǰһڵʱtick */
-    if ( (&p_timer->node)->next != &g_softimer_head ) {
-        p_next = am_list_entry((&p_timer->node)->next, am_softimer_t, node);
-        p_next->ticks += p_timer->ticks;
-    }
-    
+    __softimer_wheel_add(p_timer);
+}
+
+/******************************************************************************/
+static void __softimer_remove (am_softimer_t *p_timer)
+{
     am_list_del_init(&p_timer->node);
 }
 
-/* ԳʼָƵʵøú  */
-void am_softimer_module_tick (void)
+/******************************************************************************/
+
+/*
+ * һеĶʱ·䵽ϵ͵һÿֻڹж״̬ƶһʱ
+ * жϵʱжʱĸ޹
+ */
+static void __softimer_cascade (struct am_list_head *p_slot)
 {
-    struct am_list_head *p;
+    struct am_list_head  work;
     am_softimer_t       *p_timer;
+    int                  old;
 
-    int old = am_int_cpu_lock();
+    AM_INIT_LIST_HEAD(&work);
 
-    /* ׸ڵм1ʱȷ */
-    if ( !am_list_empty( &g_softimer_head ) ) {
+    old = am_int_cpu_lock();
+    am_list_splice_init(p_slot, &work);
+    am_int_cpu_unlock(old);
 
-        /* ָһЧԪؽڵ */
-        p       = (&g_softimer_head)->next;
-        p_timer = am_list_entry(p, am_softimer_t, node);
+    AM_FOREVER {
+        old = am_int_cpu_lock();
 
-        /*
-         * ׽ڵֵ1
-         */
-        if (p_timer->ticks) {
-            p_timer->ticks--;
+        if (am_list_empty(&work)) {
+            am_int_cpu_unlock(old);
+            break;
         }
+
+        p_timer = am_list_first_entry(&work, am_softimer_t, node);
+        am_list_del_init(&p_timer->node);
+        __softimer_wheel_add(p_timer);
+
+        am_int_cpu_unlock(old);
     }
+}
+
+#ifdef AM_SOFTIMER_STAT
+
+/** \brief ͳִʱʹõʱԴ */
+static uint32_t (*__g_softimer_clk_get) (void) = NULL;
 
+#define __SOFTIMER_CLK_GET() \
+    ((__g_softimer_clk_get != NULL) ? __g_softimer_clk_get() : 0)
+
+#endif /* AM_SOFTIMER_STAT */
+
+/* ִжʱĻصͳִʱ */
+static void __softimer_callback_run (am_softimer_t *p_timer)
+{
+    am_pfnvoid_t callback = p_timer->timeout_callback;
+#ifdef AM_SOFTIMER_STAT
+    uint32_t start = __SOFTIMER_CLK_GET();
+    uint32_t exec;
+#endif
+
+    /* ص޸Ķʱ˳¼ʹͬһ */
+    if (callback != NULL) {
+        AM_TRACE_ENTER(AM_TRACE_TIMER, callback);
+        callback(p_timer->p_arg);
+        AM_TRACE_EXIT(AM_TRACE_TIMER, callback);
+    }
+
+#ifdef AM_SOFTIMER_STAT
+    exec = __SOFTIMER_CLK_GET() - start;
+
+    p_timer->stat.run_count++;
+    p_timer->stat.exec_last   = exec;
+    p_timer->stat.exec_total += exec;
+    if (exec > p_timer->stat.exec_max) {
+        p_timer->stat.exec_max = exec;
+    }
+#endif
+}
+
+#ifdef AM_SOFTIMER_DEFER
+
+/* ִе񣬶ʱֹͣʱִлص */
+static void __softimer_job_func (void *p_arg)
+{
+    am_softimer_t *p_timer = (am_softimer_t *)p_arg;
+    am_bool_t      stopped;
+    int            old;
+
+    old     = am_int_cpu_lock();
+    stopped = am_list_empty(&p_timer->node);
     am_int_cpu_unlock(old);
 
-    old = am_int_cpu_lock();
+    if (!stopped) {
+        __softimer_callback_run(p_timer);
+    }
+}
+
+#endif /* AM_SOFTIMER_DEFER */
 
-    /* ׸ڵ㣬Ϊ 0 ȡ  */
-    while (!am_list_empty(&g_softimer_head)) {
+/* ʱڣֱִлص */
+static void __softimer_expire (am_softimer_t *p_timer)
+{
+#ifdef AM_SOFTIMER_DEFER
+    if (p_timer->jobq != NULL) {
+        if (am_jobq_post(p_timer->jobq, &p_timer->job) != AM_OK) {
+#ifdef AM_SOFTIMER_STAT
+            p_timer->stat.missed++;
+#endif
+        }
+        return;
+    }
+#endif
+
+    __softimer_callback_run(p_timer);
+}
+
+/* һ tickǰжϣصڼʱж */
+static int __softimer_tick_one (int old)
+{
+    struct am_list_head  work;
+    am_softimer_t       *p_timer;
+    unsigned int         now;
+    unsigned int         slot;
+    unsigned int         lvl;
+
+    /* һתһȦһӦеĶʱ· */
+    if ((__g_softimer_next & __WHEEL_MASK) == 0) {
+        am_int_cpu_unlock(old);
+        for (lvl = 1; lvl < AM_SOFTIMER_WHEEL_LEVELS; lvl++) {
+            slot = __WHEEL_SLOT(lvl, __g_softimer_next);
+            __softimer_cascade(&__g_softimer_wheel[lvl][slot]);
+            if (slot != 0) {
+                break;
+            }
+        }
+        old = am_int_cpu_lock();
+    }
 
-        p       = (&g_softimer_head)->next;
-        p_timer = am_list_entry(p, am_softimer_t, node);
+    AM_INIT_LIST_HEAD(&work);
 
-        /*
-         * һЧԪ,ýȻڵһ
-         * (ڵһ㣬ֵҲΪ 0´ɨͻ˳)
-         */
-        if (p_timer->ticks == 0) {
+    /* ȡ tick Ӧежʱ */
+    now = __g_softimer_next++;
+    am_list_splice_init(&__g_softimer_wheel[0][now & __WHEEL_MASK], &work);
 
-            /* ýڵ㱾ζʱʱ䵽ɾýڵ                  */
-            am_list_del_init(&p_timer->node);
+    /* ڼ䶨ʱֹܱͣӶ뿪 work  */
+    while (!am_list_empty(&work)) {
 
-            /* ڻصֹͣȽӽ  */
-            __softimer_add(p_timer, p_timer->repeat_ticks);
+        p_timer = am_list_first_entry(&work, am_softimer_t, node);
+        am_list_del_init(&p_timer->node);
 
-            /* صʱ Ϊж */
-            am_int_cpu_unlock(old);
+        /* ʱַΧĶʱδڣ·ʱ */
+        if ((int)(p_timer->ticks - now) > 0) {
+            __softimer_wheel_add(p_timer);
+            continue;
+        }
+
+        /* ڻصֹͣȽӽʱ  */
+        __softimer_add(p_timer, p_timer->repeat_ticks);
+
+        /* صʱ Ϊж */
+        am_int_cpu_unlock(old);
+
+        __softimer_expire(p_timer);
+
+        old = am_int_cpu_lock();
+    }
+
+    return old;
+}
+
+/*
+ * ȡһ¼ʱڻҪ·ĲۣҪ tick 
+ *  0 ʾûκеĶʱǰж
+ */
+static unsigned int __softimer_next_delta (void)
+{
+    unsigned int lvl, i, i0, shift, base, delta = 0, d;
+
+    for (i = 0; i < __WHEEL_SIZE; i++) {
+        if (!am_list_empty(
+                &__g_softimer_wheel[0][(__g_softimer_next + i) & __WHEEL_MASK])) {
+            delta = i + 1;
+            break;
+        }
+    }
 
-            if (p_timer->timeout_callback ) {
-                p_timer->timeout_callback(p_timer->p_arg);
+    for (lvl = 1; lvl < AM_SOFTIMER_WHEEL_LEVELS; lvl++) {
+        shift = lvl * AM_SOFTIMER_WHEEL_BITS;
+        base  = __g_softimer_next >> shift;
+
+        /* ǡöʱǰҪһ tick ʼʱ· */
+        i0 = (__g_softimer_next & ((1u << shift) - 1)) ? 1 : 0;
+
+        for (i = i0; i < i0 + __WHEEL_SIZE; i++) {
+            if (!am_list_empty(
+                    &__g_softimer_wheel[lvl][(base + i) & __WHEEL_MASK])) {
+                d = ((base + i) << shift) - __g_softimer_next + 1;
+                if ((delta == 0) || (d < delta)) {
+                    delta = d;
+                }
+                break;
             }
+        }
+    }
 
-            old = am_int_cpu_lock();
+    return delta;
+}
 
-        /* ֻҪΪ0Ľ㣬˳ѭ */
-        } else {
+/* һƽ nticks  tickֱû¼ tickǰж */
+static int __softimer_advance (int old, unsigned int nticks)
+{
+    unsigned int delta;
+
+    while (nticks != 0) {
+        delta = __softimer_next_delta();
+        if ((delta == 0) || (delta > nticks)) {
+            __g_softimer_next += nticks;
             break;
         }
+        __g_softimer_next += delta - 1;
+        nticks            -= delta;
+        old = __softimer_tick_one(old);
+    }
+
+    return old;
+}
+
+/* ԳʼָƵʵøú  */
+void am_softimer_module_tick (void)
+{
+    int old = am_int_cpu_lock();
+
+    old = __softimer_tick_one(old);
+
+    am_int_cpu_unlock(old);
+}
+
+/******************************************************************************/
+
+/** \brief Tickless ģʽʹõӲʱΪ NULL ʾ tick ģʽ */
+static am_timer_handle_t __g_tickless_handle = NULL;
+
+/** \brief Tickless ģʽʹõӲʱͨ */
+static uint8_t   __g_tickless_chan;
+
+/** \brief һ tick ӦӲʱֵ */
+static uint32_t  __g_tickless_cnt_per_tick;
+
+/** \brief Ӳʱһܶʱ tick  */
+static uint32_t  __g_tickless_max_ticks;
+
+/** \brief Ӳʱ tick  */
+static uint32_t  __g_tickless_prog;
+
+/** \brief ӲʱѾƽ tick  */
+static uint32_t  __g_tickless_done;
+
+/** \brief ӲʱʼʱѾĲһ tick ļֵ */
+static uint32_t  __g_tickless_frac;
+
+/** \brief ӲʱждʱӲʱ */
+static am_bool_t __g_tickless_busy = AM_FALSE;
+
+/*
+ * ȡӲʱǰֵʱƽǰʱ̣
+ * صǰʱ̲һ tick ļֵǰж
+ */
+static uint32_t __softimer_tickless_sync (int *p_old)
+{
+    uint32_t count = 0;
+    uint32_t ticks;
+
+    am_timer_count_get(__g_tickless_handle, __g_tickless_chan, &count);
+
+    count += __g_tickless_frac;
+    ticks  = count / __g_tickless_cnt_per_tick;
+
+    /* ζʱѵжδһ tick жϴ */
+    if (ticks >= __g_tickless_prog) {
+        ticks = __g_tickless_prog - 1;
+    }
+
+    if (ticks > __g_tickless_done) {
+        *p_old = __softimer_advance(*p_old, ticks - __g_tickless_done);
+        __g_tickless_done = ticks;
+    }
+
+    return count - ticks * __g_tickless_cnt_per_tick;
+}
+
+/* һ¼Ӳʱǰж */
+static int __softimer_tickless_program (int old)
+{
+    uint32_t frac  = __softimer_tickless_sync(&old);
+    uint32_t delta = __softimer_next_delta();
+
+    if ((delta == 0) || (delta > __g_tickless_max_ticks)) {
+        delta = __g_tickless_max_ticks;
     }
+
+    /* ڼ侭ʱٶʱһ tick */
+    if (frac >= __g_tickless_cnt_per_tick) {
+        frac = __g_tickless_cnt_per_tick - 1;
+    }
+
+    __g_tickless_prog = delta;
+    __g_tickless_done = 0;
+    __g_tickless_frac = frac;
+
+    am_timer_enable(__g_tickless_handle,
+                    __g_tickless_chan,
+                    delta * __g_tickless_cnt_per_tick - frac);
+
+    return old;
+}
+
+/* Ӳʱжϣƽζʱ tickһζʱ */
+static void __softimer_tickless_isr (void *p_arg)
+{
+    int old = am_int_cpu_lock();
+
+    (void)p_arg;
+
+    __g_tickless_busy = AM_TRUE;
+
+    old = __softimer_advance(old, __g_tickless_prog - __g_tickless_done);
+
+    /* Ѵ 0 ¿ʼڼ侭ʱʱ */
+    __g_tickless_prog = (uint32_t)-1;
+    __g_tickless_done = 0;
+    __g_tickless_frac = 0;
+
+    old = __softimer_tickless_program(old);
+
+    __g_tickless_busy = AM_FALSE;
+
     am_int_cpu_unlock(old);
 }
 
+/******************************************************************************/
 int am_softimer_module_init (unsigned int clkrate)
 {
+    unsigned int lvl, slot;
+
     if ((clkrate == 0)) {
 
         return -AM_EINVAL;
     }
 
-    AM_INIT_LIST_HEAD(&g_softimer_head);
-    __g_hwtimer_freq = clkrate;
+    for (lvl = 0; lvl < AM_SOFTIMER_WHEEL_LEVELS; lvl++) {
+        for (slot = 0; slot < __WHEEL_SIZE; slot++) {
+            AM_INIT_LIST_HEAD(&__g_softimer_wheel[lvl][slot]);
+        }
+    }
+    __g_softimer_next   = 0;
+    __g_hwtimer_freq    = clkrate;
+    __g_tickless_handle = NULL;
     return 0;
 }
+
+/******************************************************************************/
+int am_softimer_module_init_tickless (am_timer_handle_t handle,
+                                      uint8_t           chan,
+                                      unsigned int      clkrate)
+{
+    const am_timer_info_t *p_info;
+    uint32_t               freq;
+    uint32_t               max_count;
+    uint32_t               cnt_per_tick;
+    int                    old;
+
+    if ((handle == NULL) || (clkrate == 0)) {
+        return -AM_EINVAL;
+    }
+
+    p_info = am_timer_info_get(handle);
+
+    if ((p_info == NULL) ||
+        !(p_info->features & AM_TIMER_CAN_INTERRUPT) ||
+        !(p_info->features & AM_TIMER_INTERMEDIATE_COUNT)) {
+        return -AM_ENOTSUP;
+    }
+
+    if ((am_timer_count_freq_get(handle, chan, &freq) != AM_OK) ||
+        (freq < clkrate)) {
+        return -AM_EINVAL;
+    }
+
+    max_count = (p_info->counter_width >= 32) ?
+                0xFFFFFFFFul : ((1ul << p_info->counter_width) - 1);
+
+    /* һҪܶʱһ tick */
+    cnt_per_tick = freq / clkrate;
+    if (max_count / cnt_per_tick == 0) {
+        return -AM_EINVAL;
+    }
+
+    am_softimer_module_init(clkrate);
+
+    __g_tickless_chan         = chan;
+    __g_tickless_cnt_per_tick = cnt_per_tick;
+    __g_tickless_max_ticks    = max_count / cnt_per_tick;
+    __g_tickless_prog         = (uint32_t)-1;
+    __g_tickless_done         = 0;
+    __g_tickless_frac         = 0;
+
+    am_timer_callback_set(handle, chan, __softimer_tickless_isr, NULL);
+
+    old = am_int_cpu_lock();
+    __g_tickless_handle = handle;
+    old = __softimer_tickless_program(old);
+    am_int_cpu_unlock(old);
+
+    return AM_OK;
+}
  
 /******************************************************************************/
 int am_softimer_init (am_softimer_t *p_timer, 
@@ -171,6 +532,15 @@ int am_softimer_init (am_softimer_t *p_timer,
     
     p_timer->timeout_callback = p_func;
     p_timer->p_arg            = p_arg;
+
+#ifdef AM_SOFTIMER_DEFER
+    p_timer->jobq = NULL;
+    am_jobq_job_init(&p_timer->job, __softimer_job_func, p_timer, 0);
+#endif
+
+#ifdef AM_SOFTIMER_STAT
+    memset(&p_timer->stat, 0, sizeof(p_timer->stat));
+#endif
     
     am_int_cpu_unlock(old);
     
@@ -190,7 +560,20 @@ void am_softimer_start (am_softimer_t *p_timer, unsigned int ms)
     p_timer->repeat_ticks = ticks;
     
     __softimer_remove(p_timer);
-    __softimer_add(p_timer, ticks);
+
+    if ((__g_tickless_handle != NULL) && !__g_tickless_busy) {
+
+        /* Ƚʱƽǰʱ̣ʱӴ˿̿ʼ */
+        __softimer_tickless_sync(&old);
+        __softimer_add(p_timer, ticks);
+
+        /* 趨Ӳʱ絽ڣҪǰ */
+        if (ticks < __g_tickless_prog - __g_tickless_done) {
+            old = __softimer_tickless_program(old);
+        }
+    } else {
+        __softimer_add(p_timer, ticks);
+    }
     am_int_cpu_unlock(old);
 }
 
@@ -203,4 +586,63 @@ void am_softimer_stop (am_softimer_t *p_timer)
     am_int_cpu_unlock(old);
 }
 
+#ifdef AM_SOFTIMER_DEFER
+
+/******************************************************************************/
+int am_softimer_defer_set (am_softimer_t    *p_timer,
+                           am_jobq_handle_t  jobq,
+                           uint16_t          pri)
+{
+    int old;
+
+    if (p_timer == NULL) {
+        return -AM_EINVAL;
+    }
+
+    old = am_int_cpu_lock();
+    p_timer->jobq    = jobq;
+    p_timer->job.pri = pri;
+    am_int_cpu_unlock(old);
+
+    return AM_OK;
+}
+
+#endif /* AM_SOFTIMER_DEFER */
+
+#ifdef AM_SOFTIMER_STAT
+
+/******************************************************************************/
+void am_softimer_stat_clk_set (uint32_t (*pfn_clk_get) (void))
+{
+    __g_softimer_clk_get = pfn_clk_get;
+}
+
+/******************************************************************************/
+int am_softimer_stat_get (am_softimer_t *p_timer, am_softimer_stat_t *p_stat)
+{
+    int old;
+
+    if ((p_timer == NULL) || (p_stat == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    old = am_int_cpu_lock();
+    *p_stat = p_timer->stat;
+    am_int_cpu_unlock(old);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_softimer_stat_clr (am_softimer_t *p_timer)
+{
+    int old;
+
+    old = am_int_cpu_lock();
+    memset(&p_timer->stat, 0, sizeof(p_timer->stat));
+    am_int_cpu_unlock(old);
+}
+
+#endif /* AM_SOFTIMER_STAT */
+
 /* end of file */
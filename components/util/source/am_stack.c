@@ -0,0 +1,243 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ջʹͳƼ
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+#include "am_common.h"
+#include "am_stack.h"
+#include "am_int.h"
+#include "am_softimer.h"
+#include "am_vdebug.h"
+
+/** \brief ջױֵֵ */
+#define __STACK_CANARY_VALUE    0x5A5AF00Du
+
+/*******************************************************************************
+  ֲ
+*******************************************************************************/
+
+static am_stack_t             *__gp_stack_list = NULL;  /**< \brief ջ */
+static am_stack_overflow_cb_t  __gpfn_overflow_cb = NULL; /**< \brief ص */
+static void                   *__gp_overflow_arg  = NULL; /**< \brief ص */
+static am_softimer_t           __g_stack_guard_timer;   /**< \brief 鶨ʱ */
+static am_bool_t               __g_stack_guard_init = AM_FALSE;
+
+/*******************************************************************************
+  ֲ
+*******************************************************************************/
+
+/* Ƿ */
+static am_bool_t __stack_canary_ok (const am_stack_t *p_stack)
+{
+    int i;
+
+    for (i = 0; i < AM_STACK_CANARY_WORDS; i++) {
+        if (p_stack->p_bottom[i] != __STACK_CANARY_VALUE) {
+            return AM_FALSE;
+        }
+    }
+
+    return AM_TRUE;
+}
+
+/*  [p_start, p_end) */
+static void __stack_paint (uint32_t *p_start, uint32_t *p_end)
+{
+    while (p_start < p_end) {
+        *p_start++ = AM_STACK_PAINT_VALUE;
+    }
+}
+
+static void __stack_guard_timer_cb (void *p_arg)
+{
+    (void)p_arg;
+
+    am_stack_check();
+}
+
+/*******************************************************************************
+  ⲿ
+*******************************************************************************/
+
+int am_stack_register (am_stack_t *p_stack,
+                       const char *p_name,
+                       void       *p_bottom,
+                       void       *p_top)
+{
+    volatile uint32_t  marker = 0;
+    uint32_t          *p_end;
+    int                i;
+    int                key;
+
+    if ((p_stack == NULL) || (p_bottom == NULL) || (p_top == NULL)) {
+        return -AM_EINVAL;
+    }
+
+    p_stack->p_name   = p_name;
+    p_stack->p_bottom = (uint32_t *)(((uintptr_t)p_bottom + 3) & ~(uintptr_t)3);
+    p_stack->p_top    = (uint32_t *)((uintptr_t)p_top & ~(uintptr_t)3);
+    p_stack->overflow = AM_FALSE;
+
+    if (p_stack->p_top < p_stack->p_bottom + AM_STACK_CANARY_WORDS + 1) {
+        return -AM_EINVAL;
+    }
+
+    /* ʹõջֻ䵱ǰջָ¡ȥĲ */
+    p_end = p_stack->p_top;
+    if (((uint32_t *)&marker >= p_stack->p_bottom) &&
+        ((uint32_t *)&marker <  p_stack->p_top)) {
+        p_end = (uint32_t *)&marker - AM_STACK_PAINT_MARGIN / 4;
+        if (p_end < p_stack->p_bottom + AM_STACK_CANARY_WORDS) {
+            p_end = p_stack->p_bottom + AM_STACK_CANARY_WORDS;
+        }
+    }
+
+    for (i = 0; i < AM_STACK_CANARY_WORDS; i++) {
+        p_stack->p_bottom[i] = __STACK_CANARY_VALUE;
+    }
+    __stack_paint(p_stack->p_bottom + AM_STACK_CANARY_WORDS, p_end);
+
+    key = am_int_cpu_lock();
+    p_stack->p_next = __gp_stack_list;
+    __gp_stack_list = p_stack;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+size_t am_stack_size_get (const am_stack_t *p_stack)
+{
+    if (p_stack == NULL) {
+        return 0;
+    }
+
+    return (size_t)((char *)p_stack->p_top - (char *)p_stack->p_bottom);
+}
+
+/******************************************************************************/
+size_t am_stack_used_get (const am_stack_t *p_stack)
+{
+    const uint32_t *p_word;
+
+    if (p_stack == NULL) {
+        return 0;
+    }
+
+    if (!__stack_canary_ok(p_stack)) {
+        return am_stack_size_get(p_stack);
+    }
+
+    /* ջϣһдּΪʹù͵ַ */
+    p_word = p_stack->p_bottom + AM_STACK_CANARY_WORDS;
+    while ((p_word < p_stack->p_top) && (*p_word == AM_STACK_PAINT_VALUE)) {
+        p_word++;
+    }
+
+    return (size_t)((const char *)p_stack->p_top - (const char *)p_word);
+}
+
+/******************************************************************************/
+void am_stack_overflow_cb_set (am_stack_overflow_cb_t pfn_cb, void *p_arg)
+{
+    int key = am_int_cpu_lock();
+
+    __gpfn_overflow_cb = pfn_cb;
+    __gp_overflow_arg  = p_arg;
+
+    am_int_cpu_unlock(key);
+}
+
+/******************************************************************************/
+int am_stack_check (void)
+{
+    am_stack_t *p_stack;
+    int         ret = AM_OK;
+
+    for (p_stack = __gp_stack_list; p_stack != NULL; p_stack = p_stack->p_next) {
+
+        if (__stack_canary_ok(p_stack)) {
+            continue;
+        }
+
+        ret = -AM_EFAULT;
+
+        if (p_stack->overflow) {
+            continue;
+        }
+        p_stack->overflow = AM_TRUE;
+
+        if (__gpfn_overflow_cb != NULL) {
+            __gpfn_overflow_cb(__gp_overflow_arg, p_stack);
+        } else {
+            am_kprintf("stack %s overflow!\r\n",
+                       (p_stack->p_name != NULL) ? p_stack->p_name : "?");
+        }
+    }
+
+    return ret;
+}
+
+/******************************************************************************/
+int am_stack_guard_start (unsigned int period_ms)
+{
+    if (period_ms == 0) {
+        return -AM_EINVAL;
+    }
+
+    if (!__g_stack_guard_init) {
+        am_softimer_init(&__g_stack_guard_timer, __stack_guard_timer_cb, NULL);
+        __g_stack_guard_init = AM_TRUE;
+    }
+
+    am_softimer_start(&__g_stack_guard_timer, period_ms);
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_stack_guard_stop (void)
+{
+    if (__g_stack_guard_init) {
+        am_softimer_stop(&__g_stack_guard_timer);
+    }
+}
+
+/******************************************************************************/
+void am_stack_report (void)
+{
+    am_stack_t *p_stack;
+    size_t      size;
+    size_t      used;
+
+    for (p_stack = __gp_stack_list; p_stack != NULL; p_stack = p_stack->p_next) {
+
+        size = am_stack_size_get(p_stack);
+        used = am_stack_used_get(p_stack);
+
+        am_kprintf("stack %-8s size %6u used %6u (%3u%%)%s\r\n",
+                   (p_stack->p_name != NULL) ? p_stack->p_name : "?",
+                   (unsigned int)size,
+                   (unsigned int)used,
+                   (unsigned int)(used * 100 / size),
+                   __stack_canary_ok(p_stack) ? "" : " OVERFLOW");
+    }
+}
+
+/* end of file */
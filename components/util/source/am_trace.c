@@ -0,0 +1,177 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ϵͳи
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+#include "am_common.h"
+#include "am_trace.h"
+#include "am_int.h"
+#include "am_vdebug.h"
+
+#ifdef AM_TRACE
+
+/** \brief ¼ʱʱ¼Ĵ */
+#define __TRACE_CALIB_CNT    8
+
+/** \brief ٻ */
+static struct __trace_dev {
+    am_trace_rec_t     *p_buf;          /**< \brief  */
+    uint32_t            mask;           /**< \brief ¼ - 1 */
+    uint32_t            in;             /**< \brief Ѽ¼¼ */
+    uint32_t            lost;           /**< \brief ¼ */
+    int                 mode;           /**< \brief ʱĴʽ */
+    volatile am_bool_t  running;        /**< \brief Ƿڼ¼ */
+    am_trace_clk_get_t  pfn_clk_get;    /**< \brief ʱ */
+    uint32_t            clk_freq;       /**< \brief ʱƵ */
+    uint32_t            overhead;       /**< \brief һμ¼ĺʱ */
+} __g_trace;
+
+/******************************************************************************/
+void am_trace_record (uint32_t info, uint32_t id)
+{
+    am_trace_rec_t *p_rec;
+    int             key;
+
+    if (!__g_trace.running) {
+        return;
+    }
+
+    key = am_int_cpu_lock();
+
+    if (__g_trace.running) {
+        if ((__g_trace.mode == AM_TRACE_MODE_STOP) &&
+            (__g_trace.in > __g_trace.mask)) {
+            __g_trace.lost++;
+        } else {
+            p_rec       = &__g_trace.p_buf[__g_trace.in & __g_trace.mask];
+            p_rec->ts   = __g_trace.pfn_clk_get();
+            p_rec->id   = id;
+            p_rec->info = info;
+            __g_trace.in++;
+        }
+    }
+
+    am_int_cpu_unlock(key);
+}
+
+/******************************************************************************/
+int am_trace_init (am_trace_rec_t     *p_buf,
+                   size_t              nrecs,
+                   int                 mode,
+                   am_trace_clk_get_t  pfn_clk_get,
+                   uint32_t            clk_freq)
+{
+    uint32_t start;
+    int      i, j;
+
+    if ((p_buf == NULL) || (pfn_clk_get == NULL) || (clk_freq == 0) ||
+        (nrecs < __TRACE_CALIB_CNT) || ((nrecs & (nrecs - 1)) != 0) ||
+        ((mode != AM_TRACE_MODE_WRAP) && (mode != AM_TRACE_MODE_STOP))) {
+        return -AM_EINVAL;
+    }
+
+    __g_trace.running     = AM_FALSE;
+    __g_trace.p_buf       = p_buf;
+    __g_trace.mask        = nrecs - 1;
+    __g_trace.mode        = mode;
+    __g_trace.pfn_clk_get = pfn_clk_get;
+    __g_trace.clk_freq    = clk_freq;
+    __g_trace.in          = 0;
+    __g_trace.lost        = 0;
+
+    /*
+     * ʵʵļ¼·һμ¼ĺʱڻС
+     * 飬ȡڶĽ״ִʱδеȿ
+     */
+    __g_trace.running = AM_TRUE;
+    for (j = 0; j < 2; j++) {
+        start = pfn_clk_get();
+        for (i = 0; i < __TRACE_CALIB_CNT; i++) {
+            am_trace_record(AM_TRACE_USER << 1, 0);
+        }
+        __g_trace.overhead = (pfn_clk_get() - start) / __TRACE_CALIB_CNT;
+    }
+    __g_trace.running  = AM_FALSE;
+    __g_trace.in       = 0;
+    __g_trace.lost     = 0;
+
+    return AM_OK;
+}
+
+/******************************************************************************/
+void am_trace_start (void)
+{
+    int key;
+
+    if (__g_trace.p_buf == NULL) {
+        return;
+    }
+
+    key = am_int_cpu_lock();
+    __g_trace.in      = 0;
+    __g_trace.lost    = 0;
+    __g_trace.running = AM_TRUE;
+    am_int_cpu_unlock(key);
+}
+
+/******************************************************************************/
+void am_trace_stop (void)
+{
+    __g_trace.running = AM_FALSE;
+}
+
+/******************************************************************************/
+int am_trace_dump (void)
+{
+    const am_trace_rec_t *p_rec;
+    uint32_t              n;
+    uint32_t              lost;
+    uint32_t              i;
+
+    __g_trace.running = AM_FALSE;
+
+    if (__g_trace.p_buf == NULL) {
+        return 0;
+    }
+
+    n    = (__g_trace.in > __g_trace.mask) ? __g_trace.mask + 1 : __g_trace.in;
+    lost = __g_trace.lost + (__g_trace.in - n);
+
+    am_kprintf("#TB:%u,%u,%u,%u\n",
+               __g_trace.clk_freq, __g_trace.overhead, n, lost);
+
+    for (i = __g_trace.in - n; i != __g_trace.in; i++) {
+        p_rec = &__g_trace.p_buf[i & __g_trace.mask];
+        am_kprintf("#T:%08x %08x %02x\n", p_rec->ts, p_rec->id, p_rec->info);
+    }
+
+    am_kprintf("#TE\n");
+
+    return (int)n;
+}
+
+/******************************************************************************/
+uint32_t am_trace_overhead_get (void)
+{
+    return __g_trace.overhead;
+}
+
+#endif /* AM_TRACE */
+
+/* end of file */
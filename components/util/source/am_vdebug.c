@@ -16,6 +16,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.02 26-10-18  lgg, add buffered output drained by UART TX interrupt.
  * - 1.01 15-08-05  bob, USART std interface instead register operation.
  * - 1.00 14-12-01  tee, first implementation.
  * \endinternal
@@ -25,6 +26,8 @@
 #include "am_vdebug.h"
 #include "am_uart.h"
 #include "am_koutput.h"
+#include "am_rngbuf.h"
+#include "am_int.h"
  
 /**
  * \brief һַ
@@ -78,4 +81,157 @@ void am_debug_init (am_uart_handle_t handle, uint32_t baudrate)
 
  
 
+/******************************************************************************/
+
+/** \brief 豸 */
+static struct __dbg_buf_dev {
+    am_uart_handle_t       handle;      /**< \brief ڷ */
+    struct am_rngbuf_spsc  rb;          /**< \brief ͻ */
+    int                    policy;      /**< \brief Ĵ */
+    volatile uint32_t      dropped;     /**< \brief ֽ */
+} __g_dbg_buf;
+
+/**
+ * \brief жϻȡһַ
+ */
+static int __dbg_buf_txchar_get (void *p_arg, char *p_outchar)
+{
+    struct __dbg_buf_dev *p_dev = (struct __dbg_buf_dev *)p_arg;
+
+    if (am_rngbuf_spsc_getchar(&p_dev->rb, p_outchar) != 1) {
+        return -AM_EEMPTY;
+    }
+
+    return AM_OK;
+}
+
+/**
+ * \brief д뻺
+ *
+ * ѭжͬʱдʱжϣʹ߻
+ */
+static void __dbg_buf_write (struct __dbg_buf_dev *p_dev,
+                             const char           *p_data,
+                             size_t                len)
+{
+    size_t n;
+    int    key;
+
+    while (len > 0) {
+        key = am_int_cpu_lock();
+        n   = am_rngbuf_spsc_put(&p_dev->rb, p_data, len);
+        if ((n < len) && (p_dev->policy == AM_DEBUG_BUF_POLICY_DROP)) {
+            p_dev->dropped += len - n;
+            n               = len;
+        }
+        am_int_cpu_unlock(key);
+
+        am_uart_tx_startup(p_dev->handle);
+
+        p_data += n;
+        len    -= n;
+    }
+}
+
+/**
+ * \brief һַ壩
+ */
+static int __dbg_buf_fputc (const char c, void *fil)
+{
+    if ('\n' == c) {
+        __dbg_buf_write((struct __dbg_buf_dev *)fil, "\r\n", 2);
+    } else {
+        __dbg_buf_write((struct __dbg_buf_dev *)fil, &c, 1);
+    }
+
+    return 1;
+}
+
+/**
+ * \brief һַ壩'\n' ֮д
+ */
+static int __dbg_buf_fputs (const char *s, void *fil)
+{
+    const char *ss;
+    const char *start = s;
+
+    for (ss = s; *ss != '\0'; ss++) {
+        if ('\n' == *ss) {
+            __dbg_buf_write((struct __dbg_buf_dev *)fil, s, ss - s);
+            __dbg_buf_write((struct __dbg_buf_dev *)fil, "\r\n", 2);
+            s = ss + 1;
+        }
+    }
+    __dbg_buf_write((struct __dbg_buf_dev *)fil, s, ss - s);
+
+    return (ss - start);
+}
+
+/**
+ * \brief Գʼ
+ */
+int am_debug_init_buffered (am_uart_handle_t  handle,
+                            uint32_t          baudrate,
+                            char             *p_buf,
+                            size_t            size,
+                            int               policy)
+{
+    struct __dbg_buf_dev *p_dev = &__g_dbg_buf;
+
+    if ((handle == NULL) ||
+        ((policy != AM_DEBUG_BUF_POLICY_DROP) &&
+         (policy != AM_DEBUG_BUF_POLICY_BLOCK))) {
+        return -AM_EINVAL;
+    }
+
+    if (am_rngbuf_spsc_init(&p_dev->rb, p_buf, size) != AM_OK) {
+        return -AM_EINVAL;
+    }
+
+    p_dev->handle  = handle;
+    p_dev->policy  = policy;
+    p_dev->dropped = 0;
+    g_dbg_handle   = handle;
+
+    am_uart_ioctl(handle, AM_UART_BAUD_SET, (void *)baudrate);
+
+    am_uart_callback_set(handle,
+                         AM_UART_CALLBACK_TXCHAR_GET,
+                         (void *)__dbg_buf_txchar_get,
+                         (void *)p_dev);
+
+    if (am_uart_ioctl(handle,
+                      AM_UART_MODE_SET,
+                      (void *)AM_UART_MODE_INT) != AM_OK) {
+        return -AM_ENOTSUP;
+    }
+
+    am_koutput_set((void *)p_dev, __dbg_buf_fputc, __dbg_buf_fputs);
+
+    return AM_OK;
+}
+
+/**
+ * \brief ȡֽ
+ */
+uint32_t am_debug_dropped_get (void)
+{
+    return __g_dbg_buf.dropped;
+}
+
+/**
+ * \brief ȴеݷ
+ */
+void am_debug_flush (void)
+{
+    if (__g_dbg_buf.handle == NULL) {
+        return;
+    }
+
+    am_uart_tx_startup(__g_dbg_buf.handle);
+
+    while (!am_rngbuf_spsc_isempty(&__g_dbg_buf.rb)) {
+    }
+}
+
 /* end of file */
@@ -16,12 +16,821 @@
  *
  * \internal
  * \par modification history:
+ * - 1.03 26-10-18  lgg, exact float scaling with a small big integer.
+ * - 1.02 26-10-18  lgg, optional %f %F %e %E %g %G (AM_VFPRINTF_FLOAT).
+ * - 1.01 26-10-18  lgg, two digits per division, 64-bit values, %i %o %p,
+ *                  flags, precision, and buffered output through f_puts.
  * - 1.00 15-12-08  tee, first implementation from AWorks
  * \endinternal
  */
 
 #include "am_vdebug.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * \brief size of the output buffer on stack, characters are collected here
+ *        and passed to f_puts() in runs
+ */
+#ifndef AM_VFPRINTF_BUF_SIZE
+#define AM_VFPRINTF_BUF_SIZE    32
+#endif
+
+/** \name conversion flags
+ * @{
+ */
+#define __FLAG_LEFT     0x01    /**< \brief '-', left justify */
+#define __FLAG_ZERO     0x02    /**< \brief '0', pad with zeros */
+#define __FLAG_PLUS     0x04    /**< \brief '+', always put the sign */
+#define __FLAG_SPACE    0x08    /**< \brief ' ', put a space for positive */
+#define __FLAG_ALT      0x10    /**< \brief '#', alternate form */
+#define __FLAG_PREC     0x20    /**< \brief precision is given */
+/** @} */
+
+/** \name length modifiers
+ * @{
+ */
+#define __LEN_INT       0       /**< \brief no modifier */
+#define __LEN_CHAR      1       /**< \brief hh */
+#define __LEN_SHORT     2       /**< \brief h */
+#define __LEN_LONG      3       /**< \brief l */
+#define __LEN_LLONG     4       /**< \brief ll, j */
+#define __LEN_SIZE      5       /**< \brief z, t */
+/** @} */
+
+/** \brief output context */
+struct __fmt_out {
+    void   *fil;                                      /**< \brief handle */
+    int   (*f_putc) (const char  c, void *fil);       /**< \brief put char */
+    int   (*f_puts) (const char *s, void *fil);       /**< \brief put string */
+    int     res;                                      /**< \brief output count */
+    int     err;                                      /**< \brief output failed */
+    int     len;                                      /**< \brief used of buf */
+    char    buf[AM_VFPRINTF_BUF_SIZE + 1];            /**< \brief run buffer */
+};
+
+/** \brief two decimal digits for 0 ~ 99 */
+static const char __g_dec_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char __g_digits_lower[] = "0123456789abcdef";
+static const char __g_digits_upper[] = "0123456789ABCDEF";
+
+/******************************************************************************/
+
+/** \brief account the result of an output function */
+static void __out_result (struct __fmt_out *p_out, int cc)
+{
+    if (cc < 0) {
+        p_out->err = 1;
+    } else {
+        p_out->res += cc;
+    }
+}
+
+/** \brief pass the buffered run to f_puts() */
+static void __out_flush (struct __fmt_out *p_out)
+{
+    if ((p_out->len == 0) || p_out->err) {
+        p_out->len = 0;
+        return;
+    }
+
+    p_out->buf[p_out->len] = '\0';
+    p_out->len             = 0;
+
+    __out_result(p_out, p_out->f_puts(p_out->buf, p_out->fil));
+}
+
+/** \brief output len characters */
+static void __out_write (struct __fmt_out *p_out, const char *s, int len)
+{
+    int n;
+
+    while (len > 0) {
+        if (p_out->len == AM_VFPRINTF_BUF_SIZE) {
+            __out_flush(p_out);
+        }
+        n = AM_VFPRINTF_BUF_SIZE - p_out->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&p_out->buf[p_out->len], s, n);
+        p_out->len += n;
+        s          += n;
+        len        -= n;
+    }
+}
+
+/** \brief output n copies of character c */
+static void __out_fill (struct __fmt_out *p_out, char c, int n)
+{
+    int m;
+
+    while (n > 0) {
+        if (p_out->len == AM_VFPRINTF_BUF_SIZE) {
+            __out_flush(p_out);
+        }
+        m = AM_VFPRINTF_BUF_SIZE - p_out->len;
+        if (m > n) {
+            m = n;
+        }
+        memset(&p_out->buf[p_out->len], c, m);
+        p_out->len += m;
+        n          -= m;
+    }
+}
+
+/**
+ * \brief output a field: [spaces] prefix [zeros] body [spaces]
+ *
+ * \param p_out  output context
+ * \param prefix sign or "0x", may be NULL when npre is 0
+ * \param npre   length of prefix
+ * \param nzero  number of zeros between prefix and body
+ * \param body   the converted characters
+ * \param nbody  length of body
+ * \param width  minimum field width
+ * \param flags  __FLAG_LEFT and __FLAG_ZERO are used
+ */
+static void __out_field (struct __fmt_out *p_out,
+                         const char       *prefix,
+                         int               npre,
+                         int               nzero,
+                         const char       *body,
+                         int               nbody,
+                         int               width,
+                         int               flags)
+{
+    int npad = width - npre - nzero - nbody;
+
+    if (npad < 0) {
+        npad = 0;
+    }
+    if ((flags & (__FLAG_ZERO | __FLAG_LEFT)) == __FLAG_ZERO) {
+        nzero += npad;
+        npad   = 0;
+    }
+
+    if (!(flags & __FLAG_LEFT)) {
+        __out_fill(p_out, ' ', npad);
+    }
+    __out_write(p_out, prefix, npre);
+    __out_fill(p_out, '0', nzero);
+    __out_write(p_out, body, nbody);
+    if (flags & __FLAG_LEFT) {
+        __out_fill(p_out, ' ', npad);
+    }
+}
+
+/******************************************************************************/
+
+/** \brief convert a 32-bit value to decimal, backwards from p_end */
+static char *__utoa_dec32 (char *p_end, uint32_t val)
+{
+    const char *p_pair;
+    uint32_t    q;
+
+    while (val >= 100) {
+        q        = val / 100;
+        p_pair   = &__g_dec_pairs[(val - q * 100) * 2];
+        *--p_end = p_pair[1];
+        *--p_end = p_pair[0];
+        val      = q;
+    }
+    if (val >= 10) {
+        p_pair   = &__g_dec_pairs[val * 2];
+        *--p_end = p_pair[1];
+        *--p_end = p_pair[0];
+    } else {
+        *--p_end = (char)('0' + val);
+    }
+
+    return p_end;
+}
+
+/**
+ * \brief convert a value to decimal, backwards from p_end
+ *
+ * 64-bit values are split into 9-digit groups, so that only one 64-bit
+ * division is needed per group and the digits are produced in 32-bit.
+ */
+static char *__utoa_dec (char *p_end, uint64_t val)
+{
+    uint64_t q;
+    char    *p;
+
+    while (val > 0xFFFFFFFFu) {
+        q   = val / 1000000000u;
+        p   = __utoa_dec32(p_end, (uint32_t)(val - q * 1000000000u));
+        val = q;
+
+        p_end -= 9;
+        while (p > p_end) {
+            *--p = '0';
+        }
+    }
+
+    return __utoa_dec32(p_end, (uint32_t)val);
+}
+
+/** \brief convert a value to hexadecimal or octal, backwards from p_end */
+static char *__utoa_pow2 (char       *p_end,
+                          uint64_t    val,
+                          int         shift,
+                          const char *p_digits)
+{
+    unsigned int mask = (1u << shift) - 1;
+    uint32_t     val32;
+
+    while (val > 0xFFFFFFFFu) {
+        *--p_end = p_digits[(unsigned int)val & mask];
+        val    >>= shift;
+    }
+
+    val32 = (uint32_t)val;
+    do {
+        *--p_end = p_digits[val32 & mask];
+        val32  >>= shift;
+    } while (val32 != 0);
+
+    return p_end;
+}
+
+/******************************************************************************/
+
+/** \brief output an integer conversion (d i u o x X p) */
+static void __out_int (struct __fmt_out *p_out,
+                       uint64_t          val,
+                       char              conv,
+                       char              sign,
+                       int               width,
+                       int               prec,
+                       int               flags)
+{
+    char  tmp[24];                  /* 22 octal digits for 64-bit */
+    char  prefix[2];
+    char *p_end = tmp + sizeof(tmp);
+    char *p     = p_end;
+    int   npre  = 0;
+    int   ndig;
+
+    if (flags & __FLAG_PREC) {
+        flags &= ~__FLAG_ZERO;      /* '0' is ignored with a precision */
+    } else {
+        prec = 1;
+    }
+
+    if ((val != 0) || (prec != 0)) {
+        if ((conv == 'x') || (conv == 'p')) {
+            p = __utoa_pow2(p_end, val, 4, __g_digits_lower);
+        } else if (conv == 'X') {
+            p = __utoa_pow2(p_end, val, 4, __g_digits_upper);
+        } else if (conv == 'o') {
+            p = __utoa_pow2(p_end, val, 3, __g_digits_lower);
+        } else {
+            p = __utoa_dec(p_end, val);
+        }
+    }
+    ndig = p_end - p;
+
+    if (sign != 0) {
+        prefix[npre++] = sign;
+    }
+    if (conv == 'p') {
+        prefix[npre++] = '0';
+        prefix[npre++] = 'x';
+    } else if (flags & __FLAG_ALT) {
+        if (conv == 'o') {
+            if (prec <= ndig) {     /* first digit must be 0 */
+                prec = ((ndig != 0) && (*p == '0')) ? ndig : ndig + 1;
+            }
+        } else if ((conv == 'x' || conv == 'X') && (val != 0)) {
+            prefix[npre++] = '0';
+            prefix[npre++] = conv;
+        }
+    }
+
+    __out_field(p_out,
+                prefix,
+                npre,
+                (prec > ndig) ? (prec - ndig) : 0,
+                p,
+                ndig,
+                width,
+                flags);
+}
+
+/** \brief output a string conversion (s) */
+static void __out_str (struct __fmt_out *p_out,
+                       const char       *s,
+                       int               width,
+                       int               prec,
+                       int               flags)
+{
+    int len;
+
+    if (s == NULL) {
+        s = "(null)";
+    }
+
+    if (flags & __FLAG_PREC) {
+        for (len = 0; (len < prec) && (s[len] != '\0'); len++) {
+        }
+    } else if (width == 0) {
+
+        /* no need to know the length, send the string as a whole */
+        __out_flush(p_out);
+        if (!p_out->err) {
+            __out_result(p_out, p_out->f_puts(s, p_out->fil));
+        }
+        return;
+    } else {
+        len = strlen(s);
+    }
+
+    __out_field(p_out, NULL, 0, 0, s, len, width, flags & __FLAG_LEFT);
+}
+
+#ifdef AM_VFPRINTF_FLOAT
+
+/** \brief significant digits kept for a double */
+#define __FLOAT_DIGITS      18
+
+/** \brief 10^0 ~ 10^18 */
+static const uint64_t __g_pow10[] = {
+    1ull,                  10ull,                 100ull,
+    1000ull,               10000ull,              100000ull,
+    1000000ull,            10000000ull,           100000000ull,
+    1000000000ull,         10000000000ull,        100000000000ull,
+    1000000000000ull,      10000000000000ull,     100000000000000ull,
+    1000000000000000ull,   10000000000000000ull,  100000000000000000ull,
+    1000000000000000000ull
+};
+
+/**
+ * \brief 32-bit words of a big integer, 2^54 * 10^343 (the smallest
+ *        subnormal scaled to 18 digits) takes 38 words
+ */
+#define __BIG_WORDS         40
+
+/** \brief unsigned big integer, just large enough to scale a double exactly */
+struct __float_big {
+    uint32_t w[__BIG_WORDS];        /**< \brief least significant word first */
+    int      n;                     /**< \brief words in use */
+};
+
+/** \brief drop the leading zero words */
+static void __big_trim (struct __float_big *p_big)
+{
+    while ((p_big->n > 0) && (p_big->w[p_big->n - 1] == 0)) {
+        p_big->n--;
+    }
+}
+
+/** \brief big = big * k */
+static void __big_mul (struct __float_big *p_big, uint32_t k)
+{
+    uint64_t t;
+    uint32_t carry = 0;
+    int      i;
+
+    for (i = 0; i < p_big->n; i++) {
+        t           = (uint64_t)p_big->w[i] * k + carry;
+        p_big->w[i] = (uint32_t)t;
+        carry       = (uint32_t)(t >> 32);
+    }
+    if (carry != 0) {
+        p_big->w[p_big->n++] = carry;
+    }
+}
+
+/** \brief big = big / d, returns the remainder */
+static uint32_t __big_div (struct __float_big *p_big, uint32_t d)
+{
+    uint64_t r = 0;
+    int      i;
+
+    for (i = p_big->n - 1; i >= 0; i--) {
+        r           = (r << 32) | p_big->w[i];
+        p_big->w[i] = (uint32_t)(r / d);
+        r          %= d;
+    }
+    __big_trim(p_big);
+
+    return (uint32_t)r;
+}
+
+/** \brief big = big << bits, big is not 0 */
+static void __big_shl (struct __float_big *p_big, int bits)
+{
+    int      nw = bits >> 5;
+    int      sh = bits & 31;
+    uint32_t hi = 0;
+    int      i;
+
+    if (sh != 0) {
+        hi = p_big->w[p_big->n - 1] >> (32 - sh);
+        for (i = p_big->n - 1; i > 0; i--) {
+            p_big->w[i + nw] = (p_big->w[i] << sh) |
+                               (p_big->w[i - 1] >> (32 - sh));
+        }
+        p_big->w[nw] = p_big->w[0] << sh;
+    } else {
+        for (i = p_big->n - 1; i >= 0; i--) {
+            p_big->w[i + nw] = p_big->w[i];
+        }
+    }
+    for (i = 0; i < nw; i++) {
+        p_big->w[i] = 0;
+    }
+    p_big->n += nw;
+    if (hi != 0) {
+        p_big->w[p_big->n++] = hi;
+    }
+}
+
+/** \brief big = big >> bits, returns non-zero if any 1 bit is shifted out */
+static uint32_t __big_shr (struct __float_big *p_big, int bits)
+{
+    int      nw   = bits >> 5;
+    int      sh   = bits & 31;
+    uint32_t lost = 0;
+    int      i;
+
+    if (nw >= p_big->n) {
+        for (i = 0; i < p_big->n; i++) {
+            lost |= p_big->w[i];
+        }
+        p_big->n = 0;
+        return lost;
+    }
+
+    for (i = 0; i < nw; i++) {
+        lost |= p_big->w[i];
+    }
+    if (sh != 0) {
+        lost |= p_big->w[nw] << (32 - sh);
+        for (i = 0; i + nw + 1 < p_big->n; i++) {
+            p_big->w[i] = (p_big->w[i + nw]     >> sh) |
+                          (p_big->w[i + nw + 1] << (32 - sh));
+        }
+        p_big->w[i] = p_big->w[i + nw] >> sh;
+    } else {
+        for (i = 0; i + nw < p_big->n; i++) {
+            p_big->w[i] = p_big->w[i + nw];
+        }
+    }
+    p_big->n -= nw;
+    __big_trim(p_big);
+
+    return lost;
+}
+
+/**
+ * \brief split v (finite, > 0) into m * 2^e2 exactly
+ *
+ * \return e2
+ */
+static int __float_split (double v, uint64_t *p_m)
+{
+    uint64_t bits;
+    int      e;
+
+    memcpy(&bits, &v, sizeof(bits));
+    e    = (int)((bits >> 52) & 0x7FF);
+    *p_m = bits & 0xFFFFFFFFFFFFFull;
+    if (e == 0) {
+        return -1074;               /* subnormal */
+    }
+    *p_m |= 1ull << 52;
+
+    return e - 1075;
+}
+
+/**
+ * \brief m * 2^e2 * 10^s rounded half to even, computed exactly
+ *
+ * The value is scaled as a big integer with one extra bit for the rounding,
+ * the bits and digits dropped by the divisions are kept as a sticky flag.
+ *
+ * \param m       the mantissa
+ * \param e2      the binary exponent
+ * \param s       the decimal exponent
+ * \param p_floor the value before rounding, ~0 if it takes more than 63 bits
+ *
+ * \return the rounded value, only valid if *p_floor is not ~0
+ */
+static uint64_t __float_round (uint64_t m, int e2, int s, uint64_t *p_floor)
+{
+    struct __float_big big;
+    uint32_t           lost = 0;
+    uint64_t           q;
+
+    big.w[0] = (uint32_t)m;
+    big.w[1] = (uint32_t)(m >> 32);
+    big.n    = 2;
+    __big_trim(&big);
+
+    e2++;                           /* keep the half bit */
+    if (e2 > 0) {
+        __big_shl(&big, e2);
+    }
+    for (; s >= 9; s -= 9) {
+        __big_mul(&big, 1000000000u);
+    }
+    if (s > 0) {
+        __big_mul(&big, (uint32_t)__g_pow10[s]);
+    }
+    for (; s <= -9; s += 9) {
+        lost |= __big_div(&big, 1000000000u);
+    }
+    if (s < 0) {
+        lost |= __big_div(&big, (uint32_t)__g_pow10[-s]);
+    }
+    if (e2 < 0) {
+        lost |= __big_shr(&big, -e2);
+    }
+
+    if (big.n > 2) {
+        *p_floor = ~0ull;
+        return 0;
+    }
+    q = 0;
+    if (big.n > 1) {
+        q = (uint64_t)big.w[1] << 32;
+    }
+    if (big.n > 0) {
+        q |= big.w[0];
+    }
+
+    *p_floor = q >> 1;
+    if ((q & 1) && ((lost != 0) || (q & 2))) {
+        q += 2;
+    }
+
+    return q >> 1;
+}
+
+/**
+ * \brief get ndig (1 ~ 18) significant digits of v (finite, > 0), rounded
+ *        half to even
+ *
+ * The digits are exact over the whole range of double.
+ *
+ * \return the decimal exponent of the first digit
+ */
+static int __float_sci (double v, int ndig, char *p_buf)
+{
+    uint64_t m, q, fl;
+    int      e2, b, e10;
+
+    e2 = __float_split(v, &m);
+
+    /* the leading bit, then floor(b * log10(2)), 78913 / 2^18 = 0.30103 */
+    for (b = 52; !(m >> b); b--) {
+        ;
+    }
+    b += e2;
+    if (b >= 0) {
+        e10 = (b * 78913) >> 18;
+    } else {
+        e10 = -((-b * 78913 + 262143) >> 18);
+    }
+
+    /* the estimate may be one off, move it until exactly ndig digits */
+    for (;;) {
+        q = __float_round(m, e2, ndig - 1 - e10, &fl);
+        if (fl >= __g_pow10[ndig]) {
+            e10++;
+        } else if (fl < __g_pow10[ndig - 1]) {
+            e10--;
+        } else {
+            break;
+        }
+    }
+    if (q == __g_pow10[ndig]) {
+        q /= 10;
+        e10++;
+    }
+    (void)__utoa_dec(p_buf + ndig, q);
+
+    return e10;
+}
+
+/**
+ * \brief convert v (0 <= v < 2^63) with prec (0 ~ 18) fraction digits
+ *
+ * The integer part and the fraction part are separated exactly and only the
+ * fraction is scaled, the digits are rounded correctly (half to even).
+ *
+ * \param v      the value
+ * \param prec   number of fraction digits
+ * \param p_end  end of the buffer for integer digits
+ * \param p_frac buffer for prec fraction digits
+ *
+ * \return start of the integer digits
+ */
+static char *__float_fixed (double v, int prec, char *p_end, char *p_frac)
+{
+    uint64_t ip = (uint64_t)v;
+    uint64_t fp = 0;
+    uint64_t m, fl;
+    double   frac;
+    char    *p;
+    int      e2;
+
+    frac = v - (double)ip;
+    if (prec == 0) {
+        if ((frac > 0.5) || ((frac == 0.5) && (ip & 1))) {
+            ip++;
+        }
+    } else if (frac != 0) {
+        e2 = __float_split(frac, &m);
+        fp = __float_round(m, e2, prec, &fl);
+        if (fp == __g_pow10[prec]) {
+            fp = 0;
+            ip++;
+        }
+    }
+
+    if (prec != 0) {
+        p = __utoa_dec(p_frac + prec, fp);
+        while (p > p_frac) {
+            *--p = '0';
+        }
+    }
+
+    return __utoa_dec(p_end, ip);
+}
+
+/**
+ * \brief output a floating point conversion (f F e E g G)
+ *
+ * The field is [sign][digits][zeros][point and fraction][zeros][exponent],
+ * the zeros are never stored, so any width and precision can be output.
+ */
+static void __out_float (struct __fmt_out *p_out,
+                         double            v,
+                         char              conv,
+                         int               width,
+                         int               prec,
+                         int               flags)
+{
+    uint64_t    bits;
+    char        a[24];              /* integer digits, or significant digits */
+    char        b[24];              /* point and fraction digits */
+    char        e[6];               /* exponent */
+    const char *p_a;
+    char        sign  = 0;
+    char        style = conv | 0x20;
+    int         upper = (conv != style);
+    int         na, za = 0, nb = 0, zb = 0, ne = 0;
+    int         e10, ndig, npad, nzero = 0;
+
+    memcpy(&bits, &v, sizeof(bits));
+    if (bits >> 63) {
+        sign = '-';
+        v    = -v;
+    } else if (flags & __FLAG_PLUS) {
+        sign = '+';
+    } else if (flags & __FLAG_SPACE) {
+        sign = ' ';
+    }
+
+    if (((bits >> 52) & 0x7FF) == 0x7FF) {
+        if (bits & 0xFFFFFFFFFFFFFull) {
+            p_a = upper ? "NAN" : "nan";
+        } else {
+            p_a = upper ? "INF" : "inf";
+        }
+        na     = 3;
+        flags &= ~__FLAG_ZERO;
+        goto out;
+    }
+
+    if (!(flags & __FLAG_PREC)) {
+        prec = 6;
+    }
+    if (style == 'e') {
+        prec++;                     /* number of significant digits */
+    } else if ((style == 'g') && (prec == 0)) {
+        prec = 1;
+    }
+
+    b[0] = '.';
+    if ((style == 'f') && (v < 9223372036854775808.0)) {
+        ndig = (prec < __FLOAT_DIGITS) ? prec : __FLOAT_DIGITS;
+        p_a  = __float_fixed(v, ndig, a + sizeof(a), &b[1]);
+        na   = a + sizeof(a) - p_a;
+        nb   = 1 + ndig;
+        zb   = prec - ndig;
+
+    } else if (style == 'f') {
+
+        /* too large for 64-bit, the digits after 18 are zeros */
+        e10 = __float_sci(v, __FLOAT_DIGITS, a);
+        p_a = a;
+        na  = __FLOAT_DIGITS;
+        za  = e10 + 1 - __FLOAT_DIGITS;
+        nb  = 1;
+        zb  = prec;
+
+    } else {
+        ndig = (prec < __FLOAT_DIGITS) ? prec : __FLOAT_DIGITS;
+        e10  = 0;
+        if (v != 0) {
+            e10 = __float_sci(v, ndig, a);
+        } else {
+            memset(a, '0', ndig);
+        }
+
+        if ((style == 'g') && (e10 < prec) && (e10 >= -4)) {
+
+            /* %g in fixed style, prec significant digits */
+            if (e10 >= 0) {
+                p_a = a;
+                na  = (e10 + 1 < ndig) ? (e10 + 1) : ndig;
+                za  = e10 + 1 - na;
+                memcpy(&b[1], &a[na], ndig - na);
+                nb  = 1 + ndig - na;
+            } else {
+                p_a = "0";
+                na  = 1;
+                memset(&b[1], '0', -e10 - 1);
+                memcpy(&b[-e10], a, ndig);
+                nb  = ndig - e10;
+            }
+            zb = prec - ndig - za;
+
+        } else {
+            memcpy(&b[1], &a[1], ndig - 1);
+            p_a = a;
+            na  = 1;
+            nb  = ndig;
+            zb  = prec - ndig;
+
+            e[0] = upper ? 'E' : 'e';
+            e[1] = (e10 < 0) ? '-' : '+';
+            if (e10 < 0) {
+                e10 = -e10;
+            }
+            ne = 2;
+            if (e10 >= 100) {
+                e[ne++] = (char)('0' + e10 / 100);
+                e10    %= 100;
+            }
+            e[ne++] = __g_dec_pairs[e10 * 2];
+            e[ne++] = __g_dec_pairs[e10 * 2 + 1];
+        }
+
+        if ((style == 'g') && !(flags & __FLAG_ALT)) {
+
+            /* remove trailing zeros */
+            zb = 0;
+            while ((nb > 1) && (b[nb - 1] == '0')) {
+                nb--;
+            }
+        }
+    }
+
+    if ((nb == 1) && (zb == 0) && !(flags & __FLAG_ALT)) {
+        nb = 0;                     /* no point without fraction */
+    }
+
+out:
+    npad = width - (sign != 0) - na - za - nb - zb - ne;
+    if (npad < 0) {
+        npad = 0;
+    }
+    if ((flags & (__FLAG_ZERO | __FLAG_LEFT)) == __FLAG_ZERO) {
+        nzero = npad;
+        npad  = 0;
+    }
+
+    if (!(flags & __FLAG_LEFT)) {
+        __out_fill(p_out, ' ', npad);
+    }
+    __out_write(p_out, &sign, sign != 0);
+    __out_fill(p_out, '0', nzero);
+    __out_write(p_out, p_a, na);
+    __out_fill(p_out, '0', za);
+    __out_write(p_out, b, nb);
+    __out_fill(p_out, '0', zb);
+    __out_write(p_out, e, ne);
+    if (flags & __FLAG_LEFT) {
+        __out_fill(p_out, ' ', npad);
+    }
+}
+
+#endif /* AM_VFPRINTF_FLOAT */
+
+/******************************************************************************/
 
 /**
  * \brief Format a string and output it.
@@ -30,6 +839,12 @@
  * arguments to output the characters.
  * all other vXXXprintf() functions are based on this function.
  *
+ * Conversions: %d %i %u %o %x %X %p %c %s %%, with flags '-' '0' '+' ' ' '#',
+ * width and precision (also '*'), and length modifiers hh h l ll j z t.
+ * %f %F %e %E %g %G are supported when AM_VFPRINTF_FLOAT is defined.
+ * The characters are collected in a buffer of AM_VFPRINTF_BUF_SIZE and sent
+ * by f_puts() in runs; f_putc() is only used for a NUL character.
+ *
  * \param fil       The handle for f_putc and f_puts functions
  * \param f_putc    Pointer to function to output a char
  * \param f_puts    Pointer to function to output a string
@@ -44,96 +859,203 @@ int am_vfprintf_do (void       *fil,
                     const char *fmt,
                     va_list     args)
 {
-    unsigned char   c, f;
-    int             r;
-    unsigned long   val;
-    char            s[16];
-    int             i, w, res, cc;
-
-
-    for (cc = res = 0; cc >= 0; res += cc >= 0 ? cc : 0) {
-        if ((c = *fmt++) == 0) {
-            break;                      /* End of string */
-        } else if (c != '%') {          /* Non escape cahracter */
-            cc = f_putc(c, fil);
-            continue;
-        }
-        w = f = 0;
-        c = *fmt++;
-        if (c == '0') {                 /* Flag: '0' padding */
-            f = 1;
-            c = *fmt++;
-        }
-        while (c >= '0' && c <= '9') {  /* Precision */
-            w = w * 10 + (c - '0');
-            c = *fmt++;
-        }
-        if (c == 'l') {                 /* Prefix: Size is long int */
-            f |= 2;
-            c  = *fmt++;
-        }
-        if (c == 's') {                 /* Type is string */
-            cc = f_puts(va_arg(args, char *), fil);
-            continue;
-        }
-        if (c == 'c') {                 /* Type is character */
-            cc = f_putc(va_arg(args, int), fil);
-            continue;
-        }
-        if (c == '%') {                 /* Char is '%' */
-            cc = f_putc('%', fil);
-            continue;
-        }
-        r = 0;
-        if (c == 'd') {
-            r = 10;             /* Type is signed decimal */
-        } else if (c == 'u') {
-            r = 10;             /* Type is unsigned decimal */
-        } else if (c == 'X') {
-            r = 16;             /* Type is unsigned hexdecimal, upper case */
-        } else if (c == 'x') {
-            r = 0x100 + 16;     /* Type is unsigned hexdecimal, lower case */
-        }else {
-            break;              /* Unknown type */
-        }
-        if (f & 2) {            /* Get the value */
-            val = (unsigned long)va_arg(args, long);
+    struct __fmt_out out;
+    const char      *p;
+    char             c, sign;
+    int              flags, width, prec, size;
+    uint64_t         val;
+    int64_t          sval;
+
+    out.fil    = fil;
+    out.f_putc = f_putc;
+    out.f_puts = f_puts;
+    out.res    = 0;
+    out.err    = 0;
+    out.len    = 0;
+
+    while (!out.err) {
+
+        /* literal run */
+        for (p = fmt; (*p != '\0') && (*p != '%'); p++) {
+        }
+        if (*p == '\0') {
+            if ((p != fmt) && (out.len == 0)) {
+                __out_result(&out, f_puts(fmt, fil));    /* tail, no copy */
+            } else {
+                __out_write(&out, fmt, p - fmt);
+            }
+            break;
+        }
+        __out_write(&out, fmt, p - fmt);
+        fmt = p + 1;
+
+        /* flags */
+        for (flags = 0; ; fmt++) {
+            c = *fmt;
+            if (c == '-') {
+                flags |= __FLAG_LEFT;
+            } else if (c == '0') {
+                flags |= __FLAG_ZERO;
+            } else if (c == '+') {
+                flags |= __FLAG_PLUS;
+            } else if (c == ' ') {
+                flags |= __FLAG_SPACE;
+            } else if (c == '#') {
+                flags |= __FLAG_ALT;
+            } else {
+                break;
+            }
+        }
+
+        /* width */
+        width = 0;
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= __FLAG_LEFT;
+                width  = -width;
+            }
+            fmt++;
         } else {
-            val = (c == 'd')
-                ? (unsigned long)(long)va_arg(args, int)
-                : (unsigned long)va_arg(args, unsigned int);
-        }
-        /* Put numeral string */
-        if ((c == 'd') && (val & 0x80000000)) {
-            val = 0 - val;
-            f  |= 4;
-        }
-        i    = sizeof(s) - 1;
-        s[i] = 0;
-        do {
-            c = (unsigned char)(val % (r & 0xff) + '0');
-            if (c > '9') {
-                if (r & 0x100) {
-                    c += 39;
-                } else {
-                    c += 7;
+            while ((*fmt >= '0') && (*fmt <= '9')) {
+                width = width * 10 + (*fmt++ - '0');
+            }
+        }
+
+        /* precision */
+        prec = 0;
+        if (*fmt == '.') {
+            flags |= __FLAG_PREC;
+            fmt++;
+            if (*fmt == '*') {
+                prec = va_arg(args, int);
+                if (prec < 0) {
+                    flags &= ~__FLAG_PREC;      /* taken as if omitted */
+                    prec   = 0;
+                }
+                fmt++;
+            } else {
+                while ((*fmt >= '0') && (*fmt <= '9')) {
+                    prec = prec * 10 + (*fmt++ - '0');
                 }
             }
-            s[--i] = c;
-            val   /= (r & 0xff);
-        } while (i && val);
-        if (i && (f & 4)) {
-            s[--i] = '-';
         }
-        w = sizeof(s) - 1 - w;
-        while (i && i > w) {
-            s[--i] = (f & 1) ? '0' : ' ';
+
+        /* length */
+        size = __LEN_INT;
+        c    = *fmt++;
+        if (c == 'h') {
+            size = __LEN_SHORT;
+            c    = *fmt++;
+            if (c == 'h') {
+                size = __LEN_CHAR;
+                c    = *fmt++;
+            }
+        } else if (c == 'l') {
+            size = __LEN_LONG;
+            c    = *fmt++;
+            if (c == 'l') {
+                size = __LEN_LLONG;
+                c    = *fmt++;
+            }
+        } else if (c == 'j') {
+            size = __LEN_LLONG;
+            c    = *fmt++;
+        } else if ((c == 'z') || (c == 't')) {
+            size = __LEN_SIZE;
+            c    = *fmt++;
+        }
+
+        /* conversion */
+        sign = 0;
+        if ((c == 'd') || (c == 'i')) {
+            if (size == __LEN_LLONG) {
+                sval = va_arg(args, long long);
+            } else if (size == __LEN_LONG) {
+                sval = va_arg(args, long);
+            } else if (size == __LEN_SIZE) {
+                sval = (int64_t)va_arg(args, ptrdiff_t);
+            } else {
+                sval = va_arg(args, int);
+                if (size == __LEN_CHAR) {
+                    sval = (signed char)sval;
+                } else if (size == __LEN_SHORT) {
+                    sval = (short)sval;
+                }
+            }
+            if (sval < 0) {
+                sign = '-';
+                val  = 0 - (uint64_t)sval;
+            } else {
+                if (flags & __FLAG_PLUS) {
+                    sign = '+';
+                } else if (flags & __FLAG_SPACE) {
+                    sign = ' ';
+                }
+                val = (uint64_t)sval;
+            }
+            __out_int(&out, val, c, sign, width, prec, flags);
+
+        } else if ((c == 'u') || (c == 'x') || (c == 'X') || (c == 'o')) {
+            if (size == __LEN_LLONG) {
+                val = va_arg(args, unsigned long long);
+            } else if (size == __LEN_LONG) {
+                val = va_arg(args, unsigned long);
+            } else if (size == __LEN_SIZE) {
+                val = va_arg(args, size_t);
+            } else {
+                val = va_arg(args, unsigned int);
+                if (size == __LEN_CHAR) {
+                    val = (unsigned char)val;
+                } else if (size == __LEN_SHORT) {
+                    val = (unsigned short)val;
+                }
+            }
+            __out_int(&out, val, c, 0, width, prec, flags);
+
+        } else if (c == 'p') {
+            val = (uintptr_t)va_arg(args, void *);
+            __out_int(&out, val, c, 0, width, prec, flags);
+
+#ifdef AM_VFPRINTF_FLOAT
+        } else if ((c == 'f') || (c == 'F') || (c == 'e') ||
+                   (c == 'E') || (c == 'g') || (c == 'G')) {
+            __out_float(&out, va_arg(args, double), c, width, prec, flags);
+#endif
+
+        } else if (c == 's') {
+            __out_str(&out, va_arg(args, const char *), width, prec, flags);
+
+        } else if (c == 'c') {
+            c = (char)va_arg(args, int);
+            if (c != '\0') {
+                __out_field(&out, NULL, 0, 0, &c, 1, width, flags & __FLAG_LEFT);
+            } else {
+
+                /* f_puts() can not output a NUL */
+                if (!(flags & __FLAG_LEFT)) {
+                    __out_fill(&out, ' ', width - 1);
+                }
+                __out_flush(&out);
+                if (!out.err) {
+                    __out_result(&out, f_putc(c, fil));
+                }
+                if (flags & __FLAG_LEFT) {
+                    __out_fill(&out, ' ', width - 1);
+                }
+            }
+
+        } else if (c == '%') {
+            __out_write(&out, "%", 1);
+
+        } else {
+            break;                      /* Unknown type */
         }
-        cc = f_puts(&s[i], fil);
     }
 
-    return res;
+    __out_flush(&out);
+
+    return out.res;
 }
 
 /* end of file */
-
@@ -16,10 +16,15 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.03 26-10-18  lgg, add trace points.
+ * - 1.02 26-10-18  lgg, add asynchronous notify and am_wait_try().
+ * - 1.01 26-10-18  lgg, add idle hook for low power waiting.
  * - 1.00 15-09-01  tee, first implementation.
  * \endinternal
  */
 #include "am_wait.h"
+#include "am_int.h"
+#include "am_trace.h"
 
 
 /******************************************************************************/
@@ -34,13 +39,76 @@
 #define __WAIT_STAT_WAIT_ON          1   /* ȴ״̬            */
 #define __WAIT_STAT_WAIT_ON_TIMEOUT  2   /* ȴ״̬ʱ   */
 
+/* ȴڼʹõĿСѺ */
+static const am_wait_idle_funcs_t *__gp_wait_idle = NULL;
+
+/******************************************************************************/
+
+/* õȴֵѵȴ */
+static void __wait_signal (am_wait_t *p_wait, uint8_t val)
+{
+    const am_wait_idle_funcs_t *p_idle;
+    am_pfnvoid_t                pfn_notify;
+    void                       *p_notify_arg;
+    int                         key;
+
+    key = am_int_cpu_lock();
+
+    p_wait->val = val;
+
+    p_idle = __gp_wait_idle;
+    if ((p_idle != NULL) && (p_idle->pfn_wake != NULL)) {
+        p_idle->pfn_wake(p_idle->p_arg);
+    }
+
+    pfn_notify   = p_wait->pfn_notify;
+    p_notify_arg = p_wait->p_notify_arg;
+
+    am_int_cpu_unlock(key);
+
+    if (pfn_notify != NULL) {
+        pfn_notify(p_notify_arg);
+    }
+}
+
+/* ȴȴֵı䣬жϼȴֵٽУⶪʧ */
+static void __wait_pend (am_wait_t *p_wait)
+{
+    const am_wait_idle_funcs_t *p_idle;
+    int                         key;
+
+    AM_FOREVER {
+
+        p_idle = __gp_wait_idle;
+
+        /* δÿкһֱѯȴֵ */
+        if ((p_idle == NULL) || (p_idle->pfn_idle == NULL)) {
+            if (p_wait->val != __WAIT_VAL_INIT) {
+                break;
+            }
+            continue;
+        }
+
+        key = am_int_cpu_lock();
+
+        if (p_wait->val != __WAIT_VAL_INIT) {
+            am_int_cpu_unlock(key);
+            break;
+        }
+
+        p_idle->pfn_idle(p_idle->p_arg);
+
+        am_int_cpu_unlock(key);
+    }
+}
+
 /******************************************************************************/
 
 static void __timer_callback (void *p_arg)
 {
     am_wait_t *p_wait = (am_wait_t *)p_arg;
     
-    p_wait->val = __WAIT_VAL_TIMEOUT;
+    __wait_signal(p_wait, __WAIT_VAL_TIMEOUT);
     
     am_softimer_stop(&p_wait->timer);
 }
@@ -54,8 +122,10 @@ int am_wait_init (am_wait_t *p_wait)
         return -AM_EINVAL;
     }
     
-    p_wait->val   = __WAIT_VAL_INIT;
-    p_wait->stat  = __WAIT_STAT_INIT;
+    p_wait->val          = __WAIT_VAL_INIT;
+    p_wait->stat         = __WAIT_STAT_INIT;
+    p_wait->pfn_notify   = NULL;
+    p_wait->p_notify_arg = NULL;
     
     am_softimer_init(&p_wait->timer,__timer_callback, p_wait);
     
@@ -70,7 +140,9 @@ int am_wait_on (am_wait_t *p_wait)
     
     p_wait->stat = __WAIT_STAT_WAIT_ON;
     
-    while(p_wait->val == __WAIT_VAL_INIT);
+    AM_TRACE_ENTER(AM_TRACE_WAIT, p_wait);
+    __wait_pend(p_wait);
+    AM_TRACE_EXIT(AM_TRACE_WAIT, p_wait);
     
     p_wait->val  = __WAIT_VAL_INIT;
     p_wait->stat = __WAIT_STAT_INIT;
@@ -84,7 +156,65 @@ int am_wait_done(am_wait_t *p_wait)
         return -AM_EINVAL;
     }
     
-    p_wait->val  = __WAIT_VAL_DONE;
+    __wait_signal(p_wait, __WAIT_VAL_DONE);
+
+    return AM_OK;
+}
+
+int am_wait_notify_set (am_wait_t    *p_wait,
+                        am_pfnvoid_t  pfn_notify,
+                        void         *p_notify_arg)
+{
+    int key;
+
+    if (p_wait == NULL) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+    p_wait->pfn_notify   = pfn_notify;
+    p_wait->p_notify_arg = p_notify_arg;
+    am_int_cpu_unlock(key);
+
+    return AM_OK;
+}
+
+int am_wait_try (am_wait_t *p_wait)
+{
+    int ret;
+    int key;
+
+    if (p_wait == NULL) {
+        return -AM_EINVAL;
+    }
+
+    key = am_int_cpu_lock();
+
+    if (p_wait->val == __WAIT_VAL_DONE) {
+        ret = AM_OK;
+    } else if (p_wait->val == __WAIT_VAL_TIMEOUT) {
+        ret = -AM_ETIME;
+    } else {
+        ret = -AM_EAGAIN;
+    }
+
+    if (ret != -AM_EAGAIN) {
+        p_wait->val  = __WAIT_VAL_INIT;
+        p_wait->stat = __WAIT_STAT_INIT;
+    }
+
+    am_int_cpu_unlock(key);
+
+    return ret;
+}
+
+int am_wait_idle_set (const am_wait_idle_funcs_t *p_funcs)
+{
+    int key;
+
+    key = am_int_cpu_lock();
+    __gp_wait_idle = p_funcs;
+    am_int_cpu_unlock(key);
 
     return AM_OK;
 }
@@ -98,7 +228,9 @@ int am_wait_on_timeout(am_wait_t *p_wait, uint32_t timeout_ms)
     
     p_wait->stat = __WAIT_STAT_WAIT_ON_TIMEOUT;
     
-    while(p_wait->val == __WAIT_VAL_INIT);
+    AM_TRACE_ENTER(AM_TRACE_WAIT, p_wait);
+    __wait_pend(p_wait);
+    AM_TRACE_EXIT(AM_TRACE_WAIT, p_wait);
     
     if (p_wait->val == __WAIT_VAL_DONE) {  /* ɹȵź */
         ret = AM_OK;
@@ -0,0 +1,397 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief Э̣ջprotothread 
+ *
+ *     Эһڵȴ֮ӹ𴦼ִеĺЭ̲ռö
+ * ջʱ am_co_t м¼ִеλãÿЭֻٵڴ档
+ * Э̿Եȴȴź (am_wait.h)ʱ (am_softimer.h)ȴ
+ * ¼ (am_event.h) ȴ첽ɣ am_i2c_read_async()ȴڼ䲻ռ
+ * CPUЭ̼ѭԼСЭ (am_jobq.h) ȣӦֻ
+ * ѭе am_jobq_process()
+ *
+ *     Э̹ʱѾأֲֵᱣҪԽʹõı
+ * Ӧ p_arg ָĽṹ壨̬СЭ̺ڲʹ switch-case ʵ֣
+ * Э̺вʹ switch Խ㣬ͬһҲжꡣ
+ *
+ * ʹñҪͷļ:
+ * \code
+ * #include "am_co.h"
+ * \endcode
+ *
+ * 
+ * \code
+ * struct sensor_ctx {
+ *     am_i2c_device_t dev;
+ *     am_i2c_async_t  async;
+ *     uint8_t         buf[2];
+ *     int             ret;
+ * };
+ *
+ * static int __sensor_co (am_co_t *p_co, void *p_arg)
+ * {
+ *     struct sensor_ctx *p_ctx = (struct sensor_ctx *)p_arg;
+ *
+ *     AM_CO_BEGIN(p_co);
+ *
+ *     AM_FOREVER {
+ *         AM_CO_AWAIT(p_co,
+ *                     am_i2c_read_async(&p_ctx->dev, 0x00, p_ctx->buf, 2,
+ *                                       &p_ctx->async, am_co_signal, p_co),
+ *                     &p_ctx->ret);
+ *         if (p_ctx->ret == AM_OK) {
+ *             p_ctx->ret = am_i2c_async_status_get(&p_ctx->async);
+ *         }
+ *         AM_CO_SLEEP(p_co, 100);
+ *     }
+ *
+ *     AM_CO_END(p_co);
+ * }
+ *
+ * am_co_init(&sensor_co, __sensor_co, &sensor_ctx, jobq_handle, 0);
+ * am_co_start(&sensor_co);
+ * \endcode
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_CO_H
+#define __AM_CO_H
+
+#include "am_common.h"
+#include "am_jobq.h"
+#include "am_softimer.h"
+#include "am_wait.h"
+#include "am_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus  */
+
+/**
+ * \addtogroup am_if_co
+ * \copydoc am_co.h
+ * @{
+ */
+
+/**
+ * \name Э̺ķֵ
+ * @{
+ */
+
+#define AM_CO_WAITING    0    /**< \brief Э̹𣬵ȴ */
+#define AM_CO_YIELDED    1    /**< \brief ЭóԺ */
+#define AM_CO_EXITED     2    /**< \brief Э˳           */
+#define AM_CO_ENDED      3    /**< \brief Эִн       */
+
+/** @} */
+
+/**
+ * \name Э̱־ӦóӦֱʹ
+ * @{
+ */
+
+#define AM_CO_FLAG_TIMEOUT   0x01    /**< \brief ʱʱ䵽       */
+#define AM_CO_FLAG_SIGNAL    0x02    /**< \brief յź         */
+#define AM_CO_FLAG_EVENT     0x04    /**< \brief յ¼         */
+#define AM_CO_FLAG_ENDED     0x08    /**< \brief Эѽ       */
+
+/** @} */
+
+/** \brief Э */
+typedef struct am_co am_co_t;
+
+/**
+ * \brief Э̺
+ *
+ * \param[in] p_co  : ָЭ̵ָ
+ * \param[in] p_arg : Э̵û
+ *
+ * \return AM_CO_WAITINGAM_CO_YIELDEDAM_CO_EXITED  AM_CO_ENDEDЭ̺귵
+ */
+typedef int (*am_co_func_t) (am_co_t *p_co, void *p_arg);
+
+/**
+ * \brief Э̽ṹ壬ӦóӦֱӲṹԱ
+ */
+struct am_co {
+    uint16_t            lc;            /**< \brief ִеλ       */
+    volatile uint8_t    flags;         /**< \brief Э̱־             */
+    am_co_func_t        pfn_entry;     /**< \brief Э̺             */
+    void               *p_arg;         /**< \brief Э̺û   */
+    am_jobq_handle_t    jobq;          /**< \brief Э̵   */
+    am_jobq_job_t       job;           /**< \brief ִЭ̵       */
+    am_softimer_t       timer;         /**< \brief ߼ʱ       */
+    am_event_handler_t  evt_handler;   /**< \brief ڵȴ¼         */
+    void               *p_evt_data;    /**< \brief յ¼       */
+};
+
+/**
+ * \name Э̺
+ * @{
+ */
+
+/** \brief Э̿ʼλЭ̺Ŀͷ */
+#define AM_CO_BEGIN(p_co)                                                   \
+    { char __co_yield_flag = 1; (void)__co_yield_flag;                      \
+      switch ((p_co)->lc) { case 0:
+
+/** \brief Э̽λЭ̺ĩβ */
+#define AM_CO_END(p_co)                                                     \
+      } (p_co)->lc = 0; return AM_CO_ENDED; }
+
+/** \brief Эֱ̣ cond ÿλʱ飩 */
+#define AM_CO_WAIT_UNTIL(p_co, cond)                                        \
+    do {                                                                    \
+        (p_co)->lc = __LINE__; case __LINE__:                               \
+        if (!(cond)) {                                                      \
+            return AM_CO_WAITING;                                           \
+        }                                                                   \
+    } while (0)
+
+/** \brief Эֱ̣ cond  */
+#define AM_CO_WAIT_WHILE(p_co, cond)    AM_CO_WAIT_UNTIL(p_co, !(cond))
+
+/**
+ * \brief ó CPUеִ
+ *
+ * Эڱ am_jobq_process() 󣨼 am_jobq_post_yield()ٴμ
+ * У˷óЭ̲ѭѭÿһ am_jobq_process()
+ * Эִ̼һΡ
+ */
+#define AM_CO_YIELD(p_co)                                                   \
+    do {                                                                    \
+        __co_yield_flag = 0;                                                \
+        (p_co)->lc = __LINE__; case __LINE__:                               \
+        if (__co_yield_flag == 0) {                                         \
+            return AM_CO_YIELDED;                                           \
+        }                                                                   \
+    } while (0)
+
+/** \brief ˳Э */
+#define AM_CO_EXIT(p_co)                                                    \
+    do {                                                                    \
+        (p_co)->lc = 0;                                                     \
+        return AM_CO_EXITED;                                                \
+    } while (0)
+
+/** \brief  ms  */
+#define AM_CO_SLEEP(p_co, ms)                                               \
+    do {                                                                    \
+        am_co_timer_start(p_co, ms);                                        \
+        AM_CO_WAIT_UNTIL(p_co, am_co_timeout_check(p_co));                  \
+    } while (0)
+
+/**
+ * \brief ȴź p_waitam_wait_done()timeout_ms Ϊ 0 ʱһֱȴ
+ *
+ * ȴ *p_ret Ϊ AM_OK  -AM_ETIMEʱ
+ */
+#define AM_CO_WAIT_ON(p_co, p_wait, timeout_ms, p_ret)                      \
+    do {                                                                    \
+        am_co_wait_begin(p_co, p_wait, timeout_ms);                         \
+        AM_CO_WAIT_UNTIL(p_co, am_co_wait_end(p_co, p_wait, p_ret));        \
+    } while (0)
+
+/**
+ * \brief ȴ¼ p_event timeout_ms Ϊ 0 ʱһֱȴ
+ *
+ * ȴ *p_ret Ϊ AM_OK  -AM_ETIMEʱ*pp_evt_data Ϊ¼
+ */
+#define AM_CO_WAIT_EVENT(p_co, p_event, timeout_ms, pp_evt_data, p_ret)     \
+    do {                                                                    \
+        am_co_event_begin(p_co, p_event, timeout_ms);                       \
+        AM_CO_WAIT_UNTIL(p_co,                                              \
+                         am_co_event_end(p_co, p_event, pp_evt_data, p_ret)); \
+    } while (0)
+
+/**
+ * \brief һ첽ȴ
+ *
+ * start_expr Ϊ첽ıʽɻصΪ am_co_signalΪ
+ * p_co*p_ret Ϊ start_expr ķֵʧ򲻵ȴ
+ */
+#define AM_CO_AWAIT(p_co, start_expr, p_ret)                                \
+    do {                                                                    \
+        am_co_signal_clr(p_co);                                             \
+        *(p_ret) = (start_expr);                                            \
+        if (*(p_ret) == AM_OK) {                                            \
+            AM_CO_WAIT_UNTIL(p_co, am_co_signal_check(p_co));               \
+        }                                                                   \
+    } while (0)
+
+/**
+ * \brief  UARTring bufferжģʽ nbytes ݣݲʱ
+ *
+ *  am_uart_rngbuf.h*p_len Ϊѽյֽʱǰ
+ */
+#define AM_CO_UART_RECEIVE(p_co, handle, p_buf, nbytes, p_len)              \
+    do {                                                                    \
+        *(p_len) = 0;                                                       \
+        while (*(p_len) < (nbytes)) {                                       \
+            int __co_n;                                                     \
+            am_co_signal_clr(p_co);                                         \
+            __co_n = am_uart_rngbuf_receive_async(handle,                   \
+                                                  (p_buf) + *(p_len),       \
+                                                  (nbytes) - *(p_len),      \
+                                                  am_co_signal,             \
+                                                  p_co);                    \
+            if (__co_n < 0) {                                               \
+                break;                                                      \
+            }                                                               \
+            *(p_len) += __co_n;                                             \
+            if (__co_n == 0) {                                              \
+                AM_CO_WAIT_UNTIL(p_co, am_co_signal_check(p_co));           \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+/** @} */
+
+/**
+ * \brief ʼЭ
+ *
+ * \param[in] p_co      : ָЭ̵ָ
+ * \param[in] pfn_entry : Э̺
+ * \param[in] p_arg     : Э̺û
+ * \param[in] jobq      : Э̵
+ * \param[in] pri       : Эеȼ
+ *
+ * \retval  AM_OK     : ʼɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EPERM  : ʱģ黹δʼ
+ */
+int am_co_init (am_co_t          *p_co,
+                am_co_func_t      pfn_entry,
+                void             *p_arg,
+                am_jobq_handle_t  jobq,
+                uint16_t          pri);
+
+/**
+ * \brief Э̣Э̽ͷʼִ
+ *
+ * \param[in] p_co : ָЭ̵ָ
+ *
+ * \retval  AM_OK     : ɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_co_start (am_co_t *p_co);
+
+/**
+ * \brief ֹЭ̣Эִ̲
+ *
+ * Эڵȴ¼ʱעӦ¼
+ *
+ * \param[in] p_co : ָЭ̵ָ
+ * \return 
+ */
+void am_co_kill (am_co_t *p_co);
+
+/**
+ * \brief жЭǷѾִн˳ֹ
+ *
+ * \param[in] p_co : ָЭ̵ָ
+ * \return AM_TRUE ʾѽ
+ */
+am_static_inline
+am_bool_t am_co_is_ended (am_co_t *p_co)
+{
+    return (p_co->flags & AM_CO_FLAG_ENDED) ? AM_TRUE : AM_FALSE;
+}
+
+/**
+ * \brief Э̣ʹȴжеã
+ *
+ * \param[in] p_co : ָЭ̵ָ루Ϊ am_co_t *
+ * \return 
+ */
+void am_co_wake (void *p_co);
+
+/**
+ * \brief Э̷źŲЭ̣жеã
+ *
+ * ͨΪ첽ɻص AM_CO_AWAIT() ʹ
+ *
+ * \param[in] p_co : ָЭ̵ָ루Ϊ am_co_t *
+ * \return 
+ */
+void am_co_signal (void *p_co);
+
+/**
+ * \brief Э̵ź
+ * \param[in] p_co : ָЭ̵ָ
+ * \return 
+ */
+void am_co_signal_clr (am_co_t *p_co);
+
+/**
+ * \brief ЭǷյźţյź
+ * \param[in] p_co : ָЭ̵ָ
+ * \return AM_TRUE ʾյź
+ */
+am_bool_t am_co_signal_check (am_co_t *p_co);
+
+/**
+ * \brief Э̵Ķʱʱʱ䵽ʱЭ
+ *
+ * \param[in] p_co : ָЭ̵ָ
+ * \param[in] ms   : ʱʱ䣬Ϊ 0 ʱΪʱʱ䵽
+ * \return 
+ */
+void am_co_timer_start (am_co_t *p_co, unsigned int ms);
+
+/**
+ * \brief Э̵ĶʱʱǷѵ
+ * \param[in] p_co : ָЭ̵ָ
+ * \return AM_TRUE ʾʱʱѵ
+ */
+am_bool_t am_co_timeout_check (am_co_t *p_co);
+
+/**
+ * \brief ʼȴźţ AM_CO_WAIT_ON() ʹ
+ */
+void am_co_wait_begin (am_co_t *p_co, am_wait_t *p_wait, uint32_t timeout_ms);
+
+/**
+ * \brief źŵȴǷ AM_CO_WAIT_ON() ʹ
+ */
+am_bool_t am_co_wait_end (am_co_t *p_co, am_wait_t *p_wait, int *p_ret);
+
+/**
+ * \brief ʼȴ¼ AM_CO_WAIT_EVENT() ʹ
+ */
+void am_co_event_begin (am_co_t         *p_co,
+                        am_event_type_t *p_event,
+                        uint32_t         timeout_ms);
+
+/**
+ * \brief ¼ȴǷ AM_CO_WAIT_EVENT() ʹ
+ */
+am_bool_t am_co_event_end (am_co_t          *p_co,
+                           am_event_type_t  *p_event,
+                           void            **pp_evt_data,
+                           int              *p_ret);
+
+/** @}  */
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus  */
+
+#endif  /* __AM_CO_H */
+
+/* end of file */
@@ -25,8 +25,21 @@
  * 2. ¼־ AM_EVENT_PROC_FLAG_CAT_ONLY event typeе
  *    event handler Ҳִһ顣
  *
+ * ¼ʽ
+ * - Ĭ am_event_raise() ֱӵø¼ڼжϣ
+ * -  am_event_async_init() 󣬿ʹ am_event_raise_async()
+ *   AM_EVENT_PROC_FLAG_ASYNC ־ am_event_raise()¼к
+ *   أУжӳģ飩ڿжϵµø¼ʱ
+ *   ֻڶȡʱݹжϣִʱ䲻ӰжӦ
+ *
+ * ڼעע⴦̲ٷѵùĴ
+ * δõĴעҲٱá첽ʱȡ䴦
+ * ǰעôεԻִС
+ *
  * \internal
  * \par modification history:
+ * - 1.02 26-10-18 lgg, handlers can be unregistered during processing.
+ * - 1.01 26-10-18 lgg, add queued asynchronous dispatch.
  * - 1.00 17-05-12 tee, first implementation.
  * \endinternal
  */
@@ -41,6 +54,7 @@
  */
 
 #include "am_common.h"
+#include "am_jobq.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,7 +65,11 @@ extern "C" {
  * @{
  */
 
-/** \brief ¼󣬸¼Զע   */
+/**
+ * \brief ¼󣬸¼Զע
+ *
+ * ڵ䴦֮ǰע˿ڴעô
+ */
 #define AM_EVENT_HANDLER_FLAG_AUTO_UNREG     (1u << 0)
 
 /** @} */
@@ -64,8 +82,21 @@ extern "C" {
 /* \brief ¼ֻᴥ  event category е event handler  */
 #define AM_EVENT_PROC_FLAG_CAT_ONLY         (1u << 0)
 
+/**
+ * \brief ¼첽 am_event_async_init()¼ݲƣ
+ *        ڴǰ뱣Ч
+ */
+#define AM_EVENT_PROC_FLAG_ASYNC            (1u << 1)
+
 /** @} */
 
+/**
+ * \brief 첽ʱһ¼ɸƵֽ
+ */
+#ifndef AM_EVENT_ASYNC_DATA_SIZE
+#define AM_EVENT_ASYNC_DATA_SIZE            16
+#endif
+
 /** \breif event_category ṹ */
 struct am_event_category;
 typedef struct am_event_category am_event_category_t;
@@ -166,6 +197,66 @@ struct am_event_category {
 };
 
 
+/**
+ * \brief 첽е¼ӦóӦֱӲṹԱ
+ */
+typedef struct am_event_msg {
+    am_event_type_t *p_event;   /**< \brief ¼ */
+    void            *p_data;    /**< \brief ¼ݣδʱ*/
+    uint16_t         flags;     /**< \brief ־ */
+    uint16_t         size;      /**< \brief Ƶֽ */
+
+    /** \brief Ƶ¼ */
+    uint32_t         data[(AM_EVENT_ASYNC_DATA_SIZE + 3) / 4];
+} am_event_msg_t;
+
+/**
+ * \brief ʼ첽¼
+ *
+ * \param[in] p_msgs : ¼л
+ * \param[in] nmsgs  : ɵ¼
+ * \param[in] jobq   : ¼УΪ NULL ʱʹжӳģ
+ *                     am_isr_defer_job_add()ȳʼжӳģ飩
+ * \param[in] pri    : ȼ
+ *
+ * \retval AM_OK      : ʼɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_event_async_init (am_event_msg_t   *p_msgs,
+                         size_t            nmsgs,
+                         am_jobq_handle_t  jobq,
+                         uint16_t          pri);
+
+/**
+ * \brief ¼кأ¼ڿжϵִ
+ *
+ * ¼ݱƵУõݸĵַ˿ʹþֲ
+ * Ϊ¼ݡsize Ϊ 0 ʱƣֱӴ p_evt_dataδ
+ * am_event_async_init() ʱ am_event_raise() ֱͬӴ¼
+ *
+ * \param[in] p_event    : ¼
+ * \param[in] p_evt_data : ¼
+ * \param[in] size       : ҪƵ¼ֽ
+ *                         AM_EVENT_ASYNC_DATA_SIZE
+ * \param[in] flags      : ־, 0  AM_EVENT_PROC_FLAG_*
+ *
+ * \retval AM_OK       : ɹ
+ * \retval -AM_EINVAL  : 
+ * \retval -AM_ENOSPC  : ¼
+ * \retval -AM_EPERM   : жӳģδʼ¼ͬ
+ *                       شʱĴ룩
+ */
+int am_event_raise_async (am_event_type_t *p_event,
+                          const void      *p_evt_data,
+                          size_t           size,
+                          int              flags);
+
+/**
+ * \brief ȡ¼
+ * \return ¼
+ */
+uint32_t am_event_async_dropped_get (void);
+
 /** \brief ʼ¼¼ */
 am_static_inline
 void am_event_category_init (am_event_category_t *p_category)
@@ -37,6 +37,7 @@
  *
  * \internal
  * \par Modification History
+ * - 1.04 26-10-18  lgg, add asynchronous read/write.
  * - 1.03 15-12-08  cyl, delete the am_i2c_connect.
  * - 1.02 15-10-27  tee, add the concept of message.
  * - 1.01 15-08-19  tee, modified some interface.
@@ -454,6 +455,72 @@ int am_i2c_read(am_i2c_device_t *p_dev,
                 uint32_t         sub_addr,
                 uint8_t         *p_buf, 
                 uint32_t         nbytes);
+
+/**
+ * \brief I2C첽дʹõģǰһֱЧ
+ */
+typedef struct am_i2c_async {
+    am_i2c_transfer_t trans[2];        /**< \brief ӵַݴ       */
+    am_i2c_message_t  msg;             /**< \brief ϢstatusΪ */
+    uint8_t           subaddr_buf[2];  /**< \brief ӵַ             */
+} am_i2c_async_t;
+
+/**
+ * \brief ȡI2C첽дĽɻصúЧ
+ */
+#define am_i2c_async_status_get(p_async)    ((p_async)->msg.status)
+
+/**
+ * \brief I2C첽д
+ *
+ * أʱ pfn_completeͨжϻУ
+ * ʹ am_i2c_async_status_get() ȡ
+ *
+ * \param[in] p_dev        : ָӻ豸ϢĽṹָ
+ * \param[in] sub_addr     : ӻ豸ӵַ
+ * \param[in] p_buf        : ָݻ
+ * \param[in] nbytes       : ݻ泤
+ * \param[in] p_async      : 첽д
+ * \param[in] pfn_complete : ɻص
+ * \param[in] p_arg        : ص
+ *
+ * \retval  AM_OK      : 
+ * \retval -AM_EINVAL  : 
+ * \retval -AM_ENOTSUP : ֵ֧ӵַ
+ */
+int am_i2c_write_async(am_i2c_device_t *p_dev,
+                       uint32_t         sub_addr,
+                       const uint8_t   *p_buf,
+                       uint32_t         nbytes,
+                       am_i2c_async_t  *p_async,
+                       am_pfnvoid_t     pfn_complete,
+                       void            *p_arg);
+
+/**
+ * \brief I2C첽
+ *
+ * أʱ pfn_completeͨжϻУ
+ * ʹ am_i2c_async_status_get() ȡ
+ *
+ * \param[in] p_dev        : ָӻ豸ϢĽṹָ
+ * \param[in] sub_addr     : ӻ豸ӵַ
+ * \param[in] p_buf        : ָݻ
+ * \param[in] nbytes       : ݻ泤
+ * \param[in] p_async      : 첽д
+ * \param[in] pfn_complete : ɻص
+ * \param[in] p_arg        : ص
+ *
+ * \retval  AM_OK      : 
+ * \retval -AM_EINVAL  : 
+ * \retval -AM_ENOTSUP : ֵ֧ӵַ
+ */
+int am_i2c_read_async(am_i2c_device_t *p_dev,
+                      uint32_t         sub_addr,
+                      uint8_t         *p_buf,
+                      uint32_t         nbytes,
+                      am_i2c_async_t  *p_async,
+                      am_pfnvoid_t     pfn_complete,
+                      void            *p_arg);
 /** 
  * @}
  */
@@ -22,6 +22,11 @@
  * ǰִɡ
  *     ˳ִУΪ˱֤жӳҲɣ鲻Ҫжӳ
  * ʱ
+ *     δִʱٴӣظУǺϲͬһִУ
+ * ¼ӵĴ am_isr_defer_job_add_events() ӵ¼λ
+ *  am_isr_defer_job_count_get()am_isr_defer_job_events_get() ȡ
+ * ִкϲĴ¼һδϣ GPIOڵȸƵжϡÿ
+ * ͳӴϲӵִеӳ١
  *
  * ʹñҪͷļ:
  * \code
@@ -32,6 +37,7 @@
  *
  * \internal
  * \par modification history:
+ * - 1.01 26-10-18  lgg, add coalescing counts and statistics
  * - 1.00 15-09-17  tee, first implementation
  * \endinternal
  */
@@ -48,8 +54,28 @@
 #include "am_jobq.h"
 #include <string.h>
 
-/** \brief жӳ */
-typedef am_jobq_job_t am_isr_defer_job_t;
+/** \brief жӳͳϢ */
+typedef struct am_isr_defer_stat {
+    uint32_t posts;         /**< \brief ӵĴ */
+    uint32_t coalesced;     /**< \brief ϲڶеĴ */
+    uint32_t runs;          /**< \brief ִеĴ */
+    uint32_t latency_max;   /**< \brief ״ӵʼִеʱ */
+} am_isr_defer_stat_t;
+
+/**
+ * \brief жӳͣӦóӦֱӲṹԱ
+ */
+typedef struct am_isr_defer_job {
+    am_jobq_job_t          job;         /**< \brief е */
+    am_pfnvoid_t           func;        /**< \brief  */
+    void                  *p_arg;       /**< \brief  */
+    volatile uint32_t      pending;     /**< \brief δӴ */
+    volatile uint32_t      events;      /**< \brief δ¼λ */
+    uint32_t               count;       /**< \brief ִкϲӴ */
+    uint32_t               cur_events;  /**< \brief ִкϲ¼λ */
+    uint32_t               post_time;   /**< \brief ״ӵʱ */
+    am_isr_defer_stat_t    stat;        /**< \brief ͳϢ */
+} am_isr_defer_job_t;
 
 /** 
  * \brief ڴ䣬ɸָͻȡϢ 
@@ -145,11 +171,75 @@ void am_isr_defer_job_init (am_isr_defer_job_t  *p_job,
  *
  * \retval AM_OK      ɹ
  * \retval -AM_EINVAL : 
- * \retval -AM_EBUSY  : ǰѾڶУ޷ظ
+ * \retval -AM_EBUSY  : ǰѾڶУѺϲôִ
  * \retval -AM_EPERM  : isr deferģδȷʼʹ
  */
 int am_isr_defer_job_add (am_isr_defer_job_t *p_job);
 
+/**
+ * \brief һӵжӳٹУ¼λ
+ *
+ * ִǰʱε¼λλϲ
+ *
+ * \param[in] p_job  : ָָ
+ * \param[in] events : ¼λ
+ *
+ * \retval AM_OK      ɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EBUSY  : ǰѾڶУѺϲôִ
+ * \retval -AM_EPERM  : isr deferģδȷʼʹ
+ */
+int am_isr_defer_job_add_events (am_isr_defer_job_t *p_job, uint32_t events);
+
+/**
+ * \brief ȡִкϲӴĴе
+ *
+ * \param[in] p_job : ָָ
+ *
+ * \return ִ֮ǰӵĴΪ 1
+ */
+uint32_t am_isr_defer_job_count_get (am_isr_defer_job_t *p_job);
+
+/**
+ * \brief ȡִкϲ¼λĴе
+ *
+ * \param[in] p_job : ָָ
+ *
+ * \return ִ֮ǰӵ¼λλĽ
+ */
+uint32_t am_isr_defer_job_events_get (am_isr_defer_job_t *p_job);
+
+/**
+ * \brief ͳӳʹõʱԴ
+ *
+ * ʱԴͬʱжӳʹõУ am_jobq_clk_set()
+ *
+ * \param[in] pfn_clk_get : ȡǰʱĺΪ NULL ʱͳӳ
+ *
+ * \retval AM_OK      óɹ
+ * \retval -AM_EPERM  : isr deferģδȷʼʹ
+ */
+int am_isr_defer_clk_set (am_jobq_clk_get_t pfn_clk_get);
+
+/**
+ * \brief ȡͳϢ
+ *
+ * \param[in]  p_job  : ָָ
+ * \param[out] p_stat : ڻȡͳϢ
+ *
+ * \retval AM_OK      ȡɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_isr_defer_stat_get (am_isr_defer_job_t  *p_job,
+                           am_isr_defer_stat_t *p_stat);
+
+/**
+ * \brief ͳϢ
+ * \param[in] p_job : ָָ
+ * \return 
+ */
+void am_isr_defer_stat_clr (am_isr_defer_job_t *p_job);
+
 /** @}  */
 
 #ifdef __cplusplus
@@ -30,6 +30,10 @@
  *
  * \internal
  * \par modification history:
+ * - 1.04 26-10-18  lgg, document that deadlines are ordered per priority only
+ * - 1.03 26-10-18  lgg, statistics are attached to a job by am_jobq_stat_attach()
+ * - 1.02 26-10-18  lgg, add am_jobq_post_yield()
+ * - 1.01 26-10-18  lgg, add deadline jobs, budget and statistics
  * - 1.00 15-09-17  tee, first implementation
  * \endinternal
  */
@@ -45,6 +49,19 @@
 #include "am_list.h"
 #include <string.h>
 
+/**
+ * \brief ͳֱͼͰ AM_JOBQ_STAT ʱЧ
+ *
+ *  0 ͰͳʱΪ 0 Ĵ i Ͱͳʱ [2^(i-1), 2^i) ڵĴ
+ * һͰͳиʱ
+ */
+#ifndef AM_JOBQ_STAT_BUCKETS
+#define AM_JOBQ_STAT_BUCKETS    12
+#endif
+
+/** \brief ȡǰʱĺ */
+typedef uint32_t (*am_jobq_clk_get_t) (void);
+
 
 /**
  * \brief нṹ
@@ -65,6 +82,18 @@ typedef struct am_jobq_queue {
  
     /** \brief еһЩ״̬־      */
     uint32_t              flags;
+
+    /** \brief ʱԴڴʱԤ㼰ͳƣΪ NULL */
+    am_jobq_clk_get_t     pfn_clk_get;
+
+    /** \brief һδִе0 ʾ */
+    uint32_t              budget_jobs;
+
+    /** \brief һδʱ䣬0 ʾ  */
+    uint32_t              budget_time;
+
+    /** \brief δó񣬴ʱ */
+    struct am_list_head   yielded;
 } am_jobq_queue_t;
 
 /**
@@ -72,6 +101,19 @@ typedef struct am_jobq_queue {
  */
 typedef struct am_jobq_queue *am_jobq_handle_t;
 
+/**
+ * \brief ͳϢ AM_JOBQ_STAT ʱЧ
+ *
+ * Ӧö壬ͨ am_jobq_stat_attach() ҪͳƵͳϢ
+ * ţͷŻ³ʼʱִԿͳơ
+ */
+typedef struct am_jobq_stat {
+    uint32_t wait_hist[AM_JOBQ_STAT_BUCKETS]; /**< \brief Ŷӵȴʱֱͼ */
+    uint32_t exec_hist[AM_JOBQ_STAT_BUCKETS]; /**< \brief ִʱֱͼ     */
+    uint32_t wait_max;                        /**< \brief Ŷӵȴʱ   */
+    uint32_t exec_max;                        /**< \brief ִʱ       */
+} am_jobq_stat_t;
+
 /** 
  * \brief ṹ壬ӦóӦֱӲṹԱ
  *
@@ -83,6 +125,15 @@ typedef struct am_jobq_job {
     uint16_t            pri;    /**< \brief ȼ               */
     uint16_t            flags;  /**< \brief һЩ־             */
     struct am_list_head node;   /**< \brief ڵ             */
+
+#ifdef AM_JOBQ_DEADLINE
+    uint32_t            deadline; /**< \brief ֹʱ           */
+#endif
+
+#ifdef AM_JOBQ_STAT
+    uint32_t            post_time;/**< \brief еʱ     */
+    am_jobq_stat_t     *p_stat;   /**< \brief ͳϢΪ NULL */
+#endif
 } am_jobq_job_t;
 
 /**
@@ -159,7 +210,52 @@ void am_jobq_job_init (am_jobq_job_t  *p_job,
 int am_jobq_post (am_jobq_handle_t handle, am_jobq_job_t *p_job);
 
 /**
- * \brief һУϺ󷵻
+ * \brief һӵУڴ򱾴δż
+ *
+ * ó CPU ִУнٴμУʹ
+ * am_jobq_post()ڴĶУ am_jobq_process() ִᷴ
+ * ޷أϵȼѭеòִСʹñ
+ * ʱ񣨰ϵȼ񣩴am_jobq_process() 
+ * в -AM_EAGAIN´εʱִС
+ *
+ * \param[in] handle  : еı׼
+ * \param[in] p_job   : ָָ
+ *
+ * \retval AM_OK      ɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EBUSY  : ǰѾڶУȴУ޷ظ
+ */
+int am_jobq_post_yield (am_jobq_handle_t handle, am_jobq_job_t *p_job);
+
+#ifdef AM_JOBQ_DEADLINE
+
+/**
+ * \brief һֹʱӵ
+ *
+ * ڵȼڣֹʱ񰴽ֹʱ絽УֹʱıȽ
+ * ˼ֵƣڸȼ֮ͨǰ
+ *
+ * \attention ֹʱֻͬһȼEDFȼȽϣȼе
+ *            񣨰ͨڵȼеʹߵĽֹʱ
+ *            ѾڡҪֹʱͳһȵӦʹͬһȼӡ
+ *
+ * \param[in] handle   : еı׼
+ * \param[in] p_job    : ָָ
+ * \param[in] deadline : ֹʱ䣨ʱ䣬λ am_jobq_clk_set() õʱ
+ *                       Դһ£
+ *
+ * \retval AM_OK      ɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EBUSY  : ǰѾڶУ޷ظ
+ */
+int am_jobq_post_deadline (am_jobq_handle_t  handle,
+                           am_jobq_job_t    *p_job,
+                           uint32_t          deadline);
+
+#endif /* AM_JOBQ_DEADLINE */
+
+/**
+ * \brief һУϣﵽԤ㣩󷵻
  *
  * һ񱻴Զ˳УԱٴμ롣
  * δʱ޷ٴμ
@@ -169,9 +265,86 @@ int am_jobq_post (am_jobq_handle_t handle, am_jobq_job_t *p_job);
  * \retval AM_OK      
  * \retval -AM_EINVAL : 
  * \retval -AM_EBUSY  : ǰڴ
+ * \retval -AM_EAGAIN : ﵽԤ㣬ͨ am_jobq_post_yield() ó
+ *                      ٴεñ
  */
 int am_jobq_process (am_jobq_handle_t handle);
 
+/**
+ * \brief еʱԴ
+ *
+ * \param[in] handle      : еı׼
+ * \param[in] pfn_clk_get : ȡǰʱĺΪ NULL ʱƴʱ䣬Ҳ
+ *                          ͳʱ
+ *
+ * \retval AM_OK      óɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_jobq_clk_set (am_jobq_handle_t handle, am_jobq_clk_get_t pfn_clk_get);
+
+/**
+ * \brief һ am_jobq_process() ĴԤ
+ *
+ * ﵽһԤam_jobq_process() ڵǰִ󷵻 -AM_EAGAINʣ
+ * һεʱ
+ *
+ * \param[in] handle   : еı׼
+ * \param[in] max_jobs : һִе0 ʾ
+ * \param[in] max_time : һĴʱ䣨ʱԴ0 ʾ
+ *
+ * \retval AM_OK      óɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_jobq_budget_set (am_jobq_handle_t handle,
+                        uint32_t         max_jobs,
+                        uint32_t         max_time);
+
+#ifdef AM_JOBQ_STAT
+
+/**
+ * \brief ΪͳϢ㣬˺ÿִжͳ
+ *
+ * am_jobq_job_init() ȡӦڳʼ֮á
+ *
+ * \param[in] p_job  : ָָ
+ * \param[in] p_stat : ͳϢһֱЧ綨Ϊ̬Ϊ NULL ʱ
+ *                     ȡ
+ *
+ * \retval AM_OK      ɹ
+ * \retval -AM_EINVAL : 
+ *
+ * \par 
+ * \code
+ * static am_jobq_job_t  __g_job;
+ * static am_jobq_stat_t __g_job_stat;
+ *
+ * am_jobq_job_init(&__g_job, __job_func, NULL, 0);
+ * am_jobq_stat_attach(&__g_job, &__g_job_stat);
+ * \endcode
+ */
+int am_jobq_stat_attach (am_jobq_job_t *p_job, am_jobq_stat_t *p_stat);
+
+/**
+ * \brief ȡͳϢ
+ *
+ * \param[in]  p_job  : ָָ
+ * \param[out] p_stat : ڻȡͳϢ
+ *
+ * \retval AM_OK      ȡɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_EPERM  : δͳϢ
+ */
+int am_jobq_stat_get (am_jobq_job_t *p_job, am_jobq_stat_t *p_stat);
+
+/**
+ * \brief ͳϢ
+ * \param[in] p_job : ָָ
+ * \return 
+ */
+void am_jobq_stat_clr (am_jobq_job_t *p_job);
+
+#endif /* AM_JOBQ_STAT */
+
 /**
  * \brief ʵָʹõȼ
  *
@@ -0,0 +1,248 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ӳٸʽĶ־
+ *
+ *     AM_LOG() ĿϸʽַֻѸʽַĵַתΪ
+ * 32 λ֣д뻷λÿεý輸ʮڣжʹáʽַ
+ *  .am_log_fmt Сѭʱ am_log_drain()еļ¼
+ * Ϊ "#L:" ͷıУͨ am_koutput  am_kprintf() ʹõ
+ * ڣPC ˵ tools/am_log/am_log_decode.py  ELF ļеĸʽַ
+ * ԭ־ııԭ
+ *
+ * ƣ
+ * -  AM_LOG_ARGS_MAX ÿתΪ uint32_t
+ * - ֧ 64 λ͸
+ * - %s ĲӦΪַλ ELF ļУ빤ߴ ELF ļжȡ
+ *
+ * ʽַֻ PC ʹáGCC ӽűн .am_log_fmt Ϊ
+ * (INFO) ͣʽַ ELF ļУռ Flash
+ *
+ * ʹñҪͷļ:
+ * \code
+ * #include "am_log.h"
+ * \endcode
+ *
+ * 
+ * \code
+ * static uint32_t __g_log_buf[256];
+ *
+ * am_log_init(__g_log_buf, AM_NELEMENTS(__g_log_buf));
+ *
+ * AM_LOG(AM_LOG_LEVEL_INFO, "adc ch%d = %u\n", ch, val);    // ж
+ *
+ * while (1) {
+ *     am_log_drain(0);                                      // ѭ
+ * }
+ * \endcode
+ *
+ * 룺python3 am_log_decode.py app.elf /dev/ttyUSB0
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_LOG_H
+#define __AM_LOG_H
+
+#include "am_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus  */
+
+/**
+ * \addtogroup am_if_log
+ * \copydoc am_log.h
+ * @{
+ */
+
+/**
+ * \name ־
+ * @{
+ */
+
+#define AM_LOG_LEVEL_ERROR    0    /**< \brief  */
+#define AM_LOG_LEVEL_WARN     1    /**< \brief  */
+#define AM_LOG_LEVEL_INFO     2    /**< \brief Ϣ */
+#define AM_LOG_LEVEL_DEBUG    3    /**< \brief  */
+
+/** @} */
+
+/**
+ * \brief ʱ־𣬼ڸֵ AM_LOG() 
+ */
+#ifndef AM_LOG_LEVEL
+#define AM_LOG_LEVEL          AM_LOG_LEVEL_DEBUG
+#endif
+
+/** \brief ÿ־Ĳ */
+#define AM_LOG_ARGS_MAX       8
+
+/** \brief ʽַڵĶ */
+#if defined(__GNUC__) || defined(__CC_ARM)
+#define AM_LOG_FMT_SECTION    __attribute__((section(".am_log_fmt")))
+#else
+#define AM_LOG_FMT_SECTION
+#endif
+
+/**
+ * \brief ¼һ־
+ *
+ * \param[in] level : ־AM_LOG_LEVEL_*Ϊ
+ * \param[in] ...   : ʽַΪַ AM_LOG_ARGS_MAX 
+ *                    ָ
+ */
+#define AM_LOG(level, ...)                                                  \
+    __AM_LOG_N(level, __AM_LOG_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * \brief ʼ־
+ *
+ * \param[in] p_buf  : 
+ * \param[in] nwords : СΪ 2 
+ *
+ * \retval  AM_OK     : ʼɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_log_init (uint32_t *p_buf, size_t nwords);
+
+/**
+ * \brief ʱúÿ־ʱ
+ *
+ * \param[in] pfn_clk_get : ȡʱĺ綨ʱֵNULL ʾ¼
+ * \return 
+ */
+void am_log_clk_set (uint32_t (*pfn_clk_get) (void));
+
+/**
+ * \brief е־ͨ am_koutput жеã
+ *
+ * \param[in] max : ־0 ʾȫ
+ *
+ * \return ־
+ */
+int am_log_drain (unsigned int max);
+
+/**
+ * \brief ȡ򻺳־
+ * \return ־
+ */
+uint32_t am_log_dropped_get (void);
+
+/**
+ * \brief дһ־ AM_LOG() 
+ *
+ * \param[in] info   : ־bit4 ~ 7bit0 ~ 3
+ * \param[in] p_fmt  : ʽַ
+ * \param[in] p_args : 
+ *
+ * \return 
+ */
+void am_log_write (uint32_t info, const char *p_fmt, const uint32_t *p_args);
+
+/**
+ * \cond
+ * Ϊ AM_LOG() ʵ֣תΪ uint32_t
+ */
+#define __AM_LOG_NARGS(...)                                                 \
+    __AM_LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define __AM_LOG_NARGS_(f, a1, a2, a3, a4, a5, a6, a7, a8, n, ...)  n
+
+#define __AM_LOG_N(level, n, ...)     __AM_LOG_N_(level, n, __VA_ARGS__)
+#define __AM_LOG_N_(level, n, ...)    __AM_LOG_##n(level, __VA_ARGS__)
+
+#define __AM_LOG_W(x)                 ((uint32_t)(uintptr_t)(x))
+
+#define __AM_LOG_BEGIN(level, n, fmt)                                       \
+    do {                                                                    \
+        if ((level) <= AM_LOG_LEVEL) {                                      \
+            static const char __fmt[] AM_LOG_FMT_SECTION = fmt;             \
+            uint32_t          __arg[(n) + 1];
+
+#define __AM_LOG_END(level, n)                                              \
+            am_log_write(((level) << 4) | (n), __fmt, __arg);               \
+        }                                                                   \
+    } while (0)
+
+#define __AM_LOG_0(level, fmt)                                              \
+    __AM_LOG_BEGIN(level, 0, fmt)                                           \
+        (void)__arg;                                                        \
+    __AM_LOG_END(level, 0)
+
+#define __AM_LOG_1(level, fmt, a1)                                          \
+    __AM_LOG_BEGIN(level, 1, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1);                                          \
+    __AM_LOG_END(level, 1)
+
+#define __AM_LOG_2(level, fmt, a1, a2)                                      \
+    __AM_LOG_BEGIN(level, 2, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+    __AM_LOG_END(level, 2)
+
+#define __AM_LOG_3(level, fmt, a1, a2, a3)                                  \
+    __AM_LOG_BEGIN(level, 3, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3);                                          \
+    __AM_LOG_END(level, 3)
+
+#define __AM_LOG_4(level, fmt, a1, a2, a3, a4)                              \
+    __AM_LOG_BEGIN(level, 4, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3); __arg[3] = __AM_LOG_W(a4);               \
+    __AM_LOG_END(level, 4)
+
+#define __AM_LOG_5(level, fmt, a1, a2, a3, a4, a5)                          \
+    __AM_LOG_BEGIN(level, 5, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3); __arg[3] = __AM_LOG_W(a4);               \
+        __arg[4] = __AM_LOG_W(a5);                                          \
+    __AM_LOG_END(level, 5)
+
+#define __AM_LOG_6(level, fmt, a1, a2, a3, a4, a5, a6)                      \
+    __AM_LOG_BEGIN(level, 6, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3); __arg[3] = __AM_LOG_W(a4);               \
+        __arg[4] = __AM_LOG_W(a5); __arg[5] = __AM_LOG_W(a6);               \
+    __AM_LOG_END(level, 6)
+
+#define __AM_LOG_7(level, fmt, a1, a2, a3, a4, a5, a6, a7)                  \
+    __AM_LOG_BEGIN(level, 7, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3); __arg[3] = __AM_LOG_W(a4);               \
+        __arg[4] = __AM_LOG_W(a5); __arg[5] = __AM_LOG_W(a6);               \
+        __arg[6] = __AM_LOG_W(a7);                                          \
+    __AM_LOG_END(level, 7)
+
+#define __AM_LOG_8(level, fmt, a1, a2, a3, a4, a5, a6, a7, a8)              \
+    __AM_LOG_BEGIN(level, 8, fmt)                                           \
+        __arg[0] = __AM_LOG_W(a1); __arg[1] = __AM_LOG_W(a2);               \
+        __arg[2] = __AM_LOG_W(a3); __arg[3] = __AM_LOG_W(a4);               \
+        __arg[4] = __AM_LOG_W(a5); __arg[5] = __AM_LOG_W(a6);               \
+        __arg[6] = __AM_LOG_W(a7); __arg[7] = __AM_LOG_W(a8);               \
+    __AM_LOG_END(level, 8)
+
+/** \endcond */
+
+/** @}  */
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus  */
+
+#endif  /* __AM_LOG_H */
+
+/* end of file */
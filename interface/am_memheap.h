@@ -14,8 +14,18 @@
  * \file
  * \brief ѹ
  *
+ * Ĭʹ״䣨first-fit㷨п飬ʱƬ
+ *  AM_MEMHEAP_TLSF ꣨ͨڹ̵Ԥѡж壩󣬿п
+ * 䣨TLSF㷨ͷžΪ O(1)ڶʵʱҪĳϡ
+ *
+ * am_memheap_info_get()am_memheap_walk()  am_memheap_dump() ڲ鿴ѵ
+ * ʹƬ̶ȡ AM_MEMHEAP_TRACE ÿѷ黹¼
+ * am_memheap_alloc() ļкţڶλڴʹߡ
+ *
  * \internal
  * \par modification history:
+ * - 1.02 26-10-18  lgg, add heap walk, fragmentation info and call-site tags
+ * - 1.01 26-10-18  lgg, add TLSF free block management
  * - 1.00 16-10-27  tee, copy from amorks
  * \endinternal
  */
@@ -35,6 +45,37 @@ extern "C" {
  * @{
  */
 
+#ifdef AM_MEMHEAP_TLSF
+
+/**
+ * \brief TLSF λÿһ 2^AM_MEMHEAP_TLSF_SL_LOG2 
+ */
+#ifndef AM_MEMHEAP_TLSF_SL_LOG2
+#define AM_MEMHEAP_TLSF_SL_LOG2    3
+#endif
+
+/**
+ * \brief TLSF ɾȷּСΪ 2^AM_MEMHEAP_TLSF_FL_MAX ֽ
+ *
+ * ôСĿпͳһһУʱԲҡӦݶѵĴС
+ * ãֵԽÿѹռõ RAM Խࡣ
+ */
+#ifndef AM_MEMHEAP_TLSF_FL_MAX
+#define AM_MEMHEAP_TLSF_FL_MAX     16
+#endif
+
+/** \brief TLSF  */
+#define AM_MEMHEAP_TLSF_SL_COUNT   (1 << AM_MEMHEAP_TLSF_SL_LOG2)
+
+/** \brief TLSF һʼλС 2^AM_MEMHEAP_TLSF_FL_SHIFT ĿԷּ */
+#define AM_MEMHEAP_TLSF_FL_SHIFT   (AM_MEMHEAP_TLSF_SL_LOG2 + 2)
+
+/** \brief TLSF һ */
+#define AM_MEMHEAP_TLSF_FL_COUNT   (AM_MEMHEAP_TLSF_FL_MAX - \
+                                    AM_MEMHEAP_TLSF_FL_SHIFT + 1)
+
+#endif /* AM_MEMHEAP_TLSF */
+
 /**
  * \brief memory item on the memory heap
  */
@@ -48,6 +89,11 @@ typedef struct am_memheap_item
 
     struct am_memheap_item *next_free;       /**< next free memheap item   */
     struct am_memheap_item *prev_free;       /**< prev free memheap item   */
+
+#ifdef AM_MEMHEAP_TRACE
+    const char             *file;            /**< allocating source file   */
+    int                     line;            /**< allocating source line   */
+#endif
 } am_memheap_item_t;
 
 /**
@@ -66,6 +112,17 @@ typedef struct am_memheap
 
     struct am_memheap_item *free_list;          /**< free block list */
     struct am_memheap_item  free_header;        /**< free block list header */
+
+#ifdef AM_MEMHEAP_TLSF
+    uint32_t                fl_bitmap;          /**< first level bitmap */
+
+    /** \brief second level bitmaps */
+    uint32_t                sl_bitmap[AM_MEMHEAP_TLSF_FL_COUNT];
+
+    /** \brief segregated free lists */
+    struct am_memheap_item *free_lists[AM_MEMHEAP_TLSF_FL_COUNT]
+                                      [AM_MEMHEAP_TLSF_SL_COUNT];
+#endif /* AM_MEMHEAP_TLSF */
  
 } am_memheap_t;
 
@@ -128,6 +185,108 @@ void *am_memheap_realloc(struct am_memheap *heap, void *ptr, size_t newsize);
  */
 void am_memheap_free(void *ptr);
 
+/**
+ * \brief ʹ
+ */
+typedef struct am_memheap_info {
+    uint32_t    total_free;     /**< \brief пռֽ */
+    uint32_t    largest_free;   /**< \brief пֽ */
+    uint32_t    free_blocks;    /**< \brief п */
+    uint32_t    used_blocks;    /**< \brief ѷ */
+
+    /**
+     * \brief Ƭָ0 ~ 100
+     *
+     *  (1 - largest_free / total_free) * 1000 ʾпռȫ
+     * ֵԽ󣬿пռԽɢ
+     */
+    uint32_t    frag;
+} am_memheap_info_t;
+
+/**
+ * \brief ʱÿһεĻص
+ *
+ * \param[in] p_arg : û
+ * \param[in] p_mem : ׵ַ am_memheap_alloc() صĵַ
+ * \param[in] size  : ĴС
+ * \param[in] used  : AM_TRUEѷ䣻AM_FALSE
+ * \param[in] file  : ÿԴļδ AM_MEMHEAP_TRACE пʱΪ NULL
+ * \param[in] line  : ÿԴļкţδ¼ʱΪ 0
+ */
+typedef void (*am_memheap_walk_cb_t) (void       *p_arg,
+                                      void       *p_mem,
+                                      uint32_t    size,
+                                      am_bool_t   used,
+                                      const char *file,
+                                      int         line);
+
+/**
+ * \brief ַ˳еп
+ *
+ * \param[in] heap   : ָѹ
+ * \param[in] pfn_cb : ÿһεĻص
+ * \param[in] p_arg  : صû
+ *
+ * \return пĸ
+ *
+ * \note ڼ䲻ܷͷŸöѵڴ
+ */
+int am_memheap_walk (struct am_memheap    *heap,
+                     am_memheap_walk_cb_t  pfn_cb,
+                     void                 *p_arg);
+
+/**
+ * \brief ȡѵʹ
+ *
+ * \param[in]  heap   : ָѹ
+ * \param[out] p_info : ȡʹ
+ *
+ * \return 
+ */
+void am_memheap_info_get (struct am_memheap *heap, am_memheap_info_t *p_info);
+
+/**
+ * \brief ȡпĴСǰһηֽ
+ *
+ * \param[in] heap : ָѹ
+ *
+ * \return пֽ
+ */
+uint32_t am_memheap_largest_free_get (struct am_memheap *heap);
+
+/**
+ * \brief ͨ am_kprintf() ѵʹпϢ
+ *
+ * \param[in] heap : ָѹ
+ *
+ * \return 
+ */
+void am_memheap_dump (struct am_memheap *heap);
+
+#ifdef AM_MEMHEAP_TRACE
+
+/**
+ * \brief Ӷзռ䣬¼ߵļк
+ *
+ *  AM_MEMHEAP_TRACE am_memheap_alloc() Զ滻Ϊ
+ *
+ * \param[in] heap : ָѹ
+ * \param[in] size : ռĴС
+ * \param[in] file : ڵԴļ
+ * \param[in] line : ڵк
+ *
+ * \return ռ׵ַNULLʧ
+ */
+void *am_memheap_alloc_tag (struct am_memheap *heap,
+                            uint32_t           size,
+                            const char        *file,
+                            int                line);
+
+#define am_memheap_alloc(heap, size) \
+            am_memheap_alloc_tag((heap), (size), __FILE__, __LINE__)
+
+#endif /* AM_MEMHEAP_TRACE */
+
 /** @}  am_if_memheap */
 
 #ifdef __cplusplus
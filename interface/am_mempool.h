@@ -0,0 +1,199 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ڴ
+ *
+ *     ڴؽһξ̬ڴ滮ΪСͬɿ飬пԵʽӣ
+ * ͷžֻͷʱ̶Ϊ O(1)ҿ鱾ûжͷ
+ * ڴͬ am_i2c_message_tam_spi_transfer_tе
+ * ȣĶ̬䡣ͷŽڼ̵ʱڹرжϣжϺ񻷾
+ * ͬʱʹá
+ *
+ * ʹñҪͷļ:
+ * \code
+ * #include "am_mempool.h"
+ * \endcode
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_MEMPOOL_H
+#define __AM_MEMPOOL_H
+
+#include "am_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus  */
+
+/**
+ * \addtogroup am_if_mempool
+ * \copydoc am_mempool.h
+ * @{
+ */
+
+/**
+ * \brief ڴʵʹõĿС϶뵽ָС
+ *
+ * \param[in] size : С
+ */
+#define AM_MEMPOOL_BLK_SIZE(size)  \
+            AM_ROUND_UP(((size) < sizeof(void *) ? sizeof(void *) : (size)), \
+                        sizeof(void *))
+
+/**
+ * \brief ڴصĻ
+ *
+ * \param[in] buf_name : 
+ * \param[in] type     : 
+ * \param[in] nblks    : 
+ *
+ * \par 
+ * \code
+ * AM_MEMPOOL_BUF_DECL_STATIC(__g_msg_buf, am_i2c_message_t, 8);
+ *
+ * am_mempool_t        msg_pool;
+ * am_mempool_handle_t handle;
+ *
+ * handle = am_mempool_init(&msg_pool,
+ *                          __g_msg_buf,
+ *                          sizeof(__g_msg_buf),
+ *                          sizeof(am_i2c_message_t));
+ * \endcode
+ */
+#define AM_MEMPOOL_BUF_DECL_STATIC(buf_name, type, nblks)                    \
+            static void *buf_name[(AM_MEMPOOL_BLK_SIZE(sizeof(type)) *       \
+                                   (nblks)) / sizeof(void *)]
+
+/**
+ * \brief ڴؽṹ壬ӦóӦֱӲṹԱ
+ */
+typedef struct am_mempool {
+    void      *p_free;     /**< \brief п   */
+    char      *p_start;    /**< \brief ʼ   */
+    char      *p_end;      /**< \brief    */
+    size_t     blk_size;   /**< \brief С       */
+    uint32_t   nblks;      /**< \brief        */
+    uint32_t   nfree;      /**< \brief п     */
+    uint32_t   max_used;   /**< \brief ÿʷֵ */
+} am_mempool_t;
+
+/** \brief ڴؾ */
+typedef am_mempool_t *am_mempool_handle_t;
+
+/**
+ * \brief ʼڴ
+ *
+ * \param[in] p_pool   : ָڴصָ
+ * \param[in] p_buf    : ڴʹõĻ밴ָС
+ * \param[in] buf_size : Сֽ
+ * \param[in] blk_size : ÿĴС϶뵽ָС
+ *
+ * \return ڴؾ򻺳һʱΪ NULL
+ */
+am_mempool_handle_t am_mempool_init (am_mempool_t *p_pool,
+                                     void         *p_buf,
+                                     size_t        buf_size,
+                                     size_t        blk_size);
+
+/**
+ * \brief ڴзһ
+ *
+ * \param[in] handle : ڴؾ
+ *
+ * \return ׵ַNULL ڴѿ
+ *
+ * \note же
+ */
+void *am_mempool_alloc (am_mempool_handle_t handle);
+
+/**
+ * \brief һͷŻڴ
+ *
+ * \param[in] handle : ڴؾ
+ * \param[in] p_blk  :  am_mempool_alloc() Ŀ
+ *
+ * \retval  AM_OK     : ͷųɹ
+ * \retval -AM_EINVAL : 󣬻ÿ鲻ڸڴ
+ *
+ * \note же
+ */
+int am_mempool_free (am_mempool_handle_t handle, void *p_blk);
+
+/**
+ * \brief жһַǷڴ
+ *
+ * \param[in] handle : ڴؾ
+ * \param[in] p_blk  : ַ
+ *
+ * \return ڸڴط AM_TRUE򷵻 AM_FALSE
+ */
+am_static_inline
+am_bool_t am_mempool_is_owner (am_mempool_handle_t handle, const void *p_blk)
+{
+    return (am_bool_t)(((const char *)p_blk >= handle->p_start) &&
+                       ((const char *)p_blk <  handle->p_end));
+}
+
+/**
+ * \brief ȡڴؿС
+ *
+ * \param[in] handle : ڴؾ
+ *
+ * \return С
+ */
+am_static_inline
+size_t am_mempool_blk_size_get (am_mempool_handle_t handle)
+{
+    return handle->blk_size;
+}
+
+/**
+ * \brief ȡڴѷĿ
+ *
+ * \param[in] handle : ڴؾ
+ *
+ * \return ѷĿ
+ */
+am_static_inline
+uint32_t am_mempool_used_get (am_mempool_handle_t handle)
+{
+    return handle->nblks - handle->nfree;
+}
+
+/**
+ * \brief ȡڴѷʷֵˮλ
+ *
+ * \param[in] handle : ڴؾ
+ *
+ * \return ѷʷֵ
+ */
+am_static_inline
+uint32_t am_mempool_max_used_get (am_mempool_handle_t handle)
+{
+    return handle->max_used;
+}
+
+/** @}  */
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus  */
+
+#endif  /* __AM_MEMPOOL_H */
+
+/* end of file */
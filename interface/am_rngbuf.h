@@ -15,6 +15,10 @@
  * 
  * \internal
  * \par Modification history
+ * - 1.04 26-10-18  lgg, record ring buffer indices have a single writer each
+ * - 1.03 26-10-18  lgg, add record-oriented ring buffer
+ * - 1.02 26-10-18  lgg, add zero-copy reserve/commit and peek/release
+ * - 1.01 26-10-18  lgg, add lock-free SPSC ring buffer
  * - 1.00 15-12-09  tee, add implementation from AWorks
  * \endinternal
  */
@@ -155,7 +159,353 @@ size_t am_rngbuf_freebytes (am_rngbuf_t rb);
 size_t am_rngbuf_nbytes (am_rngbuf_t rb);
 
 /**
- * @} 
+ * \brief ԤλеĿпռ䣨㿽д룩
+ *
+ * ȡֱдĿпռ䣬ߣDMAֱд뷵صĿռ
+ * ٵ am_rngbuf_write_commit() ύʵдֽпռڻ
+ * ĩβƣʱΪΣһδӵǰдλÿʼڶδӻʼʼ
+ *
+ * \param[in]  rb       : ҪĻλ
+ * \param[out] pp_span1 : ȡһпռʼַ
+ * \param[out] pp_span2 : ȡڶΣƣпռʼַҪʱΪNULL
+ * \param[out] p_len2   : ȡڶοпռĴСҪʱΪNULL
+ *
+ * \return һпռĴСΪ0ʾ
+ *
+ * \note Ԥύ֮䲻д
+ */
+size_t am_rngbuf_write_reserve (am_rngbuf_t   rb,
+                                char        **pp_span1,
+                                char        **pp_span2,
+                                size_t       *p_len2);
+
+/**
+ * \brief ύͨ am_rngbuf_write_reserve() д
+ *
+ * \param[in] rb     : ҪĻλ
+ * \param[in] nbytes : ʵдֽܳԤοռС֮
+ *
+ * \return 
+ */
+void am_rngbuf_write_commit (am_rngbuf_t rb, size_t nbytes);
+
+/**
+ * \brief 鿴λеݣ㿽ȡ
+ *
+ * ȡֱӷʵݣߣDMA֡͵شٵ
+ * am_rngbuf_read_release() ͷʵʴֽݿڻĩβƣ
+ * ʱΪΣһδӵǰλÿʼڶδӻʼʼ
+ *
+ * \param[in]  rb       : ҪĻλ
+ * \param[out] pp_span1 : ȡһݵʼַ
+ * \param[out] pp_span2 : ȡڶΣƣݵʼַҪʱΪNULL
+ * \param[out] p_len2   : ȡڶݵֽҪʱΪNULL
+ *
+ * \return һݵֽΪ0ʾΪ
+ *
+ * \note 鿴ͷ֮䲻
+ */
+size_t am_rngbuf_read_peek (am_rngbuf_t   rb,
+                            char        **pp_span1,
+                            char        **pp_span2,
+                            size_t       *p_len2);
+
+/**
+ * \brief ͷͨ am_rngbuf_read_peek() ϵ
+ *
+ * \param[in] rb     : ҪĻλ
+ * \param[in] nbytes : ͷŵֽܳ鿴ݴС֮
+ *
+ * \return 
+ */
+void am_rngbuf_read_release (am_rngbuf_t rb, size_t nbytes);
+
+/******************************************************************************/
+
+/**
+ * \brief /ߣSPSCλṹ
+ *
+ * һߣжϷһߣѭ֮䴫ݣ
+ * ˫رжϡСΪ 2 ݣдʱ
+ * ͨȡʵλãռʹá
+ *
+ * \note ҪֱӲṹĳԱ
+ */
+struct am_rngbuf_spsc {
+    volatile uint32_t  in;    /**< \brief д޸ģ */
+    volatile uint32_t  out;   /**< \brief ޸ģ */
+    uint32_t           mask;  /**< \brief 룬С - 1 */
+    char              *buf;   /**< \brief  */
+};
+
+/** \brief SPSC λ */
+typedef struct am_rngbuf_spsc *am_rngbuf_spsc_t;
+
+/**
+ * \brief ʼ SPSC λ
+ *
+ * \param[in] p_rb    : Ҫʼ SPSC λ
+ * \param[in] p_buf   : λʹõĻռ
+ * \param[in] size    : СΪ 2 ݣȫռ
+ *
+ * \retval  AM_OK     : ʼ
+ * \retval -AM_EINVAL : ʼʧܣЧ
+ */
+int am_rngbuf_spsc_init (struct am_rngbuf_spsc *p_rb, char *p_buf, size_t size);
+
+/**
+ * \brief һֽڵ SPSC λߵã
+ *
+ * \param[in] rb   : ҪĻλ
+ * \param[in] data : Ҫŵֽ
+ *
+ * \retval 0 : ݴʧܣ
+ * \retval 1 : ݳɹ
+ */
+int am_rngbuf_spsc_putchar (am_rngbuf_spsc_t rb, const char data);
+
+/**
+ * \brief  SPSC λȡһֽݣߵã
+ *
+ * \param[in] rb     : ҪĻλ
+ * \param[in] p_data : ֽڵָ
+ *
+ * \retval 0 : ȡʧܣ
+ * \retval 1 : ݳɹȡ
+ */
+int am_rngbuf_spsc_getchar (am_rngbuf_spsc_t rb, char *p_data);
+
+/**
+ * \brief ֽڵ SPSC λߵã
+ *
+ * \param[in] rb     : ҪĻλ
+ * \param[in] p_buf  : Ҫŵλݻ
+ * \param[in] nbytes : Ҫŵλݸ
+ *
+ * \return ɹŵݸ
+ */
+size_t am_rngbuf_spsc_put (am_rngbuf_spsc_t rb, const char *p_buf, size_t nbytes);
+
+/**
+ * \brief  SPSC λȡݣߵã
+ *
+ * \param[in] rb     : ҪĻλ
+ * \param[in] p_buf  : ŻȡݵĻ
+ * \param[in] nbytes : Ҫȡݸ
+ *
+ * \return ɹȡݸ
+ */
+size_t am_rngbuf_spsc_get (am_rngbuf_spsc_t rb, char *p_buf, size_t nbytes);
+
+/**
+ * \brief  SPSC λߵã
+ *
+ * ǰеȫݣ߿ɼд
+ *
+ * \param[in] rb : ҪĻλ
+ *
+ * \return 
+ */
+void am_rngbuf_spsc_flush (am_rngbuf_spsc_t rb);
+
+/**
+ * \brief ȡ SPSC λֽڸ
+ *
+ * \param[in] rb : ҪжϵĻλ
+ *
+ * \return λֽڸ
+ */
+am_static_inline
+size_t am_rngbuf_spsc_nbytes (am_rngbuf_spsc_t rb)
+{
+    return (size_t)(rb->in - rb->out);
+}
+
+/**
+ * \brief ȡ SPSC λпռС
+ *
+ * \param[in] rb : ҪжϵĻλ
+ *
+ * \return λпռС
+ */
+am_static_inline
+size_t am_rngbuf_spsc_freebytes (am_rngbuf_spsc_t rb)
+{
+    return (size_t)(rb->mask + 1 - (rb->in - rb->out));
+}
+
+/**
+ * \brief  SPSC λǷΪ
+ *
+ * \param[in] rb : ҪԵĻλ
+ *
+ * \return λշAM_TRUE, 򷵻AM_FALSE
+ */
+am_static_inline
+am_bool_t am_rngbuf_spsc_isempty (am_rngbuf_spsc_t rb)
+{
+    return (am_bool_t)(rb->in == rb->out);
+}
+
+/**
+ * \brief  SPSC λǷ
+ *
+ * \param[in] rb : ҪԵĻλ
+ *
+ * \return λAM_TRUE, 򷵻AM_FALSE
+ */
+am_static_inline
+am_bool_t am_rngbuf_spsc_isfull (am_rngbuf_spsc_t rb)
+{
+    return (am_bool_t)((rb->in - rb->out) > rb->mask);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief ¼λṹ
+ *
+ * Լ¼ am_can_message_tADC ֵ¼Ϊλȡݣÿ¼
+ * ĴСڳʼʱָ֧һδȡ¼ѡ񻺳ʱɵļ¼
+ * ֻݵңⳡϡ
+ *
+ *  SPSC λͬдֱֻߺ޸ģǸģʽ£
+ * һߣжϷһߣ֮رжϡ
+ *
+ * \note ҪֱӲṹĳԱģʽ趪ɵļ¼Ҳ޸
+ *       ߴڲͬģɵ֤߱
+ */
+struct am_rngbuf_rec {
+    volatile size_t  in;         /**< \brief д޸ģ */
+    volatile size_t  out;        /**< \brief Ǹģʽ½޸ģ */
+    size_t           nrecs;      /**< \brief ɵļ¼ */
+    size_t           rec_size;   /**< \brief ÿ¼ֽ */
+    am_bool_t        overwrite;  /**< \brief ʱǷ񸲸ɵļ¼ */
+    char            *buf;        /**< \brief  */
+};
+
+/** \brief ¼λ */
+typedef struct am_rngbuf_rec *am_rngbuf_rec_t;
+
+/**
+ * \brief ʼ¼λ
+ *
+ * \param[in] p_rb      : Ҫʼļ¼λ
+ * \param[in] p_buf     : ռ䣬СΪ rec_size * nrecs ֽ
+ * \param[in] rec_size  : ÿ¼ֽ
+ * \param[in] nrecs     : ɵļ¼ȫ
+ * \param[in] overwrite : AM_TRUEʱɵļ¼
+ *                        AM_FALSEʱ¼¼
+ *
+ * \retval  AM_OK     : ʼ
+ * \retval -AM_EINVAL : ʼʧܣЧ
+ *
+ * \par ʾ
+ * \code
+ * static am_can_message_t     __g_can_msgs[16];
+ * static struct am_rngbuf_rec __g_can_rb;
+ *
+ * am_rngbuf_rec_init(&__g_can_rb,
+ *                    __g_can_msgs,
+ *                    sizeof(am_can_message_t),
+ *                    AM_NELEMENTS(__g_can_msgs),
+ *                    AM_FALSE);
+ * \endcode
+ */
+int am_rngbuf_rec_init (struct am_rngbuf_rec *p_rb,
+                        void                 *p_buf,
+                        size_t                rec_size,
+                        size_t                nrecs,
+                        am_bool_t             overwrite);
+
+/**
+ * \brief ¼¼λ
+ *
+ * \param[in] rb     : Ҫļ¼λ
+ * \param[in] p_recs : Ҫŵļ¼ţ
+ * \param[in] nrecs  : Ҫŵļ¼
+ *
+ * \return ɹŵļ¼ģʽǵ nrecs
+ */
+size_t am_rngbuf_rec_put (am_rngbuf_rec_t rb, const void *p_recs, size_t nrecs);
+
+/**
+ * \brief Ӽ¼λȡ¼
+ *
+ * \param[in] rb     : Ҫļ¼λ
+ * \param[in] p_recs : ȡ¼Ļ
+ * \param[in] nrecs  : Ҫȡļ¼
+ *
+ * \return ɹȡļ¼
+ */
+size_t am_rngbuf_rec_get (am_rngbuf_rec_t rb, void *p_recs, size_t nrecs);
+
+/**
+ * \brief ռ¼λߵã
+ *
+ * \param[in] rb : Ҫļ¼λ
+ *
+ * \return 
+ */
+void am_rngbuf_rec_flush (am_rngbuf_rec_t rb);
+
+/**
+ * \brief ȡ¼λеļ¼
+ *
+ * \param[in] rb : Ҫжϵļ¼λ
+ *
+ * \return ¼
+ */
+am_static_inline
+size_t am_rngbuf_rec_nrecs (am_rngbuf_rec_t rb)
+{
+    size_t in  = rb->in;
+    size_t out = rb->out;
+
+    return (in >= out) ? (in - out) : (in + 2 * rb->nrecs - out);
+}
+
+/**
+ * \brief ȡ¼λɴŵļ¼
+ *
+ * \param[in] rb : Ҫжϵļ¼λ
+ *
+ * \return м¼
+ */
+am_static_inline
+size_t am_rngbuf_rec_freerecs (am_rngbuf_rec_t rb)
+{
+    return rb->nrecs - am_rngbuf_rec_nrecs(rb);
+}
+
+/**
+ * \brief Լ¼λǷΪ
+ *
+ * \param[in] rb : ҪԵļ¼λ
+ *
+ * \return շAM_TRUE, 򷵻AM_FALSE
+ */
+am_static_inline
+am_bool_t am_rngbuf_rec_isempty (am_rngbuf_rec_t rb)
+{
+    return (am_bool_t)(rb->in == rb->out);
+}
+
+/**
+ * \brief Լ¼λǷ
+ *
+ * \param[in] rb : ҪԵļ¼λ
+ *
+ * \return AM_TRUE, 򷵻AM_FALSE
+ */
+am_static_inline
+am_bool_t am_rngbuf_rec_isfull (am_rngbuf_rec_t rb)
+{
+    return (am_bool_t)(am_rngbuf_rec_nrecs(rb) == rb->nrecs);
+}
+
+/**
+ * @}
  */
 
 #ifdef __cplusplus
@@ -15,9 +15,25 @@
  * \brief  ʱ׼ӿ
  *
  * ʱʹһӲʱԴṩʱ
+ *
+ * ʱʹ÷ֲʱֹ AM_SOFTIMER_WHEEL_LEVELS ÿ
+ * 2^AM_SOFTIMER_WHEEL_BITS ֹۣͣʱʱΪ O(1)붨ʱ
+ * ޹ءʱַΧĶʱһУǰᱻ·䡣
+ *
+ * ʹ am_softimer_module_init_tickless() ʼʱռһӲʱ
+ * ֻͨһʱڣӲʱﵽʱֵʱжϣѺһ
+ * ƽ tickûжʱʱ CPU Ƶѡ
+ *
+ * ʱصĬӲʱжеá AM_SOFTIMER_DEFER 󣬿ʹ
+ * am_softimer_defer_set() ĳʱĻصӳٵ (am_jobq.h) ִУ
+ * ʱֻУӦڷжϻµ am_jobq_process() 
+ *  AM_SOFTIMER_STAT ÿʱͳƻصִдִʱ估
  * 
  * \internal
  * \par Modification history
+ * - 1.03 26-10-18  lgg,  add deferred callbacks and statistics
+ * - 1.02 26-10-18  lgg,  add tickless mode
+ * - 1.01 26-10-18  lgg,  use hierarchical timing wheel instead of delta list
  * - 1.00 15-07-31  tee,  first implementation.
  * \endinternal
  */
@@ -33,6 +49,10 @@ extern "C" {
 #include "am_list.h"
 #include "am_timer.h"
 
+#ifdef AM_SOFTIMER_DEFER
+#include "am_jobq.h"
+#endif
+
 
 /**
  * \addtogroup am_if_softimer
@@ -40,15 +60,56 @@ extern "C" {
  * @{
  */
 
+/**
+ * \brief ʱÿһĲΪ 2^AM_SOFTIMER_WHEEL_BITS
+ */
+#ifndef AM_SOFTIMER_WHEEL_BITS
+#define AM_SOFTIMER_WHEEL_BITS      3
+#endif
+
+/**
+ * \brief ʱֵļ
+ *
+ * ʱֹռ AM_SOFTIMER_WHEEL_LEVELS * 2^AM_SOFTIMER_WHEEL_BITS ͷ
+ * ֱӶλʱ tick Ϊ 2^(AM_SOFTIMER_WHEEL_BITS *
+ * AM_SOFTIMER_WHEEL_LEVELS)֮С 32
+ */
+#ifndef AM_SOFTIMER_WHEEL_LEVELS
+#define AM_SOFTIMER_WHEEL_LEVELS    4
+#endif
+
+/**
+ * \brief ʱͳϢ AM_SOFTIMER_STAT ʱЧ
+ *
+ * ִʱĵλ am_softimer_stat_clk_set() õʱԴδʱԴʱ
+ * ִʱʼΪ 0
+ */
+typedef struct am_softimer_stat {
+    uint32_t run_count;    /**< \brief صִд                     */
+    uint32_t missed;       /**< \brief ϴӳִеĻصδִУ */
+    uint32_t exec_last;    /**< \brief һλصִʱ             */
+    uint32_t exec_max;     /**< \brief صִʱ                 */
+    uint32_t exec_total;   /**< \brief صۼִʱ                 */
+} am_softimer_stat_t;
+
 /**
  * \brief ʱṹ壬˱ҪϢ
  */
 struct am_softimer {
     struct am_list_head node;          /**< \brief γṹ           */
-    unsigned int        ticks;         /**< \brief ʣʱtickֵ             */
+    unsigned int        ticks;         /**< \brief ʱ̵tickֵ           */
     unsigned int        repeat_ticks;  /**< \brief ظʱtick     */
     void (*timeout_callback)( void *); /**< \brief ʱʱ䵽ص         */
     void               *p_arg;         /**< \brief صĲ             */
+
+#ifdef AM_SOFTIMER_DEFER
+    am_jobq_handle_t    jobq;          /**< \brief ӳִе         */
+    am_jobq_job_t       job;           /**< \brief ӳִлص     */
+#endif
+
+#ifdef AM_SOFTIMER_STAT
+    am_softimer_stat_t  stat;          /**< \brief ͳϢ                   */
+#endif
 };
 
 typedef struct am_softimer am_softimer_t;
@@ -63,8 +124,32 @@ typedef struct am_softimer am_softimer_t;
  */
 int am_softimer_module_init (unsigned int clkrate);
 
+/**
+ * \brief ʱģʼTickless ģʽ
+ *
+ * ʱռӲʱһͨصӲʱֻһ
+ * ʱʱﵽӲʱʱֵʱжϣԵ
+ * am_softimer_module_tick()
+ *
+ * \param[in] handle  : Ӳʱ׼֧жϼȡǰֵ
+ * \param[in] chan    : Ӳʱͨ
+ * \param[in] clkrate : tick ƵʣʱĶʱ
+ *
+ * \retval  AM_OK      : ģʼɹʹ
+ * \retval -AM_EINVAL  : ЧӲʱƵʵ clkrate
+ *                       λԶʱһ tick
+ * \retval -AM_ENOTSUP : Ӳʱ֧жϻܶȡǰֵ
+ *
+ * \note صӲʱжеãʱʱܻӲʱ
+ */
+int am_softimer_module_init_tickless (am_timer_handle_t handle,
+                                      uint8_t           chan,
+                                      unsigned int      clkrate);
+
 /**
  * \brief ʱ밴ճʼʱģʱָƵʵøú
+ *
+ * \note Tickless ģʽ²ܵøú
  */
 void am_softimer_module_tick (void);
     
@@ -97,6 +182,59 @@ void am_softimer_start(am_softimer_t *p_timer, unsigned int ms);
  */
 void am_softimer_stop(am_softimer_t *p_timer);
 
+#ifdef AM_SOFTIMER_DEFER
+
+/**
+ * \brief ʱĻصӳٵִ
+ *
+ * ʱʱصΪһУصӦõ
+ * am_jobq_process() ʱִСʱϴεδִУ򱾴
+ * ڱϲͳΪڣʱֹͣ󣬶δִеĻصִС
+ *
+ * \param[in] p_timer : ָһʱָ루ѳʼ
+ * \param[in] jobq    : оΪ NULL ʱָΪжֱִлص
+ * \param[in] pri     : ȼ
+ *
+ * \retval  AM_OK     : óɹ
+ * \retval -AM_EINVAL : Ч
+ */
+int am_softimer_defer_set (am_softimer_t    *p_timer,
+                           am_jobq_handle_t  jobq,
+                           uint16_t          pri);
+
+#endif /* AM_SOFTIMER_DEFER */
+
+#ifdef AM_SOFTIMER_STAT
+
+/**
+ * \brief ͳƻصִʱʹõʱԴ
+ *
+ * \param[in] pfn_clk_get : ȡǰʱӼֵĺ CPU ڼ
+ *                          Ϊ NULL ʱͳִʱ
+ * \return 
+ */
+void am_softimer_stat_clk_set (uint32_t (*pfn_clk_get) (void));
+
+/**
+ * \brief ȡʱͳϢ
+ *
+ * \param[in]  p_timer : ָһʱָ
+ * \param[out] p_stat  : ڻȡͳϢ
+ *
+ * \retval  AM_OK     : ȡɹ
+ * \retval -AM_EINVAL : Ч
+ */
+int am_softimer_stat_get (am_softimer_t *p_timer, am_softimer_stat_t *p_stat);
+
+/**
+ * \brief ʱͳϢ
+ * \param[in] p_timer : ָһʱָ
+ * \return 
+ */
+void am_softimer_stat_clr (am_softimer_t *p_timer);
+
+#endif /* AM_SOFTIMER_STAT */
+
 /** 
  * @}
  */
@@ -15,6 +15,7 @@
  *
  * \internal
  * \par Modification history
+ * - 1.02 26-10-18  lgg, add asynchronous write/read.
  * - 1.01 15-08-17  tee, modified some interface. 
  * - 1.00 14-11-01  jon, first implementation.
  * \endinternal
@@ -491,6 +492,73 @@ int am_spi_write_then_write (am_spi_device_t *p_dev,
                              const uint8_t   *p_txbuf1,
                              size_t           n_tx1);
 
+/**
+ * \brief SPI첽дʹõģǰһֱЧ
+ */
+typedef struct am_spi_async {
+    am_spi_transfer_t trans[2];   /**< \brief δ                 */
+    am_spi_message_t  msg;        /**< \brief ϢstatusΪ   */
+} am_spi_async_t;
+
+/**
+ * \brief ȡSPI첽дĽɻصúЧ
+ */
+#define am_spi_async_status_get(p_async)    ((p_async)->msg.status)
+
+/**
+ * \brief 첽д
+ *
+ *  am_spi_write_then_read() ͬأʱ
+ * pfn_completeͨжϻУʹ am_spi_async_status_get() ȡ
+ *
+ * \param[in]  p_dev        : SPIӻ豸
+ * \param[in]  p_txbuf      : ݷͻ
+ * \param[in]  n_tx         : Ҫ͵ֽڸ
+ * \param[out] p_rxbuf      : ݽջ
+ * \param[in]  n_rx         : Ҫյֽڸ
+ * \param[in]  p_async      : 첽д
+ * \param[in]  pfn_complete : ɻص
+ * \param[in]  p_arg        : ص
+ *
+ * \retval AM_OK      : 
+ * \retval -AM_EINVAL : 
+ */
+int am_spi_write_then_read_async (am_spi_device_t *p_dev,
+                                  const uint8_t   *p_txbuf,
+                                  size_t           n_tx,
+                                  uint8_t         *p_rxbuf,
+                                  size_t           n_rx,
+                                  am_spi_async_t  *p_async,
+                                  am_pfnvoid_t     pfn_complete,
+                                  void            *p_arg);
+
+/**
+ * \brief 첽ִд
+ *
+ *  am_spi_write_then_write() ͬأʱ
+ * pfn_completeͨжϻУʹ am_spi_async_status_get() ȡ
+ *
+ * \param[in] p_dev        : SPIӻ豸
+ * \param[in] p_txbuf0     : ݷͻ0
+ * \param[in] n_tx0        : 0ݸ
+ * \param[in] p_txbuf1     : ݷͻ1
+ * \param[in] n_tx1        : 1ݸ
+ * \param[in] p_async      : 첽д
+ * \param[in] pfn_complete : ɻص
+ * \param[in] p_arg        : ص
+ *
+ * \retval AM_OK      : 
+ * \retval -AM_EINVAL : 
+ */
+int am_spi_write_then_write_async (am_spi_device_t *p_dev,
+                                   const uint8_t   *p_txbuf0,
+                                   size_t           n_tx0,
+                                   const uint8_t   *p_txbuf1,
+                                   size_t           n_tx1,
+                                   am_spi_async_t  *p_async,
+                                   am_pfnvoid_t     pfn_complete,
+                                   void            *p_arg);
+
 /** 
  * @} 
  */
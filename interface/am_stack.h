@@ -0,0 +1,177 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ջʹͳƼ
+ *
+ *     עջʱջδʹõĲΪ AM_STACK_PAINT_VALUE֮ջ
+ * ҵһд֣ɵõջʹˮλͬʱջ׷
+ * AM_STACK_CANARY_WORDS ֣ am_stack_check()
+ * am_stack_guard_start() ʱԵã鱣Ƿ񱻸д
+ * ջ
+ *
+ *     Cortex-M  AMetal 򡢸жϼ PendSV ջMSP弶ʼ
+ * ʱ am_bsp_stack_init() עջӦóҲעԼʹõ
+ * ջһʱ am_stack_report() ջʹݴ˵
+ * ջĴСʡ RAM
+ *
+ * ʹñҪͷļ:
+ * \code
+ * #include "am_stack.h"
+ * \endcode
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_STACK_H
+#define __AM_STACK_H
+
+#include "am_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus  */
+
+/**
+ * \addtogroup am_if_stack
+ * \copydoc am_stack.h
+ * @{
+ */
+
+/** \brief δʹõջռֵ */
+#ifndef AM_STACK_PAINT_VALUE
+#define AM_STACK_PAINT_VALUE      0xCCCCCCCCu
+#endif
+
+/** \brief ջױֵĸΪ 0 ʱ */
+#ifndef AM_STACK_CANARY_WORDS
+#define AM_STACK_CANARY_WORDS     2
+#endif
+
+/**
+ * \brief ʹõջʱڵǰջָ±ֽ
+ */
+#ifndef AM_STACK_PAINT_MARGIN
+#define AM_STACK_PAINT_MARGIN     64
+#endif
+
+/**
+ * \brief ջϢӦóӦֱӲṹԱ
+ */
+typedef struct am_stack {
+    const char      *p_name;    /**< \brief  */
+    uint32_t        *p_bottom;  /**< \brief ջף͵ַ*/
+    uint32_t        *p_top;     /**< \brief ջߵַ + 1*/
+    am_bool_t        overflow;  /**< \brief Ѽ⵽ */
+    struct am_stack *p_next;    /**< \brief һջ */
+} am_stack_t;
+
+/**
+ * \brief ջص
+ *
+ * \param[in] p_arg   : û
+ * \param[in] p_stack : ջ
+ *
+ * \return 
+ */
+typedef void (*am_stack_overflow_cb_t) (void *p_arg, am_stack_t *p_stack);
+
+/**
+ * \brief עһջδʹõĲ
+ *
+ * ǰջָλڸջУעʹõջֻ䵱ǰջָ
+ * AM_STACK_PAINT_MARGIN ֽµĲ֡Ӧϵͳá
+ *
+ * \param[in] p_stack  : ջϢ
+ * \param[in] p_name   : 
+ * \param[in] p_bottom : ջף͵ַ
+ * \param[in] p_top    : ջߵַ + 1
+ *
+ * \retval  AM_OK     : עɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_stack_register (am_stack_t *p_stack,
+                       const char *p_name,
+                       void       *p_bottom,
+                       void       *p_top);
+
+/**
+ * \brief ȡջĴС
+ * \param[in] p_stack : ջϢ
+ * \return ջĴСֽڣ
+ */
+size_t am_stack_size_get (const am_stack_t *p_stack);
+
+/**
+ * \brief ȡջʹ
+ *
+ * \param[in] p_stack : ջϢ
+ *
+ * \return עջʹֽڣֱдʱΪջĴС
+ */
+size_t am_stack_used_get (const am_stack_t *p_stack);
+
+/**
+ * \brief ջʱĻص
+ *
+ * δʱ⵽ͨ am_kprintf() ʾ
+ *
+ * \param[in] pfn_cb : ص
+ * \param[in] p_arg  : صû
+ *
+ * \return 
+ */
+void am_stack_overflow_cb_set (am_stack_overflow_cb_t pfn_cb, void *p_arg);
+
+/**
+ * \brief ջı֣ÿջʱֻ֪ͨһ
+ *
+ * \retval  AM_OK     : ûջ
+ * \retval -AM_EFAULT : ջ
+ */
+int am_stack_check (void);
+
+/**
+ * \brief ʱԵؼջı
+ *
+ * \param[in] period_ms : ڣms
+ *
+ * \retval  AM_OK     : ɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_stack_guard_start (unsigned int period_ms);
+
+/**
+ * \brief ֹͣԵļ
+ * \return 
+ */
+void am_stack_guard_stop (void);
+
+/**
+ * \brief ͨ am_kprintf() ջĴСʹ
+ * \return 
+ */
+void am_stack_report (void);
+
+/** @}  */
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus  */
+
+#endif  /* __AM_STACK_H */
+
+/* end of file */
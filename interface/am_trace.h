@@ -0,0 +1,201 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief ϵͳи
+ *
+ *     ڹж AM_TRACE ϵͳλü¼롢˳¼ʱ
+ * - ͨ am_int_connect() ӵжϷʶΪжϺţ
+ * - am_jobq_process() ִе񣨱ʶΪַ
+ * - ʱĻصʶΪصַ
+ * - am_wait_on()am_wait_on_timeout() ĵȴ̣ʶΪȴṹַ
+ *
+ *     ¼ RAM еĻλУ am_trace_dump() ͨ am_kprintf()
+ * ӵԴPC ˵ tools/am_trace/am_trace2json.py תΪ Chrome
+ * trace-event ʽ JSON ļ chrome://tracing  Perfetto в鿴
+ *
+ *     ÿ¼ļ¼ʱ̶жϡȡһʱд 3 ֣뻺
+ * С¼޹ءam_trace_init() һμ¼ʵʺķѵʱ䣬
+ * һת߿ɾݴ˿۳ٱƫδ AM_TRACE ʱиٵ
+ * Ϊ䣬ģ鲻κδ롣
+ *
+ * ʹñҪͷļ:
+ * \code
+ * #include "am_trace.h"
+ * \endcode
+ *
+ * 
+ * \code
+ * static am_trace_rec_t __g_trace_buf[512];
+ *
+ * am_trace_init(__g_trace_buf,
+ *               AM_NELEMENTS(__g_trace_buf),
+ *               AM_TRACE_MODE_WRAP,
+ *               __timer_count_get,               // еļ
+ *               1000000);                        // Ƶ
+ * am_trace_start();
+ * ...
+ * am_trace_dump();
+ * \endcode
+ *
+ * תpython3 am_trace2json.py log.txt -e app.elf -o trace.json
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_TRACE_H
+#define __AM_TRACE_H
+
+#include "am_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus  */
+
+/**
+ * \addtogroup am_if_trace
+ * \copydoc am_trace.h
+ * @{
+ */
+
+/**
+ * \name ¼
+ * @{
+ */
+
+#define AM_TRACE_ISR          0    /**< \brief жϷʶΪжϺ */
+#define AM_TRACE_JOB          1    /**< \brief е */
+#define AM_TRACE_TIMER        2    /**< \brief ʱص */
+#define AM_TRACE_WAIT         3    /**< \brief am_wait ȴ */
+#define AM_TRACE_USER         4    /**< \brief ûԶ */
+
+/** @} */
+
+/**
+ * \name ʱĴʽ
+ * @{
+ */
+
+/** \brief ¼¼ */
+#define AM_TRACE_MODE_WRAP    0
+
+/** \brief ֹͣ¼¼ */
+#define AM_TRACE_MODE_STOP    1
+
+/** @} */
+
+/** \brief һ¼ */
+typedef struct am_trace_rec {
+    uint32_t ts;        /**< \brief ʱ */
+    uint32_t id;        /**< \brief ʶжϺšַȣ*/
+    uint32_t info;      /**< \brief ͣbit1 ~ 7˳־bit0*/
+} am_trace_rec_t;
+
+/** \brief ȡʱĺ */
+typedef uint32_t (*am_trace_clk_get_t) (void);
+
+#ifdef AM_TRACE
+
+/**
+ * \brief ¼¼
+ * \param[in] type : ¼ͣAM_TRACE_*
+ * \param[in] id   : ʶָ
+ */
+#define AM_TRACE_ENTER(type, id) \
+    am_trace_record((uint32_t)(type) << 1, (uint32_t)(uintptr_t)(id))
+
+/**
+ * \brief ¼˳¼
+ * \param[in] type : ¼ͣAM_TRACE_*
+ * \param[in] id   : ʶָ
+ */
+#define AM_TRACE_EXIT(type, id) \
+    am_trace_record(((uint32_t)(type) << 1) | 1, (uint32_t)(uintptr_t)(id))
+
+#else
+
+#define AM_TRACE_ENTER(type, id)    ((void)0)
+#define AM_TRACE_EXIT(type, id)     ((void)0)
+
+#endif /* AM_TRACE */
+
+/**
+ * \brief ʼٻʼֹͣ״̬
+ *
+ * \param[in] p_buf       : 
+ * \param[in] nrecs       : ܱ¼Ϊ 2 
+ * \param[in] mode        : ʱĴʽAM_TRACE_MODE_*
+ * \param[in] pfn_clk_get : ȡʱĺͨΪеĶʱֵ
+ * \param[in] clk_freq    : ʱļƵʣHz
+ *
+ * \retval  AM_OK     : ʼɹ
+ * \retval -AM_EINVAL : 
+ */
+int am_trace_init (am_trace_rec_t     *p_buf,
+                   size_t              nrecs,
+                   int                 mode,
+                   am_trace_clk_get_t  pfn_clk_get,
+                   uint32_t            clk_freq);
+
+/**
+ * \brief ջʼ¼
+ * \return 
+ */
+void am_trace_start (void);
+
+/**
+ * \brief ֹͣ¼
+ * \return 
+ */
+void am_trace_stop (void);
+
+/**
+ * \brief ֹͣ¼ͨ am_kprintf() ʱ˳еȫ¼
+ *
+ * ʽÿһ
+ * - "#TB:Ƶ,μ¼ʱ,¼,ʧ¼"
+ * - "#T:ʱ ʶ "Ϊʮƣ
+ * - "#TE"
+ *
+ * \return ¼
+ */
+int am_trace_dump (void);
+
+/**
+ * \brief ȡһμ¼ķѵʱ
+ * \return ʱֵ
+ */
+uint32_t am_trace_overhead_get (void);
+
+/**
+ * \brief ¼һ¼ AM_TRACE_ENTER()AM_TRACE_EXIT() 
+ *
+ * \param[in] info : ͣbit1 ~ 7˳־bit0
+ * \param[in] id   : ʶ
+ *
+ * \return 
+ */
+void am_trace_record (uint32_t info, uint32_t id);
+
+/** @}  */
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus  */
+
+#endif  /* __AM_TRACE_H */
+
+/* end of file */
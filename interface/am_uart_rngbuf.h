@@ -19,6 +19,7 @@
  *
  * \internal
  * \par Modification History
+ * - 1.01 26-10-18  lgg, add am_uart_rngbuf_receive_async().
  * - 1.00 14-11-01  tee, first implementation.
  * \endinternal
  */
@@ -218,6 +219,28 @@ int am_uart_rngbuf_receive(am_uart_rngbuf_handle_t  handle,
                            uint8_t                 *p_rxbuf,
                            uint32_t                 nbytes);
 
+/**
+ * \brief UARTݽգring bufferжģʽ
+ *
+ * ȡջеݣ nbytes ءûжݣ
+ * յʱ pfn_notifyжϻУܵöΣֱٴεñ
+ * Ϊֹ
+ *
+ * \param[in] handle     : UARTring bufferжģʽ׼
+ * \param[in] p_rxbuf    : ݻ
+ * \param[in] nbytes     : ݵĸ
+ * \param[in] pfn_notify : յʱ֪ͨΪ NULL
+ * \param[in] p_arg      : ֪ͨĲ
+ *
+ * \retval   >=0      ɹݵĸ
+ * \retval -AM_EINVAL : 
+ */
+int am_uart_rngbuf_receive_async(am_uart_rngbuf_handle_t  handle,
+                                 uint8_t                 *p_rxbuf,
+                                 uint32_t                 nbytes,
+                                 am_pfnvoid_t             pfn_notify,
+                                 void                    *p_arg);
+
 /**
  * \brief UARTմ
  *
@@ -27,6 +27,11 @@
  *
  * \internal
  * \par modification history:
+ * - 1.04 26-10-18  lgg, floating point conversions are exact up to 18 digits.
+ * - 1.03 26-10-18  lgg, add buffered debug output am_debug_init_buffered().
+ * - 1.02 26-10-18  lgg, add optional floating point conversions (AM_VFPRINTF_FLOAT).
+ * - 1.01 26-10-18  lgg, am_vfprintf_do() supports 64-bit values, %p, precision
+ *                  and flags, output is passed to f_puts() in runs.
  * - 1.00 15-01-16  tee, first implementation
  * \endinternal
  */
@@ -102,11 +107,74 @@ extern "C" {
  */
 void am_debug_init (am_uart_handle_t handle, uint32_t baudrate);
 
+/**
+ * \name ʱĴ
+ * @{
+ */
+
+/** \brief Ųµݣ붪ֽ */
+#define AM_DEBUG_BUF_POLICY_DROP     0
+
+/**
+ * \brief ȴжڳռ
+ * \note ò²жϷлжʱϢ
+ */
+#define AM_DEBUG_BUF_POLICY_BLOCK    1
+
+/** @} */
+
+/**
+ * \brief Գʼ
+ *
+ *  am_debug_init() ͬϢ '\\n' ǰ '\\r'ȸƵ
+ * أɴڷжں̨am_kprintf() ٵȴڷɡڱ
+ * Ϊжģʽ
+ *
+ * \param[in] handle   : ׼ĴڷHandle, Ϣô
+ * \param[in] baudrate : ʹõĲ
+ * \param[in] p_buf    : 
+ * \param[in] size     : СΪ 2 
+ * \param[in] policy   : ʱĴԣAM_DEBUG_BUF_POLICY_*
+ *
+ * \retval  AM_OK     : ʼɹ
+ * \retval -AM_EINVAL : 
+ * \retval -AM_ENOTSUP: ڲ֧жģʽ
+ */
+int am_debug_init_buffered (am_uart_handle_t  handle,
+                            uint32_t          baudrate,
+                            char             *p_buf,
+                            size_t            size,
+                            int               policy);
+
+/**
+ * \brief ȡ򻺳ֽ
+ * \return ֽ
+ */
+uint32_t am_debug_dropped_get (void);
+
+/**
+ * \brief ȴеĵϢȫڷͣ縴λǰã
+ * \note жϷлжʱ
+ * \return 
+ */
+void am_debug_flush (void);
+
 /**
  * \brief ʽַ
  *
  * ú vXXXprintf() Ļ vXXXprintf() ڴ˺
  *
+ * ֧ %d %i %u %o %x %X %p %c %s %%־ '-' '0' '+' ' ' '#'Ⱥ;
+ * Ϊ '*'Լ hh h l ll j z tַȴջϳΪ
+ * AM_VFPRINTF_BUF_SIZEĬ 32Ļٳɶεͨ f_puts f_putc 
+ *  '\0' ַ
+ *
+ *  AM_VFPRINTF_FLOAT ʱ֧ %f %F %e %E %g %Gʹ㾫ȷ
+ * ţ C  printf"˫"ȷ롣ౣ 18 λЧ
+ * ֣%f Ϊ 18 λСλΪ 0 2^63 ֵ %f Ҳֻ 18 λ
+ * Ч֡ʱջԼ 170 ֽڣСֵתx86-64 Լ
+ * 5 usδúʱЩתֹͣ
+ *
  * \param[in] fil     :  Ϊ f_putc  f_puts ĵڶ
  * \param[in] f_putc  :  ָ룬ָĺһַ
  * \param[in] f_puts  :  ָ룬ָĺһַ
@@ -18,9 +18,21 @@
  * Ҫȴĵط:am_wait_on(&wait);
  * Ҫ֮ǰȴĵطãam_wait_done(&wait);
  *
+ * Ĭ£ȴڼ CPU һֱѯȴֵʹ am_wait_idle_set() ÿ
+ * ȴڼڹжϵ״̬¼ȴֵδʱÿкִ WFI ʹ
+ * CPU ˯ߣжϹʱѣغٴжϴжϡam_wait_done()
+ * ڹжϵ״̬õȴֵûѺ˲ᶪʧѡ
+ * tools/host_test/host/am_host.cУжӳΪСѺӳΪ
+ * futexڲԻѵʱ͵ȴڼ CPU ռá
+ *
+ * ĳϣЭ am_co.hʹ am_wait_notify_set() õȴ
+ * ʱ֪ͨʹ am_wait_try() ѯȴ
  *
  * \internal
  * \par Modification History
+ * - 1.04 26-10-18  lgg, document the host mapping of the idle hook.
+ * - 1.03 26-10-18  lgg, add asynchronous notify and am_wait_try().
+ * - 1.02 26-10-18  lgg, add idle hook for low power waiting.
  * - 1.01 15-09-07  tee, add am_wait_on_timeout() interface.
  * - 1.00 15-06-12  tee, first implementation.
  * \endinternal
@@ -57,7 +69,50 @@ typedef struct am_wait {
     /** \brief ־ǰĵȴ״̬       */
     uint8_t           stat;
 
+    /** \brief ȴɣʱʱ֪ͨ */
+    am_pfnvoid_t      pfn_notify;
+
+    /** \brief ֪ͨĲ           */
+    void             *p_notify_arg;
+
 } am_wait_t;
+
+/**
+ * \brief ȴڼʹõĿСѺ
+ *
+ * Cortex-Mʹ WFI
+ * \code
+ * static void __wait_idle (void *p_arg)
+ * {
+ *     __WFI();       // ѹжϣжϹʱ WFI 
+ * }
+ *
+ * static const am_wait_idle_funcs_t __g_wait_idle_funcs = {
+ *     __wait_idle,
+ *     NULL,          // ʹ WFE ʱڴִ __SEV()
+ *     NULL
+ * };
+ *
+ * am_wait_idle_set(&__g_wait_idle_funcs);
+ * \endcode
+ */
+typedef struct am_wait_idle_funcs {
+
+    /**
+     * \brief кȴδʱڹжϵ״̬µ
+     *
+     * غжϣжϣٴμȴֵжϹ
+     * ʱأ WFIΪ NULLʱһֱѯȴֵ
+     */
+    void (*pfn_idle) (void *p_arg);
+
+    /** \brief Ѻam_wait_done() ʱʱڹжϵ״̬µãΪ NULL */
+    void (*pfn_wake) (void *p_arg);
+
+    /** \brief СѺĲ */
+    void  *p_arg;
+
+} am_wait_idle_funcs_t;
     
  
 /** 
@@ -110,6 +165,47 @@ int am_wait_on_timeout(am_wait_t *p_wait, uint32_t timeout_ms);
  * \retval -AM_EINVAL ȴʧܣ
  */
 int am_wait_done(am_wait_t *p_wait);
+
+/**
+ * \brief õȴʱ֪ͨ
+ *
+ *  am_wait_done()  am_wait_on_timeout() ʱʱø֪ͨ
+ * жϻУ֪ͨʹ am_wait_try() ȡȴ
+ *
+ * \param[in] p_wait       : ָȴźŵָ
+ * \param[in] pfn_notify   : ֪ͨΪ NULL ʱȡ֪ͨ
+ * \param[in] p_notify_arg : ֪ͨĲ
+ *
+ * \retval  AM_OK     óɹ
+ * \retval -AM_EINVAL 
+ */
+int am_wait_notify_set(am_wait_t    *p_wait,
+                       am_pfnvoid_t  pfn_notify,
+                       void         *p_notify_arg);
+
+/**
+ * \brief ѯȴǷɣ
+ *
+ * ȴɻѳʱʱ״̬ am_wait_on() ʱһ¡
+ *
+ * \param[in] p_wait  : ָȴźŵָ
+ *
+ * \retval  AM_OK     ȴ
+ * \retval -AM_ETIME  ȴѳʱ
+ * \retval -AM_EAGAIN ȴδ
+ * \retval -AM_EINVAL 
+ */
+int am_wait_try(am_wait_t *p_wait);
+
+/**
+ * \brief õȴڼʹõĿСѺеȴЧ
+ *
+ * \param[in] p_funcs : СѺʹڼһֱЧΪ NULL ʱָΪ
+ *                      һֱѯȴֵ
+ *
+ * \retval  AM_OK     óɹ
+ */
+int am_wait_idle_set(const am_wait_idle_funcs_t *p_funcs);
  
 
 /** 
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+AM_LOG decoder.
+
+Reads the text produced by am_log_drain() (lines "#L:<base64>"), looks up the
+format strings in the application's ELF file and prints the reconstructed log.
+Lines without the "#L:" prefix (ordinary am_kprintf() output) are copied as-is.
+
+usage: am_log_decode.py app.elf [input]
+
+input is a file or a serial device (already configured, e.g. with stty);
+stdin is used when it is omitted.
+"""
+
+import base64
+import re
+import struct
+import sys
+
+LEVELS = ("E", "W", "I", "D")
+
+SYNC    = 0xA5
+TS_FLAG = 1 << 15
+SEQ_MOD = 1 << 15
+
+FMT_RE = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?"
+                    r"(hh|h|ll|l|j|z|t|L)?([diouxXcspfFeEgG%])")
+
+
+class Elf(object):
+    """Loadable sections of an ELF file, addressable by target address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError("%s: not an ELF file" % path)
+        is64 = data[4] == 2
+        end  = "<" if data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(end + "Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x3A)
+            shfmt = end + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(end + "I", data, 0x20)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x2E)
+            shfmt = end + "IIIIIIIIII"
+        self.sections = []
+        for i in range(shnum):
+            (name, typ, flags, addr, off, size,
+             link, info, align, entsize) = struct.unpack_from(
+                shfmt, data, shoff + i * shentsize)
+            # SHT_PROGBITS with an address: .text, .rodata, .am_log_fmt ...
+            if typ == 1 and addr != 0 and size != 0:
+                self.sections.append((addr, data[off:off + size]))
+
+    def string(self, addr):
+        for base, blob in self.sections:
+            if base <= addr < base + len(blob):
+                off = addr - base
+                end = blob.find(b"\0", off)
+                if end < 0:
+                    end = len(blob)
+                return blob[off:end].decode("utf-8", "replace")
+        return None
+
+
+def to_signed(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def format_log(elf, fmt, args):
+    """printf() with 32-bit argument words, strings are read from the ELF."""
+    out  = []
+    pos  = 0
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    for m in FMT_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(to_signed(next_arg()))
+        if prec == "*":
+            prec = str(to_signed(next_arg()))
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        v = next_arg()
+        if conv in "di":
+            out.append((spec + "d") % to_signed(v))
+        elif conv in "ouxX":
+            out.append((spec + conv) % v)
+        elif conv == "c":
+            out.append((spec + "c") % chr(v & 0xFF))
+        elif conv == "p":
+            out.append((spec + "s") % ("0x%x" % v))
+        elif conv == "s":
+            s = elf.string(v)
+            out.append((spec + "s") % (s if s is not None else
+                                       "<0x%08x>" % v))
+        else:
+            out.append("<%s:0x%08x>" % (conv, v))
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode_line(elf, text, state):
+    try:
+        raw = base64.b64decode(text, validate=True)
+    except Exception:
+        return "<am_log: bad line>\n"
+    if len(raw) < 8 or len(raw) % 4:
+        return "<am_log: bad length>\n"
+    words = struct.unpack("<%dI" % (len(raw) // 4), raw)
+    hdr   = words[0]
+    if hdr >> 24 != SYNC:
+        return "<am_log: bad sync>\n"
+    level = (hdr >> 20) & 0x0F
+    nargs = (hdr >> 16) & 0x0F
+    seq   = hdr & (SEQ_MOD - 1)
+    idx   = 2
+    prefix = ""
+
+    if state.get("seq") is not None:
+        lost = (seq - state["seq"] - 1) % SEQ_MOD
+        if lost:
+            prefix += "<am_log: %d record(s) lost>\n" % lost
+    state["seq"] = seq
+
+    if hdr & TS_FLAG:
+        prefix += "[%10u] " % words[2]
+        idx = 3
+    prefix += "%s: " % (LEVELS[level] if level < len(LEVELS) else str(level))
+
+    fmt = elf.string(words[1])
+    if fmt is None:
+        return prefix + "<unknown format 0x%08x>\n" % words[1]
+    text = format_log(elf, fmt, words[idx:idx + nargs])
+    if not text.endswith("\n"):
+        text += "\n"
+    return prefix + text
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write(__doc__)
+        return 1
+    elf   = Elf(argv[1])
+    inp   = open(argv[2], "rb") if len(argv) > 2 else sys.stdin.buffer
+    state = {}
+    for raw in inp:
+        line = raw.decode("utf-8", "replace").rstrip("\r\n")
+        pos  = line.find("#L:")
+        if pos < 0:
+            sys.stdout.write(line + "\n")
+        else:
+            if pos:
+                sys.stdout.write(line[:pos] + "\n")
+            sys.stdout.write(decode_line(elf, line[pos + 3:].strip(), state))
+        sys.stdout.flush()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
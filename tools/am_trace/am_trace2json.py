@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Convert the output of am_trace_dump() to Chrome trace-event JSON.
+
+usage: am_trace2json.py [-e app.elf] [-c] [-o trace.json] [input]
+
+  -e  ELF file of the application, used to name jobs and softimer callbacks
+  -c  subtract the measured cost of each trace record from the timeline
+  -o  output file (default: stdout)
+
+input is the captured debug UART text (stdin when omitted); other text is
+ignored and the last complete dump ("#TB:" ... "#TE") is converted.
+The result can be opened in chrome://tracing or https://ui.perfetto.dev.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TYPES = ("isr", "job", "timer", "wait", "user")
+
+
+def elf_symbols(path):
+    """Return {address: name} for the function and object symbols."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s: not an ELF file" % path)
+    is64 = data[4] == 2
+    end  = "<" if data[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", data, 0x28)
+        shentsize, shnum = struct.unpack_from(end + "HH", data, 0x3A)
+        shfmt, symfmt = end + "IIQQQQIIQQ", end + "IBBHQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", data, 0x20)
+        shentsize, shnum = struct.unpack_from(end + "HH", data, 0x2E)
+        shfmt, symfmt = end + "IIIIIIIIII", end + "IIIBBH"
+    shdrs = [struct.unpack_from(shfmt, data, shoff + i * shentsize)
+             for i in range(shnum)]
+    syms = {}
+    for sh in shdrs:
+        if sh[1] != 2:                      # SHT_SYMTAB
+            continue
+        off, size, link, entsize = sh[4], sh[5], sh[6], sh[9]
+        stroff = shdrs[link][4]
+        for i in range(size // entsize):
+            ent = struct.unpack_from(symfmt, data, off + i * entsize)
+            if is64:
+                name, info, value = ent[0], ent[1], ent[4]
+            else:
+                name, value, info = ent[0], ent[1], ent[3]
+            if (info & 0x0F) not in (1, 2) or value == 0:   # OBJECT, FUNC
+                continue
+            end_ = data.index(b"\0", stroff + name)
+            # Thumb functions have bit 0 set in both the symbol and pointers
+            syms[value & ~1] = data[stroff + name:end_].decode("ascii",
+                                                               "replace")
+    return syms
+
+
+def read_dump(lines):
+    dump = None
+    cur  = None
+    for line in lines:
+        line = line.strip()
+        pos  = line.find("#T")
+        if pos < 0:
+            continue
+        line = line[pos:]
+        if line.startswith("#TB:"):
+            freq, overhead, n, lost = (int(v) for v in line[4:].split(","))
+            cur = {"freq": freq, "overhead": overhead, "lost": lost,
+                   "recs": []}
+        elif line.startswith("#TE"):
+            if cur is not None:
+                dump = cur
+            cur = None
+        elif line.startswith("#T:") and cur is not None:
+            ts, ident, info = (int(v, 16) for v in line[3:].split())
+            cur["recs"].append((ts, ident, info))
+    return dump
+
+
+def convert(dump, syms, compensate):
+    scale  = 1e6 / dump["freq"]
+    events = []
+    stack  = []
+    recs   = dump["recs"]
+    if not recs:
+        return events
+
+    # unwrap the 32-bit timestamps
+    times = []
+    base  = 0
+    prev  = recs[0][0]
+    for i, (ts, _, _) in enumerate(recs):
+        base += (ts - prev) & 0xFFFFFFFF
+        prev  = ts
+        t     = base - (dump["overhead"] * i if compensate else 0)
+        # the measured cost is an average, never let events swap order
+        if times and t * scale < times[-1]:
+            times.append(times[-1])
+        else:
+            times.append(t * scale)
+
+    def name_of(typ, ident):
+        if typ == 0:
+            return "IRQ %d" % ident
+        if typ in (1, 2):
+            return syms.get(ident & ~1, "0x%08x" % ident)
+        if typ == 3:
+            return "wait 0x%08x" % ident
+        return "user %d" % ident
+
+    def emit(typ, ident, t0, t1, partial=False):
+        ev = {"name": name_of(typ, ident),
+              "cat":  TYPES[typ] if typ < len(TYPES) else str(typ),
+              "ph":   "X", "pid": 0, "tid": 0,
+              "ts":   round(t0, 3), "dur": round(max(t1 - t0, 0), 3)}
+        if partial:
+            ev["args"] = {"partial": True}
+        events.append(ev)
+
+    for t, (_, ident, info) in zip(times, recs):
+        typ = info >> 1
+        if not info & 1:
+            stack.append((typ, ident, t))
+            continue
+        for i in range(len(stack) - 1, -1, -1):
+            if stack[i][0] == typ and stack[i][1] == ident:
+                break
+        else:
+            # the enter event was overwritten before the dump
+            emit(typ, ident, times[0], t, True)
+            continue
+        while len(stack) > i + 1:
+            typ_, ident_, t0 = stack.pop()
+            emit(typ_, ident_, t0, t, True)
+        _, _, t0 = stack.pop()
+        emit(typ, ident, t0, t)
+
+    while stack:
+        typ, ident, t0 = stack.pop()
+        emit(typ, ident, t0, times[-1], True)
+
+    events.sort(key=lambda e: (e["ts"], -e["dur"]))
+    events.insert(0, {"name": "thread_name", "ph": "M", "pid": 0, "tid": 0,
+                      "args": {"name": "cpu"}})
+    return events
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawTextHelpFormatter)
+    ap.add_argument("input", nargs="?")
+    ap.add_argument("-e", "--elf")
+    ap.add_argument("-c", "--compensate", action="store_true")
+    ap.add_argument("-o", "--output")
+    args = ap.parse_args()
+
+    inp = (open(args.input, "r", errors="replace") if args.input
+           else sys.stdin)
+    dump = read_dump(inp)
+    if dump is None:
+        sys.stderr.write("no complete trace dump found\n")
+        return 1
+
+    syms   = elf_symbols(args.elf) if args.elf else {}
+    result = {"traceEvents": convert(dump, syms, args.compensate),
+              "displayTimeUnit": "ns",
+              "otherData": {"clk_freq": dump["freq"],
+                            "record_overhead_ticks": dump["overhead"],
+                            "lost_records": dump["lost"],
+                            "compensated": args.compensate}}
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(result, out, indent=1)
+    out.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
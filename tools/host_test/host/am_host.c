@@ -0,0 +1,156 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host (POSIX threads) port used by the host tests
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_host.h"
+#include "am_int.h"
+#include "am_softimer.h"
+#include <pthread.h>
+#include <time.h>
+
+/** \brief the "interrupt lock" */
+static pthread_mutex_t __g_host_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** \brief signalled by am_wait_done() and timeouts */
+static pthread_cond_t  __g_host_cond = PTHREAD_COND_INITIALIZER;
+
+/** \brief the calling thread holds __g_host_lock */
+static __thread int    __g_host_locked = 0;
+
+static pthread_t       __g_tick_thread;
+static volatile int    __g_tick_run = 0;
+static unsigned int    __g_tick_rate;
+
+/******************************************************************************/
+uint32_t am_int_cpu_lock (void)
+{
+    if (__g_host_locked) {
+        return 1;                   /* nested, already locked */
+    }
+    pthread_mutex_lock(&__g_host_lock);
+    __g_host_locked = 1;
+
+    return 0;
+}
+
+void am_int_cpu_unlock (uint32_t key)
+{
+    if (key == 0) {
+        __g_host_locked = 0;
+        pthread_mutex_unlock(&__g_host_lock);
+    }
+}
+
+/******************************************************************************/
+
+/* called with the lock held, returns with it held again */
+static void __host_wait_idle (void *p_arg)
+{
+    (void)p_arg;
+
+    pthread_cond_wait(&__g_host_cond, &__g_host_lock);
+}
+
+static void __host_wait_wake (void *p_arg)
+{
+    (void)p_arg;
+
+    pthread_cond_broadcast(&__g_host_cond);
+}
+
+const am_wait_idle_funcs_t am_host_wait_idle = {
+    __host_wait_idle,
+    __host_wait_wake,
+    NULL
+};
+
+/******************************************************************************/
+uint64_t am_host_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+uint64_t am_host_thread_cpu_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* the tick "interrupt", ticks are caught up if the thread is late */
+static void *__host_tick_thread (void *p_arg)
+{
+    uint64_t period = 1000000000u / __g_tick_rate;
+    uint64_t next   = am_host_ns() + period;
+    uint32_t key;
+    struct timespec ts;
+
+    (void)p_arg;
+
+    while (__g_tick_run) {
+        ts.tv_sec  = next / 1000000000u;
+        ts.tv_nsec = next % 1000000000u;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+        while (am_host_ns() >= next) {
+            key = am_int_cpu_lock();
+            am_softimer_module_tick();
+            am_int_cpu_unlock(key);
+            next += period;
+        }
+    }
+
+    return NULL;
+}
+
+int am_host_tick_start (unsigned int clkrate)
+{
+    if ((clkrate == 0) || (clkrate > 100000)) {
+        return -AM_EINVAL;
+    }
+
+    am_softimer_module_init(clkrate);
+
+    __g_tick_rate = clkrate;
+    __g_tick_run  = 1;
+    if (pthread_create(&__g_tick_thread, NULL, __host_tick_thread, NULL)) {
+        __g_tick_run = 0;
+        return -AM_EINVAL;
+    }
+
+    return AM_OK;
+}
+
+void am_host_tick_stop (void)
+{
+    if (__g_tick_run) {
+        __g_tick_run = 0;
+        pthread_join(__g_tick_thread, NULL);
+    }
+}
+
+/* end of file */
@@ -0,0 +1,71 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host (POSIX threads) port used by the host tests
+ *
+ * Host threads play the roles of the main loop and of interrupts:
+ * - am_int_cpu_lock()/am_int_cpu_unlock() take one process-wide mutex, so a
+ *   thread holding the "interrupt lock" excludes every other thread, like
+ *   PRIMASK excludes ISRs. The lock nests per thread like the real one.
+ * - am_host_wait_idle is the am_wait idle hook: the idle function waits on
+ *   a condition variable, releasing the lock atomically (glibc implements
+ *   it with a futex), the wake function broadcasts it. This is the host
+ *   counterpart of WFI with interrupts locked.
+ * - am_host_tick_start() runs am_softimer_module_tick() from a thread, in
+ *   the lock, as the system tick interrupt would.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __AM_HOST_H
+#define __AM_HOST_H
+
+#include "am_common.h"
+#include "am_wait.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief am_wait idle and wake functions on a condition variable */
+extern const am_wait_idle_funcs_t am_host_wait_idle;
+
+/**
+ * \brief initialise the soft timers and start a thread ticking them
+ *
+ * \param[in] clkrate : tick rate (Hz)
+ *
+ * \return AM_OK or -AM_EINVAL
+ */
+int am_host_tick_start (unsigned int clkrate);
+
+/** \brief stop the tick thread */
+void am_host_tick_stop (void);
+
+/** \brief monotonic time in ns */
+uint64_t am_host_ns (void);
+
+/** \brief CPU time of the calling thread in ns */
+uint64_t am_host_thread_cpu_ns (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AM_HOST_H */
+
+/* end of file */
@@ -0,0 +1,218 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief NOR flash simulator used by the am_ftl host tests
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "nor_sim.h"
+#include <string.h>
+
+/** \brief time of a transaction without its data (us) */
+#define __NOR_SIM_OP_US         (10.0 + 4 * 0.4)
+
+/** \brief transfer time of one byte (us) */
+#define __NOR_SIM_BYTE_US       0.4
+
+/** \brief program time of one page (us) */
+#define __NOR_SIM_PAGE_US       700.0
+#define __NOR_SIM_PAGE_SIZE     256u
+
+/** \brief erase time of one sector (us) */
+#define __NOR_SIM_ERASE_US      45000.0
+
+uint8_t        nor_sim_mem[NOR_SIM_SIZE];
+unsigned int   nor_sim_erase_cnt[NOR_SIM_SIZE / NOR_SIM_ERASE_SIZE];
+nor_sim_stat_t nor_sim_stat;
+long           nor_sim_cut_after = -1;
+
+static long    __g_pf_after = 0;
+static void  (*__g_pf_func) (void *);
+static void   *__g_pf_arg;
+
+static am_mtd_serv_t __g_nor_sim;
+
+/******************************************************************************/
+static am_bool_t __nor_sim_cut (void)
+{
+    if (nor_sim_cut_after < 0) {
+        return AM_FALSE;
+    }
+    if (nor_sim_cut_after == 0) {
+        return AM_TRUE;
+    }
+    nor_sim_cut_after--;
+
+    return AM_FALSE;
+}
+
+static int __nor_sim_erase (void *p_drv, struct am_mtd_erase_info *p_info)
+{
+    uint32_t addr;
+
+    (void)p_drv;
+
+    if (__nor_sim_cut()) {
+        return -AM_EIO;
+    }
+
+    memset(nor_sim_mem + p_info->addr, 0xFF, p_info->len);
+    for (addr = p_info->addr;
+         addr < p_info->addr + p_info->len;
+         addr += NOR_SIM_ERASE_SIZE) {
+        nor_sim_erase_cnt[addr / NOR_SIM_ERASE_SIZE]++;
+        nor_sim_stat.us += __NOR_SIM_ERASE_US;
+    }
+    nor_sim_stat.er_ops++;
+    nor_sim_stat.us += __NOR_SIM_OP_US;
+
+    return AM_OK;
+}
+
+static int __nor_sim_read (void *p_drv, uint32_t addr, void *p_buf, uint32_t len)
+{
+    (void)p_drv;
+
+    memcpy(p_buf, nor_sim_mem + addr, len);
+    nor_sim_stat.rd_ops++;
+    nor_sim_stat.us += __NOR_SIM_OP_US + __NOR_SIM_BYTE_US * len;
+
+    return AM_OK;
+}
+
+static int __nor_sim_write (void       *p_drv,
+                            uint32_t    addr,
+                            const void *p_buf,
+                            uint32_t    len)
+{
+    const uint8_t *p_data = (const uint8_t *)p_buf;
+    uint32_t       i;
+
+    (void)p_drv;
+
+    if (__nor_sim_cut()) {
+        return -AM_EIO;
+    }
+
+    for (i = 0; i < len; i++) {
+        nor_sim_mem[addr + i] &= p_data[i];
+    }
+    nor_sim_stat.wr_ops++;
+    nor_sim_stat.wr_bytes += len;
+    nor_sim_stat.us += __NOR_SIM_OP_US + __NOR_SIM_BYTE_US * len +
+                       __NOR_SIM_PAGE_US *
+                       ((addr + len - 1) / __NOR_SIM_PAGE_SIZE -
+                        addr / __NOR_SIM_PAGE_SIZE + 1);
+
+    if ((__g_pf_after > 0) && (--__g_pf_after == 0)) {
+        __g_pf_func(__g_pf_arg);
+    }
+
+    return AM_OK;
+}
+
+static int __nor_sim_readv (void                 *p_drv,
+                            const am_mtd_iovec_t *p_iov,
+                            unsigned int          iovcnt)
+{
+    uint32_t     next = 0xFFFFFFFF;
+    unsigned int i;
+
+    (void)p_drv;
+
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(p_iov[i].p_buf, nor_sim_mem + p_iov[i].addr, p_iov[i].len);
+        nor_sim_stat.us += __NOR_SIM_BYTE_US * p_iov[i].len;
+
+        /* a new transaction when the address is not contiguous */
+        if (p_iov[i].addr != next) {
+            nor_sim_stat.rd_ops++;
+            nor_sim_stat.us += __NOR_SIM_OP_US;
+        }
+        next = p_iov[i].addr + p_iov[i].len;
+    }
+
+    return AM_OK;
+}
+
+static int __nor_sim_writev (void                 *p_drv,
+                             const am_mtd_iovec_t *p_iov,
+                             unsigned int          iovcnt)
+{
+    unsigned int i;
+    int          ret;
+
+    for (i = 0; i < iovcnt; i++) {
+        ret = __nor_sim_write(p_drv, p_iov[i].addr, p_iov[i].p_buf, p_iov[i].len);
+        if (ret != AM_OK) {
+            return ret;
+        }
+    }
+
+    return AM_OK;
+}
+
+static const struct am_mtd_ops __g_nor_sim_ops = {
+    __nor_sim_erase,
+    __nor_sim_read,
+    __nor_sim_write,
+    NULL,
+    NULL
+};
+
+static const struct am_mtd_ops __g_nor_sim_ops_vec = {
+    __nor_sim_erase,
+    __nor_sim_read,
+    __nor_sim_write,
+    __nor_sim_readv,
+    __nor_sim_writev
+};
+
+/******************************************************************************/
+am_mtd_handle_t nor_sim_init (am_bool_t vec)
+{
+    __g_nor_sim.type           = AM_MTD_TYPE_NOR_FLASH;
+    __g_nor_sim.flags          = AM_MTD_FLAGS_NOR_FLASH;
+    __g_nor_sim.size           = NOR_SIM_SIZE;
+    __g_nor_sim.erase_size     = NOR_SIM_ERASE_SIZE;
+    __g_nor_sim.write_size     = 1;
+    __g_nor_sim.write_buf_size = __NOR_SIM_PAGE_SIZE;
+    __g_nor_sim.p_ops          = vec ? &__g_nor_sim_ops_vec : &__g_nor_sim_ops;
+    __g_nor_sim.p_drv          = NULL;
+
+    return &__g_nor_sim;
+}
+
+void nor_sim_blank (void)
+{
+    memset(nor_sim_mem, 0xFF, sizeof(nor_sim_mem));
+}
+
+void nor_sim_stat_reset (void)
+{
+    memset(&nor_sim_stat, 0, sizeof(nor_sim_stat));
+}
+
+void nor_sim_pwr_fail_set (long n, void (*pfn_func) (void *), void *p_arg)
+{
+    __g_pf_func  = pfn_func;
+    __g_pf_arg   = p_arg;
+    __g_pf_after = n;
+}
+
+/* end of file */
@@ -0,0 +1,108 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief NOR flash simulator used by the am_ftl host tests
+ *
+ * An am_mtd device in RAM that behaves like a SPI NOR flash: a program ANDs
+ * the data into the array, an erase sets a 4 KB sector to 0xFF. Each
+ * operation adds its time to nor_sim_stat.us with the model of a 20 MHz SPI
+ * part:
+ * - 10 us of driver and chip select overhead plus a 4 byte command;
+ * - 0.4 us per byte transferred;
+ * - 0.7 ms per 256 byte page touched by a program;
+ * - 45 ms per sector erase.
+ *
+ * A power cut is simulated by failing every program and erase after a given
+ * number of them, a power-fail interrupt by calling a function from inside
+ * a program.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#ifndef __NOR_SIM_H
+#define __NOR_SIM_H
+
+#include "am_common.h"
+#include "am_mtd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief size of the device, set on the compiler command line if needed */
+#ifndef NOR_SIM_SIZE
+#define NOR_SIM_SIZE        (8u * 1024 * 1024)
+#endif
+
+/** \brief erase (sector) size */
+#define NOR_SIM_ERASE_SIZE  4096u
+
+/** \brief statistics since the last nor_sim_stat_reset() */
+typedef struct nor_sim_stat {
+    double         us;              /**< \brief simulated busy time (us) */
+    unsigned long  rd_ops;          /**< \brief read transactions */
+    unsigned long  wr_ops;          /**< \brief program transactions */
+    unsigned long  er_ops;          /**< \brief sector erases */
+    unsigned long  wr_bytes;        /**< \brief bytes programmed */
+} nor_sim_stat_t;
+
+/** \brief the flash array */
+extern uint8_t        nor_sim_mem[NOR_SIM_SIZE];
+
+/** \brief erase count of each sector, never reset by the simulator */
+extern unsigned int   nor_sim_erase_cnt[NOR_SIM_SIZE / NOR_SIM_ERASE_SIZE];
+
+extern nor_sim_stat_t nor_sim_stat;
+
+/**
+ * \brief programs and erases left before a power cut, -1 for none
+ *
+ * When it reaches 0 every program and erase fails with -AM_EIO and leaves
+ * the array unchanged, until it is set to -1 again.
+ */
+extern long           nor_sim_cut_after;
+
+/**
+ * \brief get the MTD handle of the simulator
+ *
+ * \param[in] vec : AM_TRUE to provide pfn_mtd_readv/pfn_mtd_writev. readv
+ *                  reads each run of address contiguous segments in one
+ *                  transaction, like am_mx25xx.
+ *
+ * \return the MTD handle
+ */
+am_mtd_handle_t nor_sim_init (am_bool_t vec);
+
+/** \brief erase the whole array, without counting erases */
+void nor_sim_blank (void);
+
+/** \brief clear nor_sim_stat */
+void nor_sim_stat_reset (void);
+
+/**
+ * \brief call a function from inside the n-th next program, after the data
+ *        is in the array (n == 0 to disable)
+ */
+void nor_sim_pwr_fail_set (long n, void (*pfn_func) (void *), void *p_arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NOR_SIM_H */
+
+/* end of file */
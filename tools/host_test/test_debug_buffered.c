@@ -0,0 +1,244 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of am_debug_init_buffered()
+ *
+ * A fake am_uart driver sends one character per 1/11520 s (115200 baud) into
+ * a memory buffer: from the caller in poll mode, from a "TX interrupt"
+ * thread through the TXCHAR_GET callback in interrupt mode. The test
+ * measures the time of one am_kprintf() in poll mode and the worst time in
+ * buffered mode, and checks that
+ * - with AM_DEBUG_BUF_POLICY_DROP, received + dropped bytes equal the bytes
+ *   produced;
+ * - with AM_DEBUG_BUF_POLICY_BLOCK, every byte arrives, in order, with the
+ *   '\r' before each '\n'.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "ametal.h"
+#include "am_vdebug.h"
+#include "am_int.h"
+#include "am_uart.h"
+#include "am_host.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define __NS_PER_CHAR       86806   /* 10 bits at 115200 baud */
+#define __DROP_LINES        200
+#define __BLOCK_LINES       300
+
+static unsigned long __g_fails = 0;
+
+/* the fake UART */
+static volatile int          __g_tx_on   = 0;
+static volatile int          __g_tx_run  = 1;
+static am_uart_txchar_get_t  __g_txchar_get;
+static void                 *__g_txchar_arg;
+static char                  __g_rx[1 << 20];
+static volatile size_t       __g_rx_len  = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __char_time (void)
+{
+    struct timespec ts = {0, __NS_PER_CHAR};
+
+    nanosleep(&ts, NULL);
+}
+
+static int __uart_ioctl (void *p_drv, int request, void *p_arg)
+{
+    (void)p_drv;
+    (void)p_arg;
+
+    return (request == AM_UART_MODE_SET) ? AM_OK : -AM_EIO;
+}
+
+static int __uart_tx_startup (void *p_drv)
+{
+    (void)p_drv;
+
+    __g_tx_on = 1;
+
+    return AM_OK;
+}
+
+static int __uart_callback_set (void *p_drv,
+                                int   callback_type,
+                                void *pfn_callback,
+                                void *p_arg)
+{
+    (void)p_drv;
+
+    if (callback_type == AM_UART_CALLBACK_TXCHAR_GET) {
+        __g_txchar_get = (am_uart_txchar_get_t)pfn_callback;
+        __g_txchar_arg = p_arg;
+    }
+
+    return AM_OK;
+}
+
+static int __uart_poll_getchar (void *p_drv, char *p_inchar)
+{
+    (void)p_drv;
+    (void)p_inchar;
+
+    return -AM_EAGAIN;
+}
+
+static int __uart_poll_putchar (void *p_drv, char outchar)
+{
+    (void)p_drv;
+
+    __char_time();
+    __g_rx[__g_rx_len++] = outchar;
+
+    return AM_OK;
+}
+
+static struct am_uart_drv_funcs __g_uart_funcs = {
+    __uart_ioctl,
+    __uart_tx_startup,
+    __uart_callback_set,
+    __uart_poll_getchar,
+    __uart_poll_putchar
+};
+
+static am_uart_serv_t __g_uart = {&__g_uart_funcs, NULL};
+
+/* the TX interrupt: one character per character time while enabled */
+static void *__uart_tx_isr (void *p_arg)
+{
+    uint32_t key;
+    char     c;
+    int      ret;
+
+    (void)p_arg;
+
+    while (__g_tx_run) {
+        if (!__g_tx_on) {
+            usleep(20);
+            continue;
+        }
+        key = am_int_cpu_lock();
+        ret = __g_txchar_get(__g_txchar_arg, &c);
+        if (ret != AM_OK) {
+            __g_tx_on = 0;
+        }
+        am_int_cpu_unlock(key);
+
+        if (ret == AM_OK) {
+            __char_time();
+            __g_rx[__g_rx_len++] = c;
+        }
+    }
+
+    return NULL;
+}
+
+/* wait until the UART has sent everything */
+static void __drain (void)
+{
+    am_debug_flush();
+    while (__g_tx_on) {
+        usleep(100);
+    }
+}
+
+int main (void)
+{
+    static char buf[1024];
+    static char exp[1 << 16];
+    pthread_t   isr;
+    uint64_t    t0, t, poll_ns, worst_ns = 0;
+    size_t      produced = 0, start, exp_len = 0;
+    char        line[64];
+    int         i, n;
+
+    /* poll mode: the caller waits for every character */
+    am_debug_init(&__g_uart, 115200);
+    t0      = am_host_ns();
+    am_kprintf("tick %d: loop=%u us err=%d\n", 1, 250, 0);
+    poll_ns = am_host_ns() - t0;
+
+    pthread_create(&isr, NULL, __uart_tx_isr, NULL);
+
+    /* buffered, drop when full */
+    __check(am_debug_init_buffered(&__g_uart, 115200, buf, sizeof(buf),
+                                   AM_DEBUG_BUF_POLICY_DROP) == AM_OK,
+            "am_debug_init_buffered() drop");
+    start = __g_rx_len;
+    for (i = 0; i < __DROP_LINES; i++) {
+        n  = am_snprintf(line, sizeof(line), "tick %d: loop=%u us err=%d\n",
+                         i, 250 + i, -i);
+        t0 = am_host_ns();
+        am_kprintf("%s", line);
+        t  = am_host_ns() - t0;
+        if (t > worst_ns) {
+            worst_ns = t;
+        }
+        produced += n + 1;          /* '\r' added before '\n' */
+        usleep(1000);
+    }
+    __drain();
+    __check(__g_rx_len - start + am_debug_dropped_get() == produced,
+            "drop: received + dropped != produced");
+
+    printf("test_debug_buffered: kprintf %.0f us polled, worst %.1f us "
+           "buffered\n", poll_ns / 1000.0, worst_ns / 1000.0);
+    printf("test_debug_buffered: drop: produced %zu, received %zu, "
+           "dropped %u\n", produced, __g_rx_len - start,
+           (unsigned)am_debug_dropped_get());
+
+    /* buffered, block when full: every byte arrives */
+    __check(am_debug_init_buffered(&__g_uart, 115200, buf, sizeof(buf),
+                                   AM_DEBUG_BUF_POLICY_BLOCK) == AM_OK,
+            "am_debug_init_buffered() block");
+    start = __g_rx_len;
+    for (i = 0; i < __BLOCK_LINES; i++) {
+        am_kprintf("line %d %s\n", i, "abcdefghijklmnopqrstuvwxyz");
+        exp_len += sprintf(exp + exp_len, "line %d %s\r\n",
+                           i, "abcdefghijklmnopqrstuvwxyz");
+    }
+    __drain();
+    __check((__g_rx_len - start == exp_len) &&
+            !memcmp(exp, __g_rx + start, exp_len),
+            "block: output differs");
+    __check(am_debug_dropped_get() == 0, "block: bytes dropped");
+
+    __check(am_debug_init_buffered(&__g_uart, 115200, buf, 1000,
+                                   AM_DEBUG_BUF_POLICY_DROP) == -AM_EINVAL,
+            "size not a power of 2 accepted");
+
+    __g_tx_run = 0;
+    pthread_join(isr, NULL);
+
+    printf("test_debug_buffered: block: %d lines, %zu bytes, %lu failures\n",
+           __BLOCK_LINES, exp_len, __g_fails);
+
+    return (__g_fails != 0);
+}
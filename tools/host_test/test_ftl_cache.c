@@ -0,0 +1,342 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of the am_ftl write-back cache
+ *
+ * am_ftl runs on the NOR simulator (nor_sim.h), 8 MB with 256 byte logic
+ * blocks and 4 log blocks. The test
+ * - replays one hour of a data logger with 0, 4, 8, 16 and 32 cache items
+ *   and prints the flash traffic and the am_ftl_write() latency, then
+ *   remounts and verifies the data;
+ * - fires am_ftl_power_fail() from inside an MTD program, remounts without
+ *   am_ftl_sync() and verifies the data;
+ * - makes random partial NVRAM reads and writes through a 6 item cache,
+ *   with syncs and remounts, against a shadow copy.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_ftl.h"
+#include "am_nvram.h"
+#include "nor_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __LBS           256
+#define __NB_LOG        4
+#define __NB_LBN        4000        /* logic blocks used by the test */
+#define __CACHE_MAX     32
+#define __NVRAM_SIZE    (64 * __LBS)
+#define __NVRAM_OPS     20000
+
+static uint8_t __g_ram[AM_FTL_RAM_SIZE_GET(NOR_SIM_SIZE,
+                                           NOR_SIM_ERASE_SIZE,
+                                           __LBS,
+                                           __NB_LOG)];
+
+static uint8_t __g_cache[AM_FTL_CACHE_RAM_SIZE_GET(__LBS, __CACHE_MAX)];
+
+static const am_ftl_info_t __g_info = {
+    __g_ram,
+    sizeof(__g_ram),
+    __LBS,
+    __NB_LOG,
+    0,
+    0,
+    0
+};
+
+static am_ftl_serv_t   __g_ftl;
+static am_ftl_handle_t __g_handle;
+
+/** \brief seed of the content of each logic block, 0 if never written */
+static uint32_t        __g_shadow[__NB_LBN];
+
+/** \brief am_ftl_write() times of a trace (us) */
+static double          __g_lat[40000];
+static int             __g_nlat;
+
+static unsigned long   __g_fails = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __fill (uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    int i;
+
+    for (i = 0; i < __LBS; i++) {
+        p_buf[i] = (uint8_t)(seed * 31 + lbn + i * 7);
+    }
+}
+
+/** \brief number of logic blocks that differ from the shadow */
+static int __verify (void)
+{
+    uint8_t      buf[__LBS], exp[__LBS];
+    unsigned int lbn;
+    int          bad = 0;
+
+    for (lbn = 0; lbn < __NB_LBN; lbn++) {
+        am_ftl_read(__g_handle, lbn, buf);
+        if (__g_shadow[lbn]) {
+            __fill(exp, __g_shadow[lbn], lbn);
+        } else {
+            memset(exp, 0, sizeof(exp));
+        }
+        if (memcmp(buf, exp, __LBS) && (bad++ < 5)) {
+            printf("  mismatch lbn %u\n", lbn);
+        }
+    }
+
+    return bad;
+}
+
+static void __write (unsigned int lbn)
+{
+    uint8_t buf[__LBS];
+    double  t0;
+
+    __g_shadow[lbn] = rand() | 1;
+    __fill(buf, __g_shadow[lbn], lbn);
+
+    t0 = nor_sim_stat.us;
+    if (am_ftl_write(__g_handle, lbn, buf) != AM_OK) {
+        printf("FAIL: am_ftl_write() lbn %u\n", lbn);
+        exit(1);
+    }
+    __g_lat[__g_nlat++] = nor_sim_stat.us - t0;
+}
+
+static void __read (unsigned int lbn)
+{
+    uint8_t buf[__LBS];
+
+    am_ftl_read(__g_handle, lbn, buf);
+}
+
+/** \brief mount as after a reset, with n cache items (0 for none) */
+static void __mount (int n)
+{
+    memset(&__g_ftl, 0xA5, sizeof(__g_ftl));
+    __g_handle = am_ftl_init(&__g_ftl, &__g_info, nor_sim_init(AM_FALSE));
+    if (__g_handle == NULL) {
+        printf("FAIL: am_ftl_init()\n");
+        exit(1);
+    }
+    if (n != 0) {
+        __check(am_ftl_cache_init(__g_handle,
+                                  __g_cache,
+                                  AM_FTL_CACHE_RAM_SIZE_GET(__LBS, n),
+                                  n) == AM_OK,
+                "am_ftl_cache_init()");
+    }
+}
+
+/*
+ * one hour of a logger: 4 counters every second, 8 config records every
+ * minute, an event record every 10 s appended to a ring of 2000 blocks,
+ * status and history reads, a sync every minute
+ */
+static void __trace (void)
+{
+    unsigned int ev = 0;
+    int          t, c;
+
+    for (t = 0; t < 3600; t++) {
+        for (c = 0; c < 4; c++) {
+            __write(10 + c);
+        }
+        if (t % 60 == 0) {
+            for (c = 0; c < 8; c++) {
+                __write(c);
+            }
+        }
+        if (t % 10 == 0) {
+            __write(1000 + ev);
+            ev = (ev + 1) % 2000;
+        }
+        if (t % 5 == 0) {
+            __read(10 + t % 4);
+        }
+        if (t % 2 == 0) {
+            __read(1000 + rand() % 2000);
+        }
+        if (t % 60 == 59) {
+            am_ftl_sync(__g_handle);
+        }
+    }
+}
+
+static int __cmp_double (const void *p_a, const void *p_b)
+{
+    double a = *(const double *)p_a;
+    double b = *(const double *)p_b;
+
+    return (a < b) ? -1 : (a > b);
+}
+
+static double __percent (unsigned int hits, unsigned int misses)
+{
+    return (hits + misses) ? 100.0 * hits / (hits + misses) : 0.0;
+}
+
+static void __trace_test (int n)
+{
+    am_ftl_cache_stat_t stat;
+    double              sum = 0;
+    int                 i;
+
+    nor_sim_blank();
+    memset(__g_shadow, 0, sizeof(__g_shadow));
+    srand(7);
+    __mount(n);
+
+    nor_sim_stat_reset();
+    __g_nlat = 0;
+    __trace();
+    am_ftl_sync(__g_handle);
+
+    memset(&stat, 0, sizeof(stat));
+    am_ftl_cache_stat_get(__g_handle, &stat);
+    for (i = 0; i < __g_nlat; i++) {
+        sum += __g_lat[i];
+    }
+    qsort(__g_lat, __g_nlat, sizeof(__g_lat[0]), __cmp_double);
+
+    printf("%5d  %10lu  %11lu  %6lu  %7u  %6.1f  %6.1f  %8.1f  %8.1f  %7.1f\n",
+           n, nor_sim_stat.wr_ops, nor_sim_stat.wr_bytes, nor_sim_stat.er_ops,
+           stat.flushes,
+           __percent(stat.read_hits, stat.read_misses),
+           __percent(stat.write_hits, stat.write_misses),
+           sum / __g_nlat, __g_lat[__g_nlat * 99 / 100],
+           __g_lat[__g_nlat - 1] / 1000);
+
+    __mount(0);
+    __check(__verify() == 0, "data after the trace");
+}
+
+static void __pwr_fail (void *p_arg)
+{
+    am_ftl_power_fail((am_ftl_handle_t)p_arg);
+}
+
+/* the power-fail interrupt comes in the middle of an operation */
+static void __pwr_fail_test (void)
+{
+    int i;
+
+    nor_sim_blank();
+    memset(__g_shadow, 0, sizeof(__g_shadow));
+    __mount(16);
+    for (i = 0; i < 500; i++) {
+        __write(rand() % 50);
+    }
+
+    nor_sim_pwr_fail_set(3, __pwr_fail, __g_handle);
+    for (i = 0; i < 50; i++) {
+        __write(rand() % 50);
+    }
+    nor_sim_pwr_fail_set(0, NULL, NULL);
+
+    __check(__g_ftl.pwr_fail && (__g_ftl.busy == 0),
+            "power fail not handled at the end of the operation");
+
+    /* no am_ftl_sync(): the cache was written back by the power fail */
+    __mount(0);
+    __check(__verify() == 0, "data after power fail");
+}
+
+static void __nvram_mount (am_nvram_dev_t *p_dev)
+{
+    am_nvram_dev_unregister(p_dev);
+    __mount(6);
+    __check(am_ftl_nvram_init(__g_handle, p_dev, "ftl") == AM_OK,
+            "am_ftl_nvram_init()");
+}
+
+/* partial block access goes through the cache */
+static void __nvram_test (void)
+{
+    static uint8_t      shadow[__NVRAM_SIZE];
+    uint8_t             buf[3 * __LBS];
+    am_nvram_dev_t      dev;
+    am_ftl_cache_stat_t stat;
+    int                 i, j, off, len;
+
+    nor_sim_blank();
+    memset(&dev, 0, sizeof(dev));
+    __nvram_mount(&dev);
+
+    for (i = 0; i < __NVRAM_OPS; i++) {
+        off = rand() % __NVRAM_SIZE;
+        len = 1 + rand() % sizeof(buf);
+        if (off + len > __NVRAM_SIZE) {
+            len = __NVRAM_SIZE - off;
+        }
+
+        if (rand() % 3) {
+            for (j = 0; j < len; j++) {
+                buf[j] = rand();
+            }
+            dev.p_funcs->pfn_nvram_set(dev.p_drv, off, buf, len);
+            memcpy(shadow + off, buf, len);
+        } else {
+            dev.p_funcs->pfn_nvram_get(dev.p_drv, off, buf, len);
+            if (memcmp(buf, shadow + off, len)) {
+                __check(0, "nvram data");
+                break;
+            }
+        }
+
+        if (rand() % 500 == 0) {
+            am_ftl_sync(__g_handle);
+            __nvram_mount(&dev);
+        }
+    }
+
+    am_ftl_cache_stat_get(__g_handle, &stat);
+    printf("test_ftl_cache: nvram %d ops, since the last mount read hits "
+           "%u/%u, write hits %u/%u, %u flushes\n", i, stat.read_hits,
+           stat.read_hits + stat.read_misses, stat.write_hits,
+           stat.write_hits + stat.write_misses, stat.flushes);
+}
+
+int main (void)
+{
+    static const int items[] = {0, 4, 8, 16, 32};
+    unsigned int     i;
+
+    printf("items  mtd_writes  bytes_wrote  erases  flushes  rd_hit%%  "
+           "wr_hit%%  avg_us    p99_us    max_ms\n");
+    for (i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+        __trace_test(items[i]);
+    }
+
+    __pwr_fail_test();
+    __nvram_test();
+
+    printf("test_ftl_cache: %lu failures\n", __g_fails);
+
+    return (__g_fails != 0);
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of the am_ftl checkpoint
+ *
+ * am_ftl runs on the NOR simulator (nor_sim.h), 8 MB with 256 byte logic
+ * blocks, 4 log blocks and two checkpoint slots. Every logic block written
+ * is kept in a shadow table and the whole volume is read back after each
+ * mount. The test
+ * - measures the full scan mount and the checkpoint mount;
+ * - checks that a write after a checkpoint makes it stale;
+ * - runs 300 cycles of random writes, checkpoints (some of them cut by a
+ *   simulated power loss) and mounts.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_ftl.h"
+#include "nor_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __LBS           256
+#define __NB_LOG        4
+#define __CKPT_BLOCKS   (2 * AM_FTL_CKPT_BLOCKS_GET(NOR_SIM_SIZE,           \
+                                                    NOR_SIM_ERASE_SIZE,     \
+                                                    __LBS,                  \
+                                                    __NB_LOG))
+#define __NB_LBN        3000        /* logic blocks used by the test */
+#define __CYCLES        300
+
+/** \brief a mount with no more reads than this loaded the checkpoint */
+#define __CKPT_READS    1000
+
+static uint8_t __g_ram[AM_FTL_RAM_SIZE_GET(NOR_SIM_SIZE,
+                                           NOR_SIM_ERASE_SIZE,
+                                           __LBS,
+                                           __NB_LOG)];
+
+static const am_ftl_info_t __g_info = {
+    __g_ram,
+    sizeof(__g_ram),
+    __LBS,
+    __NB_LOG,
+    0,
+    __CKPT_BLOCKS,
+    0
+};
+
+static am_ftl_serv_t   __g_ftl;
+static am_ftl_handle_t __g_handle;
+
+/** \brief seed of the content of each logic block, 0 if never written */
+static uint32_t        __g_shadow[__NB_LBN];
+
+static unsigned long   __g_fails = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __fill (uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    int i;
+
+    for (i = 0; i < __LBS; i++) {
+        p_buf[i] = (uint8_t)(seed * 31 + lbn + i * 7);
+    }
+}
+
+/** \brief number of logic blocks that differ from the shadow */
+static int __verify (void)
+{
+    uint8_t      buf[__LBS], exp[__LBS];
+    unsigned int lbn;
+    int          bad = 0;
+
+    for (lbn = 0; lbn < __NB_LBN; lbn++) {
+        am_ftl_read(__g_handle, lbn, buf);
+        if (__g_shadow[lbn]) {
+            __fill(exp, __g_shadow[lbn], lbn);
+        } else {
+            memset(exp, 0, sizeof(exp));
+        }
+        if (memcmp(buf, exp, __LBS) && (bad++ < 5)) {
+            printf("  mismatch lbn %u\n", lbn);
+        }
+    }
+
+    return bad;
+}
+
+/** \brief n writes, 80 % of them to 100 hot blocks */
+static void __write (int n)
+{
+    uint8_t      buf[__LBS];
+    unsigned int lbn;
+
+    while (n-- > 0) {
+        lbn = (rand() % 10 < 8) ? rand() % 100 : rand() % __NB_LBN;
+        __g_shadow[lbn] = rand() | 1;
+        __fill(buf, __g_shadow[lbn], lbn);
+        if (am_ftl_write(__g_handle, lbn, buf) != AM_OK) {
+            printf("FAIL: am_ftl_write() lbn %u\n", lbn);
+            exit(1);
+        }
+    }
+}
+
+/** \brief mount as after a reset, the statistics are those of the mount */
+static void __mount (void)
+{
+    nor_sim_stat_reset();
+    memset(&__g_ftl, 0xA5, sizeof(__g_ftl));
+    __g_handle = am_ftl_init(&__g_ftl, &__g_info, nor_sim_init(AM_FALSE));
+    if (__g_handle == NULL) {
+        printf("FAIL: am_ftl_init()\n");
+        exit(1);
+    }
+}
+
+int main (void)
+{
+    nor_sim_stat_t scan, ckpt, save;
+    int            cycle, loads = 0, torn = 0;
+
+    nor_sim_blank();
+    __mount();
+    srand(1);
+    __write(20000);
+    __check(__verify() == 0, "data after writes");
+
+    /* no checkpoint yet: full scan */
+    __mount();
+    scan = nor_sim_stat;
+    __check(__verify() == 0, "data after full scan mount");
+
+    __check(am_ftl_checkpoint(__g_handle) == AM_OK, "am_ftl_checkpoint()");
+    nor_sim_stat_reset();
+    am_ftl_checkpoint(__g_handle);
+    __check(nor_sim_stat.wr_ops == 0, "checkpoint without change writes");
+
+    __write(1);
+    nor_sim_stat_reset();
+    am_ftl_checkpoint(__g_handle);
+    save = nor_sim_stat;
+
+    __mount();
+    ckpt = nor_sim_stat;
+    __check(__g_ftl.ckpt_live != 0xFFFFFFFF, "checkpoint not loaded");
+    __check(ckpt.rd_ops < __CKPT_READS, "checkpoint mount reads");
+    __check(__verify() == 0, "data after checkpoint mount");
+
+    /* a change after the checkpoint makes it stale */
+    __write(1);
+    __mount();
+    __check(nor_sim_stat.rd_ops >= __CKPT_READS, "stale checkpoint loaded");
+    __check(__verify() == 0, "data after stale checkpoint");
+
+    /* rotation across the slots, checkpoints torn by power loss */
+    for (cycle = 0; cycle < __CYCLES; cycle++) {
+        __write(rand() % 200);
+        if (rand() % 4) {
+            if (rand() % 5 == 0) {
+                nor_sim_cut_after = rand() % 6;
+                torn++;
+            }
+            am_ftl_checkpoint(__g_handle);
+            nor_sim_cut_after = -1;
+        }
+        __mount();
+        if (nor_sim_stat.rd_ops < __CKPT_READS) {
+            loads++;
+        }
+        if (__verify() != 0) {
+            __check(0, "data after a cycle");
+            break;
+        }
+    }
+
+    printf("test_ftl_ckpt: mount %.1f ms (%lu reads) full scan, "
+           "%.2f ms (%lu reads) checkpoint\n",
+           scan.us / 1000, scan.rd_ops, ckpt.us / 1000, ckpt.rd_ops);
+    printf("test_ftl_ckpt: checkpoint save %.1f ms (%lu writes)\n",
+           save.us / 1000, save.wr_ops);
+    printf("test_ftl_ckpt: %d cycles, %d checkpoint mounts, %d torn, "
+           "%lu failures\n", cycle, loads, torn, __g_fails);
+
+    return (__g_fails != 0);
+}
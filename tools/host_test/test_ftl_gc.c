@@ -0,0 +1,361 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of the am_ftl merge in background
+ *
+ * am_ftl runs on the NOR simulator (nor_sim.h), 1 MB with 256 byte logic
+ * blocks and 4 log blocks. The test prints the am_ftl_write() latency
+ * - of 4 hours of a data logger, with and without am_ftl_gc_step() in the
+ *   idle time of each second;
+ * - of random writes (70 % of them to 64 hot blocks), with 0, 20, 50 and
+ *   150 ms of am_ftl_gc_step() after each write;
+ * and verifies the data every 5000 writes and after a remount. At last it
+ * cuts the power 400 times at a random point of a write or of a merge
+ * step, remounts and verifies the data: the block being written holds the
+ * old or the new data, every other block is unchanged.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_ftl.h"
+#include "nor_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __LBS           256
+#define __NB_LOG        4
+#define __NB_LBN        3000        /* logic blocks used by the test */
+#define __RANDOM_WRITES 50000
+#define __CUTS          400
+
+/** \brief a write longer than this did a merge (us) */
+#define __MERGE_US      40000
+
+static uint8_t __g_ram[AM_FTL_RAM_SIZE_GET(NOR_SIM_SIZE,
+                                           NOR_SIM_ERASE_SIZE,
+                                           __LBS,
+                                           __NB_LOG)];
+
+static const am_ftl_info_t __g_info = {
+    __g_ram,
+    sizeof(__g_ram),
+    __LBS,
+    __NB_LOG,
+    0,
+    0,
+    0
+};
+
+static am_ftl_serv_t   __g_ftl;
+static am_ftl_handle_t __g_handle;
+
+/** \brief seed of the content of each logic block, 0 if never written */
+static uint32_t        __g_shadow[__NB_LBN];
+static uint32_t        __g_prev[__NB_LBN];
+
+/** \brief am_ftl_write() times (us) */
+static double          __g_lat[100000];
+static int             __g_nlat;
+
+static unsigned long   __g_steps;
+static unsigned long   __g_fails = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __fill (uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    int i;
+
+    for (i = 0; i < __LBS; i++) {
+        p_buf[i] = (uint8_t)(seed * 31 + lbn + i * 7);
+    }
+}
+
+/** \brief the logic block holds the data of seed */
+static am_bool_t __same (unsigned int lbn, uint32_t seed)
+{
+    uint8_t buf[__LBS], exp[__LBS];
+
+    am_ftl_read(__g_handle, lbn, buf);
+    if (seed) {
+        __fill(exp, seed, lbn);
+    } else {
+        memset(exp, 0, sizeof(exp));
+    }
+
+    return (memcmp(buf, exp, __LBS) == 0);
+}
+
+/**
+ * \brief number of logic blocks that differ from the shadow, the block
+ *        inflight (-1 for none) may also hold its previous data
+ */
+static int __verify (int inflight)
+{
+    unsigned int lbn;
+    int          bad = 0;
+
+    for (lbn = 0; lbn < __NB_LBN; lbn++) {
+        if (__same(lbn, __g_shadow[lbn])) {
+            continue;
+        }
+        if ((lbn == (unsigned int)inflight) && __same(lbn, __g_prev[lbn])) {
+            __g_shadow[lbn] = __g_prev[lbn];
+            continue;
+        }
+        if (bad++ < 5) {
+            printf("  mismatch lbn %u\n", lbn);
+        }
+    }
+
+    return bad;
+}
+
+static int __write (unsigned int lbn)
+{
+    uint8_t buf[__LBS];
+    double  t0;
+    int     ret;
+
+    __g_prev[lbn]   = __g_shadow[lbn];
+    __g_shadow[lbn] = rand() | 1;
+    __fill(buf, __g_shadow[lbn], lbn);
+
+    t0  = nor_sim_stat.us;
+    ret = am_ftl_write(__g_handle, lbn, buf);
+    __g_lat[__g_nlat++] = nor_sim_stat.us - t0;
+
+    return ret;
+}
+
+static void __mount (void)
+{
+    memset(&__g_ftl, 0xA5, sizeof(__g_ftl));
+    __g_handle = am_ftl_init(&__g_ftl, &__g_info, nor_sim_init(AM_FALSE));
+    if (__g_handle == NULL) {
+        printf("FAIL: am_ftl_init()\n");
+        exit(1);
+    }
+}
+
+/** \brief a blank volume with every logic block written once */
+static void __format (unsigned int seed)
+{
+    unsigned int lbn;
+
+    nor_sim_blank();
+    memset(__g_shadow, 0, sizeof(__g_shadow));
+    srand(seed);
+    __mount();
+    for (lbn = 0; lbn < __NB_LBN; lbn++) {
+        __write(lbn);
+    }
+    nor_sim_stat_reset();
+    __g_nlat  = 0;
+    __g_steps = 0;
+}
+
+static unsigned int __pick (void)
+{
+    return (rand() % 10 < 7) ? rand() % 64 : 64 + rand() % (__NB_LBN - 64);
+}
+
+/** \brief merge steps until nothing to do or the budget is used up */
+static void __idle (double budget_us)
+{
+    double t0  = nor_sim_stat.us;
+    int    ret = 0;
+
+    while ((nor_sim_stat.us - t0 < budget_us) &&
+           ((ret = am_ftl_gc_step(__g_handle)) > 0)) {
+        __g_steps++;
+    }
+    if (ret < 0) {
+        printf("FAIL: am_ftl_gc_step() %d\n", ret);
+        exit(1);
+    }
+}
+
+/*
+ * the logger: 4 counters every second, 8 config records every minute, an
+ * event record every 10 s appended to a ring of 2000 blocks, the rest of
+ * each second is idle
+ */
+static void __trace (int hours, am_bool_t gc)
+{
+    unsigned int ev = 0;
+    double       t0;
+    int          t, c;
+
+    for (t = 0; t < 3600 * hours; t++) {
+        t0 = nor_sim_stat.us;
+        for (c = 0; c < 4; c++) {
+            __write(10 + c);
+        }
+        if (t % 60 == 0) {
+            for (c = 0; c < 8; c++) {
+                __write(c);
+            }
+        }
+        if (t % 10 == 0) {
+            __write(1000 + ev);
+            ev = (ev + 1) % 2000;
+        }
+        if (gc) {
+            __idle(1e6 - (nor_sim_stat.us - t0));
+        }
+    }
+}
+
+static int __cmp_double (const void *p_a, const void *p_b)
+{
+    double a = *(const double *)p_a;
+    double b = *(const double *)p_b;
+
+    return (a < b) ? -1 : (a > b);
+}
+
+static void __report (const char *name)
+{
+    double sum = 0;
+    int    merges = 0, i;
+
+    for (i = 0; i < __g_nlat; i++) {
+        sum += __g_lat[i];
+        if (__g_lat[i] > __MERGE_US) {
+            merges++;
+        }
+    }
+    qsort(__g_lat, __g_nlat, sizeof(__g_lat[0]), __cmp_double);
+
+    printf("%-16s %6d %7.0f %7.0f %7.0f %7.1f %7d %8lu %7.1f %7lu\n",
+           name, __g_nlat, sum / __g_nlat,
+           __g_lat[__g_nlat / 2], __g_lat[__g_nlat * 99 / 100],
+           __g_lat[__g_nlat - 1] / 1000, merges, __g_steps,
+           nor_sim_stat.us / 1e6, nor_sim_stat.er_ops);
+}
+
+static void __random_test (double budget_us)
+{
+    nor_sim_stat_t stat;
+    char           name[32];
+    int            i, bad;
+
+    __format(11);
+    for (i = 1; i <= __RANDOM_WRITES; i++) {
+        if (__write(__pick()) != AM_OK) {
+            printf("FAIL: am_ftl_write()\n");
+            exit(1);
+        }
+        if (budget_us > 0) {
+            __idle(budget_us);
+        }
+        if (i % 5000 == 0) {
+            stat = nor_sim_stat;        /* not counted in the busy time */
+            bad  = __verify(-1);
+            nor_sim_stat = stat;
+            if (bad != 0) {
+                __check(0, "data while merging in background");
+                break;
+            }
+        }
+    }
+
+    snprintf(name, sizeof(name), "random, %.0f ms", budget_us / 1000);
+    __report(name);
+
+    __mount();
+    __check(__verify(-1) == 0, "data after random writes");
+}
+
+/* power cut in a write or in a merge step */
+static void __cut_test (void)
+{
+    unsigned int lbn;
+    int          cut, inflight, in_gc = 0, i, j;
+
+    __format(5);
+    for (cut = 0; cut < __CUTS; cut++) {
+        for (i = rand() % 40; i > 0; i--) {
+            __write(__pick());
+            for (j = rand() % 20; (j > 0) && (am_ftl_gc_step(__g_handle) > 0);
+                 j--) {
+            }
+        }
+
+        inflight          = -1;
+        nor_sim_cut_after = rand() % 60;
+        if (rand() % 2) {
+            lbn      = __pick();
+            inflight = lbn;
+            __write(lbn);
+        } else {
+            in_gc++;
+            while ((am_ftl_gc_step(__g_handle) > 0) &&
+                   (nor_sim_cut_after > 0)) {
+            }
+        }
+        nor_sim_cut_after = -1;
+
+        __mount();
+        if (__verify(inflight) != 0) {
+            __check(0, "data after a power cut");
+            break;
+        }
+    }
+
+    printf("test_ftl_gc: %d power cuts (%d in merge steps)\n", cut, in_gc);
+}
+
+int main (void)
+{
+    static const double budget[] = {0, 20000, 50000, 150000};
+    unsigned int        i;
+
+    printf("%-16s %6s %7s %7s %7s %7s %7s %8s %7s %7s\n", "run", "writes",
+           "avg_us", "p50_us", "p99_us", "max_ms", "merges", "gc_steps",
+           "busy_s", "erases");
+
+    __format(11);
+    __trace(4, AM_FALSE);
+    __report("logger");
+    __mount();
+    __check(__verify(-1) == 0, "data after the logger");
+
+    __format(11);
+    __trace(4, AM_TRUE);
+    __report("logger, idle gc");
+    __mount();
+    __check(__verify(-1) == 0, "data after the logger with idle gc");
+
+    for (i = 0; i < sizeof(budget) / sizeof(budget[0]); i++) {
+        __random_test(budget[i]);
+    }
+
+    __cut_test();
+
+    printf("test_ftl_gc: %lu failures\n", __g_fails);
+
+    return (__g_fails != 0);
+}
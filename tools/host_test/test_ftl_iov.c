@@ -0,0 +1,376 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of am_ftl_readv()/am_ftl_writev()
+ *
+ * am_ftl runs on the NOR simulator (nor_sim.h), 1 MB with 256 byte logic
+ * blocks and 4 log blocks. The test
+ * - makes random am_ftl_writev(), am_ftl_write(), am_ftl_readv() and merge
+ *   steps against a shadow table, remounting every 3000 operations, with
+ *   the plain MTD operations, with the driver readv/writev and with a
+ *   write-back cache;
+ * - cuts the power 300 times in an am_ftl_writev(): each block of the
+ *   range holds its old or its new data after the remount;
+ * - compares the number of MTD transactions and the simulated time of
+ *   single block and multi-block access, and of an 8 KB NVRAM record.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_ftl.h"
+#include "am_nvram.h"
+#include "nor_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __LBS           256
+#define __NB_LOG        4
+#define __NB_LBN        3000        /* logic blocks used by the test */
+#define __NB_CACHE      8
+#define __RANDOM_OPS    30000
+#define __CUTS          300
+
+static uint8_t __g_ram[AM_FTL_RAM_SIZE_GET(NOR_SIM_SIZE,
+                                           NOR_SIM_ERASE_SIZE,
+                                           __LBS,
+                                           __NB_LOG)];
+
+static uint8_t __g_cache[AM_FTL_CACHE_RAM_SIZE_GET(__LBS, __NB_CACHE)];
+
+static const am_ftl_info_t __g_info = {
+    __g_ram,
+    sizeof(__g_ram),
+    __LBS,
+    __NB_LOG,
+    0,
+    0,
+    0
+};
+
+static am_ftl_serv_t   __g_ftl;
+static am_ftl_handle_t __g_handle;
+static am_bool_t       __g_vec;     /* the driver has readv/writev */
+
+/** \brief seed of the content of each logic block, 0 if never written */
+static uint32_t        __g_shadow[__NB_LBN];
+static uint32_t        __g_prev[__NB_LBN];
+
+static uint8_t         __g_big[64 * __LBS];
+
+static unsigned long   __g_fails = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __fill (uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    int i;
+
+    for (i = 0; i < __LBS; i++) {
+        p_buf[i] = (uint8_t)(seed * 31 + lbn + i * 7);
+    }
+}
+
+static am_bool_t __same (const uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    uint8_t exp[__LBS];
+
+    if (seed) {
+        __fill(exp, seed, lbn);
+    } else {
+        memset(exp, 0, sizeof(exp));
+    }
+
+    return (memcmp(p_buf, exp, __LBS) == 0);
+}
+
+static void __mount (am_bool_t cache)
+{
+    memset(&__g_ftl, 0xA5, sizeof(__g_ftl));
+    __g_handle = am_ftl_init(&__g_ftl, &__g_info, nor_sim_init(__g_vec));
+    if (__g_handle == NULL) {
+        printf("FAIL: am_ftl_init()\n");
+        exit(1);
+    }
+    if (cache) {
+        am_ftl_cache_init(__g_handle, __g_cache, sizeof(__g_cache), __NB_CACHE);
+    }
+}
+
+/** \brief a blank volume */
+static void __format (unsigned int seed, am_bool_t cache)
+{
+    nor_sim_blank();
+    memset(__g_shadow, 0, sizeof(__g_shadow));
+    srand(seed);
+    __mount(cache);
+}
+
+/** \brief read all by am_ftl_readv() and by am_ftl_read(), compare both */
+static int __verify (void)
+{
+    static uint8_t buf[__NB_LBN * __LBS];
+    uint8_t        one[__LBS];
+    unsigned int   lbn;
+    int            bad = 0;
+
+    if (am_ftl_readv(__g_handle, 0, buf, __NB_LBN) != AM_OK) {
+        return 1;
+    }
+    for (lbn = 0; lbn < __NB_LBN; lbn++) {
+        am_ftl_read(__g_handle, lbn, one);
+        if ((!__same(buf + lbn * __LBS, __g_shadow[lbn], lbn) ||
+             !__same(one, __g_shadow[lbn], lbn)) &&
+            (bad++ < 5)) {
+            printf("  mismatch lbn %u\n", lbn);
+        }
+    }
+
+    return bad;
+}
+
+static int __writev (unsigned int lbn, unsigned int n)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        __g_prev[lbn + i]   = __g_shadow[lbn + i];
+        __g_shadow[lbn + i] = rand() | 1;
+        __fill(__g_big + i * __LBS, __g_shadow[lbn + i], lbn + i);
+    }
+
+    return am_ftl_writev(__g_handle, lbn, __g_big, n);
+}
+
+static void __write (unsigned int lbn)
+{
+    uint8_t buf[__LBS];
+
+    __g_prev[lbn]   = __g_shadow[lbn];
+    __g_shadow[lbn] = rand() | 1;
+    __fill(buf, __g_shadow[lbn], lbn);
+    am_ftl_write(__g_handle, lbn, buf);
+}
+
+/** \brief all the blocks written in ranges of 30 */
+static void __fill_all (void)
+{
+    unsigned int lbn;
+
+    for (lbn = 0; lbn < __NB_LBN; lbn += 30) {
+        if (__writev(lbn, 30) != AM_OK) {
+            printf("FAIL: am_ftl_writev()\n");
+            exit(1);
+        }
+    }
+}
+
+static void __random_test (const char *name, am_bool_t vec, am_bool_t cache)
+{
+    unsigned int n, lbn, i;
+    int          it, op, j;
+
+    __g_vec = vec;
+    __format(17 + vec + 2 * cache, cache);
+    __fill_all();
+
+    for (it = 1; it <= __RANDOM_OPS; it++) {
+        n   = 1 + rand() % 40;
+        lbn = rand() % (__NB_LBN - n);
+        op  = rand() % 10;
+
+        if (op < 4) {
+            __check(__writev(lbn, n) == AM_OK, "am_ftl_writev()");
+        } else if (op < 6) {
+            __write(lbn);
+        } else if (op < 9) {
+            __check(am_ftl_readv(__g_handle, lbn, __g_big, n) == AM_OK,
+                    "am_ftl_readv()");
+            for (i = 0; i < n; i++) {
+                if (!__same(__g_big + i * __LBS, __g_shadow[lbn + i], lbn + i)) {
+                    __check(0, "am_ftl_readv() data");
+                    break;
+                }
+            }
+        } else {
+            for (j = rand() % 30; (j > 0) && (am_ftl_gc_step(__g_handle) > 0);
+                 j--) {
+            }
+        }
+
+        if (it % 3000 == 0) {
+            if (cache) {
+                am_ftl_sync(__g_handle);
+            }
+            __mount(cache);
+            if (__verify() != 0) {
+                __check(0, "data after remount");
+                break;
+            }
+        }
+    }
+
+    printf("test_ftl_iov: %d random ops (%s)\n", it - 1, name);
+    __g_vec = AM_FALSE;
+}
+
+/* power cut in the middle of am_ftl_writev() */
+static void __cut_test (void)
+{
+    uint8_t      buf[__LBS];
+    unsigned int n, lbn0, lbn;
+    int          cut, i;
+
+    __format(9, AM_FALSE);
+    __fill_all();
+
+    for (cut = 0; cut < __CUTS; cut++) {
+        for (i = rand() % 10; i > 0; i--) {
+            n = 1 + rand() % 40;
+            __writev(rand() % (__NB_LBN - n), n);
+        }
+
+        n    = 1 + rand() % 40;
+        lbn0 = rand() % (__NB_LBN - n);
+        nor_sim_cut_after = rand() % 80;
+        __writev(lbn0, n);
+        nor_sim_cut_after = -1;
+
+        __mount(AM_FALSE);
+        for (lbn = 0; lbn < __NB_LBN; lbn++) {
+            am_ftl_read(__g_handle, lbn, buf);
+            if (__same(buf, __g_shadow[lbn], lbn)) {
+                continue;
+            }
+            if ((lbn >= lbn0) && (lbn < lbn0 + n) &&
+                __same(buf, __g_prev[lbn], lbn)) {
+                __g_shadow[lbn] = __g_prev[lbn];
+                continue;
+            }
+            printf("FAIL: power cut %d, lbn %u of %u+%u\n", cut, lbn, lbn0, n);
+            __g_fails++;
+            return;
+        }
+    }
+
+    printf("test_ftl_iov: %d power cuts in am_ftl_writev()\n", cut);
+}
+
+static void __perf_line (const char *name, const char *what, am_bool_t wr)
+{
+    printf("%-6s %-34s %6lu %s %8.1f ms\n", name, what,
+           wr ? nor_sim_stat.wr_ops : nor_sim_stat.rd_ops,
+           wr ? "writes" : "reads ", nor_sim_stat.us / 1000);
+}
+
+static void __perf (const char *name, am_bool_t vec)
+{
+    static uint8_t rec[8192];
+    uint8_t        buf[__LBS];
+    am_nvram_dev_t dev;
+    unsigned int   lbn, i;
+
+    __g_vec = vec;
+
+    /* sequential, one block per call or 16 */
+    __format(3, AM_FALSE);
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn++) {
+        __write(lbn);
+    }
+    __perf_line(name, "write 2000 x am_ftl_write()", AM_TRUE);
+
+    __format(3, AM_FALSE);
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn += 16) {
+        __writev(lbn, 16);
+    }
+    __perf_line(name, "write 125 x am_ftl_writev(16)", AM_TRUE);
+
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn++) {
+        am_ftl_read(__g_handle, lbn, buf);
+    }
+    __perf_line(name, "read 2000 x am_ftl_read()", AM_FALSE);
+
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn += 16) {
+        am_ftl_readv(__g_handle, lbn, __g_big, 16);
+    }
+    __perf_line(name, "read 125 x am_ftl_readv(16)", AM_FALSE);
+
+    /* random single block updates, the data is in the log buffers */
+    for (i = 0; i < 3000; i++) {
+        __write(rand() % 2000);
+    }
+
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn++) {
+        am_ftl_read(__g_handle, lbn, buf);
+    }
+    __perf_line(name, "fragmented 2000 x am_ftl_read()", AM_FALSE);
+
+    nor_sim_stat_reset();
+    for (lbn = 0; lbn < 2000; lbn += 16) {
+        am_ftl_readv(__g_handle, lbn, __g_big, 16);
+    }
+    __perf_line(name, "fragmented 125 x am_ftl_readv(16)", AM_FALSE);
+
+    /* an 8 KB record at an offset not aligned to a block */
+    memset(&dev, 0, sizeof(dev));
+    __check(am_ftl_nvram_init(__g_handle, &dev, "ftl") == AM_OK,
+            "am_ftl_nvram_init()");
+    for (i = 0; i < sizeof(rec); i++) {
+        rec[i] = rand();
+    }
+
+    nor_sim_stat_reset();
+    dev.p_funcs->pfn_nvram_set(dev.p_drv, 100 * __LBS + 17, rec, sizeof(rec));
+    __perf_line(name, "nvram set 8 KB", AM_TRUE);
+
+    memset(__g_big, 0, sizeof(rec));
+    nor_sim_stat_reset();
+    dev.p_funcs->pfn_nvram_get(dev.p_drv, 100 * __LBS + 17, __g_big,
+                               sizeof(rec));
+    __perf_line(name, "nvram get 8 KB", AM_FALSE);
+    __check(memcmp(__g_big, rec, sizeof(rec)) == 0, "nvram data");
+
+    am_nvram_dev_unregister(&dev);
+    __g_vec = AM_FALSE;
+}
+
+int main (void)
+{
+    __random_test("MTD read/write", AM_FALSE, AM_FALSE);
+    __random_test("driver readv/writev", AM_TRUE, AM_FALSE);
+    __random_test("cache", AM_FALSE, AM_TRUE);
+
+    __cut_test();
+
+    __perf("mtd", AM_FALSE);
+    __perf("drv-v", AM_TRUE);
+
+    printf("test_ftl_iov: %lu failures\n", __g_fails);
+
+    return (__g_fails != 0);
+}
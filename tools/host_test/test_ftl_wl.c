@@ -0,0 +1,243 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test of the am_ftl static wear leveling
+ *
+ * am_ftl runs on the NOR simulator (nor_sim.h), 1 MB (256 blocks of 4 KB)
+ * with 256 byte logic blocks and 4 log blocks. 85 % of the capacity is
+ * written once as static data, then all writes go to a hot 5 %. The erase
+ * counts of the simulator are the reference. Each run
+ * - checks that am_ftl_wear_stats_get() gives the same minimum and maximum;
+ * - verifies all data before and after a last remount.
+ *
+ * The runs are without static wear leveling, with it and no reset, and
+ * with it and a reset every few writes, mounted by a full scan or from a
+ * checkpoint. The static blocks must take part in the erases in every
+ * case with wear leveling, however often the system is reset.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_ftl.h"
+#include "nor_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __LBS           256
+#define __NB_LOG        4
+#define __CKPT_BLOCKS   (2 * AM_FTL_CKPT_BLOCKS_GET(NOR_SIM_SIZE,           \
+                                                    NOR_SIM_ERASE_SIZE,     \
+                                                    __LBS,                  \
+                                                    __NB_LOG))
+#define __WRITES        200000
+#define __THRESHOLD     50
+
+static uint8_t __g_ram[AM_FTL_RAM_SIZE_GET(NOR_SIM_SIZE,
+                                           NOR_SIM_ERASE_SIZE,
+                                           __LBS,
+                                           __NB_LOG)];
+
+static am_ftl_info_t __g_info = {
+    __g_ram,
+    sizeof(__g_ram),
+    __LBS,
+    __NB_LOG,
+    0,
+    __CKPT_BLOCKS,
+    0
+};
+
+static am_ftl_serv_t   __g_ftl;
+static am_ftl_handle_t __g_handle;
+
+/** \brief seed of the content of each logic block, 0 if never written */
+static uint32_t       *__g_shadow;
+static unsigned int    __g_nb_lbn;
+
+static unsigned long   __g_fails = 0;
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void __fill (uint8_t *p_buf, uint32_t seed, unsigned int lbn)
+{
+    uint32_t v;
+    int      i;
+
+    for (i = 0; i < __LBS; i += 4) {
+        v = seed ^ (lbn * 2654435761u) ^ i;
+        memcpy(p_buf + i, &v, 4);
+    }
+}
+
+/** \brief number of logic blocks that differ from the shadow */
+static int __verify (void)
+{
+    uint8_t      buf[__LBS], exp[__LBS];
+    unsigned int lbn;
+    int          bad = 0;
+
+    for (lbn = 0; lbn < __g_nb_lbn; lbn++) {
+        am_ftl_read(__g_handle, lbn, buf);
+        if (__g_shadow[lbn]) {
+            __fill(exp, __g_shadow[lbn], lbn);
+        } else {
+            memset(exp, 0, sizeof(exp));
+        }
+        if (memcmp(buf, exp, __LBS)) {
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+static void __write (unsigned int lbn)
+{
+    uint8_t buf[__LBS];
+
+    __g_shadow[lbn] = rand() | 1;
+    __fill(buf, __g_shadow[lbn], lbn);
+    if (am_ftl_write(__g_handle, lbn, buf) != AM_OK) {
+        printf("FAIL: am_ftl_write() lbn %u\n", lbn);
+        exit(1);
+    }
+}
+
+static void __mount (void)
+{
+    memset(&__g_ftl, 0xA5, sizeof(__g_ftl));
+    __g_handle = am_ftl_init(&__g_ftl, &__g_info, nor_sim_init(AM_FALSE));
+    if (__g_handle == NULL) {
+        printf("FAIL: am_ftl_init()\n");
+        exit(1);
+    }
+}
+
+/**
+ * \brief one run
+ *
+ * \param[in] threshold : am_ftl_info_t.wl_threshold
+ * \param[in] reset     : writes between two resets, 0 for none
+ * \param[in] ckpt      : save a checkpoint before each reset
+ *
+ * \return the lowest erase count
+ */
+static unsigned int __run (const char   *name,
+                           uint32_t      threshold,
+                           long          reset,
+                           am_bool_t     ckpt)
+{
+    am_ftl_wear_stats_t stat;
+    unsigned int        cold, lbn, pbn, min = ~0u, max = 0;
+    unsigned long       ckpt_mounts = 0, mounts = 0;
+    double              sum = 0;
+    long                i;
+
+    nor_sim_blank();
+    memset(nor_sim_erase_cnt, 0, sizeof(nor_sim_erase_cnt));
+    __g_info.wl_threshold = threshold;
+    __mount();
+
+    __g_nb_lbn = __g_ftl.max_lbn + 1;
+    __g_shadow = calloc(__g_nb_lbn, sizeof(__g_shadow[0]));
+    srand(3);
+
+    /* static data, written once */
+    cold = __g_nb_lbn * 85 / 100;
+    for (lbn = 0; lbn < cold; lbn++) {
+        __write(lbn);
+    }
+    memset(nor_sim_erase_cnt, 0, sizeof(nor_sim_erase_cnt));
+
+    for (i = 1; i <= __WRITES; i++) {
+        __write(cold + rand() % (__g_nb_lbn / 20));
+        if ((reset != 0) && (i % reset == 0)) {
+            if (ckpt) {
+                am_ftl_checkpoint(__g_handle);
+            }
+            __mount();
+            mounts++;
+            if (__g_ftl.ckpt_live != 0xFFFFFFFF) {
+                ckpt_mounts++;
+            }
+        }
+    }
+
+    for (pbn = 0; pbn < __g_ftl.nb_blocks; pbn++) {
+        if (nor_sim_erase_cnt[pbn] < min) {
+            min = nor_sim_erase_cnt[pbn];
+        }
+        if (nor_sim_erase_cnt[pbn] > max) {
+            max = nor_sim_erase_cnt[pbn];
+        }
+        sum += nor_sim_erase_cnt[pbn];
+    }
+
+    am_ftl_wear_stats_get(__g_handle, &stat);
+    __check((stat.max >= max) && (stat.max <= max + 1),
+            "am_ftl_wear_stats_get() max");
+    __check(__verify() == 0, "data");
+    __mount();
+    __check(__verify() == 0, "data after remount");
+    __check(!ckpt || (ckpt_mounts == mounts), "checkpoint not loaded");
+
+    printf("%-24s %6u %6u %8.1f %9.0f  (%lu mounts, %lu from checkpoint)\n",
+           name, min, max, sum / __g_ftl.nb_blocks, sum,
+           mounts, ckpt_mounts);
+
+    free(__g_shadow);
+
+    return min;
+}
+
+int main (void)
+{
+    unsigned int min;
+
+    printf("%-24s %6s %6s %8s %9s\n",
+           "run", "min", "max", "mean", "erases");
+
+    __run("no wear leveling", 0, 0, AM_FALSE);
+
+    /*
+     * about 140 erases between resets every 100 writes, fewer than the 512
+     * of a scan pass, and about 14 every 10 writes, fewer than
+     * AM_FTL_WL_PERIOD
+     */
+    min = __run("no reset", __THRESHOLD, 0, AM_FALSE);
+    __check(min > 100, "no reset: static blocks not moved");
+
+    min = __run("reset / 100, full scan", __THRESHOLD, 100, AM_FALSE);
+    __check(min > 100, "reset / 100, full scan: static blocks not moved");
+
+    min = __run("reset / 100, checkpoint", __THRESHOLD, 100, AM_TRUE);
+    __check(min > 100, "reset / 100, checkpoint: static blocks not moved");
+
+    min = __run("reset / 10, checkpoint", __THRESHOLD, 10, AM_TRUE);
+    __check(min > 100, "reset / 10, checkpoint: static blocks not moved");
+
+    printf("test_ftl_wl: %lu failures\n", __g_fails);
+
+    return (__g_fails != 0);
+}
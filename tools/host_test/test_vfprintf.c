@@ -0,0 +1,269 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of the integer and string conversions of
+ *        am_vfprintf_do
+ *
+ * Every case is compared with the C library vsnprintf, also with small
+ * output buffers to check the truncation. The Makefile builds the test with
+ * the default AM_VFPRINTF_BUF_SIZE and with a 1 character buffer, so every
+ * run boundary of the buffered output is crossed. The benchmark prints the
+ * time of two typical log lines against the C library.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_vdebug.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define __RANDOM_VALUES     20000
+#define __BENCH_CALLS       1000000
+#define __FAIL_SHOWN        20
+
+static unsigned long __g_total = 0;
+static unsigned long __g_fails = 0;
+
+static uint64_t __rand64 (void)
+{
+    static uint64_t x = 0x9E3779B97F4A7C15ull;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return x;
+}
+
+static void __fail (size_t sz, const char *fmt, const char *a, int ra,
+                    const char *b, int rb)
+{
+    if (++__g_fails <= __FAIL_SHOWN) {
+        printf("FAIL size %zu \"%s\": am \"%s\" (%d) libc \"%s\" (%d)\n",
+               sz, fmt, a, ra, b, rb);
+    }
+}
+
+/*
+ * am_vsnprintf() returns the number of characters stored, the C library the
+ * number that would have been stored, so the lengths are compared with the
+ * stored string
+ */
+static void __check_size (size_t sz, const char *fmt, ...)
+{
+    char    a[512], b[512];
+    va_list ap, ap2;
+    int     ra;
+
+    memset(a, 'Z', sizeof(a));
+    va_start(ap, fmt);
+    va_copy(ap2, ap);
+    ra = am_vsnprintf(a, sz, fmt, ap);
+    vsnprintf(b, sz, fmt, ap2);
+    va_end(ap2);
+    va_end(ap);
+
+    __g_total++;
+    if (strcmp(a, b) || (ra != (int)strlen(b))) {
+        __fail(sz, fmt, a, ra, b, (int)strlen(b));
+    }
+}
+
+static void __check (const char *fmt, ...)
+{
+    char    a[512], b[512];
+    va_list ap, ap2;
+    int     ra, rb;
+
+    va_start(ap, fmt);
+    va_copy(ap2, ap);
+    ra = am_vsnprintf(a, sizeof(a), fmt, ap);
+    rb = vsnprintf(b, sizeof(b), fmt, ap2);
+    va_end(ap2);
+    va_end(ap);
+
+    __g_total++;
+    if (strcmp(a, b) || (ra != rb)) {
+        __fail(sizeof(a), fmt, a, ra, b, rb);
+    }
+}
+
+/* implementation-defined output, checked against the expected string */
+static void __expect (const char *exp, const char *fmt, ...)
+{
+    char    a[512];
+    va_list ap;
+    int     ra;
+
+    va_start(ap, fmt);
+    ra = am_vsnprintf(a, sizeof(a), fmt, ap);
+    va_end(ap);
+
+    __g_total++;
+    if (strcmp(a, exp) || (ra != (int)strlen(exp))) {
+        __fail(sizeof(a), fmt, a, ra, exp, (int)strlen(exp));
+    }
+}
+
+static void __fixed_cases (void)
+{
+    static const int ival[] = {
+        0, 1, -1, 9, 10, 99, 100, 12345, -12345, 2147483647,
+        (int)0x80000000, 1000000000, 999999999
+    };
+    static const char *ifmt[] = {
+        "%d", "%5d", "%-5d|", "%05d", "%+d", "% d", "%.3d", "%.0d",
+        "%8.3d", "%-8.3d|", "%08.3d", "%u", "%x", "%X", "%#x", "%#o", "%o",
+        "%#X", "%08x", "%-#10x|", "%i", "%+05d", "%.10d", "%hhd", "%hd",
+        "%hu", "%hhx"
+    };
+    static const long long llval[] = {
+        0LL, 1LL, -1LL, 4294967296LL, -4294967296LL, 9223372036854775807LL,
+        (long long)0x8000000000000000ull, 1000000000000000000LL,
+        999999999999999999LL, 123456789012LL
+    };
+    static const char *llfmt[] = {
+        "%lld", "%llu", "%llx", "%llX", "%20lld", "%-20lld|", "%020lld",
+        "%+lld", "%.25lld", "%#llo", "%jd", "%lli"
+    };
+    unsigned f, i;
+    size_t   sz;
+
+    for (f = 0; f < sizeof(ifmt) / sizeof(ifmt[0]); f++) {
+        for (i = 0; i < sizeof(ival) / sizeof(ival[0]); i++) {
+            __check(ifmt[f], ival[i]);
+        }
+    }
+    for (f = 0; f < sizeof(llfmt) / sizeof(llfmt[0]); f++) {
+        for (i = 0; i < sizeof(llval) / sizeof(llval[0]); i++) {
+            __check(llfmt[f], llval[i]);
+        }
+    }
+
+    __check("%ld %lu %lx", -5L, 7UL, 0xdeadbeefUL);
+    __check("%zu %zd %td", (size_t)123, (ssize_t)-4, (ptrdiff_t)-9);
+    __check("%s|%10s|%-10s|%.2s|%10.2s|%-3s|",
+            "abc", "abc", "abc", "abc", "abc", "abcdef");
+    __check("%c%c%5c%-5c|", 'a', 'b', 'c', 'd');
+    __check("%%|%5%|");
+    __check("%*d|%-*d|%*d|", 5, 42, 5, 42, -5, 42);
+    __check("%.*d|%.*d|", 3, 7, -1, 7);
+    __check("%p %p", (void *)0x1234, (void *)&__g_total);
+    __expect("0x0", "%p", (void *)0);       /* glibc prints "(nil)" */
+    __check("a literal that is longer than the thirty-two characters of "
+            "the buffer %d end", 5);
+    __check("%s", "a string longer than the buffer, sent by the direct path");
+    __check("");
+    __check("plain");
+    __check("%s", "");
+    __check("%.0s|", "abc");
+    __check("%#.0o|%#.0x|%.0x|", 0, 0, 0);
+    __check("%#x", 0);
+    __check("%#5o", 8);
+    __check("%-+8d|", 42);
+    __check("%0-8d|", 42);
+    __check("%+ d", 5);
+    __check("%40s|%-40d|", "x", 5);
+
+    for (sz = 1; sz < 50; sz += 3) {
+        __check_size(sz, "abc%d def %s ghi %08x", 12345, "xyz", 0xbeef);
+        __check_size(sz, "%40d", 1);
+        __check_size(sz, "%-20s|%s", "aa", "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+    }
+}
+
+static void __random_cases (void)
+{
+    static const char *flags[] = {"", "-", "0", "+", " ", "#", "-+", "0#"};
+    static const char  convs[] = "diuxXo";
+    char     fmt[32];
+    uint64_t r, v;
+    unsigned i;
+    int      width, prec;
+
+    for (i = 0; i < __RANDOM_VALUES; i++) {
+        r     = __rand64();
+        v     = __rand64() >> (r & 63);
+        width = (int)(r >> 16 & 31);
+        prec  = (int)(r >> 24 & 31);
+
+        snprintf(fmt, sizeof(fmt), "[%%%s%d.%dll%c]",
+                 flags[r >> 8 & 7], width, prec, convs[(r >> 32) % 6]);
+        __check(fmt, (long long)v);
+
+        snprintf(fmt, sizeof(fmt), "[%%%s%d%c]",
+                 flags[r >> 40 & 7], width, convs[(r >> 48) % 6]);
+        __check(fmt, (int)v);
+    }
+}
+
+/* ns per call of fmt with (unsigned, int, unsigned, string) */
+static double __bench_ns (int am, const char *fmt, int n)
+{
+    char            buf[128];
+    struct timespec t0, t1;
+    volatile int    sum = 0;
+    int             i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        if (am) {
+            sum += am_snprintf(buf, sizeof(buf), fmt,
+                               i, -i * 37, i * 2654435761u, "IDLE");
+        } else {
+            sum += snprintf(buf, sizeof(buf), fmt,
+                            i, -i * 37, i * 2654435761u, "IDLE");
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sum;
+
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+}
+
+int main (void)
+{
+    static const char *bench[] = {
+        "sensor %u: val=%d raw=0x%08x\n",
+        "tick %10u state %-6d event %x %s\n"
+    };
+    unsigned i;
+
+    __fixed_cases();
+    __random_cases();
+
+    for (i = 0; i < sizeof(bench) / sizeof(bench[0]); i++) {
+        printf("test_vfprintf: \"%.*s\" %.0f ns am, %.0f ns libc\n",
+               (int)strcspn(bench[i], "\n"), bench[i],
+               __bench_ns(1, bench[i], __BENCH_CALLS),
+               __bench_ns(0, bench[i], __BENCH_CALLS));
+    }
+
+#ifdef AM_VFPRINTF_BUF_SIZE
+    printf("test_vfprintf: buffer %d, ", AM_VFPRINTF_BUF_SIZE);
+#else
+    printf("test_vfprintf: default buffer, ");
+#endif
+    printf("%lu checks, %lu failures\n", __g_total, __g_fails);
+
+    return (__g_fails != 0);
+}
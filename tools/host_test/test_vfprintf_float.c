@@ -0,0 +1,145 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test of the %f %e %g conversions of am_vfprintf_do
+ *
+ * Every conversion is compared with the C library snprintf (glibc rounds
+ * exactly, half to even). Random bit patterns cover the whole range of
+ * double for %e and %g, %f is checked below 2^63 where am_vfprintf_do keeps
+ * all the digits. Precisions 0 ~ 17 are checked.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_vdebug.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define __RANDOM_VALUES     30000
+#define __FAIL_SHOWN        20
+
+static unsigned long __g_total = 0;
+static unsigned long __g_fails = 0;
+
+/** \brief xorshift64, a fixed sequence so failures can be reproduced */
+static uint64_t __rand64 (void)
+{
+    static uint64_t x = 0x2545F4914F6CDD1Dull;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return x;
+}
+
+/**
+ * \brief glibc drops the zeros of %#g when the rounding carries into a new
+ *        digit ("%#.2g" of 99.5 gives "1.e+02"), C99 asks for "1.0e+02"
+ */
+static int __glibc_alt_g_carry (const char *fmt, const char *a, const char *b)
+{
+    const char *pa = strchr(a, '.');
+    const char *pb = strchr(b, '.');
+    size_t      n;
+
+    if ((strchr(fmt, '#') == NULL) || (pa == NULL) || (pb == NULL) ||
+        (pa - a != pb - b) || strncmp(a, b, pa - a + 1)) {
+        return 0;
+    }
+    n = strspn(pa + 1, "0");
+
+    return (n != 0) && !strcmp(pa + 1 + n, pb + 1);
+}
+
+static void __check (const char *fmt, int prec, double v)
+{
+    char a[512], b[512];
+    int  ra, rb;
+
+    ra = am_snprintf(a, sizeof(a), fmt, prec, v);
+    rb = snprintf(b, sizeof(b), fmt, prec, v);
+
+    __g_total++;
+    if (((ra != rb) || strcmp(a, b)) && !__glibc_alt_g_carry(fmt, a, b)) {
+        if (++__g_fails <= __FAIL_SHOWN) {
+            printf("FAIL %-8s prec %2d %a: am \"%s\" libc \"%s\"\n",
+                   fmt, prec, v, a, b);
+        }
+    }
+}
+
+static void __check_all (double v, int fixed)
+{
+    static const char *fmts[] = {"%.*e", "%.*g", "%#.*g", "%+.*E", "%.*G"};
+    int prec;
+    unsigned i;
+
+    for (prec = 0; prec <= 17; prec++) {
+        for (i = 0; i < sizeof(fmts) / sizeof(fmts[0]); i++) {
+            __check(fmts[i], prec, v);
+        }
+        if (fixed) {
+            __check("%.*f", prec, v);
+            __check("%-30.*f", prec, v);
+        }
+    }
+}
+
+int main (void)
+{
+    static const double special[] = {
+        0.0, 1.0, 0.5, 1.5, 2.5, 0.125, 9.5, 99.5, 999.5,
+        1e-7, 1e-6, 1e-5, 0.1, 0.3, 2.0 / 3.0, 37.58137846252945,
+        1e15, 1e16, 1e17, 1e18, 1e22, 1e23, 123456789012345678.0,
+        9007199254740993.0, 9223372036854774784.0,
+        1.7976931348623157e308, 2.2250738585072014e-308,
+        4.9406564584124654e-324, 1e-320, 1e-310, 1e300
+    };
+    uint64_t bits;
+    double   v;
+    unsigned i;
+
+    for (i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        __check_all(special[i], special[i] < 9223372036854775808.0);
+        __check_all(-special[i], special[i] < 9223372036854775808.0);
+    }
+
+    /* any finite double for %e and %g */
+    for (i = 0; i < __RANDOM_VALUES; i++) {
+        do {
+            bits = __rand64();
+            memcpy(&v, &bits, sizeof(v));
+        } while (!isfinite(v));
+        __check_all(v, 0);
+    }
+
+    /* %f below 2^63, with a wide spread of exponents */
+    for (i = 0; i < __RANDOM_VALUES; i++) {
+        bits = __rand64();
+        v    = ldexp((double)(bits >> 11), (int)(bits % 126) - 116);
+        __check_all(v, 1);
+    }
+
+    printf("test_vfprintf_float: %lu checks, %lu failures\n",
+           __g_total, __g_fails);
+
+    return (__g_fails != 0);
+}
@@ -0,0 +1,197 @@
+/*******************************************************************************
+*                                 AMetal
+*                       ----------------------------
+*                       innovating embedded platform
+*
+* Copyright (c) 2001-2018 Guangzhou ZHIYUAN Electronics Co., Ltd.
+* All rights reserved.
+*
+* Contact information:
+* web site:    http://www.zlg.cn/
+*******************************************************************************/
+
+/**
+ * \file
+ * \brief host test and benchmark of am_wait
+ *
+ * am_wait runs on the host port (am_host.h): the interrupt lock is a mutex
+ * and the idle hook is a condition variable (futex). The test checks:
+ * - no lost wakeup: two threads hand a token back and forth many times with
+ *   the idle hook, a lost wakeup hangs and the watchdog fails the test;
+ * - am_wait_on_timeout() with the soft timer ticked from a thread;
+ * and measures, with and without the idle hook:
+ * - the round trip latency of am_wait_done() -> am_wait_on() return;
+ * - the CPU time taken by a thread waiting for slow completions.
+ *
+ * \internal
+ * \par modification history:
+ * - 1.00 26-10-18  lgg, first implementation
+ * \endinternal
+ */
+
+#include "am_wait.h"
+#include "am_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define __PINGPONG_IDLE     200000  /* round trips with the idle hook */
+#define __PINGPONG_POLL     500     /* round trips when polling */
+#define __SLOW_COUNT        20      /* slow completions */
+#define __SLOW_US           5000    /* time of one slow completion */
+
+static am_wait_t     __g_wait[2];
+static int           __g_rounds;
+static unsigned long __g_fails = 0;
+
+static void __watchdog (int sig)
+{
+    (void)sig;
+
+    printf("FAIL: not done in 60 s, a wakeup was lost\n");
+    _exit(1);
+}
+
+static void __check (int cond, const char *what)
+{
+    if (!cond) {
+        __g_fails++;
+        printf("FAIL: %s\n", what);
+    }
+}
+
+static void *__pong (void *p_arg)
+{
+    int i;
+
+    (void)p_arg;
+
+    for (i = 0; i < __g_rounds; i++) {
+        am_wait_on(&__g_wait[1]);
+        am_wait_done(&__g_wait[0]);
+    }
+
+    return NULL;
+}
+
+/* round trip time in ns */
+static double __pingpong (int rounds)
+{
+    pthread_t thread;
+    uint64_t  t0;
+    int       i;
+
+    __g_rounds = rounds;
+    t0 = am_host_ns();
+    pthread_create(&thread, NULL, __pong, NULL);
+    for (i = 0; i < rounds; i++) {
+        am_wait_done(&__g_wait[1]);
+        am_wait_on(&__g_wait[0]);
+    }
+    pthread_join(thread, NULL);
+
+    return (double)(am_host_ns() - t0) / rounds;
+}
+
+static void *__slow_device (void *p_arg)
+{
+    int i;
+
+    (void)p_arg;
+
+    for (i = 0; i < __SLOW_COUNT; i++) {
+        usleep(__SLOW_US);
+        am_wait_done(&__g_wait[0]);
+    }
+
+    return NULL;
+}
+
+/* CPU time of the waiting thread over the elapsed time, in percent */
+static double __slow_waits (void)
+{
+    pthread_t thread;
+    uint64_t  t0, c0;
+    int       i;
+
+    t0 = am_host_ns();
+    c0 = am_host_thread_cpu_ns();
+    pthread_create(&thread, NULL, __slow_device, NULL);
+    for (i = 0; i < __SLOW_COUNT; i++) {
+        am_wait_on(&__g_wait[0]);
+    }
+    pthread_join(thread, NULL);
+
+    return 100.0 * (am_host_thread_cpu_ns() - c0) / (am_host_ns() - t0);
+}
+
+static void *__done_later (void *p_arg)
+{
+    usleep(5000);
+    am_wait_done((am_wait_t *)p_arg);
+
+    return NULL;
+}
+
+static void __timeout_test (void)
+{
+    pthread_t thread;
+    uint64_t  t0, ms;
+    int       ret;
+
+    t0  = am_host_ns();
+    ret = am_wait_on_timeout(&__g_wait[0], 20);
+    ms  = (am_host_ns() - t0) / 1000000u;
+    __check(ret == -AM_ETIME, "am_wait_on_timeout() without done");
+    __check((ms >= 19) && (ms < 200), "timeout length");
+
+    pthread_create(&thread, NULL, __done_later, &__g_wait[0]);
+    ret = am_wait_on_timeout(&__g_wait[0], 1000);
+    pthread_join(thread, NULL);
+    __check(ret == AM_OK, "am_wait_on_timeout() with done");
+
+    /* the stopped timer must not fire into the next wait */
+    usleep(30000);
+    __check(am_wait_try(&__g_wait[0]) == -AM_EAGAIN, "stale timeout");
+}
+
+int main (void)
+{
+    double rt_poll, rt_idle, cpu_poll, cpu_idle;
+
+    signal(SIGALRM, __watchdog);
+    alarm(60);
+
+    /* the soft timers first, as am_wait_init() sets up a timer */
+    if (am_host_tick_start(1000) != AM_OK) {
+        printf("FAIL: tick thread\n");
+        return 1;
+    }
+    am_wait_init(&__g_wait[0]);
+    am_wait_init(&__g_wait[1]);
+
+    am_wait_idle_set(NULL);
+    rt_poll  = __pingpong(__PINGPONG_POLL);
+    cpu_poll = __slow_waits();
+    __timeout_test();
+
+    am_wait_idle_set(&am_host_wait_idle);
+    rt_idle  = __pingpong(__PINGPONG_IDLE);
+    cpu_idle = __slow_waits();
+    __timeout_test();
+
+    __check(cpu_idle < 50.0, "waiting thread uses little CPU with idle hook");
+
+    am_host_tick_stop();
+
+    printf("test_wait: round trip %.2f us polling, %.2f us idle hook\n",
+           rt_poll / 1000, rt_idle / 1000);
+    printf("test_wait: CPU while waiting %.1f%% polling, %.1f%% idle hook\n",
+           cpu_poll, cpu_idle);
+    printf("test_wait: %d round trips without lost wakeup, %lu failures\n",
+           __PINGPONG_IDLE, __g_fails);
+
+    return (__g_fails != 0);
+}